@@ -457,7 +457,7 @@ JAX = Mode(
 )
 NUMBA = Mode(
     NumbaLinker(),
-    OptimizationQuery(include=["fast_run"], exclude=["cxx_only", "BlasOpt"]),
+    OptimizationQuery(include=["fast_run", "numba"], exclude=["cxx_only", "BlasOpt"]),
 )
 
 
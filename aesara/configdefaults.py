@@ -1255,10 +1255,31 @@ def add_numba_configvars():
     )
     config.add(
         "numba__cache",
-        ("If True, use Numba's file based caching."),
+        (
+            "If True, use Numba's file based caching. The functions generated "
+            "by Aesara are cached in the numba subdirectory of compiledir."
+        ),
         BoolParam(True),
         in_c_key=False,
     )
+    config.add(
+        "numba__parallel",
+        (
+            "If True, compile the loops of Elemwise and CAReduce with "
+            "parallel=True and split their outermost dimension between threads."
+        ),
+        BoolParam(False),
+        in_c_key=False,
+    )
+    config.add(
+        "numba__num_threads",
+        (
+            "Number of threads used by the parallel loops of Numba-compiled "
+            "functions.  0 means Numba's default (NUMBA_NUM_THREADS)."
+        ),
+        IntParam(0, _is_greater_or_equal_0),
+        in_c_key=False,
+    )
 
 
 def _default_compiledirname():
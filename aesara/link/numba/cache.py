@@ -0,0 +1,255 @@
+"""
+Persistent files for the Numba functions that Aesara generates from source.
+
+Numba's file-based cache stores the compiled functions next to their source
+files and invalidates them when these files change.  The functions built by
+`compile_function_src` are written to new temporary files, so Numba never
+finds them again in another process.
+
+Instead, these functions are re-created from files in the ``numba``
+subdirectory of ``config.compiledir``, named after a hash of their source, the
+objects they reference and the options they're compiled with.  These files
+are never rewritten, so Numba's cache of a function (which is keyed on the
+argument types) is reused by all the processes that generate the same
+function.
+
+"""
+
+import logging
+import os
+import tempfile
+import types
+from typing import Any, Callable, Dict, Optional, Tuple
+
+import numba
+import numpy as np
+from numba.core.dispatcher import Dispatcher
+from numba.core.extending import _Intrinsic
+from numba.core.typing.templates import Signature
+from numba.np.ufunc.dufunc import DUFunc
+from numba.np.ufunc.ufuncbuilder import UFuncDispatcher
+
+from aesara.configdefaults import config
+from aesara.tensor.utils import hash_from_ndarray
+from aesara.utils import hash_from_code
+
+
+_logger = logging.getLogger("aesara.link.numba.cache")
+
+
+class Unhashable(Exception):
+    """Raised when an object can't be identified by its contents."""
+
+
+def get_cache_dir() -> str:
+    """Return the directory of the persistent files of generated functions."""
+    return os.path.join(config.compiledir, "numba")
+
+
+def _code_names(code: types.CodeType):
+    """Return the global names referenced by `code` and its nested code."""
+    names = set(code.co_names)
+    for const in code.co_consts:
+        if isinstance(const, types.CodeType):
+            names |= _code_names(const)
+    return names
+
+
+def _code_fingerprint(code: types.CodeType):
+    return (
+        code.co_code,
+        code.co_names,
+        code.co_varnames,
+        tuple(
+            _code_fingerprint(const)
+            if isinstance(const, types.CodeType)
+            else repr(const)
+            for const in code.co_consts
+        ),
+    )
+
+
+def _function_fingerprint(fn: types.FunctionType, memo: Dict[int, Any]):
+    key = getattr(fn, "_aesara_cache_key", None)
+    if key is not None:
+        return key
+
+    code = fn.__code__
+    closure = tuple(
+        fingerprint(cell.cell_contents, memo) for cell in fn.__closure__ or ()
+    )
+    fn_globals = tuple(
+        (name, fingerprint(fn.__globals__[name], memo))
+        for name in sorted(_code_names(code))
+        if name in fn.__globals__
+    )
+    return (
+        fn.__module__,
+        fn.__qualname__,
+        _code_fingerprint(code),
+        fingerprint(fn.__defaults__, memo),
+        closure,
+        fn_globals,
+    )
+
+
+def fingerprint(obj: Any, memo: Optional[Dict[int, Any]] = None):
+    """Return a picklable value that identifies `obj` by its contents.
+
+    Functions are identified by their code, their defaults, their closures and
+    the globals they reference, recursively.
+
+    Raises
+    ------
+    Unhashable
+        When `obj`, or an object it references, can't be identified by its
+        contents (e.g. an arbitrary Python object).
+
+    """
+    if memo is None:
+        memo = {}
+
+    if obj is None or isinstance(obj, (bool, int, float, complex, str, bytes)):
+        return (type(obj).__name__, repr(obj))
+
+    if isinstance(obj, np.ndarray):
+        if obj.dtype.hasobject:
+            raise Unhashable(obj)
+        return ("ndarray", hash_from_ndarray(obj))
+
+    if isinstance(obj, np.generic):
+        return ("generic", obj.dtype.str, obj.tobytes())
+
+    if isinstance(obj, np.dtype):
+        return ("dtype", obj.str)
+
+    if isinstance(obj, (tuple, list)):
+        return (type(obj).__name__,) + tuple(fingerprint(o, memo) for o in obj)
+
+    if isinstance(obj, dict):
+        return ("dict",) + tuple(
+            (fingerprint(k, memo), fingerprint(v, memo)) for k, v in obj.items()
+        )
+
+    if isinstance(obj, types.ModuleType):
+        return ("module", obj.__name__)
+
+    if isinstance(obj, (numba.types.Type, Signature)):
+        return (type(obj).__name__, str(obj))
+
+    if isinstance(obj, type):
+        return ("class", obj.__module__, obj.__qualname__)
+
+    if isinstance(obj, (np.ufunc, types.BuiltinFunctionType)):
+        return (type(obj).__name__, getattr(obj, "__module__", None), obj.__name__)
+
+    # Functions can reference themselves (e.g. recursion), or each other, so
+    # the ones being identified are replaced by their names.
+    obj_id = id(obj)
+    if obj_id in memo:
+        return ("cycle", memo[obj_id])
+
+    if isinstance(obj, (Dispatcher, UFuncDispatcher)):
+        memo[obj_id] = obj.py_func.__qualname__
+        res = (
+            "dispatcher",
+            fingerprint(obj.py_func, memo),
+            fingerprint(obj.targetoptions, memo),
+        )
+    elif isinstance(obj, DUFunc):
+        memo[obj_id] = obj.__name__
+        res = ("dufunc", fingerprint(obj._dispatcher, memo))
+    elif isinstance(obj, _Intrinsic):
+        memo[obj_id] = obj._name
+        res = ("intrinsic", fingerprint(obj._defn, memo))
+    elif isinstance(obj, types.FunctionType):
+        memo[obj_id] = obj.__qualname__
+        res = ("function", _function_fingerprint(obj, memo))
+    else:
+        raise Unhashable(obj)
+
+    del memo[obj_id]
+    return res
+
+
+def get_cache_key(fn: Callable, options: Dict[str, Any]) -> Optional[str]:
+    """Return the key of a generated function, or ``None`` if it can't have one.
+
+    Only the functions created by `compile_function_src`, which don't have a
+    closure, can be re-created from a file.
+
+    """
+    src = getattr(fn, "__source__", None)
+    if src is None or getattr(fn, "__closure__", None):
+        return None
+
+    try:
+        key = (
+            src,
+            fn.__name__,
+            _function_fingerprint(fn, {}),
+            fingerprint(options),
+        )
+    except Unhashable as e:
+        _logger.debug(f"Function {fn.__name__} references unhashable object {e}")
+        return None
+
+    return hash_from_code(repr(key))
+
+
+def load_persistent_function(fn: Callable, key: str) -> Optional[Callable]:
+    """Re-create the generated function `fn` from the file of its `key`.
+
+    The file is written the first time the function is generated.
+
+    """
+    src = fn.__source__
+    cache_dir = get_cache_dir()
+    filename = os.path.join(cache_dir, f"{fn.__name__}_{key[1:33]}.py")
+
+    try:
+        if not os.path.exists(filename):
+            os.makedirs(cache_dir, exist_ok=True)
+            # Write to a temporary file first, so that the other processes
+            # never read a partial file, and the modification time of an
+            # existing file (on which Numba's cache depends) never changes.
+            with tempfile.NamedTemporaryFile(
+                "w", dir=cache_dir, suffix=".tmp", delete=False
+            ) as f:
+                f.write(src)
+            os.replace(f.name, filename)
+    except OSError as e:
+        _logger.warning(f"Could not write the Numba cache file {filename}: {e}")
+        return None
+
+    local_env: Dict[str, Any] = {}
+    exec(compile(src, filename, mode="exec"), fn.__globals__, local_env)
+
+    res = local_env[fn.__name__]
+    res.__source__ = src
+    res._aesara_cache_key = key
+    return res
+
+
+def cacheable_function(fn: Callable, options: Dict[str, Any]) -> Tuple[Callable, bool]:
+    """Return the function to compile in place of `fn`, and whether to cache it.
+
+    Generated functions are replaced by their persistent copies.  The ones that
+    can't be are not cached, since they would never be found again.
+
+    """
+    if not config.numba__cache:
+        return fn, False
+
+    if not isinstance(fn, types.FunctionType) or not hasattr(fn, "__source__"):
+        return fn, True
+
+    if getattr(fn, "_aesara_cache_key", None) is not None:
+        return fn, True
+
+    key = get_cache_key(fn, options)
+    persistent_fn = None if key is None else load_persistent_function(fn, key)
+    if persistent_fn is None:
+        return fn, False
+
+    return persistent_fn, True
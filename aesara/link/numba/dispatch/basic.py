@@ -14,12 +14,12 @@ from numba.core.errors import TypingError
 from numba.cpython.unsafe.tuple import tuple_setitem  # noqa: F401
 from numba.extending import box
 
-from aesara import config
 from aesara.compile.ops import DeepCopyOp
 from aesara.graph.basic import Apply, NoParams
 from aesara.graph.fg import FunctionGraph
 from aesara.graph.type import Type
 from aesara.ifelse import IfElse
+from aesara.link.numba.cache import cacheable_function
 from aesara.link.utils import (
     compile_function_src,
     fgraph_to_python,
@@ -44,18 +44,25 @@ from aesara.tensor.type_other import MakeSlice
 
 
 def numba_njit(*args, **kwargs):
+    """Compile a function with `numba.njit`, caching it when possible.
 
+    See `aesara.link.numba.cache` for how the generated functions are cached.
+    """
     if len(args) > 0 and callable(args[0]):
-        return numba.njit(*args[1:], cache=config.numba__cache, **kwargs)(args[0])
+        fn, cache = cacheable_function(args[0], {"args": args[1:], **kwargs})
+        return numba.njit(*args[1:], cache=cache, **kwargs)(fn)
 
-    return numba.njit(*args, cache=config.numba__cache, **kwargs)
+    return lambda fn: numba_njit(fn, *args, **kwargs)
 
 
 def numba_vectorize(*args, **kwargs):
     if len(args) > 0 and callable(args[0]):
-        return numba.vectorize(*args[1:], cache=config.numba__cache, **kwargs)(args[0])
+        fn, cache = cacheable_function(
+            args[0], {"vectorize": True, "args": args[1:], **kwargs}
+        )
+        return numba.vectorize(*args[1:], cache=cache, **kwargs)(fn)
 
-    return numba.vectorize(*args, cache=config.numba__cache, **kwargs)
+    return lambda fn: numba_vectorize(fn, *args, **kwargs)
 
 
 def get_numba_type(
@@ -370,20 +377,135 @@ def numba_funcify(op, node=None, storage_map=None, **kwargs):
     return perform
 
 
+@singledispatch
+def numba_accepts_buffer(op, node):
+    """Tell whether the Numba function of `node` can write its output to an array.
+
+    When this is ``True``, ``numba_funcify(op, node=node, output_buffer=True)``
+    must return a function that takes an extra, last argument: an array of the
+    output's dtype and number of dimensions that holds the output when it has
+    the right shape.
+    """
+    return False
+
+
+def find_output_buffers(fgraph, order, reuse_outputs=False):
+    """Find the arrays that the nodes of `fgraph` can reuse for their outputs.
+
+    The outputs of the nodes for which `numba_accepts_buffer` is ``True`` are
+    arrays that no other variable holds, unless a later node returns a view of
+    them or updates them in place.  The other nodes are assumed to alias all
+    their inputs, since their Numba functions don't always honor
+    ``view_map``/``destroy_map`` (e.g. `IfElse`).  Once all the variables that
+    alias such an array have been used, the array is handed to the next node
+    that needs one of the same dtype and number of dimensions.
+
+    Parameters
+    ==========
+    fgraph
+        The ``FunctionGraph`` whose nodes are considered.
+    order
+        The order in which the nodes are computed.
+    reuse_outputs
+        When no array is free, let the nodes whose arrays can end up in the
+        outputs of `fgraph` reuse the previous values of these outputs.
+
+    Returns
+    =======
+    A ``dict`` mapping nodes to the variables whose values they can reuse.
+    """
+    accepts = {node: numba_accepts_buffer(node.op, node) for node in order}
+
+    # The arrays that each variable can alias, given by the outputs of the
+    # nodes that allocate them
+    aliases = {}
+    for node in order:
+        if accepts[node]:
+            (out,) = node.outputs
+            aliases[out] = {out}
+        else:
+            node_aliases = set().union(*(aliases.get(i, ()) for i in node.inputs))
+            for out in node.outputs:
+                aliases[out] = node_aliases
+
+    last_use = {}
+    for pos, node in enumerate(order):
+        for i in node.inputs:
+            for a in aliases.get(i, ()):
+                last_use[a] = pos
+    for out in fgraph.outputs:
+        for a in aliases.get(out, ()):
+            last_use[a] = len(order)
+
+    buffers = {}
+    free = {}
+    reused_outputs = set()
+    for pos, node in enumerate(order):
+        if accepts[node]:
+            (out,) = node.outputs
+            key = (out.type.dtype, out.type.ndim)
+            free_arrays = free.get(key)
+            if free_arrays:
+                buffers[node] = free_arrays.pop()
+            elif reuse_outputs:
+                for fgraph_out in fgraph.outputs:
+                    if (
+                        fgraph_out not in reused_outputs
+                        and out in aliases.get(fgraph_out, ())
+                        and (fgraph_out.type.dtype, fgraph_out.type.ndim) == key
+                    ):
+                        buffers[node] = fgraph_out
+                        reused_outputs.add(fgraph_out)
+                        break
+
+        for a in set().union(*(aliases.get(i, ()) for i in node.inputs)):
+            if last_use[a] == pos:
+                free.setdefault((a.type.dtype, a.type.ndim), []).append(a)
+
+    return buffers
+
+
 @numba_funcify.register(FunctionGraph)
 def numba_funcify_FunctionGraph(
     fgraph,
     node=None,
     fgraph_name="numba_funcified_fgraph",
+    order=None,
+    reuse_outputs=False,
     **kwargs,
 ):
-    return fgraph_to_python(
+    """Convert `fgraph` into a single Python function that calls the Numba functions of its nodes.
+
+    The intermediate arrays are reused across the nodes (see
+    `find_output_buffers`).  With `reuse_outputs`, the resulting function
+    takes an extra argument per output whose previous value can be reused,
+    after the inputs, and its ``output_buffers`` attribute lists the
+    corresponding output variables.  Any array of the output's dtype and number
+    of dimensions can be passed to these arguments.
+    """
+    if order is None:
+        order = fgraph.toposort()
+
+    buffers = find_output_buffers(fgraph, order, reuse_outputs=reuse_outputs)
+
+    def op_conversion_fn(op, node, **kwargs):
+        if node in buffers:
+            return numba_funcify(op, node=node, output_buffer=True, **kwargs)
+        return numba_funcify(op, node=node, **kwargs)
+
+    fgraph_def = fgraph_to_python(
         fgraph,
-        numba_funcify,
+        op_conversion_fn,
         type_conversion_fn=numba_typify,
         fgraph_name=fgraph_name,
+        order=order,
+        buffers=buffers,
         **kwargs,
     )
+    fgraph_def.output_buffers = [
+        buffer for buffer in buffers.values() if buffer in fgraph.outputs
+    ]
+    return fgraph_def
 
 
 def create_index_func(node, objmode=False):
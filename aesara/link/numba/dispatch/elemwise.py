@@ -2,7 +2,7 @@ import inspect
 from functools import singledispatch
 from numbers import Number
 from textwrap import indent
-from typing import Any, Callable, Optional, Union
+from typing import Any, Callable, Optional, Sequence, Tuple, Union
 
 import numba
 import numpy as np
@@ -14,6 +14,7 @@ from aesara.link.numba.dispatch import basic as numba_basic
 from aesara.link.numba.dispatch.basic import (
     create_numba_signature,
     create_tuple_creator,
+    numba_accepts_buffer,
     numba_funcify,
     use_optimized_cheap_pass,
 )
@@ -37,7 +38,7 @@ from aesara.scalar.basic import (
 )
 from aesara.scalar.basic import add as add_as
 from aesara.scalar.basic import scalar_maximum
-from aesara.tensor.elemwise import CAReduce, DimShuffle, Elemwise
+from aesara.tensor.elemwise import CAReduce, DimShuffle, Elemwise, FusedCAReduce
 from aesara.tensor.math import MaxAndArgmax, MulWithoutZeros
 from aesara.tensor.nnet.basic import LogSoftmax, Softmax, SoftmaxGrad
 
@@ -406,6 +407,213 @@ def jit_compile_reducer(node, fn, **kwds):
     return res
 
 
+# The scalar `Op`s that `create_loop_nest` can reduce, in any order
+parallel_reduce_ops = (
+    Add,
+    Mul,
+    MulWithoutZeros,
+    ScalarMaximum,
+    ScalarMinimum,
+    AND,
+    OR,
+    XOR,
+)
+
+
+def create_loop_nest(
+    inputs_broadcastable: Sequence[Tuple[bool, ...]],
+    dtype: np.dtype,
+    scalar_fn: Optional[Callable] = None,
+    scalar_op: Optional[Op] = None,
+    axes: Sequence[int] = (),
+    identity: Optional[np.ndarray] = None,
+    acc_dtype: Optional[np.dtype] = None,
+    inplace_idx: Optional[int] = None,
+    parallel: bool = False,
+) -> Callable:
+    r"""Create a Python function that applies a scalar function in one loop nest.
+
+    The functions generated by this function take the following form:
+
+    .. code-block:: python
+
+        def loop_nest(x_0, x_1):
+            n_0 = x_0.shape[0]
+            if x_1.shape[0] != n_0:
+                raise ValueError("Input dimension mismatch")
+            ...
+            out = np.empty((n_0, n_1), dtype=dtype)
+            for j_0 in numba.prange(n_0):
+                for j_1 in range(n_1):
+                    out[j_0, j_1] = scalar_fn(x_0[j_0, j_1], x_1[0, j_1])
+            return out
+
+    When `scalar_op` is given, the values are instead reduced with it over
+    `axes`, without creating the array of the values of `scalar_fn`.  The
+    loops follow the order of the dimensions, so that C-contiguous inputs are
+    read sequentially.  If the outermost dimension is reduced, it's split in
+    one chunk per thread, whose partial results are reduced at the end.
+
+    The generated function also takes an optional ``out`` array, which holds
+    the result when it has the right shape (see `numba_accepts_buffer`).
+
+    Parameters
+    ==========
+    inputs_broadcastable:
+        The broadcastable patterns of the inputs, which all have the same
+        number of dimensions.
+    dtype:
+        The data type of the result.
+    scalar_fn:
+        The function applied to the elements of the inputs, or ``None`` to
+        use the elements of the single input.
+    scalar_op:
+        The scalar :class:`Op` that performs the reduction, if any.  It must be
+        one of `parallel_reduce_ops`.
+    axes:
+        The axes to reduce.
+    identity:
+        The identity value for the reduction.
+    acc_dtype:
+        The data type of the accumulator of the reduction.
+    inplace_idx:
+        The index of an input in which to store the result.
+    parallel:
+        Distribute the outermost loop between threads with `numba.prange`.
+        The function must then be compiled with ``parallel=True``.
+
+    Returns
+    =======
+    A Python function that can be JITed.
+
+    """
+    ndim = len(inputs_broadcastable[0])
+    n_inputs = len(inputs_broadcastable)
+    input_names = [f"x_{i}" for i in range(n_inputs)]
+    global_env = {
+        "np": np,
+        "numba": numba,
+        "scalar_fn": scalar_fn,
+        "identity": None if identity is None else identity.item(),
+        "dtype": dtype,
+        "acc_dtype": acc_dtype,
+        # `numba.get_num_threads` would prevent caching
+        "n_threads": numba.config.NUMBA_NUM_THREADS,
+    }
+
+    # Take the size of each dimension from the first input that isn't
+    # broadcastable in it, and check that the others match
+    lines = []
+    for d in range(ndim):
+        sized = [i for i, bcast in enumerate(inputs_broadcastable) if not bcast[d]]
+        if not sized:
+            lines.append(f"n_{d} = 1")
+            continue
+        lines.append(f"n_{d} = {input_names[sized[0]]}.shape[{d}]")
+        for i in sized[1:]:
+            lines.append(f"if {input_names[i]}.shape[{d}] != n_{d}:")
+            lines.append('    raise ValueError("Input dimension mismatch")')
+
+    index = [
+        ", ".join("0" if bcast[d] else f"j_{d}" for d in range(ndim))
+        for bcast in inputs_broadcastable
+    ]
+    elements = [f"{name}[{idx}]" for name, idx in zip(input_names, index)]
+    if scalar_fn is None:
+        (value,) = elements
+    else:
+        value = f"scalar_fn({', '.join(elements)})"
+
+    kept = [d for d in range(ndim) if d not in axes]
+    res_shape = "".join(f"n_{d}, " for d in kept) or "1, "
+    res_idx = ", ".join(f"j_{d}" for d in kept) or "0"
+    loop_range = "numba.prange" if parallel else "range"
+
+    def loops(body, first=0):
+        src = []
+        for depth, d in enumerate(range(first, ndim)):
+            loop = loop_range if depth == 0 and d == 0 else "range"
+            src.append(indent(f"for j_{d} in {loop}(n_{d}):", " " * 4 * depth))
+        src.append(indent(body, " " * 4 * (ndim - first)))
+        return src
+
+    # The output is stored in `out` when its shape fits, which requires an
+    # accumulator of the output's dtype
+    use_out = (
+        inplace_idx is None
+        and len(kept) > 0
+        and (scalar_op is None or acc_dtype == dtype)
+    )
+
+    def allocate(fill):
+        alloc = (
+            f"np.full(({res_shape}), identity, dtype=acc_dtype)"
+            if fill
+            else f"np.empty(({res_shape}), dtype=dtype)"
+        )
+        if not use_out:
+            return [f"res = {alloc}"]
+        src = [
+            "if out is None:",
+            f"    res = {alloc}",
+            f"elif out.shape != ({res_shape}):",
+            f"    res = {alloc}",
+            "else:",
+            "    res = out",
+        ]
+        if fill:
+            src.append("    res.fill(identity)")
+        return src
+
+    if scalar_op is None:
+        if inplace_idx is None:
+            lines.extend(allocate(fill=False))
+        else:
+            lines.append(f"res = {input_names[inplace_idx]}")
+        lines.extend(loops(f"res[{res_idx}] = {value}"))
+        return_expr = "res"
+    else:
+        update = scalar_in_place_fn(scalar_op, res_idx, "res", "v").strip()
+        body = f"v = {value}\n{update}"
+        if not parallel or 0 in kept:
+            lines.extend(allocate(fill=True))
+            lines.extend(loops(body))
+        else:
+            # Each thread reduces its chunk of the outermost dimension into
+            # its own partial result
+            lines.extend(
+                [
+                    "n_chunks = max(1, min(n_threads, n_0))",
+                    "chunk = -(-n_0 // n_chunks)",
+                    f"partial = np.full((n_chunks, {res_shape}), identity, dtype=acc_dtype)",
+                    "for c in numba.prange(n_chunks):",
+                    "    res = partial[c]",
+                    "    for j_0 in range(c * chunk, min(n_0, (c + 1) * chunk)):",
+                ]
+            )
+            lines.extend(indent(line, " " * 8) for line in loops(body, first=1))
+            combine = scalar_in_place_fn(scalar_op, "idx", "res", "partial[c][idx]")
+            lines.extend(allocate(fill=True))
+            lines.extend(
+                [
+                    "for c in range(n_chunks):",
+                    "    for idx in np.ndindex(res.shape):",
+                    indent(combine.strip(), " " * 8),
+                ]
+            )
+        if acc_dtype != dtype:
+            lines.append("res = res.astype(dtype)")
+        return_expr = "res" if kept else "res[0]"
+
+    lines.append(f"return {return_expr}")
+    loop_nest_src = f"""
+def loop_nest({", ".join(input_names)}, out=None):
+{indent(chr(10).join(lines), " " * 4)}
+    """
+
+    return compile_function_src(loop_nest_src, "loop_nest", {**globals(), **global_env})
+
+
 def create_axis_apply_fn(fn, axis, ndim, dtype):
     reaxis_first = tuple(i for i in range(ndim) if i != axis) + (axis,)
 
@@ -422,10 +630,110 @@ def create_axis_apply_fn(fn, axis, ndim, dtype):
     return axis_apply_fn
 
 
+def jit_compile_loop_nest(fn):
+    """Compile a function created by `create_loop_nest`.
+
+    The function is compiled lazily, because the inputs of its node can be
+    read-only constants, which aren't covered by `create_numba_signature`.
+    """
+    return numba_basic.numba_njit(
+        parallel=config.numba__parallel,
+        boundscheck=False,
+        fastmath=config.numba__fastmath,
+    )(fn)
+
+
+@numba_accepts_buffer.register(Elemwise)
+def numba_accepts_buffer_Elemwise(op, node):
+    return (
+        len(node.outputs) == 1 and node.outputs[0].ndim > 0 and not op.inplace_pattern
+    )
+
+
+def create_buffered_elemwise_func(elemwise_fn, node):
+    """Wrap a vectorized function so that it writes its output to a last, extra argument.
+
+    The output array is only used when its shape is the broadcasted shape of
+    the inputs.
+    """
+    elemwise_fn_name = elemwise_fn.__name__
+    unique_names = unique_name_generator([elemwise_fn_name], suffix_sep="_")
+    input_names = [unique_names(i, force_unique=True) for i in node.inputs]
+    out_name = unique_names("out", force_unique=True)
+
+    out_shape = []
+    for d in range(node.outputs[0].ndim):
+        dim_sizes = [
+            f"{name}.shape[{d}]"
+            for name, inp in zip(input_names, node.inputs)
+            if not inp.broadcastable[d]
+        ]
+        if not dim_sizes:
+            out_shape.append("1")
+        elif len(dim_sizes) == 1:
+            out_shape.append(dim_sizes[0])
+        else:
+            out_shape.append(f"max({', '.join(dim_sizes)})")
+
+    input_signature_str = ", ".join(input_names)
+    buffered_elemwise_fn_name = f"{elemwise_fn_name}_buffered"
+    buffered_elemwise_src = f"""
+def {buffered_elemwise_fn_name}({input_signature_str}, {out_name}):
+    if {out_name}.shape == ({", ".join(out_shape)},):
+        return {elemwise_fn_name}({input_signature_str}, {out_name})
+    return {elemwise_fn_name}({input_signature_str})
+    """
+
+    buffered_elemwise_fn = compile_function_src(
+        buffered_elemwise_src,
+        buffered_elemwise_fn_name,
+        {**globals(), elemwise_fn_name: elemwise_fn},
+    )
+    return numba_basic.numba_njit(inline="always", fastmath=config.numba__fastmath)(
+        buffered_elemwise_fn
+    )
+
+
 @numba_funcify.register(Elemwise)
-def numba_funcify_Elemwise(op, node, **kwargs):
+def numba_funcify_Elemwise(op, node, output_buffer=False, **kwargs):
 
     scalar_op_fn = numba_funcify(op.scalar_op, node=node, inline="always", **kwargs)
+
+    # NumPy ufuncs, and thus `numba.vectorize`, are limited to 32 operands,
+    # which the fused `Elemwise`s can exceed
+    too_many_operands = len(node.inputs) + len(node.outputs) > 32
+
+    if too_many_operands and node.outputs[0].ndim == 0 and len(node.outputs) == 1:
+        input_names = [f"x_{i}" for i in range(len(node.inputs))]
+        scalar_elemwise_src = f"""
+def elemwise_scalar({", ".join(input_names)}):
+    return np.asarray(scalar_op_fn({", ".join(f"to_scalar({n})" for n in input_names)}))
+        """
+        scalar_elemwise_fn = compile_function_src(
+            scalar_elemwise_src,
+            "elemwise_scalar",
+            {
+                **globals(),
+                "scalar_op_fn": scalar_op_fn,
+                "to_scalar": numba_basic.to_scalar,
+            },
+        )
+        return numba_basic.numba_njit(fastmath=config.numba__fastmath)(
+            scalar_elemwise_fn
+        )
+
+    if (config.numba__parallel or too_many_operands) and (
+        node.outputs[0].ndim > 0 and len(node.outputs) == 1
+    ):
+        loop_nest_fn = create_loop_nest(
+            [inp.broadcastable for inp in node.inputs],
+            np.dtype(node.outputs[0].dtype),
+            scalar_fn=scalar_op_fn,
+            inplace_idx=op.inplace_pattern.get(0),
+            parallel=config.numba__parallel,
+        )
+        return jit_compile_loop_nest(loop_nest_fn)
+
     elemwise_fn = create_vectorize_func(scalar_op_fn, node, use_signature=False)
     elemwise_fn_name = elemwise_fn.__name__
 
@@ -471,15 +779,14 @@ def {inplace_elemwise_fn_name}({input_signature_str}):
             inplace_elemwise_fn
         )
 
-    return elemwise_fn
+    if output_buffer:
+        return create_buffered_elemwise_func(elemwise_fn, node)
 
+    return elemwise_fn
 
-@numba_funcify.register(CAReduce)
-def numba_funcify_CAReduce(op, node, **kwargs):
-    axes = op.axis
-    if axes is None:
-        axes = list(range(node.inputs[0].ndim))
 
+def careduce_identity(op, node):
+    """Return the identity of a `CAReduce` node, with its accumulator dtype."""
     if hasattr(op, "acc_dtype") and op.acc_dtype is not None:
         acc_dtype = op.acc_dtype
     else:
@@ -495,7 +802,59 @@ def numba_funcify_CAReduce(op, node, **kwargs):
             scalar_op_identity = np.iinfo(np_acc_dtype).min
 
     # Make sure it has the correct dtype
-    scalar_op_identity = np.array(scalar_op_identity, dtype=np_acc_dtype)
+    return np.array(scalar_op_identity, dtype=np_acc_dtype)
+
+
+def create_careduce_loop_nest(op, node, inputs_broadcastable, scalar_fn=None):
+    """Create the loop nest of a `CAReduce` node, applied to `scalar_fn`."""
+    axes = op.axis
+    if axes is None:
+        axes = list(range(node.inputs[0].ndim))
+    identity = careduce_identity(op, node)
+    return create_loop_nest(
+        inputs_broadcastable,
+        np.dtype(node.outputs[0].dtype),
+        scalar_fn=scalar_fn,
+        scalar_op=op.scalar_op,
+        axes=axes,
+        identity=identity,
+        acc_dtype=identity.dtype,
+        parallel=config.numba__parallel,
+    )
+
+
+def careduce_uses_loop_nest(op, node):
+    return (
+        config.numba__parallel
+        and node.inputs[0].ndim > 0
+        and isinstance(op.scalar_op, parallel_reduce_ops)
+    )
+
+
+@numba_accepts_buffer.register(CAReduce)
+def numba_accepts_buffer_CAReduce(op, node):
+    # The loop nests can only write their output directly when they accumulate
+    # in the output's dtype
+    return (
+        careduce_uses_loop_nest(op, node)
+        and node.outputs[0].ndim > 0
+        and careduce_identity(op, node).dtype == node.outputs[0].type.numpy_dtype
+    )
+
+
+@numba_funcify.register(CAReduce)
+def numba_funcify_CAReduce(op, node, output_buffer=False, **kwargs):
+    axes = op.axis
+    if axes is None:
+        axes = list(range(node.inputs[0].ndim))
+
+    if careduce_uses_loop_nest(op, node):
+        loop_nest_fn = create_careduce_loop_nest(
+            op, node, [node.inputs[0].broadcastable]
+        )
+        return jit_compile_loop_nest(loop_nest_fn)
+
+    scalar_op_identity = careduce_identity(op, node)
 
     input_name = get_name_for_object(node.inputs[0])
     ndim = node.inputs[0].ndim
@@ -512,6 +871,31 @@ def numba_funcify_CAReduce(op, node, **kwargs):
     return careduce_fn
 
 
+@numba_accepts_buffer.register(FusedCAReduce)
+def numba_accepts_buffer_FusedCAReduce(op, node):
+    careduce_node = op.inner_nodes(node.inputs)[1]
+    return (
+        node.outputs[0].ndim > 0
+        and careduce_identity(op.careduce, careduce_node).dtype
+        == node.outputs[0].type.numpy_dtype
+    )
+
+
+@numba_funcify.register(FusedCAReduce)
+def numba_funcify_FusedCAReduce(op, node, output_buffer=False, **kwargs):
+    elemwise_node, careduce_node = op.inner_nodes(node.inputs)
+    scalar_fn = numba_funcify(
+        op.elemwise.scalar_op, node=elemwise_node, inline="always", **kwargs
+    )
+    loop_nest_fn = create_careduce_loop_nest(
+        careduce_node.op,
+        careduce_node,
+        [inp.broadcastable for inp in node.inputs],
+        scalar_fn=scalar_fn,
+    )
+    return jit_compile_loop_nest(loop_nest_fn)
+
+
 @numba_funcify.register(DimShuffle)
 def numba_funcify_DimShuffle(op, **kwargs):
     shuffle = tuple(op.shuffle)
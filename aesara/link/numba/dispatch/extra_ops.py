@@ -331,7 +331,22 @@ def numba_funcify_Searchsorted(op, node, **kwargs):
     if len(node.inputs) == 3:
         use_python = True
 
-    if use_python:
+    if node.inputs[0].ndim > 1:
+        if use_python:
+            return numba_funcify.dispatch(object)(op, node, **kwargs)
+
+        @numba_basic.numba_njit
+        def searchsorted(a, v):
+            if a.shape[:-1] != v.shape[:-1]:
+                raise ValueError("The leading dimensions of `x` and `v` must match")
+            a_rows = np.ascontiguousarray(a).reshape((-1, a.shape[-1]))
+            v_rows = np.ascontiguousarray(v).reshape((-1, v.shape[-1]))
+            res = np.empty(v_rows.shape, dtype=np.int64)
+            for i in range(a_rows.shape[0]):
+                res[i] = np.searchsorted(a_rows[i], v_rows[i], side)
+            return res.reshape(v.shape)
+
+    elif use_python:
         warnings.warn(
             (
                 "Numba will use object mode to allow the "
@@ -1,3 +1,5 @@
+from textwrap import indent
+
 import numpy as np
 from numba import types
 from numba.extending import overload
@@ -9,7 +11,7 @@ from aesara.link.numba.dispatch.basic import (
     create_tuple_string,
     numba_funcify,
 )
-from aesara.link.utils import compile_function_src
+from aesara.link.utils import compile_function_src, unique_name_generator
 from aesara.scan.op import Scan
 
 
@@ -34,124 +36,191 @@ def array0d_range(x):
 
 @numba_funcify.register(Scan)
 def numba_funcify_Scan(op, node, **kwargs):
+    """Create a Numba function that runs a `Scan`'s inner graph in a compiled loop.
+
+    This follows `Scan.perform`: the outputs with taps are stored in copies of
+    their initial states (or in the states themselves when the `Scan` is
+    in-place), which, like the buffers of the nit-sots, are used as circular
+    buffers when `save_mem_new_scan` made them shorter than the number of
+    steps.
+    """
     inner_fg = FunctionGraph(op.inputs, op.outputs)
     numba_at_inner_func = numba_basic.numba_njit(numba_funcify(inner_fg, **kwargs))
 
-    n_seqs = op.info.n_seqs
-    n_mit_mot = op.info.n_mit_mot
-    n_mit_sot = op.info.n_mit_sot
-    n_nit_sot = op.info.n_nit_sot
-    n_sit_sot = op.info.n_sit_sot
-    tap_array = op.info.tap_array
-    n_shared_outs = op.info.n_shared_outs
-    mit_mot_in_taps = tuple(tap_array[:n_mit_mot])
-    mit_sot_in_taps = tuple(tap_array[n_mit_mot : n_mit_mot + n_mit_sot])
-
-    p_in_mit_mot = n_seqs
-    p_in_mit_sot = p_in_mit_mot + n_mit_mot
-    p_in_sit_sot = p_in_mit_sot + n_mit_sot
-    p_outer_in_shared = p_in_sit_sot + n_sit_sot
-    p_outer_in_nit_sot = p_outer_in_shared + n_shared_outs
-    p_outer_in_non_seqs = p_outer_in_nit_sot + n_nit_sot
-
-    input_names = [n.auto_name for n in node.inputs[1:]]
+    info = op.info
+    n_seqs = info.n_seqs
+    n_mit_mot = info.n_mit_mot
+    n_mit_sot = info.n_mit_sot
+    n_sit_sot = info.n_sit_sot
+    n_nit_sot = info.n_nit_sot
+    n_shared_outs = info.n_shared_outs
+    n_outs = n_mit_mot + n_mit_sot + n_sit_sot
+
+    # The same variable can be passed as several inputs (e.g. the lengths of
+    # the nit-sots)
+    unique_names = unique_name_generator(
+        ["scan", "np", "numba_at_inner_func", "to_scalar", "i", "n_steps"],
+        suffix_sep="_",
+    )
+    input_names = [unique_names(n, force_unique=True) for n in node.inputs[1:]]
     outer_in_seqs_names = input_names[:n_seqs]
-    outer_in_mit_mot_names = input_names[p_in_mit_mot : p_in_mit_mot + n_mit_mot]
-    outer_in_mit_sot_names = input_names[p_in_mit_sot : p_in_mit_sot + n_mit_sot]
-    outer_in_sit_sot_names = input_names[p_in_sit_sot : p_in_sit_sot + n_sit_sot]
+    outer_in_taps_names = input_names[n_seqs : n_seqs + n_outs]
+    p_outer_in_shared = n_seqs + n_outs
     outer_in_shared_names = input_names[
         p_outer_in_shared : p_outer_in_shared + n_shared_outs
     ]
+    p_outer_in_nit_sot = p_outer_in_shared + n_shared_outs
     outer_in_nit_sot_names = input_names[
         p_outer_in_nit_sot : p_outer_in_nit_sot + n_nit_sot
     ]
-    outer_in_feedback_names = input_names[n_seqs:p_outer_in_non_seqs]
-    outer_in_non_seqs_names = input_names[p_outer_in_non_seqs:]
-
-    inner_in_indexed = []
-    allocate_mem_to_nit_sot = ""
-
-    for _name in outer_in_seqs_names:
-        # A sequence with multiple taps is provided as multiple modified
-        # input sequences to the Scan Op sliced appropriately
-        # to keep following the logic of a normal sequence.
-        index = "[i]"
-        inner_in_indexed.append(_name + index)
-
-    name_to_input_map = dict(zip(input_names, node.inputs[1:]))
-    mit_sot_name_to_taps = dict(zip(outer_in_mit_sot_names, mit_sot_in_taps))
-    inner_out_name_to_index = {}
-    for _name in outer_in_feedback_names:
-        if _name in outer_in_mit_sot_names:
-            curr_taps = mit_sot_name_to_taps[_name]
-            min_tap = min(curr_taps)
-
-            for _tap in curr_taps:
-                index = idx_to_str(_tap - min_tap)
-                inner_in_indexed.append(_name + index)
-
-            inner_out_name_to_index[_name] = -min_tap
-
-        if _name in outer_in_sit_sot_names:
-            # Note that the outputs with single taps which are not
-            # -1 are (for instance taps = [-2]) are classified
-            # as mit-sot so the code for handling sit-sots remains
-            # constant as follows
-            index = "[i]"
-            inner_in_indexed.append(_name + index)
-            inner_out_name_to_index[_name] = 1
-
-        if _name in outer_in_nit_sot_names:
-            inner_out_name_to_index[_name] = 0
-            # In case of nit-sots we are provided shape of the array
-            # instead of actual arrays like other cases, hence we
-            # allocate space for the results accordingly.
-            curr_nit_sot_position = input_names.index(_name) - n_seqs
-            curr_nit_sot = inner_fg.outputs[curr_nit_sot_position]
-            mem_shape = ["1"] * curr_nit_sot.ndim
-            curr_dtype = curr_nit_sot.type.numpy_dtype.name
-            allocate_mem_to_nit_sot += f"""
-    {_name} = [np.zeros(({create_arg_string(mem_shape)}), dtype=np.{curr_dtype})]*{_name}.item()
-"""
-    # The non_seqs are passed to inner function as-is
-    inner_in_indexed += outer_in_non_seqs_names
-    inner_out_indexed = [
-        _name + idx_to_str(idx) for _name, idx in inner_out_name_to_index.items()
+    outer_in_non_seqs_names = input_names[p_outer_in_nit_sot + n_nit_sot :]
+
+    # The buffers of the mit-mots, mit-sots, sit-sots and nit-sots, in the
+    # order of the outputs
+    storage_names = [
+        f"{name}_storage" for name in outer_in_taps_names + outer_in_nit_sot_names
     ]
+    inner_nit_sot_outs = op.inner_nitsot_outs(op.outputs)
+
+    allocate = []
+    for name in outer_in_seqs_names:
+        allocate.append(
+            f"""
+if {name}.shape[0] < n_steps:
+    raise ValueError("A sequence is shorter than the number of steps")
+"""
+        )
+
+    for j, (name, storage_name) in enumerate(zip(outer_in_taps_names, storage_names)):
+        storage = name if j in op.destroy_map else f"{name}.copy()"
+        allocate.append(
+            f"""
+{storage_name} = {storage}
+{storage_name}_len = {storage_name}.shape[0]
+{storage_name}_pos = {-min(info.tap_array[j])} % {storage_name}_len
+"""
+        )
+
+    # The shapes of the nit-sots are only known after the first step, when
+    # their buffers are allocated
+    for name, storage_name, inner_out in zip(
+        outer_in_nit_sot_names, storage_names[n_outs:], inner_nit_sot_outs
+    ):
+        dtype = inner_out.type.numpy_dtype.name
+        shape = (
+            f"{storage_name}_len"
+            if inner_out.ndim == 0
+            else create_tuple_string(["0"] * (inner_out.ndim + 1))
+        )
+        allocate.append(
+            f"""
+{storage_name}_len = to_scalar({name})
+{storage_name} = np.empty({shape}, dtype=np.{dtype})
+{storage_name}_pos = 0
+"""
+        )
+
+    shared_names = [f"{name}_state" for name in outer_in_shared_names]
+    for name, shared_name in zip(outer_in_shared_names, shared_names):
+        allocate.append(f"{shared_name} = {name}")
+
+    # The inner inputs: the sequences' entries, the outputs' taps, the
+    # shared variables' states and the non-sequences
+    inner_in = [f"{name}[i]" for name in outer_in_seqs_names]
+    for j, storage_name in enumerate(storage_names[:n_outs]):
+        for tap in info.tap_array[j]:
+            inner_in.append(
+                f"{storage_name}[({storage_name}_pos + {tap}) % {storage_name}_len]"
+            )
+    inner_in += shared_names
+    inner_in += outer_in_non_seqs_names
+
+    # Store the inner outputs in the buffers
+    inner_out_names = [f"inner_out_{k}" for k in range(len(op.outputs))]
+    store = []
+    k = 0
+    for j, storage_name in enumerate(storage_names[:n_mit_mot]):
+        for tap in info.mit_mot_out_slices[j]:
+            value = inner_out_names[k]
+            if op.outputs[k].ndim == 0:
+                value = f"to_scalar({value})"
+            store.append(f"{storage_name}[{storage_name}_pos + {tap}] = {value}")
+            k += 1
+
+    for storage_name, inner_out in zip(
+        storage_names[n_mit_mot:], op.outputs[k : k + n_outs - n_mit_mot + n_nit_sot]
+    ):
+        value = inner_out_names[k]
+        if inner_out.ndim == 0:
+            value = f"to_scalar({value})"
+        elif storage_name in storage_names[n_outs:]:
+            store.append(
+                f"""
+if i == 0:
+    {storage_name} = np.empty(({storage_name}_len,) + {value}.shape, dtype={storage_name}.dtype)
+"""
+            )
+        store.append(f"{storage_name}[{storage_name}_pos] = {value}")
+        k += 1
+
+    for shared_name in shared_names:
+        store.append(f"{shared_name} = {inner_out_names[k]}")
+        k += 1
+
+    for storage_name in storage_names:
+        store.append(
+            f"{storage_name}_pos = ({storage_name}_pos + 1) % {storage_name}_len"
+        )
 
-    while_logic = ""
     if op.as_while:
-        # The inner function will be returning a boolean as last argument
-        inner_out_indexed.append("while_flag")
-        while_logic += """
-        if while_flag:
-        """
-        for _name, idx in inner_out_name_to_index.items():
-            while_logic += f"""
-            {_name} = {_name}[:i+{idx+1}]
-            """
-        while_logic += """
-            break
-        """
-
-    global_env = locals()
-    global_env["np"] = np
+        store.append(
+            f"""
+if to_scalar({inner_out_names[k]}):
+    i += 1
+    break
+"""
+        )
+
+    # Put the entries of the circular buffers back in order, and trim the
+    # outputs of the loops that stopped early
+    reorder = []
+    mintaps = [min(taps) for taps in info.tap_array[n_mit_mot:n_outs]]
+    mintaps += [0] * n_nit_sot
+    for storage_name, mintap in zip(storage_names[n_mit_mot:], mintaps):
+        reorder.append(
+            f"""
+if {storage_name}_len < i - {mintap}:
+    {storage_name} = np.concatenate(
+        ({storage_name}[{storage_name}_pos:], {storage_name}[:{storage_name}_pos])
+    )
+elif {storage_name}_len > i - {mintap}:
+    {storage_name}[i - {mintap}:] = 0
+    if i < n_steps:
+        {storage_name} = {storage_name}[: {storage_name}_len - (n_steps - i)]
+"""
+        )
+
+    global_env = {
+        "np": np,
+        "numba_at_inner_func": numba_at_inner_func,
+        "to_scalar": numba_basic.to_scalar,
+    }
+
+    def indent_lines(lines, n):
+        return indent("\n".join(line.strip("\n") for line in lines), " " * 4 * n)
 
     scan_op_src = f"""
-def scan(n_steps, {", ".join(input_names)}):
-{allocate_mem_to_nit_sot}
-    for i in range(n_steps):
-        inner_args = {create_tuple_string(inner_in_indexed)}
-        {create_tuple_string(inner_out_indexed)} = numba_at_inner_func(*inner_args)
-{while_logic}
-    return {create_arg_string(
-        outer_in_mit_sot_names +
-        outer_in_sit_sot_names +
-        outer_in_nit_sot_names
-    )}
+def scan(n_steps_arg, {", ".join(input_names)}):
+    n_steps = to_scalar(n_steps_arg)
+{indent_lines(allocate, 1)}
+    i = 0
+    while i < n_steps:
+        {create_tuple_string(inner_out_names)} = numba_at_inner_func({create_arg_string(inner_in)})
+{indent_lines(store, 2)}
+        i += 1
+{indent_lines(reorder, 1)}
+    return {create_arg_string(storage_names + shared_names)}
     """
-    scalar_op_fn = compile_function_src(
-        scan_op_src, "scan", {**globals(), **global_env}
-    )
+    scan_fn = compile_function_src(scan_op_src, "scan", {**globals(), **global_env})
 
-    return numba_basic.numba_njit(scalar_op_fn)
+    return numba_basic.numba_njit(scan_fn)
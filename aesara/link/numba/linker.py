@@ -1,20 +1,72 @@
+import numpy as np
+
+from aesara.configdefaults import config
 from aesara.link.basic import JITLinker
 
 
+class OutputBuffer:
+    """A storage-like view of an output's storage, used as a thunk input.
+
+    It holds the output's previous value, which the jitted function can
+    overwrite, or an empty array of the output's type when there's none (e.g.
+    when the output isn't borrowed and its storage is cleared between calls).
+    """
+
+    def __init__(self, storage, variable):
+        self.storage = storage
+        self.empty = np.empty((0,) * variable.type.ndim, dtype=variable.type.dtype)
+
+    def __getitem__(self, i):
+        value = self.storage[i]
+        if value is None:
+            return self.empty
+        return value
+
+
 class NumbaLinker(JITLinker):
     """A `Linker` that JIT-compiles NumPy-based operations using Numba."""
 
     def fgraph_convert(self, fgraph, **kwargs):
         from aesara.link.numba.dispatch import numba_funcify
 
-        return numba_funcify(fgraph, **kwargs)
+        converted_fgraph = numba_funcify(fgraph, reuse_outputs=True, **kwargs)
+        self.output_buffers = converted_fgraph.output_buffers
+        return converted_fgraph
 
     def jit_compile(self, fn):
-        import numba
+        from aesara.link.numba.dispatch.basic import numba_njit
 
-        jitted_fn = numba.njit(fn)
+        jitted_fn = numba_njit(fn)
         return jitted_fn
 
+    def create_jitable_thunk(self, *args, **kwargs):
+        thunks, output_nodes, jit_fn = super().create_jitable_thunk(*args, **kwargs)
+
+        num_threads = config.numba__num_threads
+        if num_threads > 0:
+            import numba
+
+            # `numba.set_num_threads` fails above the size of the thread pool
+            num_threads = min(num_threads, numba.config.NUMBA_NUM_THREADS)
+            (thunk,) = thunks
+
+            def thunk_with_threads():
+                # The number of threads is per thread of the caller, and is
+                # restored for the other Numba code it runs
+                previous = numba.get_num_threads()
+                numba.set_num_threads(num_threads)
+                try:
+                    return thunk()
+                finally:
+                    numba.set_num_threads(previous)
+
+            thunk_with_threads.inputs = thunk.inputs
+            thunk_with_threads.outputs = thunk.outputs
+            thunk_with_threads.lazy = thunk.lazy
+            thunks = [thunk_with_threads]
+
+        return thunks, output_nodes, jit_fn
+
     def create_thunk_inputs(self, storage_map):
         from numpy.random import RandomState
 
@@ -34,4 +86,9 @@ class NumbaLinker(JITLinker):
                 sinput = [new_value]
             thunk_inputs.append(sinput)
 
+        # The outputs are computed in the arrays of the previous call, when
+        # they have the right shape
+        for out in self.output_buffers:
+            thunk_inputs.append(OutputBuffer(storage_map[out], out))
+
         return thunk_inputs
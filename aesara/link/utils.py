@@ -687,6 +687,7 @@ def fgraph_to_python(
     local_env: Optional[Dict[Any, Any]] = None,
     get_name_for_object: Callable[[Any], str] = get_name_for_object,
     squeeze_output: bool = False,
+    buffers: Optional[Dict[Apply, Variable]] = None,
     **kwargs,
 ) -> Callable:
     """Convert a ``FunctionGraph`` into a regular Python function.
@@ -725,6 +726,13 @@ def fgraph_to_python(
     squeeze_output
         If the ``FunctionGraph`` has only one output and this option is
         ``True``, return the single output instead of a tuple with the output.
+    buffers
+        A map from nodes to the variables whose values are passed as an extra,
+        last argument to the converted functions of the nodes.  When such a
+        variable is an output of `fgraph`, the value is taken from an extra
+        argument of the resulting function instead, named after the variable
+        with a ``_buffer`` suffix; these arguments follow the inputs in the
+        order of `order`.
     **kwargs
         The remaining keywords are passed to `python_conversion_fn`
     """
@@ -740,7 +748,11 @@ def fgraph_to_python(
     if global_env is None:
         global_env = {}
 
+    if buffers is None:
+        buffers = {}
+
     body_assigns = []
+    fgraph_buffer_names = []
     for node in order:
         compiled_func = op_conversion_fn(
             node.op, node=node, storage_map=storage_map, **kwargs
@@ -762,6 +774,15 @@ def fgraph_to_python(
                 # E.g. `local_input_name = f"{local_input_name}[0]"`
             node_input_names.append(local_input_name)
 
+        buffer = buffers.get(node)
+        if buffer is not None:
+            if buffer in fgraph.outputs:
+                buffer_name = f"{unique_name(buffer)}_buffer"
+                fgraph_buffer_names.append(buffer_name)
+            else:
+                buffer_name = unique_name(buffer)
+            node_input_names.append(buffer_name)
+
         node_output_names = [unique_name(v) for v in node.outputs]
 
         body_assigns.append(
@@ -780,7 +801,7 @@ def fgraph_to_python(
         fgraph_return_src = ", ".join(fgraph_output_names)
 
     fgraph_def_src = f"""
-def {fgraph_name}({", ".join(fgraph_input_names)}):
+def {fgraph_name}({", ".join(fgraph_input_names + fgraph_buffer_names)}):
 {joined_body_assigns}
     return {fgraph_return_src}
     """
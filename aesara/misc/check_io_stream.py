@@ -0,0 +1,108 @@
+#!/usr/bin/env python
+
+# Measure how fast `aesara.tensor.io.ChunkReader` streams a file through a
+# compiled function, compared with the read speed of the disk alone.
+#
+# The file should be larger than the RAM, or the page cache dropped
+# beforehand (`echo 3 > /proc/sys/vm/drop_caches` as root), for the numbers
+# to reflect the disk rather than the page cache.
+
+import os
+import sys
+import time
+from optparse import OptionParser
+
+import numpy as np
+
+import aesara
+from aesara.tensor.io import ChunkReader
+from aesara.tensor.type import matrix
+
+
+parser = OptionParser(
+    usage="%prog <options> file\n Time the streaming of a file through a function"
+)
+parser.add_option(
+    "--size",
+    type="int",
+    default=1024,
+    help="Size in MiB of the float32 .npy file to create when it doesn't exist",
+)
+parser.add_option(
+    "--columns", type="int", default=1024, help="Number of columns of the array"
+)
+parser.add_option("--chunk", type="int", default=16, help="Size in MiB of the chunks")
+parser.add_option(
+    "--prefetch", type="int", default=4, help="Number of chunks read ahead"
+)
+
+
+def create(path, size, columns):
+    rows = size * 2**20 // (4 * columns)
+    array = np.lib.format.open_memmap(
+        path, mode="w+", dtype="float32", shape=(rows, columns)
+    )
+    block = max(1, 2**26 // (4 * columns))
+    rng = np.random.default_rng(0)
+    for begin in range(0, rows, block):
+        end = min(rows, begin + block)
+        array[begin:end] = rng.random((end - begin, columns), dtype="float32")
+    array.flush()
+    del array
+
+
+def run(chunks, fn):
+    start = time.perf_counter()
+    n_bytes = 0
+    for chunk in chunks:
+        fn(chunk)
+        n_bytes += chunk.nbytes
+    return n_bytes / 2**20 / (time.perf_counter() - start)
+
+
+def read_synchronously(path, rows):
+    """Read the chunks in the main thread, without reading ahead."""
+    reader = ChunkReader(path, rows)
+    with open(path, "rb", buffering=0) as f:
+        f.seek(reader.offset)
+        for begin in range(0, reader.shape[0], rows):
+            shape = (min(rows, reader.shape[0] - begin),) + reader.shape[1:]
+            chunk = np.empty(shape, dtype=reader.dtype)
+            f.readinto(memoryview(chunk.reshape(-1).view(np.uint8)))
+            yield chunk
+
+
+def execute(path, chunk, prefetch):
+    x = matrix("x", dtype="float32")
+    fn = aesara.function([x], x.sum(axis=0))
+    columns = ChunkReader(path, 1).shape[1]
+    rows = max(1, chunk * 2**20 // (4 * columns))
+
+    with open(path, "rb", buffering=0) as f:
+        start = time.perf_counter()
+        buffer = bytearray(chunk * 2**20)
+        n_bytes = 0
+        while True:
+            n_read = f.readinto(buffer)
+            if not n_read:
+                break
+            n_bytes += n_read
+        disk = n_bytes / 2**20 / (time.perf_counter() - start)
+    print(f"Read alone:         {disk:8.1f} MiB/s")
+    speed = run(read_synchronously(path, rows), fn)
+    print(f"Synchronous reads:  {speed:8.1f} MiB/s")
+    for mmap_mode in (None, "r"):
+        reader = ChunkReader(path, rows, mmap_mode=mmap_mode, prefetch=prefetch)
+        speed = run(reader, fn)
+        print(f"ChunkReader({mmap_mode!s:4}): {speed:8.1f} MiB/s")
+
+
+if __name__ == "__main__":
+    options, arguments = parser.parse_args(sys.argv)
+    if len(arguments) != 2:
+        parser.print_help()
+        sys.exit(1)
+    path = arguments[1]
+    if not os.path.exists(path):
+        create(path, options.size, options.columns)
+    execute(path, options.chunk, options.prefetch)
@@ -7,13 +7,13 @@ from aesara.tensor.basic_opt import (
     register_specialize,
     register_stabilize,
 )
-from aesara.tensor.blas import Dot22
 from aesara.tensor.elemwise import DimShuffle
-from aesara.tensor.math import Dot, Prod, dot, log
+from aesara.tensor.linalg_opt import inv_as_solve  # noqa: F401
+from aesara.tensor.math import Prod, dot, log
 from aesara.tensor.math import pow as at_pow
 from aesara.tensor.math import prod
 from aesara.tensor.nlinalg import Det, MatrixInverse, trace
-from aesara.tensor.slinalg import Cholesky, Solve, cholesky, solve
+from aesara.tensor.slinalg import Cholesky, Solve, cholesky
 
 
 logger = logging.getLogger(__name__)
@@ -31,24 +31,6 @@ def transinv_to_invtrans(fgraph, node):
                     return [A.owner.op(node.op(X))]
 
 
-@register_stabilize
-@local_optimizer([Dot, Dot22])
-def inv_as_solve(fgraph, node):
-    """
-    This utilizes a boolean `symmetric` tag on the matrices.
-    """
-    if isinstance(node.op, (Dot, Dot22)):
-        l, r = node.inputs
-        if l.owner and isinstance(l.owner.op, MatrixInverse):
-            return [solve(l.owner.inputs[0], r)]
-        if r.owner and isinstance(r.owner.op, MatrixInverse):
-            x = r.owner.inputs[0]
-            if getattr(x.tag, "symmetric", None) is True:
-                return [solve(x, l.T).T]
-            else:
-                return [solve(x.T, l.T).T]
-
-
 @register_stabilize
 @register_canonicalize
 @local_optimizer([Solve])
@@ -1,4 +1,3 @@
-import copy
 import warnings
 from typing import Tuple, Union
 
@@ -7,28 +6,33 @@ import numpy as np
 import aesara.tensor as at
 from aesara.configdefaults import config
 from aesara.graph.basic import Apply
-from aesara.link.c.op import COp
+from aesara.link.c.op import OpenMPOp
 from aesara.scalar import ScalarType, as_scalar
 from aesara.tensor.type import discrete_dtypes
 
 
-class MultinomialFromUniform(COp):
+class MultinomialFromUniform(OpenMPOp):
     """
     Converts samples from a uniform into sample from a multinomial.
 
+    The C code computes the CDF of each row once, and finds the outcome of
+    each uniform with a binary search on it.  The rows are processed in
+    parallel when OpenMP is enabled.
+
     TODO : need description for parameter 'odtype'
     """
 
     __props__: Union[Tuple[str], Tuple[str, str]] = ("odtype",)
 
-    def __init__(self, odtype):
+    def __init__(self, odtype, openmp=None):
         self.odtype = odtype
+        super().__init__(openmp=openmp)
 
     def __str__(self):
         return f"{self.__class__.__name__}{{{self.odtype}}}"
 
     def __setstate__(self, dct):
-        self.__dict__.update(dct)
+        super().__setstate__(dct)
         try:
             self.odtype
         except AttributeError:
@@ -59,7 +63,45 @@ class MultinomialFromUniform(COp):
         ]
 
     def c_code_cache_version(self):
-        return (8,)
+        return (9, self.openmp, config.openmp_elemwise_minsize)
+
+    def c_support_code(self, **kwargs):
+        return """
+        #ifndef _AESARA_CDF_SEARCH_DEFINED
+        #define _AESARA_CDF_SEARCH_DEFINED
+        // Index of the first element of `cdf` that is greater than `u`, or
+        // `n` if there is none.  `cdf` is the cumulative sum of the
+        // probabilities of `n` outcomes.
+        static npy_intp aesara_cdf_search(const double* cdf, npy_intp n, double u)
+        {
+            npy_intp lo = 0, hi = n;
+            if (n <= 32) {
+                while (lo < n && !(cdf[lo] > u))
+                    ++lo;
+                return lo;
+            }
+            while (lo < hi) {
+                const npy_intp mid = lo + (hi - lo) / 2;
+                if (cdf[mid] > u)
+                    hi = mid;
+                else
+                    lo = mid + 1;
+            }
+            return lo;
+        }
+        #endif
+        """
+
+    def _omp_pragmas(self, work):
+        """Return the OpenMP pragmas of the loop over the rows of `pvals`."""
+        if not self.openmp:
+            return "", "", ""
+        return (
+            "#pragma omp parallel if(nb_multi > 1 && %s >= %d)"
+            % (work, config.openmp_elemwise_minsize),
+            "#pragma omp for schedule(static)",
+            "#pragma omp atomic write",
+        )
 
     def c_code(self, node, name, ins, outs, sub):
         # support old pickled graphs
@@ -69,6 +111,9 @@ class MultinomialFromUniform(COp):
         else:
             (pvals, unis, n) = ins
         (z,) = outs
+        omp_parallel, omp_for, omp_atomic = self._omp_pragmas(
+            "nb_multi * (nb_outcomes + n_samples)"
+        )
         if self.odtype == "auto":
             t = f"PyArray_TYPE({pvals})"
         else:
@@ -116,46 +161,48 @@ class MultinomialFromUniform(COp):
 
         { // NESTED SCOPE
 
-        const int nb_multi = PyArray_DIMS(%(pvals)s)[0];
-        const int nb_outcomes = PyArray_DIMS(%(pvals)s)[1];
-        const int n_samples = %(n)s;
+        const npy_intp nb_multi = PyArray_DIMS(%(pvals)s)[0];
+        const npy_intp nb_outcomes = PyArray_DIMS(%(pvals)s)[1];
+        const npy_intp n_samples = %(n)s;
+        int failed = 0;
 
-        //
-        // For each multinomial, loop over each possible outcome
-        //
-        for (int c = 0; c < n_samples; ++c){
-            for (int n = 0; n < nb_multi; ++n)
+        %(omp_parallel)s
+        {
+            double* cdf = (double*)malloc((nb_outcomes > 0 ? nb_outcomes : 1) * sizeof(double));
+            if (cdf == NULL) {
+                %(omp_atomic)s
+                failed = 1;
+            }
+
+            %(omp_for)s
+            for (npy_intp n = 0; n < nb_multi; ++n)
             {
-                int waiting = 1;
                 double cummul = 0.;
-                const dtype_%(unis)s* unis_n = (dtype_%(unis)s*)PyArray_GETPTR1(%(unis)s, c*nb_multi + n);
-                for (int m = 0; m < nb_outcomes; ++m)
+                if (cdf == NULL)
+                    continue;
+                for (npy_intp m = 0; m < nb_outcomes; ++m)
                 {
-                    dtype_%(z)s* z_nm = (dtype_%(z)s*)PyArray_GETPTR2(%(z)s, n,m);
-                    const dtype_%(pvals)s* pvals_nm = (dtype_%(pvals)s*)PyArray_GETPTR2(%(pvals)s, n,m);
-                    cummul += *pvals_nm;
-                    if (c == 0)
+                    cummul += *(dtype_%(pvals)s*)PyArray_GETPTR2(%(pvals)s, n, m);
+                    cdf[m] = cummul;
+                    *(dtype_%(z)s*)PyArray_GETPTR2(%(z)s, n, m) = 0;
+                }
+                for (npy_intp c = 0; c < n_samples; ++c)
+                {
+                    const double unis_n = *(dtype_%(unis)s*)PyArray_GETPTR1(%(unis)s, c * nb_multi + n);
+                    const npy_intp m = aesara_cdf_search(cdf, nb_outcomes, unis_n);
+                    if (m < nb_outcomes)
                     {
-                        if (waiting && (cummul > *unis_n))
-                        {
-                            *z_nm = 1.;
-                            waiting = 0;
-                        }
-                        else
-                        {
-                            // if we re-used old z pointer, we have to clear it out.
-                            *z_nm = 0.;
-                        }
-                    }
-                    else {
-                        if (cummul > *unis_n)
-                        {
-                            *z_nm = *z_nm + 1.;
-                            break;
-                        }
+                        dtype_%(z)s* z_nm = (dtype_%(z)s*)PyArray_GETPTR2(%(z)s, n, m);
+                        *z_nm = *z_nm + 1.;
                     }
                 }
             }
+            free(cdf);
+        }
+        if (failed)
+        {
+            PyErr_NoMemory();
+            %(fail)s;
         }
         } // END NESTED SCOPE
         """
@@ -224,6 +271,11 @@ class ChoiceFromUniform(MultinomialFromUniform):
     Converts samples from a uniform into sample (without replacement) from a
     multinomial.
 
+    Without replacement, the probabilities of the outcomes that remain are
+    kept in a sum tree, which gives each sample and the removal of its
+    outcome in ``O(log(n_outcomes))``, instead of renormalizing the
+    probabilities after each sample.
+
     """
 
     __props__ = (
@@ -236,7 +288,7 @@ class ChoiceFromUniform(MultinomialFromUniform):
         super().__init__(odtype=odtype, *args, **kwargs)
 
     def __setstate__(self, state):
-        self.__dict__.update(state)
+        super().__setstate__(state)
         if "replace" not in state:
             self.replace = False
 
@@ -255,12 +307,59 @@ class ChoiceFromUniform(MultinomialFromUniform):
         return Apply(self, [pvals, unis, as_scalar(n)], [out])
 
     def c_code_cache_version(self):
-        return (1,)
+        return (2, self.openmp, config.openmp_elemwise_minsize)
+
+    def c_support_code(self, **kwargs):
+        return (
+            super().c_support_code(**kwargs)
+            + """
+        #ifndef _AESARA_SUM_TREE_DEFINED
+        #define _AESARA_SUM_TREE_DEFINED
+        // A sum tree over `size` leaves, a power of 2, is stored in
+        // tree[1:2 * size]: the leaves are tree[size:2 * size] and the
+        // node i is the sum of the nodes 2 * i and 2 * i + 1.
+        static void aesara_sum_tree_build(double* tree, npy_intp size)
+        {
+            for (npy_intp i = size - 1; i > 0; --i)
+                tree[i] = tree[2 * i] + tree[2 * i + 1];
+        }
+
+        // Index of the leaf in which the fraction `u` of the total falls.
+        // Subtrees with a null sum are never entered.
+        static npy_intp aesara_sum_tree_search(const double* tree, npy_intp size, double u)
+        {
+            double t = u * tree[1];
+            npy_intp i = 1;
+            while (i < size) {
+                if (t < tree[2 * i] || !(tree[2 * i + 1] > 0)) {
+                    i = 2 * i;
+                }
+                else {
+                    t -= tree[2 * i];
+                    i = 2 * i + 1;
+                }
+            }
+            return i - size;
+        }
+
+        static void aesara_sum_tree_remove(double* tree, npy_intp size, npy_intp m)
+        {
+            npy_intp i = size + m;
+            tree[i] = 0;
+            for (i /= 2; i > 0; i /= 2)
+                tree[i] = tree[2 * i] + tree[2 * i + 1];
+        }
+        #endif
+        """
+        )
 
     def c_code(self, node, name, ins, outs, sub):
         (pvals, unis, n) = ins
         (z,) = outs
         replace = int(self.replace)
+        omp_parallel, omp_for, omp_atomic = self._omp_pragmas(
+            "nb_multi * (nb_outcomes + n_samples)"
+        )
         if self.odtype == "auto":
             t = "NPY_INT64"
         else:
@@ -272,9 +371,6 @@ class ChoiceFromUniform(MultinomialFromUniform):
         fail = sub["fail"]
         return (
             """
-        // create a copy of pvals matrix
-        PyArrayObject* pvals_copy = NULL;
-
         if (PyArray_NDIM(%(pvals)s) != 2)
         {
             PyErr_Format(PyExc_TypeError, "pvals ndim should be 2");
@@ -298,18 +394,6 @@ class ChoiceFromUniform(MultinomialFromUniform):
             %(fail)s;
         }
 
-        pvals_copy = (PyArrayObject*) PyArray_EMPTY(2,
-            PyArray_DIMS(%(pvals)s),
-            PyArray_TYPE(%(pvals)s),
-            0);
-
-        if (!pvals_copy)
-        {
-            PyErr_SetString(PyExc_MemoryError, "failed to alloc pvals_copy");
-            %(fail)s;
-        }
-        PyArray_CopyInto(pvals_copy, %(pvals)s);
-
         if ((NULL == %(z)s)
             || ((PyArray_DIMS(%(z)s))[0] != (PyArray_DIMS(%(pvals)s))[0])
             || ((PyArray_DIMS(%(z)s))[1] != %(n)s)
@@ -332,57 +416,78 @@ class ChoiceFromUniform(MultinomialFromUniform):
 
         { // NESTED SCOPE
 
-        const int nb_multi = PyArray_DIMS(%(pvals)s)[0];
-        const int nb_outcomes = PyArray_DIMS(%(pvals)s)[1];
-        const int n_samples = %(n)s;
+        const npy_intp nb_multi = PyArray_DIMS(%(pvals)s)[0];
+        const npy_intp nb_outcomes = PyArray_DIMS(%(pvals)s)[1];
+        const npy_intp n_samples = %(n)s;
+        npy_intp tree_size = 1;
+        int failed = 0, exhausted = 0;
+
+        while (tree_size < nb_outcomes)
+            tree_size *= 2;
+
+        %(omp_parallel)s
+        {
+            // The CDF of the row with replacement, its sum tree without
+            double* buf = (double*)malloc(
+                (%(replace)s ? (nb_outcomes > 0 ? nb_outcomes : 1) : 2 * tree_size) * sizeof(double));
+            if (buf == NULL) {
+                %(omp_atomic)s
+                failed = 1;
+            }
 
-        //
-        // For each multinomial, loop over each possible outcome,
-        // and set selected pval to 0 after being selected
-        //
-        for (int c = 0; c < n_samples; ++c){
-            for (int n = 0; n < nb_multi; ++n)
+            %(omp_for)s
+            for (npy_intp n = 0; n < nb_multi; ++n)
             {
-                double cummul = 0.;
-                const dtype_%(unis)s* unis_n = (dtype_%(unis)s*)PyArray_GETPTR1(%(unis)s, c*nb_multi + n);
-                dtype_%(z)s* z_nc = (dtype_%(z)s*)PyArray_GETPTR2(%(z)s, n, c);
-                for (int m = 0; m < nb_outcomes; ++m)
+                if (buf == NULL)
+                    continue;
+                if (%(replace)s)
                 {
-                    dtype_%(pvals)s* pvals_nm = (dtype_%(pvals)s*)PyArray_GETPTR2(pvals_copy, n, m);
-                    cummul += *pvals_nm;
-                    if (cummul > *unis_n)
+                    double cummul = 0.;
+                    for (npy_intp m = 0; m < nb_outcomes; ++m)
                     {
-                        *z_nc = m;
-                        // No need to renormalize after the last samples.
-                        if (c == (n_samples - 1))
-                            break;
-                        if (! %(replace)s )
+                        cummul += *(dtype_%(pvals)s*)PyArray_GETPTR2(%(pvals)s, n, m);
+                        buf[m] = cummul;
+                    }
+                    for (npy_intp c = 0; c < n_samples; ++c)
+                    {
+                        const double unis_n = *(dtype_%(unis)s*)PyArray_GETPTR1(%(unis)s, c * nb_multi + n);
+                        const npy_intp m = aesara_cdf_search(buf, nb_outcomes, unis_n);
+                        *(dtype_%(z)s*)PyArray_GETPTR2(%(z)s, n, c) = m < nb_outcomes ? m : -1;
+                    }
+                }
+                else
+                {
+                    for (npy_intp m = 0; m < tree_size; ++m)
+                        buf[tree_size + m] = m < nb_outcomes ?
+                            *(dtype_%(pvals)s*)PyArray_GETPTR2(%(pvals)s, n, m) : 0;
+                    aesara_sum_tree_build(buf, tree_size);
+                    for (npy_intp c = 0; c < n_samples; ++c)
+                    {
+                        const double unis_n = *(dtype_%(unis)s*)PyArray_GETPTR1(%(unis)s, c * nb_multi + n);
+                        npy_intp m;
+                        if (!(buf[1] > 0))
                         {
-                            // renormalize the nth row of pvals, reuse (cummul-*pvals_nm) to initialize the sum
-                            dtype_%(pvals)s sum = cummul - *pvals_nm;
-                            dtype_%(pvals)s* pvals_n = (dtype_%(pvals)s*)PyArray_GETPTR2(pvals_copy, n, m);
-                            *pvals_nm = 0.;
-                            for (int k = m; k < nb_outcomes; ++k)
-                            {
-                                sum = sum + *pvals_n;
-                                pvals_n++;
-                            }
-                            pvals_n = (dtype_%(pvals)s*)PyArray_GETPTR2(pvals_copy, n, 0);
-                            for (int k = 0; k < nb_outcomes; ++k)
-                            {
-                                *pvals_n = *pvals_n / sum;
-                                pvals_n++;
-                            }
+                            %(omp_atomic)s
+                            exhausted = 1;
+                            break;
                         }
-                        break;
+                        m = aesara_sum_tree_search(buf, tree_size, unis_n);
+                        *(dtype_%(z)s*)PyArray_GETPTR2(%(z)s, n, c) = m;
+                        aesara_sum_tree_remove(buf, tree_size, m);
                     }
                 }
             }
+            free(buf);
         }
-
-        // delete pvals_copy
+        if (failed)
+        {
+            PyErr_NoMemory();
+            %(fail)s;
+        }
+        if (exhausted)
         {
-            Py_XDECREF(pvals_copy);
+            PyErr_SetString(PyExc_ValueError, "Fewer non-zero entries in p than size");
+            %(fail)s;
         }
         } // END NESTED SCOPE
         """
@@ -391,8 +496,6 @@ class ChoiceFromUniform(MultinomialFromUniform):
 
     def perform(self, node, ins, outs):
         (pvals, unis, n_samples) = ins
-        # make a copy so we do not overwrite the input
-        pvals = copy.copy(pvals)
         (z,) = outs
 
         if n_samples > pvals.shape[1]:
@@ -419,22 +522,45 @@ class ChoiceFromUniform(MultinomialFromUniform):
         nb_multi = pvals.shape[0]
         nb_outcomes = pvals.shape[1]
 
-        # For each multinomial, loop over each possible outcome,
-        # and set selected pval to 0 after being selected
-        for c in range(n_samples):
+        if self.replace:
             for n in range(nb_multi):
-                cummul = 0
-                unis_n = unis[c * nb_multi + n]
-                for m in range(nb_outcomes):
-                    cummul += pvals[n, m]
-                    if cummul > unis_n:
-                        z[0][n, c] = m
-                        # set to zero and re-normalize so that it's not
-                        # selected again
-                        if not self.replace:
-                            pvals[n, m] = 0.0
-                            pvals[n] /= pvals[n].sum()
-                        break
+                cdf = pvals[n].cumsum(dtype="float64")
+                unis_n = unis[n::nb_multi][:n_samples]
+                m = np.searchsorted(cdf, unis_n, side="right")
+                z[0][n] = np.where(m < nb_outcomes, m, -1)
+            return
+
+        # Sample each row with the sum tree of the C code
+        tree_size = 1
+        while tree_size < nb_outcomes:
+            tree_size *= 2
+        for n in range(nb_multi):
+            tree = np.zeros(2 * tree_size, dtype="float64")
+            tree[tree_size : tree_size + nb_outcomes] = pvals[n]
+            level = tree_size // 2
+            while level > 0:
+                tree[level : 2 * level] = (
+                    tree[2 * level : 4 * level : 2]
+                    + tree[2 * level + 1 : 4 * level : 2]
+                )
+                level //= 2
+            for c in range(n_samples):
+                if not tree[1] > 0:
+                    raise ValueError("Fewer non-zero entries in p than size")
+                t = float(unis[c * nb_multi + n]) * tree[1]
+                i = 1
+                while i < tree_size:
+                    if t < tree[2 * i] or not tree[2 * i + 1] > 0:
+                        i = 2 * i
+                    else:
+                        t -= tree[2 * i]
+                        i = 2 * i + 1
+                z[0][n, c] = i - tree_size
+                tree[i] = 0
+                i //= 2
+                while i > 0:
+                    tree[i] = tree[2 * i] + tree[2 * i + 1]
+                    i //= 2
 
 
 class MultinomialWOReplacementFromUniform(ChoiceFromUniform):
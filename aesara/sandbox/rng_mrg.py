@@ -26,7 +26,7 @@ from aesara.configdefaults import config
 from aesara.gradient import undefined_grad
 from aesara.graph.basic import Apply, Constant, Variable
 from aesara.graph.opt import in2out, local_optimizer
-from aesara.link.c.op import COp, Op
+from aesara.link.c.op import COp, Op, OpenMPOp
 from aesara.link.c.params_type import ParamsType
 from aesara.sandbox import multinomial
 from aesara.scalar import bool as bool_t
@@ -214,10 +214,8 @@ MASK2 = np.int32(65535)  # 2^16 - 1
 MULT2 = np.int32(21069)
 NORM = 4.656612873077392578125e-10  # 1./2^31
 
-# A1p0 = np.asarray([[0, 4194304, 129], [1, 0, 0], [0, 1, 0]],
-#                      dtype='int64')
-# A2p0 = np.asarray([[32768, 0, 32769], [1, 0, 0], [0, 1, 0]],
-#                      dtype='int64')
+A1p0 = np.asarray([[0, 4194304, 129], [1, 0, 0], [0, 1, 0]], dtype="int64")
+A2p0 = np.asarray([[32768, 0, 32769], [1, 0, 0], [0, 1, 0]], dtype="int64")
 
 A1p72 = np.asarray(
     [
@@ -255,6 +253,24 @@ A2p134 = np.asarray(
 np_int32_vals = [np.int32(i) for i in (0, 7, 9, 15, 16, 22, 24)]
 
 
+def matMatModM(A, B, m):
+    """Compute ``A.dot(B) % m`` for the ``int64`` matrices of a MRG component."""
+    return np.sum((A[:, :, None] * B[None, :, :]) % m, 1) % m
+
+
+def matVecsModM(A, S, m):
+    """Compute `matVecModM` for each row of `S`."""
+    return np.int32(np.sum((A[None, :, :] * np.int64(S)[:, None, :]) % m, 2) % m)
+
+
+def jump_matrices(A, m, n):
+    """Return ``[A**(2**j) % m for j in range(n)]``."""
+    rval = [A]
+    for j in range(1, n):
+        rval.append(matMatModM(rval[-1], rval[-1], m))
+    return rval
+
+
 def ff_2p134(rstate):
     # TODO : need description for method, parameter and return
     return multMatVect(rstate, A1p134, M1, A2p134, M2)
@@ -362,10 +378,14 @@ class mrg_uniform_base(Op):
         return [None for i in eval_points]
 
 
-class mrg_uniform(COp, mrg_uniform_base):
+class mrg_uniform(OpenMPOp, mrg_uniform_base):
     # CPU VERSION
     _f16_ok = True
 
+    def __init__(self, output_type, inplace=False, openmp=None):
+        mrg_uniform_base.__init__(self, output_type, inplace=inplace)
+        OpenMPOp.__init__(self, openmp=openmp)
+
     def make_node(self, rstate, size):
         # error checking slightly redundant here, since
         # this op should not be called directly.
@@ -439,84 +459,154 @@ class mrg_uniform(COp, mrg_uniform_base):
         o_sample[0] = node.outputs[1].type.filter(rval.reshape(size))
 
     def c_support_code(self, **kwargs):
-        return "\n".join(
-            """
-        void cpu_rng_mrg_uniform_%(dtype)s(PyArrayObject* o_sample, PyArrayObject* o_rstate,
-                                           npy_int64 n_elements, int n_streams) {
-            const npy_int32 i0 = 0;
-            const npy_int32 i7 = 7;
-            const npy_int32 i9 = 9;
-            const npy_int32 i15 = 15;
-            const npy_int32 i16 = 16;
-            const npy_int32 i22 = 22;
-            const npy_int32 i24 = 24;
-
-            const npy_int32 M1 = 2147483647;      //2^31 - 1
-            const npy_int32 M2 = 2147462579;      //2^31 - 21069
-            const npy_int32 MASK12 = 511;       //2^9 - 1
-            const npy_int32 MASK13 = 16777215;  //2^24 - 1
-            const npy_int32 MASK2 = 65535;      //2^16 - 1
-            const npy_int32 MULT2 = 21069;
-
-            %(dtype)s* sample_data = (%(dtype)s *) PyArray_DATA(o_sample);
-            npy_int32* state_data = (npy_int32 *) PyArray_DATA(o_rstate);
-            for (int i = 0; i < n_elements; ++i)
-            {
-                npy_int32 * state_data_i = state_data + (i%%n_streams)*6;
-                npy_int32 y1, y2, x11, x12, x13, x21, x22, x23;
-
-                x11 = state_data_i[0];
-                x12 = state_data_i[1];
-                x13 = state_data_i[2];
-                x21 = state_data_i[3];
-                x22 = state_data_i[4];
-                x23 = state_data_i[5];
-
-                y1 = ((x12 & MASK12) << i22) + (x12 >> i9) + ((x13 & MASK13) << i7) + (x13 >> i24);
-                if ((y1 < 0 || y1 >= M1))     //must also check overflow
-                    y1 -= M1;
-                y1 += x13;
-                if ((y1 < 0 or y1 >= M1))
-                    y1 -= M1;
-                x13 = x12;
-                x12 = x11;
-                x11 = y1;
-
-                y1 = ((x21 & MASK2) << i15) + (MULT2 * (x21 >> i16));
-                if (y1 < 0 || y1 >= M2)
-                    y1 -= M2;
-                y2 = ((x23 & MASK2) << i15) + (MULT2 * (x23 >> i16));
-                if (y2 < 0 || y2 >= M2)
-                    y2 -= M2;
-                y2 += x23;
-                if (y2 < 0 || y2 >= M2)
-                    y2 -= M2;
-                y2 += y1;
-                if (y2 < 0 or y2 >= M2)
-                    y2 -= M2;
+        def c_matrices(name, matrices):
+            rows = ",\n".join(
+                "{%s}" % ", ".join(f"{int(v)}LL" for v in A.flatten()) for A in matrices
+            )
+            return f"static const npy_int64 {name}[31][9] = {{\n{rows}\n}};"
+
+        # `A**(2**j)` for each component, to jump a stream ahead by up to
+        # `M1` steps, i.e. the largest number of samples of a draw.
+        jumps = "\n".join(
+            [
+                c_matrices("aesara_mrg_jump1", jump_matrices(A1p0, M1, 31)),
+                c_matrices("aesara_mrg_jump2", jump_matrices(A2p0, M2, 31)),
+            ]
+        )
+        common = """
+        #define AESARA_MRG_LANES 8
 
-                x23 = x22;
-                x22 = x21;
-                x21 = y2;
+        %(jumps)s
 
-                if (x11 <= x21) {
-                    assert((x11 - x21 + M1) <= M1);
-                    sample_data[i] = (x11 - x21 + M1) * %(NORM)s;
+        // Advance the state `x` of a MRG31k3p stream by `k` steps.
+        static void aesara_mrg_jump(npy_int32* x, npy_int64 k)
+        {
+            for (int j = 0; k > 0; ++j, k >>= 1) {
+                npy_int64 y[6];
+                if (!(k & 1))
+                    continue;
+                for (int r = 0; r < 3; ++r) {
+                    y[r] = 0;
+                    y[r + 3] = 0;
+                    for (int c = 0; c < 3; ++c) {
+                        y[r] += (aesara_mrg_jump1[j][3 * r + c] * x[c]) %% 2147483647LL;
+                        y[r + 3] += (aesara_mrg_jump2[j][3 * r + c] * x[c + 3]) %% 2147462579LL;
+                    }
                 }
-                else
-                {
-                    assert(x11 - x21 <= M1);
-                    sample_data[i] = (x11 - x21) * %(NORM)s;
+                for (int r = 0; r < 3; ++r) {
+                    x[r] = (npy_int32)(y[r] %% 2147483647LL);
+                    x[r + 3] = (npy_int32)(y[r + 3] %% 2147462579LL);
                 }
+            }
+        }
 
-                state_data_i[0]= x11;
-                state_data_i[1]= x12;
-                state_data_i[2]= x13;
-                state_data_i[3]= x21;
-                state_data_i[4]= x22;
-                state_data_i[5]= x23;
+        // One step of AESARA_MRG_LANES streams, whose states are stored as
+        // x[component][lane].  The unsigned arithmetic wraps like the signed
+        // one of the reference implementation, and the loop has no branches
+        // so that the compiler can vectorise it over the lanes.
+        static inline void aesara_mrg_step(npy_uint32 (*x)[AESARA_MRG_LANES], npy_uint32* z)
+        {
+            const npy_uint32 M1 = 2147483647u;
+            const npy_uint32 M2 = 2147462579u;
+            for (int l = 0; l < AESARA_MRG_LANES; ++l) {
+                npy_uint32 y1, y2;
+
+                y1 = ((x[1][l] & 511u) << 22) + (x[1][l] >> 9)
+                     + ((x[2][l] & 16777215u) << 7) + (x[2][l] >> 24);
+                y1 = y1 >= M1 ? y1 - M1 : y1;
+                y1 += x[2][l];
+                y1 = y1 >= M1 ? y1 - M1 : y1;
+                x[2][l] = x[1][l];
+                x[1][l] = x[0][l];
+                x[0][l] = y1;
+
+                y1 = ((x[3][l] & 65535u) << 15) + 21069u * (x[3][l] >> 16);
+                y1 = y1 >= M2 ? y1 - M2 : y1;
+                y2 = ((x[5][l] & 65535u) << 15) + 21069u * (x[5][l] >> 16);
+                y2 = y2 >= M2 ? y2 - M2 : y2;
+                y2 += x[5][l];
+                y2 = y2 >= M2 ? y2 - M2 : y2;
+                y2 += y1;
+                y2 = y2 >= M2 ? y2 - M2 : y2;
+                x[5][l] = x[4][l];
+                x[4][l] = x[3][l];
+                x[3][l] = y2;
+
+                z[l] = x[0][l] <= x[3][l] ? x[0][l] - x[3][l] + M1 : x[0][l] - x[3][l];
             }
         }
+        """ % dict(
+            jumps=jumps
+        )
+        kernels = "\n".join(
+            """
+        // Sample `i` of a draw is the sample `i / n_streams` of the stream
+        // `i %% n_streams`.  The work is split in items, which are the
+        // samples [k0, k1) of AESARA_MRG_LANES consecutive streams.  An item
+        // that doesn't start at the first sample of its streams jumps ahead
+        // from their initial states `init`, and the last item of a group
+        // of streams writes their final state in `state`.
+        void cpu_rng_mrg_uniform_%(dtype)s(%(dtype)s* sample_data,
+                                           const npy_int32* init,
+                                           npy_int32* state,
+                                           npy_int64 n_elements,
+                                           npy_int64 n_streams,
+                                           npy_int64 n_chunks,
+                                           npy_int64 item) {
+            const npy_int64 n_active = n_streams < n_elements ? n_streams : n_elements;
+            const npy_int64 n_draws = n_elements / n_streams;
+            const npy_int64 rem = n_elements %% n_streams;
+            const npy_int64 chunk = item %% n_chunks;
+            const npy_int64 s0 = (item / n_chunks) * AESARA_MRG_LANES;
+            const npy_int64 n_lanes = (n_active - s0 < AESARA_MRG_LANES ?
+                                       n_active - s0 : AESARA_MRG_LANES);
+            const npy_int64 k0 = n_draws * chunk / n_chunks;
+            const npy_int64 k1 = n_draws * (chunk + 1) / n_chunks;
+            npy_uint32 x[6][AESARA_MRG_LANES];
+            npy_uint32 z[AESARA_MRG_LANES];
+
+            for (int l = 0; l < AESARA_MRG_LANES; ++l) {
+                npy_int32 xl[6] = {1, 1, 1, 1, 1, 1};
+                if (l < n_lanes) {
+                    for (int c = 0; c < 6; ++c)
+                        xl[c] = init[(s0 + l) * 6 + c];
+                    if (k0 > 0)
+                        aesara_mrg_jump(xl, k0);
+                }
+                for (int c = 0; c < 6; ++c)
+                    x[c][l] = (npy_uint32)xl[c];
+            }
+
+            for (npy_int64 k = k0; k < k1; ++k) {
+                %(dtype)s* out = sample_data + k * n_streams + s0;
+                aesara_mrg_step(x, z);
+                for (int l = 0; l < n_lanes; ++l)
+                    out[l] = (npy_int32)z[l] * %(NORM)s;
+            }
+
+            if (chunk != n_chunks - 1)
+                return;
+
+            // The first `rem` streams have one more sample
+            if (s0 < rem) {
+                npy_uint32 prev[6][AESARA_MRG_LANES];
+                memcpy(prev, x, sizeof(x));
+                aesara_mrg_step(x, z);
+                for (int l = 0; l < n_lanes; ++l) {
+                    if (s0 + l < rem) {
+                        sample_data[n_draws * n_streams + s0 + l] = (npy_int32)z[l] * %(NORM)s;
+                    }
+                    else {
+                        for (int c = 0; c < 6; ++c)
+                            x[c][l] = prev[c][l];
+                    }
+                }
+            }
+
+            for (int l = 0; l < n_lanes; ++l)
+                for (int c = 0; c < 6; ++c)
+                    state[(s0 + l) * 6 + c] = (npy_int32)x[c][l];
+        }
         """
             % dict(dtype=dtype, NORM=NORM)
             for dtype, NORM in (
@@ -524,6 +614,7 @@ class mrg_uniform(COp, mrg_uniform_base):
                 ("npy_float64", "4.656612873077392578125e-10"),
             )
         )
+        return common + kernels
 
     def c_code(self, node, name, inp, out, sub):
         # If we try to use the C code here with something else than a
@@ -532,6 +623,31 @@ class mrg_uniform(COp, mrg_uniform_base):
         if self.output_type.dtype == "float16":
             # C code is not tested, fall back to Python
             raise NotImplementedError()
+        if self.openmp:
+            omp = "#pragma omp parallel for schedule(static) if(n_elements >= %d)" % (
+                config.openmp_elemwise_minsize
+            )
+            # Split the samples of each stream when there are not enough
+            # streams to give a few groups of streams to each thread.
+            n_chunks = """
+            if (n_elements >= %d) {
+                const npy_int64 n_blocks = (n_active + AESARA_MRG_LANES - 1) / AESARA_MRG_LANES;
+                const npy_int64 n_wanted = 4 * omp_get_max_threads();
+                if (n_blocks < n_wanted) {
+                    n_chunks = (n_wanted + n_blocks - 1) / n_blocks;
+                    // Jumping ahead costs a few hundred samples
+                    if (n_chunks > n_elements / n_streams / 1024)
+                        n_chunks = n_elements / n_streams / 1024;
+                    if (n_chunks < 1)
+                        n_chunks = 1;
+                }
+            }
+            """ % (
+                config.openmp_elemwise_minsize
+            )
+        else:
+            omp = ""
+            n_chunks = ""
         return """
         //////// <code generated by mrg_uniform>
         npy_int64 odims_i;
@@ -544,20 +660,7 @@ class mrg_uniform(COp, mrg_uniform_base):
                                     (NPY_ARRAY_C_CONTIGUOUS|NPY_ARRAY_ALIGNED) :
                                     (NPY_ARRAY_ENSURECOPY|NPY_ARRAY_C_CONTIGUOUS|NPY_ARRAY_ALIGNED);
 
-        const npy_int32 i0 = 0;
-        const npy_int32 i7 = 7;
-        const npy_int32 i9 = 9;
-        const npy_int32 i15 = 15;
-        const npy_int32 i16 = 16;
-        const npy_int32 i22 = 22;
-        const npy_int32 i24 = 24;
-
         const npy_int32 M1 = 2147483647;      //2^31 - 1
-        const npy_int32 M2 = 2147462579;      //2^31 - 21069
-        const npy_int32 MASK12 = 511;       //2^9 - 1
-        const npy_int32 MASK13 = 16777215;  //2^24 - 1
-        const npy_int32 MASK2 = 65535;      //2^16 - 1
-        const npy_int32 MULT2 = 21069;
 
         // We have to read size[i] as an int64, but odims has to be intp*
         // for NumPy on 32-bit platforms.
@@ -585,10 +688,7 @@ class mrg_uniform(COp, mrg_uniform_base):
             odims[i] = odims_i;
             n_elements *= odims_i;
             must_alloc_sample = must_alloc_sample || (PyArray_DIMS(%(o_sample)s)[i] != odims[i]);
-            //fprintf(stderr, "size %%i %%i\\n", i, (int)odims[i]);
-            //printf("%%li", n_elements);
         }
-        //fprintf(stderr, "n_elements %%lld\\n", (long long)n_elements);
         if (n_elements > M1)
         {
             PyErr_SetString(
@@ -628,10 +728,39 @@ class mrg_uniform(COp, mrg_uniform_base):
         }
         n_streams = PyArray_DIMS(%(o_rstate)s)[0];
 
-        if (%(params)s->otype_is_float32) {
-            cpu_rng_mrg_uniform_npy_float32(%(o_sample)s, %(o_rstate)s, n_elements, n_streams);
-        } else {
-            cpu_rng_mrg_uniform_npy_float64(%(o_sample)s, %(o_rstate)s, n_elements, n_streams);
+        if (n_elements > 0 && n_streams > 0)
+        {
+            const npy_int64 n_active = n_streams < n_elements ? n_streams : n_elements;
+            npy_int64 n_chunks = 1;
+            npy_int32* state = (npy_int32*)PyArray_DATA(%(o_rstate)s);
+            npy_int32* init = state;
+            %(n_chunks)s
+            if (n_chunks > 1) {
+                // Some items read the initial states while others write
+                // the final ones.
+                init = (npy_int32*)malloc(n_active * 6 * sizeof(npy_int32));
+                if (init == NULL) {
+                    PyErr_NoMemory();
+                    %(fail)s
+                }
+                memcpy(init, state, n_active * 6 * sizeof(npy_int32));
+            }
+            const npy_int64 n_items = n_chunks * ((n_active + AESARA_MRG_LANES - 1) / AESARA_MRG_LANES);
+            if (%(params)s->otype_is_float32) {
+                npy_float32* sample_data = (npy_float32*)PyArray_DATA(%(o_sample)s);
+                %(omp)s
+                for (npy_int64 item = 0; item < n_items; ++item)
+                    cpu_rng_mrg_uniform_npy_float32(sample_data, init, state, n_elements,
+                                                    n_streams, n_chunks, item);
+            } else {
+                npy_float64* sample_data = (npy_float64*)PyArray_DATA(%(o_sample)s);
+                %(omp)s
+                for (npy_int64 item = 0; item < n_items; ++item)
+                    cpu_rng_mrg_uniform_npy_float64(sample_data, init, state, n_elements,
+                                                    n_streams, n_chunks, item);
+            }
+            if (init != state)
+                free(init);
         }
 
         free(odims);
@@ -642,6 +771,8 @@ class mrg_uniform(COp, mrg_uniform_base):
             o_rstate=out[0],
             o_sample=out[1],
             params=sub["params"],
+            omp=omp,
+            n_chunks=n_chunks,
             just_fail=sub["fail"],
             fail="""
                    {
@@ -653,7 +784,7 @@ class mrg_uniform(COp, mrg_uniform_base):
         )
 
     def c_code_cache_version(self):
-        return (10,)
+        return (11, self.openmp, config.openmp_elemwise_minsize)
 
 
 def guess_n_streams(size, warn=False):
@@ -812,24 +943,16 @@ class MRG_RandomStream:
         rval = np.zeros((n_streams, 6), dtype="int32")
         rval[0] = self.rstate
 
-        # If multMatVect.dot_modulo isn't compiled, compile it.
-        if multMatVect.dot_modulo is None:
-            multMatVect(rval[0], A1p72, M1, A2p72, M2)
-
-        # This way of calling the Aesara fct is done to bypass Aesara overhead.
-        f = multMatVect.dot_modulo
-        f.input_storage[0].storage[0] = A1p72
-        f.input_storage[2].storage[0] = M1
-        f.input_storage[3].storage[0] = A2p72
-        f.input_storage[5].storage[0] = M2
-        for i in range(1, n_streams):
-            # Inline the following call to bypass Python overhead
-            # rval[i] = ff_2p72(rval[i - 1])
-            v = rval[i - 1]
-            f.input_storage[1].storage[0] = v[:3]
-            f.input_storage[4].storage[0] = v[3:]
-            f.fn()
-            rval[i] = f.output_storage[0].storage[0]
+        # Fill the states by doubling: the streams [n, 2 * n) are the
+        # streams [0, n) advanced by n * 2**72 samples.
+        A1, A2 = A1p72, A2p72
+        n = 1
+        while n < n_streams:
+            m = min(n, n_streams - n)
+            rval[n : n + m, :3] = matVecsModM(A1, rval[:m, :3], M1)
+            rval[n : n + m, 3:] = matVecsModM(A2, rval[:m, 3:], M2)
+            A1, A2 = matMatModM(A1, A1, M1), matMatModM(A2, A2, M2)
+            n += m
 
         if inc_rstate:
             self.inc_rstate()
@@ -1349,7 +1472,8 @@ def mrg_random_make_inplace(fgraph, node):
     op = node.op
     if isinstance(op, mrg_uniform_base) and not op.inplace:
         # op might be gpu version
-        new_op = op.__class__(op.output_type, inplace=True)
+        kwargs = {"openmp": op.openmp} if isinstance(op, OpenMPOp) else {}
+        new_op = op.__class__(op.output_type, inplace=True, **kwargs)
         return new_op.make_node(*node.inputs).outputs
     return False
 
@@ -14,8 +14,14 @@
   Modification by M. Domenzain:
             2018.10.11 copied unitqtlQ and unitqtlP from normal.c
             2018.10.11 removed all unused code
+  Modification for Aesara:
+            2026.10.17 added an include guard so that the file can be
+                       combined with other support code
 
 ----------------------------------------------------------------------*/
+#ifndef _AESARA_GAMMA_C
+#define _AESARA_GAMMA_C
+
 //For GPU support
 #ifdef __CUDACC__
 #define DEVICE __device__
@@ -379,3 +385,5 @@ DEVICE double GammaqtlQ (double prob, double k, double theta)
   if (fabs(dp) > EPS_QTL *prob) return -1;
   return x *theta;              /* check for convergence and */
 }  /* GammaqtlQ() */            /* return the computed quantile */
+
+#endif
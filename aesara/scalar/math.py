@@ -13,6 +13,7 @@ import scipy.stats
 
 from aesara.configdefaults import config
 from aesara.gradient import grad_not_implemented
+from aesara.graph.utils import MethodNotDefined
 from aesara.scalar.basic import (
     BinaryScalarOp,
     ScalarOp,
@@ -35,6 +36,38 @@ from aesara.scalar.basic import (
 )
 
 
+def _special_c_support_code():
+    with open(os.path.join(os.path.dirname(__file__), "c_code", "special.c")) as f:
+        return f.read()
+
+
+def _special_c_code_contiguous(fct, node, x, z):
+    """Apply one of the array functions of ``special.c`` to contiguous data.
+
+    The elements go through small ``double`` buffers, which converts the
+    dtypes and lets `z` alias `x` for the inplace versions of the ops.
+
+    """
+    if "complex" in node.inputs[0].dtype or node.outputs[0].dtype == "float16":
+        raise MethodNotDefined()
+    return f"""
+{{
+        const npy_intp n = PyArray_SIZE({z});
+        const dtype_{x} * x = (dtype_{x}*) PyArray_DATA({x});
+        dtype_{z} * z = (dtype_{z}*) PyArray_DATA({z});
+        double xb[256], zb[256];
+        for (npy_intp b = 0; b < n; b += 256) {{
+            const npy_intp m = n - b < 256 ? n - b : 256;
+            for (npy_intp i = 0; i < m; i++)
+                xb[i] = (double) x[b + i];
+            {fct}(xb, zb, m);
+            for (npy_intp i = 0; i < m; i++)
+                z[b + i] = (dtype_{z}) zb[i];
+        }}
+}}
+        """
+
+
 class Erf(UnaryScalarOp):
     nfunc_spec = ("scipy.special.erf", 1, 1)
 
@@ -173,12 +206,8 @@ class Erfinv(UnaryScalarOp):
     """
     Implements the inverse error function.
 
-    Notes
-    -----
-    This op can still be executed on GPU, despite not having c_code. When
-    running on GPU, an optimization will replace it with a GPU version.
-
-    (TODO) Find a C implementation of erfinv for CPU.
+    The C implementation refines a single precision approximation with
+    Halley's method and is accurate to 2 ulp (see ``c_code/special.c``).
     """
 
     nfunc_spec = ("scipy.special.erfinv", 1, 1)
@@ -202,14 +231,23 @@ class Erfinv(UnaryScalarOp):
         )
         return (gz * cst * exp(erfinv(x) ** 2),)
 
+    def c_support_code(self, **kwargs):
+        return _special_c_support_code()
+
     def c_code(self, node, name, inp, out, sub):
-        # TODO: erfinv() is not provided by the C standard library
-        # x, = inp
-        # z, = out
-        # if node.inputs[0].type in complex_types:
-        #     raise NotImplementedError('type not supported', type)
-        # return "%(z)s = erfinv(%(x)s);" % locals()
-        raise NotImplementedError()
+        (x,) = inp
+        (z,) = out
+        if node.inputs[0].type in complex_types:
+            raise NotImplementedError("type not supported", type)
+        dtype = node.outputs[0].type.dtype_specs()[1]
+        return f"{z} = ({dtype}) aesara_erfinv({x});"
+
+    def c_code_cache_version(self):
+        v = super().c_code_cache_version()
+        if v:
+            return (1,) + v
+        else:
+            return v
 
 
 erfinv = Erfinv(upgrade_to_float_no_complex, name="erfinv")
@@ -237,14 +275,23 @@ class Erfcinv(UnaryScalarOp):
         )
         return (-gz * cst * exp(erfcinv(x) ** 2),)
 
+    def c_support_code(self, **kwargs):
+        return _special_c_support_code()
+
     def c_code(self, node, name, inp, out, sub):
-        # TODO: erfcinv() is not provided by the C standard library
-        # x, = inp
-        # z, = out
-        # if node.inputs[0].type in complex_types:
-        #     raise NotImplementedError('type not supported', type)
-        # return "%(z)s = erfcinv(%(x)s);" % locals()
-        raise NotImplementedError()
+        (x,) = inp
+        (z,) = out
+        if node.inputs[0].type in complex_types:
+            raise NotImplementedError("type not supported", type)
+        dtype = node.outputs[0].type.dtype_specs()[1]
+        return f"{z} = ({dtype}) aesara_erfcinv({x});"
+
+    def c_code_cache_version(self):
+        v = super().c_code_cache_version()
+        if v:
+            return (1,) + v
+        else:
+            return v
 
 
 erfcinv = Erfcinv(upgrade_to_float_no_complex, name="erfcinv")
@@ -288,6 +335,9 @@ class GammaLn(UnaryScalarOp):
     """
     Log gamma function.
 
+    On contiguous arrays the C implementation uses a branch-free kernel
+    that the compiler vectorises (see ``c_code/special.c``).
+
     """
 
     nfunc_spec = ("scipy.special.gammaln", 1, 1)
@@ -324,6 +374,21 @@ class GammaLn(UnaryScalarOp):
         cast = node.outputs[0].type.dtype_specs()[1]
         return f"""{z} = lgamma(({cast}){x});"""
 
+    def c_support_code(self, **kwargs):
+        return _special_c_support_code()
+
+    def c_code_contiguous(self, node, name, inputs, outputs, sub):
+        (x,) = inputs
+        (z,) = outputs
+        return _special_c_code_contiguous("aesara_vlgamma", node, x, z)
+
+    def c_code_cache_version(self):
+        v = super().c_code_cache_version()
+        if v:
+            return (1,) + v
+        else:
+            return v
+
 
 gammaln = GammaLn(upgrade_to_float, name="gammaln")
 
@@ -332,6 +397,9 @@ class Psi(UnaryScalarOp):
     """
     Derivative of log gamma function.
 
+    On contiguous arrays the C implementation uses a branch-free kernel
+    that the compiler vectorises (see ``c_code/special.c``).
+
     """
 
     nfunc_spec = ("scipy.special.psi", 1, 1)
@@ -357,66 +425,28 @@ class Psi(UnaryScalarOp):
         return [gz * tri_gamma(x)]
 
     def c_support_code(self, **kwargs):
-        return """
-            // For GPU support
-            #ifdef WITHIN_KERNEL
-            #define DEVICE WITHIN_KERNEL
-            #else
-            #define DEVICE
-            #endif
-
-            #ifndef ga_double
-            #define ga_double double
-            #endif
-
-            #ifndef _PSIFUNCDEFINED
-            #define _PSIFUNCDEFINED
-            DEVICE double _psi(ga_double x) {
-
-            /*taken from
-            Bernardo, J. M. (1976). Algorithm AS 103:
-            Psi (Digamma) Function. Applied Statistics. 25 (3), 315-317.
-            http://www.uv.es/~bernardo/1976AppStatist.pdf */
-
-            ga_double y, R, psi_ = 0;
-            ga_double S  = 1.0e-5;
-            ga_double C = 8.5;
-            ga_double S3 = 8.333333333e-2;
-            ga_double S4 = 8.333333333e-3;
-            ga_double S5 = 3.968253968e-3;
-            ga_double D1 = -0.5772156649;
-
-            y = x;
-
-            if (y <= 0.0)
-               return psi_;
-
-            if (y <= S)
-                return D1 - 1.0/y;
-
-            while (y < C) {
-                psi_ = psi_ - 1.0 / y;
-                y = y + 1;
-            }
-
-            R = 1.0 / y;
-            psi_ = psi_ + log(y) - .5 * R ;
-            R= R*R;
-            psi_ = psi_ - R * (S3 - R * (S4 - R * S5));
-
-            return psi_;
-            }
-            #endif
-            """
+        return _special_c_support_code()
 
     def c_code(self, node, name, inp, out, sub):
         (x,) = inp
         (z,) = out
         if node.inputs[0].type in float_types:
             return f"""{z} =
-                _psi({x});"""
+                aesara_digamma({x});"""
         raise NotImplementedError("only floating point is implemented")
 
+    def c_code_contiguous(self, node, name, inputs, outputs, sub):
+        (x,) = inputs
+        (z,) = outputs
+        return _special_c_code_contiguous("aesara_vdigamma", node, x, z)
+
+    def c_code_cache_version(self):
+        v = super().c_code_cache_version()
+        if v:
+            return (1,) + v
+        else:
+            return v
+
 
 psi = Psi(upgrade_to_float, name="psi")
 
@@ -645,6 +675,116 @@ class GammaIncC(BinaryScalarOp):
 gammaincc = GammaIncC(upgrade_to_float, name="gammaincc")
 
 
+_gammainc_der_c_code = """
+#ifndef _GAMMAINCDERDEFINED
+#define _GAMMAINCDERDEFINED
+
+DEVICE double _gammaincc_der (double k, double x);
+
+/* Ports of `GammaIncDer.impl` and `GammaIncCDer.st_impl`, which return
+   NaN where those warn.  The terms of the series of the lower gamma
+   function are updated with recurrences rather than recomputed with
+   exp, lgamma and digamma. */
+DEVICE double _gammainc_der (double k, double x)
+{
+  const double precision = 1e-10;
+  const int max_iters = 100000;
+  double sqrt_exp, log_x, term0, term, psi, sum_a, sum_b;
+  int n;
+
+  if (x == 0)
+    return 0;
+
+  sqrt_exp = -756 - x * x + 60 * x;
+  if ((k < 0.8 && x > 15) || (k < 12 && x > 30)
+      || (sqrt_exp > 0 && k < sqrt(sqrt_exp)))
+    return -_gammaincc_der(k, x);
+
+  log_x = log(x);
+  /* term = x^(k+n) / Gamma(k+n+1), psi = digamma(k+n+1) */
+  term0 = exp(k * log_x - lgamma(k + 1));
+
+  sum_a = 0;
+  term = term0;
+  for (n = 0; n <= max_iters; n++) {
+    sum_a += term;
+    if (term <= precision)
+      break;
+    term *= x / (k + n + 1);
+  }
+  if (n >= max_iters)
+    return NAN;
+
+  sum_b = 0;
+  term = term0;
+  psi = aesara_digamma(k + 1);
+  for (n = 0; n <= max_iters; n++) {
+    sum_b += term * psi;
+    /* Require at least two iterations */
+    if (term * psi <= precision && n >= 1)
+      return exp(-x) * (log_x * sum_a - sum_b);
+    term *= x / (k + n + 1);
+    psi += 1 / (k + n + 1);
+  }
+  return NAN;
+}
+
+DEVICE double _gammaincc_der (double k, double x)
+{
+  const double gamma_k = tgamma(k);
+  const double digamma_k = aesara_digamma(k);
+  const double log_x = log(x);
+  int n;
+
+  if (x >= k && x >= 8) {
+    /* asymptotic expansion http://dlmf.nist.gov/8.11#E2 */
+    double S = 0;
+    double k_minus_one_minus_n = k - 1;
+    double fac = k_minus_one_minus_n;
+    double dfac = 1;
+    double xpow = x;
+    double delta = dfac / xpow;
+
+    for (n = 1; n < 10; n++) {
+      k_minus_one_minus_n -= 1;
+      S += delta;
+      xpow *= x;
+      dfac = k_minus_one_minus_n * dfac + fac;
+      fac *= k_minus_one_minus_n;
+      delta = dfac / xpow;
+      if (isinf(delta))
+        return NAN;
+    }
+    return GammaQ(k, x) * (log_x - digamma_k)
+           + exp(-x + (k - 1) * log_x) * S / gamma_k;
+  } else {
+    /* gradient of series expansion http://dlmf.nist.gov/8.7#E3 */
+    const double log_precision = log(1e-6);
+    const int max_iters = 100000;
+    double S = 0;
+    double log_s = 0.0;
+    int s_sign = 1;
+    double log_delta = log_s - 2 * log(k);
+
+    for (n = 1; n <= max_iters; n++) {
+      S += s_sign > 0 ? exp(log_delta) : -exp(log_delta);
+      s_sign = -s_sign;
+      log_s += log_x - log((double) n);
+      log_delta = log_s - 2 * log(n + k);
+      if (isinf(log_delta))
+        return NAN;
+      if (log_delta <= log_precision)
+        return GammaP(k, x) * (digamma_k - log_x)
+               + exp(k * log_x) * S / gamma_k;
+    }
+    return NAN;
+  }
+}
+
+#endif
+"""
+
+
 class GammaIncDer(BinaryScalarOp):
     """
     Gradient of the the regularized lower gamma function (P) wrt to the first
@@ -714,8 +854,18 @@ class GammaIncDer(BinaryScalarOp):
         )
         return np.nan
 
-    def c_code(self, *args, **kwargs):
-        raise NotImplementedError()
+    def c_support_code(self, **kwargs):
+        with open(os.path.join(os.path.dirname(__file__), "c_code", "gamma.c")) as f:
+            raw = f.read()
+        return raw + _special_c_support_code() + _gammainc_der_c_code
+
+    def c_code(self, node, name, inp, out, sub):
+        k, x = inp
+        (z,) = out
+        if node.inputs[0].type in float_types:
+            dtype = "npy_" + node.outputs[0].dtype
+            return f"{z} = ({dtype}) _gammainc_der({k}, {x});"
+        raise NotImplementedError("only floatingpoint is implemented")
 
 
 gammainc_der = GammaIncDer(upgrade_to_float, name="gammainc_der")
@@ -797,8 +947,18 @@ class GammaIncCDer(BinaryScalarOp):
     def impl(self, k, x):
         return self.st_impl(k, x)
 
-    def c_code(self, *args, **kwargs):
-        raise NotImplementedError()
+    def c_support_code(self, **kwargs):
+        with open(os.path.join(os.path.dirname(__file__), "c_code", "gamma.c")) as f:
+            raw = f.read()
+        return raw + _special_c_support_code() + _gammainc_der_c_code
+
+    def c_code(self, node, name, inp, out, sub):
+        k, x = inp
+        (z,) = out
+        if node.inputs[0].type in float_types:
+            dtype = "npy_" + node.outputs[0].dtype
+            return f"{z} = ({dtype}) _gammaincc_der({k}, {x});"
+        raise NotImplementedError("only floatingpoint is implemented")
 
 
 gammaincc_der = GammaIncCDer(upgrade_to_float, name="gammaincc_der")
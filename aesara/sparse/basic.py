@@ -549,7 +549,7 @@ discrete_dtypes = int_dtypes + uint_dtypes
 
 
 # CONSTRUCTION
-class CSMProperties(Op):
+class CSMProperties(COp):
     # See doc in instance of this Op or function after this class definition.
     # NOTE
     # We won't implement infer_shape for this op now. This will
@@ -595,6 +595,46 @@ class CSMProperties(Op):
         out[2][0] = _asarray(csm.indptr, dtype="int32")
         out[3][0] = _asarray(csm.shape, dtype="int32")
 
+    def c_code(self, node, name, inputs, outputs, sub):
+        (csm,) = inputs
+        data, indices, indptr, shape = outputs
+        fail = sub["fail"]
+        typenum = node.outputs[0].type.dtype_specs()[2]
+        return f"""
+        {{
+            // The arrays of the matrix are returned as they are, unless
+            // they need a cast
+            const char* names[3] = {{"data", "indices", "indptr"}};
+            PyArrayObject** outs[3] = {{&{data}, &{indices}, &{indptr}}};
+            int typenums[3] = {{{typenum}, NPY_INT32, NPY_INT32}};
+            for (int i = 0; i < 3; ++i)
+            {{
+                PyObject* attr = PyObject_GetAttrString({csm}, names[i]);
+                Py_XDECREF(*outs[i]);
+                *outs[i] = attr ? (PyArrayObject*)PyArray_FROMANY(
+                    attr, typenums[i], 1, 1, NPY_ARRAY_ALIGNED) : NULL;
+                Py_XDECREF(attr);
+                if (!*outs[i]) {{{fail};}}
+            }}
+
+            PyObject* shape = PyObject_GetAttrString({csm}, "shape");
+            if (!shape) {{{fail};}}
+            Py_ssize_t M = PyLong_AsSsize_t(PyTuple_GetItem(shape, 0));
+            Py_ssize_t N = PyLong_AsSsize_t(PyTuple_GetItem(shape, 1));
+            Py_DECREF(shape);
+            if (PyErr_Occurred()) {{{fail};}}
+            Py_XDECREF({shape});
+            npy_intp dims[1] = {{2}};
+            {shape} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            if (!{shape}) {{{fail};}}
+            ((npy_int32*)PyArray_DATA({shape}))[0] = (npy_int32)M;
+            ((npy_int32*)PyArray_DATA({shape}))[1] = (npy_int32)N;
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (1,)
+
     def grad(self, inputs, g):
 
         # g[1:] is all integers, so their Jacobian in this op
@@ -669,7 +709,51 @@ def csm_shape(csm):
     return csm_properties(csm)[3]
 
 
-class CSM(Op):
+class BSRProperties(Op):
+    # See doc in instance of this Op or function after this class definition.
+    __props__ = ()
+    view_map = {0: [0], 1: [0], 2: [0]}
+
+    def make_node(self, bsr):
+        bsr = as_sparse_variable(bsr)
+        assert bsr.format == "bsr"
+        data = TensorType(dtype=bsr.type.dtype, shape=(False, False, False))()
+        return Apply(self, [bsr], [data, ivector(), ivector(), ivector()])
+
+    def perform(self, node, inputs, out):
+        (bsr,) = inputs
+        out[0][0] = bsr.data
+        out[1][0] = _asarray(bsr.indices, dtype="int32")
+        out[2][0] = _asarray(bsr.indptr, dtype="int32")
+        out[3][0] = _asarray(bsr.shape, dtype="int32")
+
+    def grad(self, inputs, g):
+        (bsr,) = inputs
+        return [grad_not_implemented(self, 0, bsr)]
+
+
+bsr_properties = BSRProperties()
+"""
+Extract all of .data, .indices, .indptr and .shape field of a bsr matrix.
+
+Parameters
+----------
+bsr
+    Sparse matrix in BSR format.
+
+Returns
+    (data, indices, indptr, shape), the properties of `bsr`. `data` has
+    shape (number of blocks, R, C) for R x C blocks, `indices` holds the
+    block column of each block and `indptr` delimits the block rows.
+
+Notes
+-----
+The grad is not implemented.
+
+"""
+
+
+class CSM(COp):
     # See doc in instance of this Op or function after this class definition.
     """
     Indexing to specified what part of the data parameter
@@ -757,6 +841,89 @@ class CSM(Op):
                 (data, indices.copy(), indptr.copy()), _shape.copy(), copy=False
             )
 
+    def c_code(self, node, name, inputs, outputs, sub):
+        data, indices, indptr, shape = inputs
+        (out,) = outputs
+        if node.inputs[1].dtype != "int32" or node.inputs[2].dtype != "int32":
+            raise NotImplementedError("indices and indptr must be int32")
+        fail = sub["fail"]
+        major = 0 if self.format == "csr" else 1
+        return f"""
+        {{
+            if (PyArray_DIMS({shape})[0] != 2)
+            {{
+                PyErr_SetString(PyExc_ValueError, "Shape should be an array of length 2");
+                {fail};
+            }}
+            npy_intp nnz = PyArray_DIMS({data})[0];
+            if (nnz != PyArray_DIMS({indices})[0])
+            {{
+                PyErr_Format(PyExc_ValueError,
+                             "Data (shape (%ld,)) must have the same number of "
+                             "elements as indices (shape (%ld,))",
+                             (long)nnz, (long)PyArray_DIMS({indices})[0]);
+                {fail};
+            }}
+            PyArrayObject* shape = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*){shape}, NPY_INT64, 1, 1, NPY_ARRAY_CARRAY_RO);
+            if (!shape) {{{fail};}}
+            npy_int64 M = ((npy_int64*)PyArray_DATA(shape))[0];
+            npy_int64 N = ((npy_int64*)PyArray_DATA(shape))[1];
+            Py_DECREF(shape);
+            npy_int64 n_major = {major} ? N : M;
+
+            // The same checks as SciPy's, which the matrix is built without
+            npy_intp n_ptr = PyArray_DIMS({indptr})[0];
+            if (M < 0 || N < 0)
+            {{
+                PyErr_SetString(PyExc_ValueError, "invalid shape");
+                {fail};
+            }}
+            if (n_ptr != n_major + 1)
+            {{
+                PyErr_Format(PyExc_ValueError, "index pointer size (%ld) should be (%ld)",
+                             (long)n_ptr, (long)(n_major + 1));
+                {fail};
+            }}
+            npy_int32 first = *(npy_int32*)PyArray_GETPTR1({indptr}, 0);
+            npy_int32 last = *(npy_int32*)PyArray_GETPTR1({indptr}, n_ptr - 1);
+            if (first != 0)
+            {{
+                PyErr_SetString(PyExc_ValueError, "index pointer should start with 0");
+                {fail};
+            }}
+            if (last < 0 || last > nnz)
+            {{
+                PyErr_SetString(PyExc_ValueError,
+                                "Last value of index pointer should be less than "
+                                "the size of index and data arrays");
+                {fail};
+            }}
+
+            // Like perform, this views data but copies indices and indptr.
+            // Entries past the end of the last row are dropped, as SciPy does.
+            PyObject* data = (PyObject*){data};
+            Py_INCREF(data);
+            PyObject* ind = PyArray_NewCopy({indices}, NPY_CORDER);
+            PyObject* ptr = PyArray_NewCopy({indptr}, NPY_CORDER);
+            if (data && ind && last < nnz)
+            {{
+                Py_SETREF(data, PySequence_GetSlice(data, 0, last));
+                Py_SETREF(ind, PySequence_GetSlice(ind, 0, last));
+            }}
+            Py_XDECREF({out});
+            {out} = (data && ind && ptr)
+                ? aesara_sparse_new("{self.format}", data, ind, ptr, M, N) : NULL;
+            Py_XDECREF(data);
+            Py_XDECREF(ind);
+            Py_XDECREF(ptr);
+            if (!{out}) {{{fail};}}
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (2,)
+
     def connection_pattern(self, node):
         return [[True], [False], [False], [False]]
 
@@ -1172,6 +1339,136 @@ sparse matrix
 
 """
 
+bsr_from_dense = SparseFromDense("bsr")
+"""
+Convert a dense matrix to a sparse bsr matrix.
+
+The block size is estimated from the nonzero pattern of the value, see
+`scipy.sparse.bsr_matrix`; use `bsr_from_sparse` to choose it.
+
+Parameters
+----------
+x
+    A dense matrix.
+
+Returns
+-------
+sparse matrix
+    The same as `x` in a sparse bsr matrix format.
+
+"""
+
+
+class SparseFromSparse(Op):
+    # See doc in instance of this Op or function after this class definition.
+    __props__ = ("format", "blocksize")
+
+    def __init__(self, format, blocksize=None):
+        if format not in SparseTensorType.format_cls:
+            raise ValueError(f"Unsupported sparse format: {format}")
+        if blocksize is not None:
+            if format != "bsr":
+                raise ValueError("blocksize is only meaningful for the bsr format")
+            blocksize = tuple(int(b) for b in blocksize)
+        self.format = format
+        self.blocksize = blocksize
+
+    def __str__(self):
+        if self.blocksize is None:
+            return f"{self.__class__.__name__}{{{self.format}}}"
+        return f"{self.__class__.__name__}{{{self.format}, {self.blocksize}}}"
+
+    def make_node(self, x):
+        x = as_sparse_variable(x)
+        return Apply(
+            self, [x], [SparseTensorType(dtype=x.type.dtype, format=self.format)()]
+        )
+
+    def perform(self, node, inputs, outputs):
+        (x,) = inputs
+        (out,) = outputs
+        if self.format == "bsr":
+            out[0] = x.tobsr(blocksize=self.blocksize)
+        else:
+            out[0] = x.asformat(self.format)
+        if out[0] is x:
+            out[0] = x.copy()
+
+    def grad(self, inputs, gout):
+        (x,) = inputs
+        (gz,) = gout
+        return [SparseFromSparse(x.type.format)(gz)]
+
+    def infer_shape(self, fgraph, node, shapes):
+        return [shapes[0]]
+
+
+csr_from_sparse = SparseFromSparse("csr")
+"""
+Convert a sparse matrix of any format to the csr format.
+
+Parameters
+----------
+x
+    A sparse matrix.
+
+Returns
+-------
+sparse matrix
+    The same as `x` in a sparse csr matrix format.
+
+Notes
+-----
+The grad implemented is structured.
+
+"""
+
+csc_from_sparse = SparseFromSparse("csc")
+"""
+Convert a sparse matrix of any format to the csc format.
+
+Parameters
+----------
+x
+    A sparse matrix.
+
+Returns
+-------
+sparse matrix
+    The same as `x` in a sparse csc matrix format.
+
+Notes
+-----
+The grad implemented is structured.
+
+"""
+
+
+def bsr_from_sparse(x, blocksize=None):
+    """
+    Convert a sparse matrix of any format to the bsr format.
+
+    Parameters
+    ----------
+    x
+        A sparse matrix.
+    blocksize
+        The (R, C) shape of the blocks. Both must divide the corresponding
+        dimension of `x`. If None, it is estimated from the nonzero pattern
+        of the value of `x`.
+
+    Returns
+    -------
+    sparse matrix
+        The same as `x` in a sparse bsr matrix format.
+
+    Notes
+    -----
+    The grad implemented is structured.
+
+    """
+    return SparseFromSparse("bsr", blocksize)(x)
+
 
 # Indexing
 class GetItemList(Op):
@@ -1579,7 +1876,7 @@ class Transpose(Op):
     # See doc in instance of this Op or function after this class definition.
     view_map = {0: [0]}
 
-    format_map = {"csr": "csc", "csc": "csr"}
+    format_map = {"csr": "csc", "csc": "csr", "bsr": "bsr"}
     __props__ = ()
 
     def __str__(self):
@@ -1587,7 +1884,7 @@ class Transpose(Op):
 
     def make_node(self, x):
         x = as_sparse_variable(x)
-        assert x.format in ("csr", "csc")
+        assert x.format in self.format_map
         return Apply(
             self,
             [x],
@@ -4103,6 +4400,47 @@ class StructuredDotGradCSR(COp):
 sdg_csr = StructuredDotGradCSR()
 
 
+class StructuredDotGradBSR(Op):
+    # Op that produces the grad of StructuredDot for a bsr matrix.
+
+    # :param a: Sparse matrix in bsr format
+    # :param b: Right operand
+    # :param g_ab: Accumulated gradient
+
+    # :return: The grad of `a`.`b` for `a` accumulated
+    #          with g_ab, with the block structure of `a`.
+
+    __props__ = ()
+
+    def make_node(self, a, b, g_ab):
+        a = as_sparse_variable(a)
+        assert a.format == "bsr"
+        b = at.as_tensor_variable(b)
+        g_ab = at.as_tensor_variable(g_ab)
+        return Apply(self, [a, b, g_ab], [SparseTensorType("bsr", g_ab.type.dtype)()])
+
+    def perform(self, node, inputs, outputs):
+        (a, b, g_ab) = inputs
+        (out,) = outputs
+        R, C = a.blocksize
+        n = b.shape[1]
+        block_rows = np.repeat(np.arange(len(a.indptr) - 1), np.diff(a.indptr))
+        # g[k] = g_ab[rows of block k] . b[cols of block k].T
+        g_blocks = g_ab.reshape(-1, R, n)[block_rows]
+        b_blocks = b.reshape(-1, C, n)[a.indices]
+        data = np.einsum("krn,kcn->krc", g_blocks, b_blocks)
+        out[0] = scipy.sparse.bsr_matrix(
+            (data.astype(node.outputs[0].dtype), a.indices.copy(), a.indptr.copy()),
+            shape=a.shape,
+        )
+
+    def infer_shape(self, fgraph, node, shapes):
+        return [shapes[0]]
+
+
+sdg_bsr = StructuredDotGradBSR()
+
+
 def structured_dot_grad(sparse_A, dense_B, ga):
     if sparse_A.type.format in ("csc", "csr"):
 
@@ -4117,6 +4455,8 @@ def structured_dot_grad(sparse_A, dense_B, ga):
         return CSx(
             g_A_data, csm_indices(sparse_A), csm_indptr(sparse_A), csm_shape(sparse_A)
         )
+    elif sparse_A.type.format == "bsr":
+        return sdg_bsr(sparse_A, dense_B, ga)
     else:
         raise NotImplementedError()
 
@@ -4203,6 +4543,112 @@ sparse matrix
 """
 
 
+def _csr_row_softmax(x):
+    """Softmax of the stored entries of each row of a canonical csr matrix."""
+    lengths = np.diff(x.indptr)
+    starts = x.indptr[:-1][lengths > 0]
+    lengths = lengths[lengths > 0]
+    data = x.data
+    if len(starts):
+        data = data - np.repeat(np.maximum.reduceat(data, starts), lengths)
+        data = np.exp(data)
+        data /= np.repeat(np.add.reduceat(data, starts), lengths)
+    return scipy.sparse.csr_matrix((data, x.indices, x.indptr), x.shape)
+
+
+class StructuredSoftmax(Op):
+    # See doc in instance of this Op or function after this class definition.
+    __props__ = ()
+
+    def make_node(self, x):
+        x = as_sparse_variable(x)
+        assert x.format in ("csr", "csc")
+        if x.type.dtype not in float_dtypes:
+            raise NotImplementedError("StructuredSoftmax needs a float matrix.")
+        return Apply(self, [x], [x.type()])
+
+    def perform(self, node, inputs, outputs):
+        (x,) = inputs
+        (out,) = outputs
+        x = scipy.sparse.csr_matrix(x, copy=True)
+        x.sum_duplicates()
+        out[0] = _csr_row_softmax(x).asformat(node.outputs[0].type.format)
+
+    def grad(self, inputs, gout):
+        (x,) = inputs
+        (gz,) = gout
+        return [structured_softmax_grad(self(x), gz)]
+
+    def infer_shape(self, fgraph, node, shapes):
+        return shapes
+
+
+structured_softmax = StructuredSoftmax()
+"""
+Softmax over the stored entries of each row of a sparse matrix.
+
+The entries that are not stored do not take part in the softmax: they stay
+zero, as if they were ``-inf``.  This is the normalisation of the attention
+scores of a sparse attention mask, e.g.
+``dot(structured_softmax(sampling_dot(q, k, mask)), v)``.
+
+Parameters
+----------
+x
+    Sparse matrix in csr or csc format.
+
+Returns
+-------
+A sparse matrix with the same format and sparsity pattern as `x`.
+
+Notes
+-----
+Duplicated entries are summed first.
+
+The grad implemented is structured.
+
+"""
+
+
+class StructuredSoftmaxGrad(Op):
+    # See doc in instance of this Op or function after this class definition.
+    __props__ = ()
+
+    def make_node(self, sm, gz):
+        sm = as_sparse_variable(sm)
+        gz = as_sparse_variable(gz)
+        assert sm.format in ("csr", "csc")
+        return Apply(self, [sm, gz], [sm.type()])
+
+    def perform(self, node, inputs, outputs):
+        (sm, gz) = inputs
+        (out,) = outputs
+        sm = scipy.sparse.csr_matrix(sm)
+        # The values of gz at the entries of sm
+        rows = np.repeat(np.arange(sm.shape[0]), np.diff(sm.indptr))
+        gz_sm = np.asarray(scipy.sparse.csr_matrix(gz)[rows, sm.indices]).ravel()
+        prod = scipy.sparse.csr_matrix(
+            (sm.data * gz_sm, sm.indices, sm.indptr), sm.shape
+        )
+        row_sum = np.asarray(prod.sum(axis=1)).ravel()
+        data = sm.data * (gz_sm - row_sum[rows])
+        g = scipy.sparse.csr_matrix((data, sm.indices, sm.indptr), sm.shape)
+        out[0] = g.asformat(node.outputs[0].type.format).astype(
+            node.outputs[0].type.dtype
+        )
+
+    def infer_shape(self, fgraph, node, shapes):
+        return [shapes[0]]
+
+
+structured_softmax_grad = StructuredSoftmaxGrad()
+"""
+Gradient of `structured_softmax`, given its output `sm` and the gradient of
+the cost with respect to it, `gz`.
+
+"""
+
+
 class Dot(Op):
     # See doc in instance of this Op or function after this class definition.
     __props__ = ()
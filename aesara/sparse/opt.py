@@ -4,9 +4,9 @@ import scipy
 import aesara
 import aesara.scalar as aes
 from aesara.configdefaults import config
-from aesara.graph.basic import Apply
+from aesara.graph.basic import Apply, Constant
 from aesara.graph.opt import PatternSub, TopoOptimizer, local_optimizer
-from aesara.link.c.op import COp, _NoPythonCOp
+from aesara.link.c.op import COp, OpenMPOp, _NoPythonCOp
 from aesara.misc.safe_asarray import _asarray
 from aesara.sparse import basic as sparse
 from aesara.sparse.basic import (
@@ -24,7 +24,7 @@ from aesara.tensor.basic import as_tensor_variable, cast, patternbroadcast
 from aesara.tensor.basic_opt import register_canonicalize, register_specialize
 from aesara.tensor.math import mul, neg, sub
 from aesara.tensor.shape import shape, specify_shape
-from aesara.tensor.type import TensorType, tensor
+from aesara.tensor.type import TensorType, ivector, tensor
 
 
 _is_sparse_variable = sparse._is_sparse_variable
@@ -49,6 +49,8 @@ def local_csm_properties_csm(fgraph, node):
                 patternbroadcast(i, o.broadcastable)
                 for i, o in zip(csm.owner.inputs, node.outputs)
             ]
+            # CSM accepts any integer shape, CSMProperties returns int32
+            ret_var[3] = cast(ret_var[3], node.outputs[3].dtype)
             return ret_var
 
     return False
@@ -254,7 +256,134 @@ aesara.compile.optdb.register(
 )
 
 
-class StructuredDotCSC(COp):
+# Support code of the C implementations of `StructuredDotCSC`,
+# `StructuredDotCSR` and `UsmmCscDense`.
+#
+# The product is computed row by row of the sparse matrix, so the rows can be
+# split between threads.  Each thread gets a contiguous range of rows with
+# about the same number of nonzeros plus rows, so that a few long rows do not
+# leave the other threads idle.  CSC matrices are first transposed to CSR with
+# a stable counting sort, which costs O(nnz + M) against O(nnz * N) for the
+# product and keeps the sums in the same order as the serial loop.
+_csr_dense_c_support_code = """
+#ifndef _AESARA_CSR_DENSE
+#define _AESARA_CSR_DENSE
+
+// First row m such that m + (number of nonzeros in the rows before m) >= target.
+static npy_intp aesara_csr_split(const npy_int32* ptr, npy_intp Sptr, npy_intp M,
+                                 npy_intp target)
+{
+    npy_intp lo = 0, hi = M;
+    while (lo < hi)
+    {
+        npy_intp mid = lo + (hi - lo) / 2;
+        if (mid + (npy_intp)(ptr[mid * Sptr] - ptr[0]) < target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Range of rows [*begin, *end) of the M rows of a CSR matrix that the
+// calling thread of the current OpenMP team is responsible for.
+static void aesara_csr_thread_rows(const npy_int32* ptr, npy_intp Sptr, npy_intp M,
+                                   npy_intp* begin, npy_intp* end)
+{
+    npy_intp tid = 0, nthreads = 1;
+#ifdef _OPENMP
+    tid = omp_get_thread_num();
+    nthreads = omp_get_num_threads();
+#endif
+    npy_intp work = M + (npy_intp)(ptr[M * Sptr] - ptr[0]);
+    *begin = aesara_csr_split(ptr, Sptr, M, work * tid / nthreads);
+    *end = aesara_csr_split(ptr, Sptr, M, work * (tid + 1) / nthreads);
+}
+
+// CSR structure (rptr, cols) of the M x K matrix whose CSC structure is
+// (ind, ptr); pos[j] is the position in the CSC arrays of the j-th CSR entry.
+// Returns -1 if a row index is out of range.
+static int aesara_csc_to_csr(npy_intp M, npy_intp K,
+                             const npy_int32* ind, npy_intp Sind,
+                             const npy_int32* ptr, npy_intp Sptr,
+                             npy_int32* rptr, npy_int32* cols, npy_int32* pos)
+{
+    memset(rptr, 0, (M + 1) * sizeof(npy_int32));
+    for (npy_intp k = 0; k < K; ++k)
+    {
+        for (npy_int32 j = ptr[k * Sptr]; j < ptr[(k + 1) * Sptr]; ++j)
+        {
+            npy_int32 m = ind[j * Sind];
+            if (m < 0 || m >= M)
+                return -1;
+            ++rptr[m + 1];
+        }
+    }
+    for (npy_intp m = 0; m < M; ++m)
+        rptr[m + 1] += rptr[m];
+    // Use rptr[m] as the insertion point of row m, then shift it back.
+    for (npy_intp k = 0; k < K; ++k)
+    {
+        for (npy_int32 j = ptr[k * Sptr]; j < ptr[(k + 1) * Sptr]; ++j)
+        {
+            npy_int32 dst = rptr[ind[j * Sind]]++;
+            cols[dst] = k;
+            pos[dst] = j;
+        }
+    }
+    for (npy_intp m = M; m > 0; --m)
+        rptr[m] = rptr[m - 1];
+    rptr[0] = 0;
+    return 0;
+}
+
+// z[m, :] (+)= sum_j alpha * a[m, ind[j]] * b[ind[j], :] for the rows
+// m_begin <= m < m_end of the CSR matrix a.  The values of a are read
+// from val[pos[j]] when pos is not NULL.  Szm and Sbk are byte strides,
+// Szn and Sbn element strides.
+template <typename Tz, typename Ta, typename Tb>
+static void aesara_csr_dense_rows(npy_intp m_begin, npy_intp m_end, npy_intp N,
+                                  const npy_int32* ptr, npy_intp Sptr,
+                                  const npy_int32* ind, npy_intp Sind,
+                                  const npy_int32* pos,
+                                  const Ta* val, npy_intp Sval, Tz alpha,
+                                  const char* b, npy_intp Sbk, npy_intp Sbn,
+                                  char* z, npy_intp Szm, npy_intp Szn,
+                                  bool accumulate)
+{
+    for (npy_intp m = m_begin; m < m_end; ++m)
+    {
+        Tz* __restrict__ zm = (Tz*)(z + Szm * m);
+        if (!accumulate)
+        {
+            for (npy_intp n = 0; n < N; ++n)
+                zm[n * Szn] = 0;
+        }
+        for (npy_int32 j = ptr[m * Sptr]; j < ptr[(m + 1) * Sptr]; ++j)
+        {
+            const npy_int32 k = ind[j * Sind];
+            const Tz amk = alpha * (Tz)val[(pos ? pos[j] : j) * Sval];
+            const Tb* __restrict__ bk = (const Tb*)(b + Sbk * k);
+            // The contiguous case is vectorised over the columns of b.
+            if (Szn == 1 && Sbn == 1)
+            {
+                for (npy_intp n = 0; n < N; ++n)
+                    zm[n] += amk * bk[n];
+            }
+            else
+            {
+                for (npy_intp n = 0; n < N; ++n)
+                    zm[n * Szn] += amk * bk[n * Sbn];
+            }
+        }
+    }
+}
+
+#endif
+"""
+
+
+class StructuredDotCSC(OpenMPOp):
     """
     Structured Dot CSC is like dot, except that only the gradient wrt non-zero
     elements of the sparse matrix `a` are calculated and propagated.
@@ -278,6 +407,9 @@ class StructuredDotCSC(COp):
     The grad implemented is structured.
     This op is used as an optimization for StructuredDot.
 
+    When OpenMP is enabled, large products transpose `a` to csr and split its
+    rows between the threads.
+
     """
 
     __props__ = ()
@@ -325,6 +457,14 @@ class StructuredDotCSC(COp):
         typenum_a_val = node.inputs[0].type.dtype_specs()[2]  # retrieve dtype number
         typenum_b = node.inputs[4].type.dtype_specs()[2]  # retrieve dtype number
 
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            parallel = f"omp_get_max_threads() > 1 && M > 1 && (Dptr[K * Sptr] - Dptr[0]) * N >= {minsize}"
+            omp_parallel = "#pragma omp parallel"
+        else:
+            parallel = "0"
+            omp_parallel = ""
+
         rval = """
 
         if (PyArray_NDIM(%(a_val)s) != 1) {PyErr_SetString(PyExc_NotImplementedError, "rank(a_val) != 1"); %(fail)s;}
@@ -391,6 +531,37 @@ class StructuredDotCSC(COp):
 
             //npy_intp nnz = PyArray_DIMS(%(a_ind)s)[0];
 
+            if (%(parallel)s)
+            {
+                npy_intp nnz = Dptr[K * Sptr] - Dptr[0];
+                npy_int32* Rptr = (npy_int32*)malloc((M + 1) * sizeof(npy_int32));
+                npy_int32* Rind = (npy_int32*)malloc((nnz + 1) * sizeof(npy_int32));
+                npy_int32* Rpos = (npy_int32*)malloc((nnz + 1) * sizeof(npy_int32));
+                if (!Rptr || !Rind || !Rpos)
+                {
+                    free(Rptr); free(Rind); free(Rpos);
+                    PyErr_NoMemory();
+                    %(fail)s;
+                }
+                if (aesara_csc_to_csr(M, K, Dind, Sind, Dptr, Sptr, Rptr, Rind, Rpos))
+                {
+                    free(Rptr); free(Rind); free(Rpos);
+                    PyErr_SetString(PyExc_NotImplementedError, "illegal row index in a");
+                    %(fail)s;
+                }
+                %(omp_parallel)s
+                {
+                    npy_intp m_begin, m_end;
+                    aesara_csr_thread_rows(Rptr, 1, M, &m_begin, &m_end);
+                    aesara_csr_dense_rows<dtype_%(z)s, dtype_%(a_val)s, dtype_%(b)s>(
+                        m_begin, m_end, N, Rptr, 1, Rind, 1, Rpos, Dval, Sval, 1,
+                        PyArray_BYTES(%(b)s), PyArray_STRIDES(%(b)s)[0], Sbn,
+                        PyArray_BYTES(%(z)s), PyArray_STRIDES(%(z)s)[0], Szn, false);
+                }
+                free(Rptr); free(Rind); free(Rpos);
+            }
+            else
+            {
             //clear the output array
             memset(Dz, 0, M*N*sizeof(dtype_%(z)s));
 
@@ -444,6 +615,7 @@ class StructuredDotCSC(COp):
                     }
                 }
             }
+            }
         }
         """ % dict(
             locals(), **sub
@@ -451,14 +623,17 @@ class StructuredDotCSC(COp):
 
         return rval
 
+    def c_support_code(self, **kwargs):
+        return _csr_dense_c_support_code
+
     def c_code_cache_version(self):
-        return (3,)
+        return (4, self.openmp, config.openmp_elemwise_minsize)
 
 
 sd_csc = StructuredDotCSC()
 
 
-class StructuredDotCSR(COp):
+class StructuredDotCSR(OpenMPOp):
     """
     Structured Dot CSR is like dot, except that only the
     gradient wrt non-zero elements of the sparse matrix
@@ -484,6 +659,9 @@ class StructuredDotCSR(COp):
     The grad implemented is structured.
     This op is used as an optimization for StructuredDot.
 
+    When OpenMP is enabled, the rows of `a` are split between the threads so
+    that each gets about the same number of nonzeros.
+
     """
 
     __props__ = ()
@@ -540,6 +718,14 @@ class StructuredDotCSR(COp):
         if node.inputs[3].type.dtype in ("complex64", "complex128"):
             raise NotImplementedError("Complex types are not supported for b")
 
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            omp_parallel = (
+                f"#pragma omp parallel if((Dptr[M * Sptr] - Dptr[0]) * N >= {minsize})"
+            )
+        else:
+            omp_parallel = ""
+
         return """
         if (PyArray_NDIM(%(a_val)s) != 1) {PyErr_SetString(PyExc_NotImplementedError, "rank(a_val) != 1"); %(fail)s;}
         if (PyArray_NDIM(%(a_ind)s) != 1) {PyErr_SetString(PyExc_NotImplementedError, "rank(a_ind) != 1"); %(fail)s;}
@@ -592,9 +778,6 @@ class StructuredDotCSR(COp):
 
             //npy_intp nnz = PyArray_DIMS(%(a_ind)s)[0];
 
-            //clear the output array
-            memset(Dz, 0, M*N*sizeof(dtype_%(z)s));
-
             //iterate over the sparse array, making the most of an entry wherever we find it.
             // Normal matrix matrix multiply:
             // for m
@@ -606,29 +789,14 @@ class StructuredDotCSR(COp):
             //   for k (sparse)
             //     for n
             //        z[m, n] += a[m, k] * b[k, n]
-
-            // loop over inner dimension
-            for (npy_int64 m = 0; m < M; ++m)
+            %(omp_parallel)s
             {
-                // pointer to m-th row of the output matrix Z
-                dtype_%(z)s* __restrict__ zm = (dtype_%(z)s*)(PyArray_BYTES(%(z)s) + PyArray_STRIDES(%(z)s)[0] * m);
-
-                // loop over sparse rows indices through index pointer array
-                // (amounts to looping over cols k of sparse matrix)
-                for (npy_int32 k_idx = Dptr[m * Sptr]; k_idx < Dptr[(m+1) * Sptr]; ++k_idx)
-                {
-                    npy_int32 k = Dind[k_idx * Sind]; // col index of non-null value for row m
-                    const dtype_%(a_val)s Amk = Dval[k_idx * Sval]; // actual value at that location
-
-                    // get pointer to k-th row of dense matrix
-                    const dtype_%(b)s* __restrict__ bk = (dtype_%(b)s*)(PyArray_BYTES(%(b)s) + PyArray_STRIDES(%(b)s)[0] * k);
-
-                    // loop over final dimension (cols of dense matrix) and perform dot product
-                    for(npy_int32 n = 0; n < N; ++n)
-                    {
-                        zm[n*Szn] += Amk * bk[n*Sbn];
-                    }
-                }
+                npy_intp m_begin, m_end;
+                aesara_csr_thread_rows(Dptr, Sptr, M, &m_begin, &m_end);
+                aesara_csr_dense_rows<dtype_%(z)s, dtype_%(a_val)s, dtype_%(b)s>(
+                    m_begin, m_end, N, Dptr, Sptr, Dind, Sind, NULL, Dval, Sval, 1,
+                    PyArray_BYTES(%(b)s), PyArray_STRIDES(%(b)s)[0], Sbn,
+                    PyArray_BYTES(%(z)s), PyArray_STRIDES(%(z)s)[0], Szn, false);
             }
         }
 
@@ -636,8 +804,11 @@ class StructuredDotCSR(COp):
             locals(), **sub
         )
 
+    def c_support_code(self, **kwargs):
+        return _csr_dense_c_support_code
+
     def c_code_cache_version(self):
-        return (2,)
+        return (3, self.openmp, config.openmp_elemwise_minsize)
 
 
 sd_csr = StructuredDotCSR()
@@ -667,7 +838,7 @@ def local_structured_dot(fgraph, node):
 # register_specialize(local_structured_dot)
 
 
-class UsmmCscDense(_NoPythonCOp):
+class UsmmCscDense(OpenMPOp, _NoPythonCOp):
     """
     Performs the expression is `alpha` * `x` `y` + `z`.
 
@@ -690,11 +861,14 @@ class UsmmCscDense(_NoPythonCOp):
     -----
     The grad is not implemented for this op.
     Optimized version os Usmm when `x` is in csc format and `y` is dense.
+    When OpenMP is enabled, large products transpose `x` to csr and split its
+    rows between the threads.
     """
 
     __props__ = ("inplace",)
 
-    def __init__(self, inplace):
+    def __init__(self, inplace, openmp=None):
+        super().__init__(openmp=openmp)
         self.inplace = inplace
         if inplace:
             self.destroy_map = {0: [6]}
@@ -749,13 +923,13 @@ class UsmmCscDense(_NoPythonCOp):
         return r
 
     def c_support_code(self, **kwargs):
-        return blas.blas_header_text()
+        return blas.blas_header_text() + _csr_dense_c_support_code
 
     def c_libraries(self, **kwargs):
         return blas.ldflags()
 
     def c_compile_args(self, **kwargs):
-        return blas.ldflags(libs=False, flags=True)
+        return super().c_compile_args(**kwargs) + blas.ldflags(libs=False, flags=True)
 
     def c_lib_dirs(self, **kwargs):
         return blas.ldflags(libs=False, libs_dir=True)
@@ -773,7 +947,7 @@ class UsmmCscDense(_NoPythonCOp):
         if node.inputs[6].type.dtype != node.outputs[0].type.dtype:
             raise NotImplementedError("z and output must have same type")
 
-        if node.inputs[1].type.dtype == "float32":
+        if node.outputs[0].type.dtype == "float32":
             conv_type = "float"
             axpy = "saxpy_"
         else:
@@ -788,6 +962,14 @@ class UsmmCscDense(_NoPythonCOp):
 
         inplace = int(self.inplace)
 
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            parallel = f"omp_get_max_threads() > 1 && M > 1 && (Dptr[K * Sptr] - Dptr[0]) * N >= {minsize}"
+            omp_parallel = "#pragma omp parallel"
+        else:
+            parallel = "0"
+            omp_parallel = ""
+
         rval = """
 
         if (PyArray_NDIM(%(x_val)s) != 1) {PyErr_SetString(PyExc_NotImplementedError, "rank(x_val) != 1"); %(fail)s;}
@@ -872,7 +1054,8 @@ class UsmmCscDense(_NoPythonCOp):
             const dtype_%(x_val)s* __restrict__ Dval = (dtype_%(x_val)s*)PyArray_DATA(%(x_val)s);
             const npy_int32 * __restrict__ Dind = (npy_int32*)PyArray_DATA(%(x_ind)s);
             const npy_int32 * __restrict__ Dptr = (npy_int32*)PyArray_DATA(%(x_ptr)s);
-            const dtype_%(alpha)s alpha = ((dtype_%(alpha)s*)PyArray_DATA(%(alpha)s))[0];
+            // Both paths compute alpha * x_val in the output dtype
+            const dtype_%(zn)s alpha = ((dtype_%(alpha)s*)PyArray_DATA(%(alpha)s))[0];
 
             npy_intp Sz = PyArray_STRIDES(%(z)s)[1] / PyArray_DESCR(%(z)s)->elsize;
             npy_intp Szn = PyArray_STRIDES(%(zn)s)[1] / PyArray_DESCR(%(zn)s)->elsize;
@@ -897,13 +1080,43 @@ class UsmmCscDense(_NoPythonCOp):
                 }
             }
 
+            if (%(parallel)s)
+            {
+                npy_intp nnz = Dptr[K * Sptr] - Dptr[0];
+                npy_int32* Rptr = (npy_int32*)malloc((M + 1) * sizeof(npy_int32));
+                npy_int32* Rind = (npy_int32*)malloc((nnz + 1) * sizeof(npy_int32));
+                npy_int32* Rpos = (npy_int32*)malloc((nnz + 1) * sizeof(npy_int32));
+                if (!Rptr || !Rind || !Rpos)
+                {
+                    free(Rptr); free(Rind); free(Rpos);
+                    PyErr_NoMemory();
+                    %(fail)s;
+                }
+                if (aesara_csc_to_csr(M, K, Dind, Sind, Dptr, Sptr, Rptr, Rind, Rpos))
+                {
+                    free(Rptr); free(Rind); free(Rpos);
+                    PyErr_SetString(PyExc_NotImplementedError, "illegal row index in x");
+                    %(fail)s;
+                }
+                %(omp_parallel)s
+                {
+                    npy_intp m_begin, m_end;
+                    aesara_csr_thread_rows(Rptr, 1, M, &m_begin, &m_end);
+                    aesara_csr_dense_rows<dtype_%(zn)s, dtype_%(x_val)s, dtype_%(y)s>(
+                        m_begin, m_end, N, Rptr, 1, Rind, 1, Rpos, Dval, Sval, alpha,
+                        PyArray_BYTES(%(y)s), PyArray_STRIDES(%(y)s)[0], Sy,
+                        PyArray_BYTES(%(zn)s), PyArray_STRIDES(%(zn)s)[0], Szn, true);
+                }
+                free(Rptr); free(Rind); free(Rpos);
+            }
+            else
             for (npy_intp k = 0; k < K; ++k)
             {
                 for (npy_int32 m_idx = Dptr[k * Sptr]; m_idx < Dptr[(k+1)*Sptr]; ++m_idx)
                 {
                     const npy_int32 m = Dind[m_idx * Sind]; // row index of non-null value for column K
 
-                    const dtype_%(x_val)s Amk = alpha * Dval[m_idx * Sval]; // actual value at that location
+                    const dtype_%(zn)s Amk = alpha * (dtype_%(zn)s)Dval[m_idx * Sval]; // actual value at that location
 
                     dtype_%(y)s* y_row = (dtype_%(y)s*)(PyArray_BYTES(%(y)s) + PyArray_STRIDES(%(y)s)[0] * k);
                     // axpy expects pointer to the beginning of memory arrays,
@@ -927,7 +1140,12 @@ class UsmmCscDense(_NoPythonCOp):
         return rval
 
     def c_code_cache_version(self):
-        return (3, blas.blas_header_version())
+        return (
+            5,
+            blas.blas_header_version(),
+            self.openmp,
+            config.openmp_elemwise_minsize,
+        )
 
 
 usmm_csc_dense = UsmmCscDense(inplace=False)
@@ -1804,7 +2022,29 @@ def local_structured_add_s_v(fgraph, node):
 register_specialize(local_structured_add_s_v, "cxx_only")
 
 
-class SamplingDotCSR(_NoPythonCOp):
+_sddmm_c_support_code = """
+#ifndef _AESARA_SDDMM
+#define _AESARA_SDDMM
+
+// Dot product of the contiguous vectors x and y of length K.  The loop is
+// vectorised when compiled with -fopenmp-simd, which allows the partial sums
+// of the SIMD lanes to be added in a different order.
+template <typename T>
+static inline T aesara_sddmm_dot(npy_intp K, const T* __restrict__ x,
+                                 const T* __restrict__ y)
+{
+    T sum = 0;
+    #pragma omp simd reduction(+:sum)
+    for (npy_intp k = 0; k < K; ++k)
+        sum += x[k] * y[k];
+    return sum;
+}
+
+#endif
+"""
+
+
+class SamplingDotCSR(OpenMPOp, _NoPythonCOp):
     r"""
     Operand optimized for calculating the dot product :math:`x y^\top = z`
     when you only want to calculate a subset of :math:`z`.
@@ -1849,12 +2089,20 @@ class SamplingDotCSR(_NoPythonCOp):
     in the graph to be able to call BLAS function as they don't
     allow mixed dtype.
 
+    When the rows of `x` and `y` are contiguous, the dot products are inlined
+    instead of calling BLAS for each nonzero, the row of `x` staying in cache
+    for all the nonzeros of the row, and the rows of the pattern are split
+    between the threads when OpenMP is enabled.
+
     This `Op` is used as an optimization for `SamplingDot`.
 
     """
 
     __props__ = ()
 
+    def __init__(self, openmp=None):
+        super().__init__(openmp=openmp)
+
     def make_node(self, x, y, p_data, p_ind, p_ptr, p_ncols):
         x = as_tensor_variable(x)
         y = as_tensor_variable(y)
@@ -1883,16 +2131,25 @@ class SamplingDotCSR(_NoPythonCOp):
         )
 
     def c_code_cache_version(self):
-        return (4, blas.blas_header_version())
+        return (
+            5,
+            blas.blas_header_version(),
+            self.openmp,
+            config.openmp_elemwise_minsize,
+        )
 
     def c_support_code(self, **kwargs):
-        return blas.blas_header_text()
+        return blas.blas_header_text() + _sddmm_c_support_code
 
     def c_libraries(self, **kwargs):
         return blas.ldflags()
 
     def c_compile_args(self, **kwargs):
-        return blas.ldflags(libs=False, flags=True)
+        return (
+            super().c_compile_args(**kwargs)
+            + ["-fopenmp-simd"]
+            + blas.ldflags(libs=False, flags=True)
+        )
 
     def c_lib_dirs(self, **kwargs):
         return blas.ldflags(libs=False, libs_dir=True)
@@ -1927,6 +2184,15 @@ class SamplingDotCSR(_NoPythonCOp):
         typenum_zi = TensorType(node.outputs[1].dtype, []).dtype_specs()[2]
         typenum_zp = TensorType(node.outputs[2].dtype, []).dtype_specs()[2]
 
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            omp_parallel_for = (
+                "#pragma omp parallel for schedule(dynamic, 16) "
+                f"if(PyArray_DIMS({p_data})[0] * K >= {minsize})"
+            )
+        else:
+            omp_parallel_for = ""
+
         rval = """
         if (PyArray_NDIM(%(x)s) != 2) {
 PyErr_SetString(PyExc_NotImplementedError, "rank(x) != 2"); %(fail)s;}
@@ -2028,22 +2294,37 @@ PyErr_SetString(PyExc_NotImplementedError, "rank(y) != 2"); %(fail)s;}
             int Sdx32 = Sdx;
             int Sdy32 = Sdy;
 
-            for (npy_intp m = 0; m < M; ++m) {
-                for (npy_int32 n_idx = Dpp[m * Sdpp]; n_idx < Dpp[(m+1)*Sdpp]; ++n_idx) {
-                    const npy_int32 n = Dpi[n_idx * Sdpi]; // row index of non-null value for column K
-
+            if (PyArray_STRIDES(%(x)s)[1] == sizeof(dtype_%(x)s)
+                && PyArray_STRIDES(%(y)s)[1] == sizeof(dtype_%(y)s))
+            {
+                %(omp_parallel_for)s
+                for (npy_intp m = 0; m < M; ++m) {
                     const dtype_%(x)s* x_row = (dtype_%(x)s*)(PyArray_BYTES(%(x)s) + PyArray_STRIDES(%(x)s)[0] * m);
-
-                    const dtype_%(y)s* y_col = (dtype_%(y)s*)(PyArray_BYTES(%(y)s) + PyArray_STRIDES(%(y)s)[0] * n);
-                    // dot expects pointer to the beginning of memory arrays,
-                    // so when the stride is negative, we need to get the
-                    // last element
-                    if (Sdx < 0)
-                        x_row += (K - 1) * Sdx;
-                    if (Sdy < 0)
-                        y_col += (K - 1) * Sdy;
-
-                    Dzd[n_idx * Sdzd] = Dpd[n_idx * Sdpd] * %(cdot)s(&K32, (const %(conv_type)s*)x_row, &Sdx32, (const %(conv_type)s*)y_col, &Sdy32);
+                    for (npy_intp n_idx = Dpp[m * Sdpp]; n_idx < Dpp[(m + 1) * Sdpp]; ++n_idx) {
+                        const dtype_%(y)s* y_row = (dtype_%(y)s*)(PyArray_BYTES(%(y)s) + PyArray_STRIDES(%(y)s)[0] * Dpi[n_idx * Sdpi]);
+                        Dzd[n_idx * Sdzd] = Dpd[n_idx * Sdpd] * aesara_sddmm_dot(K, x_row, y_row);
+                    }
+                }
+            }
+            else
+            {
+                for (npy_intp m = 0; m < M; ++m) {
+                    for (npy_int32 n_idx = Dpp[m * Sdpp]; n_idx < Dpp[(m+1)*Sdpp]; ++n_idx) {
+                        const npy_int32 n = Dpi[n_idx * Sdpi]; // row index of non-null value for column K
+
+                        const dtype_%(x)s* x_row = (dtype_%(x)s*)(PyArray_BYTES(%(x)s) + PyArray_STRIDES(%(x)s)[0] * m);
+
+                        const dtype_%(y)s* y_col = (dtype_%(y)s*)(PyArray_BYTES(%(y)s) + PyArray_STRIDES(%(y)s)[0] * n);
+                        // dot expects pointer to the beginning of memory arrays,
+                        // so when the stride is negative, we need to get the
+                        // last element
+                        if (Sdx < 0)
+                            x_row += (K - 1) * Sdx;
+                        if (Sdy < 0)
+                            y_col += (K - 1) * Sdy;
+
+                        Dzd[n_idx * Sdzd] = Dpd[n_idx * Sdpd] * %(cdot)s(&K32, (const %(conv_type)s*)x_row, &Sdx32, (const %(conv_type)s*)y_col, &Sdy32);
+                    }
                 }
             }
         }
@@ -2088,3 +2369,2177 @@ def local_sampling_dot_csr(fgraph, node):
 
 
 register_specialize(local_sampling_dot_csr, "cxx_only", name="local_sampling_dot_csr")
+
+
+class SamplingDotSoftmaxDotCSR(OpenMPOp):
+    r"""
+    Fused ``dot(structured_softmax(sampling_dot(x, y, p)), v)``, the
+    attention of the rows of `x` over the rows of `y` restricted to the
+    pattern of a csr matrix :math:`p`.
+
+    For each row :math:`m`, the scores :math:`p_{mn} x_m \cdot y_n` at the
+    columns :math:`n` of the pattern are computed, normalised with a softmax
+    and used to weight the rows of `v`.  The scores of a row are kept in a
+    buffer of the thread, so that no sparse matrix is built.
+
+    Parameters
+    ----------
+    x
+        Tensor matrix, :math:`m \times k`.
+    y
+        Tensor matrix, :math:`n \times k`.
+    p_data
+        Sparse matrix data.
+    p_ind
+        Sparse matrix indices.
+    p_ptr
+        Sparse matrix indptr.
+    p_ncols
+        Sparse matrix number of columns.
+    v
+        Tensor matrix, :math:`n \times d`.
+
+    Returns
+    -------
+    A dense :math:`m \times d` matrix.
+
+    Notes
+    -----
+    Duplicated entries of the pattern are summed, as `SamplingDot` does.  The
+    rows of the pattern are split between the threads when OpenMP is enabled.
+    The scores and their softmax are computed in the upcast dtype of `x`, `y`
+    and `p`, and the output in the upcast dtype of all the inputs.
+
+    This `Op` is used as an optimization for `Dot` and `StructuredDot` of a
+    `StructuredSoftmax` of a `SamplingDot`.
+
+    """
+
+    __props__ = ()
+
+    def __init__(self, openmp=None):
+        super().__init__(openmp=openmp)
+
+    def make_node(self, x, y, p_data, p_ind, p_ptr, p_ncols, v):
+        x, y, p_data, p_ind, p_ptr, p_ncols, v = map(
+            as_tensor_variable, [x, y, p_data, p_ind, p_ptr, p_ncols, v]
+        )
+        assert p_ind.dtype == "int32" and p_ptr.dtype == "int32"
+        assert p_ncols.dtype == "int32" and p_ncols.ndim == 0
+        assert x.ndim == 2 and y.ndim == 2 and v.ndim == 2
+
+        # The scores are computed in the dtype of `SamplingDot`, and the
+        # output in the dtype of the product of its softmax with `v`
+        dtype_scores = aes.upcast(x.type.dtype, y.type.dtype, p_data.type.dtype)
+        x = cast(x, dtype_scores)
+        y = cast(y, dtype_scores)
+        dtype_out = aes.upcast(dtype_scores, v.type.dtype)
+        return Apply(
+            self,
+            [x, y, p_data, p_ind, p_ptr, p_ncols, v],
+            [tensor(dtype_out, (False, v.type.broadcastable[1]))],
+        )
+
+    def perform(self, node, inputs, outputs):
+        x, y, p_data, p_ind, p_ptr, p_ncols, v = inputs
+        p = scipy.sparse.csr_matrix(
+            (p_data, p_ind, p_ptr), (len(p_ptr) - 1, p_ncols), copy=True
+        )
+        p.sum_duplicates()
+        rows = np.repeat(np.arange(p.shape[0]), np.diff(p.indptr))
+        scores = p.data * np.einsum("ij,ij->i", x[rows], y[p.indices])
+        scores = scipy.sparse.csr_matrix(
+            (scores.astype(x.dtype), p.indices, p.indptr), p.shape
+        )
+        sm = sparse._csr_row_softmax(scores)
+        outputs[0][0] = _asarray(sm * v, dtype=node.outputs[0].type.dtype)
+
+    def c_support_code(self, **kwargs):
+        return _sddmm_c_support_code
+
+    def c_headers(self, **kwargs):
+        return ["<cmath>"] + super().c_headers(**kwargs)
+
+    def c_compile_args(self, **kwargs):
+        return super().c_compile_args(**kwargs) + ["-fopenmp-simd"]
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        x, y, p_data, p_ind, p_ptr, p_ncols, v = inputs
+        (z,) = outputs
+        for i in node.inputs[:3] + node.inputs[6:]:
+            if i.type.dtype in sparse.complex_dtypes:
+                raise NotImplementedError("Complex types are not supported")
+        if node.inputs[2].type.dtype not in sparse.float_dtypes:
+            raise NotImplementedError("The pattern must be a float matrix")
+        fail = sub["fail"]
+        typenum_z = node.outputs[0].type.dtype_specs()[2]
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            parallel = f"(PyArray_DIMS({p_data})[0] * (K + D) >= {minsize})"
+        else:
+            parallel = "0"
+
+        return f"""
+        {{
+            if (PyArray_NDIM({p_data}) != 1 || PyArray_NDIM({p_ind}) != 1
+                || PyArray_NDIM({p_ptr}) != 1
+                || PyArray_DIMS({p_data})[0] != PyArray_DIMS({p_ind})[0])
+            {{PyErr_SetString(PyExc_ValueError, "invalid pattern"); {fail};}}
+            const npy_intp M = PyArray_DIMS({x})[0];
+            const npy_intp K = PyArray_DIMS({x})[1];
+            const npy_intp N = PyArray_DIMS({y})[0];
+            const npy_intp D = PyArray_DIMS({v})[1];
+            if (PyArray_DIMS({y})[1] != K || PyArray_DIMS({v})[0] != N
+                || PyArray_DIMS({p_ptr})[0] != M + 1
+                || *(npy_int32*)PyArray_DATA({p_ncols}) != N)
+            {{PyErr_SetString(PyExc_ValueError, "shape mismatch in SamplingDotSoftmaxDotCSR"); {fail};}}
+
+            Py_XDECREF({z});
+            npy_intp dims[2] = {{M, D}};
+            {z} = (PyArrayObject*)PyArray_ZEROS(2, dims, {typenum_z}, 0);
+            if (!{z}) {{{fail};}}
+
+            // The rows of x, y and v are read as contiguous vectors
+            PyArrayObject* xc = PyArray_GETCONTIGUOUS({x});
+            PyArrayObject* yc = PyArray_GETCONTIGUOUS({y});
+            PyArrayObject* vc = PyArray_GETCONTIGUOUS({v});
+            if (!xc || !yc || !vc)
+            {{
+                Py_XDECREF(xc); Py_XDECREF(yc); Py_XDECREF(vc);
+                {fail};
+            }}
+            const dtype_{x}* Dx = (const dtype_{x}*)PyArray_DATA(xc);
+            const dtype_{y}* Dy = (const dtype_{y}*)PyArray_DATA(yc);
+            const dtype_{v}* Dv = (const dtype_{v}*)PyArray_DATA(vc);
+            dtype_{z}* Dz = (dtype_{z}*)PyArray_DATA({z});
+            const dtype_{p_data}* Dpd = (const dtype_{p_data}*)PyArray_DATA({p_data});
+            const npy_int32* Dpi = (const npy_int32*)PyArray_DATA({p_ind});
+            const npy_int32* Dpp = (const npy_int32*)PyArray_DATA({p_ptr});
+            const npy_intp Spd = PyArray_STRIDES({p_data})[0] / PyArray_DESCR({p_data})->elsize;
+            const npy_intp Spi = PyArray_STRIDES({p_ind})[0] / sizeof(npy_int32);
+            const npy_intp Spp = PyArray_STRIDES({p_ptr})[0] / sizeof(npy_int32);
+
+            // 1: out of memory, 2: invalid pattern
+            int failed = 0;
+            #pragma omp parallel if({parallel}) reduction(|:failed)
+            {{
+                // Column n of the row is cols[slot[n]] when mark[n] == m
+                npy_intp* mark = (npy_intp*)malloc((N + 1) * sizeof(npy_intp));
+                npy_int32* slot = (npy_int32*)malloc((N + 1) * sizeof(npy_int32));
+                npy_int32* cols = (npy_int32*)malloc((N + 1) * sizeof(npy_int32));
+                dtype_{x}* scores = (dtype_{x}*)malloc((N + 1) * sizeof(dtype_{x}));
+                if (!mark || !slot || !cols || !scores)
+                    failed = 1;
+                else
+                    for (npy_intp n = 0; n < N; ++n)
+                        mark[n] = -1;
+                #pragma omp for schedule(dynamic, 16)
+                for (npy_intp m = 0; m < M; ++m)
+                {{
+                    if (failed)
+                        continue;
+                    const npy_intp j0 = Dpp[m * Spp], j1 = Dpp[(m + 1) * Spp];
+                    if (j0 < 0 || j1 < j0 || j1 > PyArray_DIMS({p_data})[0])
+                    {{
+                        failed = 2;
+                        continue;
+                    }}
+                    // Distinct columns of the row and the sum of their weights
+                    npy_intp count = 0;
+                    for (npy_intp j = j0; j < j1; ++j)
+                    {{
+                        const npy_int32 n = Dpi[j * Spi];
+                        if (n < 0 || n >= N)
+                        {{
+                            failed = 2;
+                            break;
+                        }}
+                        if (mark[n] != m)
+                        {{
+                            mark[n] = m;
+                            slot[n] = (npy_int32)count;
+                            cols[count] = n;
+                            scores[count++] = Dpd[j * Spd];
+                        }}
+                        else
+                            scores[slot[n]] += Dpd[j * Spd];
+                    }}
+                    if (failed || !count)
+                        continue;
+
+                    const dtype_{x}* x_row = Dx + m * K;
+                    for (npy_intp c = 0; c < count; ++c)
+                        scores[c] *= aesara_sddmm_dot(K, x_row, Dy + (npy_intp)cols[c] * K);
+
+                    dtype_{x} max = scores[0];
+                    for (npy_intp c = 1; c < count; ++c)
+                        max = scores[c] > max ? scores[c] : max;
+                    dtype_{x} sum = 0;
+                    for (npy_intp c = 0; c < count; ++c)
+                    {{
+                        scores[c] = std::exp(scores[c] - max);
+                        sum += scores[c];
+                    }}
+
+                    dtype_{z}* z_row = Dz + m * D;
+                    for (npy_intp c = 0; c < count; ++c)
+                    {{
+                        const dtype_{z} w = scores[c] / sum;
+                        const dtype_{v}* v_row = Dv + (npy_intp)cols[c] * D;
+                        for (npy_intp k = 0; k < D; ++k)
+                            z_row[k] += w * v_row[k];
+                    }}
+                }}
+                free(mark);
+                free(slot);
+                free(cols);
+                free(scores);
+            }}
+            Py_DECREF(xc);
+            Py_DECREF(yc);
+            Py_DECREF(vc);
+            if (failed & 1)
+            {{PyErr_NoMemory(); {fail};}}
+            if (failed)
+            {{PyErr_SetString(PyExc_ValueError, "invalid pattern"); {fail};}}
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (4, self.openmp, config.openmp_elemwise_minsize)
+
+
+# register a canonicalization to replace the sparse attention
+# dot(structured_softmax(sampling_dot(x, y, p)), v) -> SamplingDotSoftmaxDotCSR
+# It runs before the specialization of SamplingDot to SamplingDotCSR.
+@local_optimizer([sparse._dot, sparse._structured_dot])
+def local_sampling_dot_softmax_dot_csr(fgraph, node):
+    if isinstance(node.op, (sparse.Dot, sparse.StructuredDot)):
+        sm, v = node.inputs
+        if not _is_sparse_variable(sm) or _is_sparse_variable(v) or v.ndim != 2:
+            return False
+        if not (sm.owner and isinstance(sm.owner.op, sparse.StructuredSoftmax)):
+            return False
+        scores = sm.owner.inputs[0]
+        if not (scores.owner and isinstance(scores.owner.op, sparse.SamplingDot)):
+            return False
+        x, y, p = scores.owner.inputs
+        if p.type.format != "csr":
+            return False
+        if any(i.type.dtype in sparse.complex_dtypes for i in (x, y, v)):
+            return False
+        p_data, p_ind, p_ptr, p_shape = sparse.csm_properties(p)
+        z = SamplingDotSoftmaxDotCSR()(x, y, p_data, p_ind, p_ptr, p_shape[1], v)
+        return [cast(z, node.outputs[0].type.dtype)]
+    return False
+
+
+register_canonicalize(local_sampling_dot_softmax_dot_csr, "cxx_only")
+
+
+# Support code of the C implementations of the sparse-sparse `Op`s below.
+# They work on the (data, indices, indptr) triplets of `csm_properties`, in
+# the terms of CSR matrices: a CSC matrix is handled as the CSR structure of
+# its transpose.
+_csx_c_support_code = """
+#ifndef _AESARA_CSX
+#define _AESARA_CSX
+
+// Read-only view of the triplet of a CSR (or CSC) matrix.
+template <typename T>
+struct aesara_csx
+{
+    const T* val;
+    npy_intp Sval;
+    const npy_int32* ind;
+    npy_intp Sind;
+    const npy_int32* ptr;
+    npy_intp Sptr;
+
+    T at(npy_intp j) const { return val[j * Sval]; }
+    npy_int32 index(npy_intp j) const { return ind[j * Sind]; }
+    npy_int32 begin(npy_intp m) const { return ptr[m * Sptr]; }
+    npy_int32 end(npy_intp m) const { return ptr[(m + 1) * Sptr]; }
+};
+
+template <typename T>
+static aesara_csx<T> aesara_csx_from(PyArrayObject* val, PyArrayObject* ind,
+                                     PyArrayObject* ptr)
+{
+    aesara_csx<T> x;
+    x.val = (const T*)PyArray_DATA(val);
+    x.Sval = PyArray_STRIDES(val)[0] / PyArray_DESCR(val)->elsize;
+    x.ind = (const npy_int32*)PyArray_DATA(ind);
+    x.Sind = PyArray_STRIDES(ind)[0] / PyArray_DESCR(ind)->elsize;
+    x.ptr = (const npy_int32*)PyArray_DATA(ptr);
+    x.Sptr = PyArray_STRIDES(ptr)[0] / PyArray_DESCR(ptr)->elsize;
+    return x;
+}
+
+// Check that the triplet describes a matrix with nmajor rows and nminor
+// columns whose entries all lie within the nnz stored values.  Sets a
+// Python exception and returns -1 otherwise.
+template <typename T>
+static int aesara_csx_check(const char* name, const aesara_csx<T>& x,
+                            PyArrayObject* val, PyArrayObject* ind,
+                            PyArrayObject* ptr, npy_intp nmajor, npy_intp nminor)
+{
+    if (PyArray_NDIM(val) != 1 || PyArray_NDIM(ind) != 1 || PyArray_NDIM(ptr) != 1)
+    {
+        PyErr_Format(PyExc_ValueError, "%s: data, indices and indptr must be vectors", name);
+        return -1;
+    }
+    if (PyArray_TYPE(ind) != NPY_INT32 || PyArray_TYPE(ptr) != NPY_INT32)
+    {
+        PyErr_Format(PyExc_TypeError, "%s: indices and indptr must be int32", name);
+        return -1;
+    }
+    if (PyArray_DIMS(val)[0] != PyArray_DIMS(ind)[0])
+    {
+        PyErr_Format(PyExc_ValueError, "%s: data and indices have different lengths", name);
+        return -1;
+    }
+    if (PyArray_DIMS(ptr)[0] != nmajor + 1)
+    {
+        PyErr_Format(PyExc_ValueError,
+                     "%s: indptr has %lld elements, expected %lld", name,
+                     (long long)PyArray_DIMS(ptr)[0], (long long)(nmajor + 1));
+        return -1;
+    }
+    npy_intp nnz = PyArray_DIMS(val)[0];
+    if (x.begin(0) < 0 || x.begin(nmajor) > nnz)
+    {
+        PyErr_Format(PyExc_ValueError, "%s: indptr out of range", name);
+        return -1;
+    }
+    for (npy_intp m = 0; m < nmajor; ++m)
+    {
+        if (x.end(m) < x.begin(m))
+        {
+            PyErr_Format(PyExc_ValueError, "%s: indptr is not sorted", name);
+            return -1;
+        }
+    }
+    for (npy_intp j = x.begin(0); j < x.begin(nmajor); ++j)
+    {
+        if (x.index(j) < 0 || x.index(j) >= nminor)
+        {
+            PyErr_Format(PyExc_ValueError, "%s: index out of range", name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Exclusive prefix sum of the row counts stored in ptr[1..n].  Returns the
+// total, or -1 if it does not fit in the int32 indices.
+static npy_intp aesara_csx_cumsum(npy_int32* ptr, npy_intp n)
+{
+    npy_intp total = 0;
+    ptr[0] = 0;
+    for (npy_intp m = 1; m <= n; ++m)
+    {
+        total += ptr[m];
+        if (total > NPY_MAX_INT32)
+            return -1;
+        ptr[m] = (npy_int32)total;
+    }
+    return total;
+}
+
+// Whether the indices of row m are sorted and without duplicates.
+template <typename T>
+static bool aesara_csx_row_canonical(const aesara_csx<T>& x, npy_intp m)
+{
+    for (npy_intp j = x.begin(m) + 1; j < x.end(m); ++j)
+    {
+        if (x.index(j) <= x.index(j - 1))
+            return false;
+    }
+    return true;
+}
+
+// Dense accumulator of one thread, for the rows that cannot be merged.
+// mark[n] == stamp when column n was met in the current row.
+template <typename T>
+struct aesara_csx_spa
+{
+    npy_intp stamp;
+    npy_intp* mark;
+    npy_int32* cols;
+    T* xs;
+    T* ys;
+};
+
+template <typename T>
+static int aesara_csx_spa_init(aesara_csx_spa<T>* spa, npy_intp n)
+{
+    spa->stamp = 0;
+    spa->mark = (npy_intp*)calloc(n + 1, sizeof(npy_intp));
+    spa->cols = (npy_int32*)malloc((n + 1) * sizeof(npy_int32));
+    spa->xs = (T*)malloc((n + 1) * sizeof(T));
+    spa->ys = (T*)malloc((n + 1) * sizeof(T));
+    return (spa->mark && spa->cols && spa->xs && spa->ys) ? 0 : -1;
+}
+
+template <typename T>
+static void aesara_csx_spa_free(aesara_csx_spa<T>* spa)
+{
+    free(spa->mark);
+    free(spa->cols);
+    free(spa->xs);
+    free(spa->ys);
+}
+
+#endif
+"""
+
+
+_csx_binary_c_support_code = """
+#ifndef _AESARA_CSX_BINARY
+#define _AESARA_CSX_BINARY
+
+struct aesara_csx_add
+{
+    template <typename T>
+    static T apply(T x, T y) { return x + y; }
+};
+
+struct aesara_csx_mul
+{
+    template <typename T>
+    static T apply(T x, T y) { return x * y; }
+};
+
+// Row m of Op(x, y), with duplicated entries summed and the zeros of the
+// result dropped, as SciPy does.  Writes the row from position p of (zind,
+// zval) unless zind is NULL, and returns its number of entries, or -1 if
+// the accumulator cannot be allocated.  Canonical rows are merged; other
+// rows go through a dense accumulator and come out sorted.
+template <typename Op, typename Tz, typename Tx, typename Ty>
+static npy_intp aesara_csx_binary_row(npy_intp m, npy_intp nminor,
+                                      const aesara_csx<Tx>& x,
+                                      const aesara_csx<Ty>& y,
+                                      aesara_csx_spa<Tz>* spa,
+                                      npy_int32* zind, Tz* zval, npy_intp p)
+{
+    npy_intp nz = 0;
+    if (aesara_csx_row_canonical(x, m) && aesara_csx_row_canonical(y, m))
+    {
+        npy_intp i = x.begin(m), ie = x.end(m);
+        npy_intp j = y.begin(m), je = y.end(m);
+        while (i < ie || j < je)
+        {
+            npy_int32 xi = (i < ie) ? x.index(i) : NPY_MAX_INT32;
+            npy_int32 yj = (j < je) ? y.index(j) : NPY_MAX_INT32;
+            npy_int32 n;
+            Tz v;
+            if (xi == yj)
+            {
+                n = xi;
+                v = Op::apply((Tz)x.at(i++), (Tz)y.at(j++));
+            }
+            else if (xi < yj)
+            {
+                n = xi;
+                v = Op::apply((Tz)x.at(i++), (Tz)0);
+            }
+            else
+            {
+                n = yj;
+                v = Op::apply((Tz)0, (Tz)y.at(j++));
+            }
+            if (v != (Tz)0)
+            {
+                if (zind)
+                {
+                    zind[p + nz] = n;
+                    zval[p + nz] = v;
+                }
+                ++nz;
+            }
+        }
+        return nz;
+    }
+
+    if (!spa->mark && aesara_csx_spa_init(spa, nminor))
+        return -1;
+    npy_intp stamp = ++spa->stamp;
+    npy_intp nc = 0;
+    for (npy_intp i = x.begin(m); i < x.end(m); ++i)
+    {
+        npy_int32 n = x.index(i);
+        if (spa->mark[n] != stamp)
+        {
+            spa->mark[n] = stamp;
+            spa->xs[n] = spa->ys[n] = 0;
+            spa->cols[nc++] = n;
+        }
+        spa->xs[n] += (Tz)x.at(i);
+    }
+    for (npy_intp j = y.begin(m); j < y.end(m); ++j)
+    {
+        npy_int32 n = y.index(j);
+        if (spa->mark[n] != stamp)
+        {
+            spa->mark[n] = stamp;
+            spa->xs[n] = spa->ys[n] = 0;
+            spa->cols[nc++] = n;
+        }
+        spa->ys[n] += (Tz)y.at(j);
+    }
+    if (zind)
+        std::sort(spa->cols, spa->cols + nc);
+    for (npy_intp c = 0; c < nc; ++c)
+    {
+        npy_int32 n = spa->cols[c];
+        Tz v = Op::apply(spa->xs[n], spa->ys[n]);
+        if (v != (Tz)0)
+        {
+            if (zind)
+            {
+                zind[p + nz] = n;
+                zval[p + nz] = v;
+            }
+            ++nz;
+        }
+    }
+    return nz;
+}
+
+// Two passes over the rows: with zind NULL, store the row counts in
+// zptr[1..nmajor]; otherwise fill zind and zval from the offsets in zptr.
+// Returns -1 if out of memory.
+template <typename Op, typename Tz, typename Tx, typename Ty>
+static int aesara_csx_binary(npy_intp nmajor, npy_intp nminor,
+                             const aesara_csx<Tx>& x, const aesara_csx<Ty>& y,
+                             npy_int32* zptr, npy_int32* zind, Tz* zval,
+                             int parallel)
+{
+    int failed = 0;
+    #pragma omp parallel if(parallel) reduction(|:failed)
+    {
+        aesara_csx_spa<Tz> spa = {0, NULL, NULL, NULL, NULL};
+        #pragma omp for schedule(dynamic, 64)
+        for (npy_intp m = 0; m < nmajor; ++m)
+        {
+            npy_intp nz = aesara_csx_binary_row<Op>(
+                m, nminor, x, y, &spa, zind, zval, zind ? zptr[m] : 0);
+            if (nz < 0)
+                failed = 1;
+            else if (!zind)
+                zptr[m + 1] = (npy_int32)nz;
+        }
+        aesara_csx_spa_free(&spa);
+    }
+    return failed ? -1 : 0;
+}
+
+#endif
+"""
+
+
+class BinarySSCSx(OpenMPOp):
+    """
+    Element-wise addition or multiplication of two sparse matrices with the
+    same format, on their (data, indices, indptr, shape) triplets.
+
+    Parameters
+    ----------
+    operation
+        ``"add"`` or ``"mul"``.
+    format
+        ``"csr"`` or ``"csc"``, the format of both matrices.
+
+    Returns
+    -------
+    The data, indices and indptr of the result, in the same format, with
+    sorted indices and without explicit zeros.
+
+    Notes
+    -----
+    This op is used as an optimization for AddSS and MulSS.  Rows with sorted
+    indices are merged; the others go through a dense accumulator, so
+    duplicated entries are summed first, as SciPy does.
+
+    """
+
+    __props__ = ("operation", "format")
+
+    def __init__(self, operation, format, openmp=None):
+        super().__init__(openmp=openmp)
+        if operation not in ("add", "mul"):
+            raise ValueError(f"Unknown operation {operation}")
+        if format not in ("csr", "csc"):
+            raise ValueError(f"Unknown format {format}")
+        self.operation = operation
+        self.format = format
+
+    def make_node(self, x_val, x_ind, x_ptr, x_shape, y_val, y_ind, y_ptr, y_shape):
+        x_val, x_ind, x_ptr, x_shape, y_val, y_ind, y_ptr, y_shape = map(
+            as_tensor_variable,
+            [x_val, x_ind, x_ptr, x_shape, y_val, y_ind, y_ptr, y_shape],
+        )
+        for i in (x_ind, x_ptr, x_shape, y_ind, y_ptr, y_shape):
+            assert i.dtype == "int32" and i.ndim == 1
+        assert x_val.ndim == 1 and y_val.ndim == 1
+        dtype_out = aes.upcast(x_val.type.dtype, y_val.type.dtype)
+        return Apply(
+            self,
+            [x_val, x_ind, x_ptr, x_shape, y_val, y_ind, y_ptr, y_shape],
+            [tensor(dtype_out, (False,)), ivector(), ivector()],
+        )
+
+    def perform(self, node, inputs, outputs):
+        x_val, x_ind, x_ptr, x_shape, y_val, y_ind, y_ptr, y_shape = inputs
+        if tuple(x_shape) != tuple(y_shape):
+            raise ValueError("inconsistent shapes")
+        cls = getattr(scipy.sparse, self.format + "_matrix")
+        x = cls((x_val, x_ind, x_ptr), tuple(x_shape))
+        y = cls((y_val, y_ind, y_ptr), tuple(y_shape))
+        if self.operation == "add":
+            z = x + y
+        else:
+            z = x.multiply(y)
+        z = cls(z)
+        z.sum_duplicates()
+        z.eliminate_zeros()
+        outputs[0][0] = _asarray(z.data, dtype=node.outputs[0].type.dtype)
+        outputs[1][0] = _asarray(z.indices, dtype="int32")
+        outputs[2][0] = _asarray(z.indptr, dtype="int32")
+
+    def c_support_code(self, **kwargs):
+        return _csx_c_support_code + _csx_binary_c_support_code
+
+    def c_headers(self, **kwargs):
+        return ["<algorithm>"] + super().c_headers(**kwargs)
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        x_val, x_ind, x_ptr, x_shape, y_val, y_ind, y_ptr, y_shape = inputs
+        z_val, z_ind, z_ptr = outputs
+        for i in (node.inputs[0], node.inputs[4]):
+            if (
+                i.type.dtype
+                not in sparse.float_dtypes + sparse.int_dtypes + sparse.uint_dtypes
+            ):
+                raise NotImplementedError(f"{i.type.dtype} is not supported")
+        fail = sub["fail"]
+        typenum_z = node.outputs[0].type.dtype_specs()[2]
+        operation = f"aesara_csx_{self.operation}"
+        major, minor = (0, 1) if self.format == "csr" else (1, 0)
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            parallel = (
+                f"(PyArray_DIMS({x_val})[0] + PyArray_DIMS({y_val})[0] >= {minsize})"
+            )
+        else:
+            parallel = "0"
+
+        return f"""
+        {{
+            if (PyArray_NDIM({x_shape}) != 1 || PyArray_DIMS({x_shape})[0] != 2
+                || PyArray_NDIM({y_shape}) != 1 || PyArray_DIMS({y_shape})[0] != 2)
+            {{PyErr_SetString(PyExc_ValueError, "shapes must have two elements"); {fail};}}
+            npy_intp nmajor = *(npy_int32*)PyArray_GETPTR1({x_shape}, {major});
+            npy_intp nminor = *(npy_int32*)PyArray_GETPTR1({x_shape}, {minor});
+            if (nmajor != *(npy_int32*)PyArray_GETPTR1({y_shape}, {major})
+                || nminor != *(npy_int32*)PyArray_GETPTR1({y_shape}, {minor}))
+            {{PyErr_SetString(PyExc_ValueError, "inconsistent shapes"); {fail};}}
+
+            aesara_csx<dtype_{x_val}> x = aesara_csx_from<dtype_{x_val}>({x_val}, {x_ind}, {x_ptr});
+            aesara_csx<dtype_{y_val}> y = aesara_csx_from<dtype_{y_val}>({y_val}, {y_ind}, {y_ptr});
+            if (aesara_csx_check("x", x, {x_val}, {x_ind}, {x_ptr}, nmajor, nminor)
+                || aesara_csx_check("y", y, {y_val}, {y_ind}, {y_ptr}, nmajor, nminor))
+            {{{fail};}}
+
+            Py_XDECREF({z_ptr});
+            npy_intp dims[1] = {{nmajor + 1}};
+            {z_ptr} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            if (!{z_ptr}) {{{fail};}}
+            npy_int32* zptr = (npy_int32*)PyArray_DATA({z_ptr});
+
+            if (aesara_csx_binary<{operation}, dtype_{z_val}>(
+                    nmajor, nminor, x, y, zptr, (npy_int32*)NULL, (dtype_{z_val}*)NULL, {parallel}))
+            {{PyErr_NoMemory(); {fail};}}
+            dims[0] = aesara_csx_cumsum(zptr, nmajor);
+            if (dims[0] < 0)
+            {{PyErr_SetString(PyExc_ValueError, "too many nonzeros (overflows int32 index)"); {fail};}}
+
+            Py_XDECREF({z_ind});
+            Py_XDECREF({z_val});
+            {z_ind} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            {z_val} = (PyArrayObject*)PyArray_SimpleNew(1, dims, {typenum_z});
+            if (!{z_ind} || !{z_val}) {{{fail};}}
+            if (aesara_csx_binary<{operation}, dtype_{z_val}>(
+                    nmajor, nminor, x, y, zptr, (npy_int32*)PyArray_DATA({z_ind}),
+                    (dtype_{z_val}*)PyArray_DATA({z_val}), {parallel}))
+            {{PyErr_NoMemory(); {fail};}}
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
+
+def _csx_supported(*variables):
+    """Whether the C implementations of the sparse-sparse ops support these."""
+    return all(
+        v.type.format in ("csr", "csc") and v.type.dtype not in sparse.complex_dtypes
+        for v in variables
+    )
+
+
+# register a specialization to replace AddSS and MulSS -> BinarySSCSx
+@local_optimizer([sparse.AddSS, sparse.MulSS])
+def local_binary_s_s_csx(fgraph, node):
+    if isinstance(node.op, (sparse.AddSS, sparse.MulSS)):
+        x, y = node.inputs
+        if x.type.format != y.type.format or not _csx_supported(x, y):
+            return False
+        operation = "add" if isinstance(node.op, sparse.AddSS) else "mul"
+        CSx = sparse.CSC if x.type.format == "csc" else sparse.CSR
+        x_shape = sparse.csm_shape(x)
+        z_val, z_ind, z_ptr = BinarySSCSx(operation, x.type.format)(
+            *csm_properties(x), *csm_properties(y)
+        )
+        return [CSx(z_val, z_ind, z_ptr, x_shape)]
+    return False
+
+
+register_specialize(local_binary_s_s_csx, "cxx_only")
+
+
+_spgemm_c_support_code = """
+#ifndef _AESARA_SPGEMM
+#define _AESARA_SPGEMM
+
+// Symbolic phase of Gustavson's algorithm: zptr[m + 1] is set to the number
+// of distinct columns in row m of the product a * b of CSR matrices.
+// Returns -1 if out of memory.
+template <typename Ta, typename Tb>
+static int aesara_spgemm_symbolic(npy_intp M, npy_intp N,
+                                  const aesara_csx<Ta>& a, const aesara_csx<Tb>& b,
+                                  npy_int32* zptr, int parallel)
+{
+    int failed = 0;
+    #pragma omp parallel if(parallel) reduction(|:failed)
+    {
+        npy_intp* mark = (npy_intp*)malloc((N + 1) * sizeof(npy_intp));
+        if (!mark)
+            failed = 1;
+        else
+            for (npy_intp n = 0; n < N; ++n)
+                mark[n] = -1;
+        #pragma omp for schedule(dynamic, 64)
+        for (npy_intp m = 0; m < M; ++m)
+        {
+            if (!mark)
+                continue;
+            npy_int32 count = 0;
+            for (npy_intp i = a.begin(m); i < a.end(m); ++i)
+            {
+                npy_int32 k = a.index(i);
+                for (npy_intp l = b.begin(k); l < b.end(k); ++l)
+                {
+                    npy_int32 n = b.index(l);
+                    if (mark[n] != m)
+                    {
+                        mark[n] = m;
+                        ++count;
+                    }
+                }
+            }
+            zptr[m + 1] = count;
+        }
+        free(mark);
+    }
+    return failed ? -1 : 0;
+}
+
+// Numeric phase: row m of a * b is written, without the zeros
+// that cancelled out, from zptr[m]; its length is stored in znnz[m].
+template <typename Tz, typename Ta, typename Tb>
+static int aesara_spgemm_numeric(npy_intp M, npy_intp N,
+                                 const aesara_csx<Ta>& a, const aesara_csx<Tb>& b,
+                                 const npy_int32* zptr, npy_int32* zind, Tz* zval,
+                                 npy_int32* znnz, int parallel)
+{
+    int failed = 0;
+    #pragma omp parallel if(parallel) reduction(|:failed)
+    {
+        npy_intp* mark = (npy_intp*)malloc((N + 1) * sizeof(npy_intp));
+        Tz* acc = (Tz*)malloc((N + 1) * sizeof(Tz));
+        if (!mark || !acc)
+            failed = 1;
+        else
+            for (npy_intp n = 0; n < N; ++n)
+                mark[n] = -1;
+        #pragma omp for schedule(dynamic, 64)
+        for (npy_intp m = 0; m < M; ++m)
+        {
+            if (!mark || !acc)
+                continue;
+            const npy_intp p0 = zptr[m];
+            npy_intp p = p0;
+            for (npy_intp i = a.begin(m); i < a.end(m); ++i)
+            {
+                const npy_int32 k = a.index(i);
+                const Tz amk = (Tz)a.at(i);
+                for (npy_intp l = b.begin(k); l < b.end(k); ++l)
+                {
+                    const npy_int32 n = b.index(l);
+                    const Tz v = amk * (Tz)b.at(l);
+                    if (mark[n] != m)
+                    {
+                        mark[n] = m;
+                        acc[n] = v;
+                        zind[p++] = n;
+                    }
+                    else
+                        acc[n] += v;
+                }
+            }
+            npy_intp w = p0;
+            for (npy_intp q = p0; q < p; ++q)
+            {
+                const npy_int32 n = zind[q];
+                if (acc[n] != (Tz)0)
+                {
+                    zind[w] = n;
+                    zval[w] = acc[n];
+                    ++w;
+                }
+            }
+            znnz[m] = (npy_int32)(w - p0);
+        }
+        free(mark);
+        free(acc);
+    }
+    return failed ? -1 : 0;
+}
+
+// Dense product: z[m, :] = a[m, :] * b, Szm in bytes and Szn in elements.
+template <typename Tz, typename Ta, typename Tb>
+static void aesara_spgemm_dense(npy_intp M, npy_intp N,
+                                const aesara_csx<Ta>& a, const aesara_csx<Tb>& b,
+                                char* z, npy_intp Szm, npy_intp Szn, int parallel)
+{
+    #pragma omp parallel for schedule(dynamic, 64) if(parallel)
+    for (npy_intp m = 0; m < M; ++m)
+    {
+        Tz* zm = (Tz*)(z + Szm * m);
+        for (npy_intp n = 0; n < N; ++n)
+            zm[n * Szn] = 0;
+        for (npy_intp i = a.begin(m); i < a.end(m); ++i)
+        {
+            const npy_int32 k = a.index(i);
+            const Tz amk = (Tz)a.at(i);
+            for (npy_intp l = b.begin(k); l < b.end(k); ++l)
+                zm[b.index(l) * Szn] += amk * (Tz)b.at(l);
+        }
+    }
+}
+
+#endif
+"""
+
+
+class SpGEMMCSR(OpenMPOp):
+    """
+    Product of two sparse matrices in csr format, on their (data, indices,
+    indptr, shape) triplets.
+
+    Parameters
+    ----------
+    dense
+        If true, the output is a dense matrix.  Otherwise it is the data,
+        indices and indptr of the product in csr format, without explicit
+        zeros.  As with SciPy, the indices of each row are not sorted.
+
+    Notes
+    -----
+    The sparse product uses Gustavson's row-by-row algorithm in two passes: a
+    symbolic one counts the nonzeros of each row, so that the output can be
+    allocated once, and a numeric one fills it.  The rows are split between
+    the threads when OpenMP is enabled.
+
+    The product of two csc matrices is computed as the product of their
+    transposes in the opposite order.
+
+    This op is used as an optimization for Dot, StructuredDot and TrueDot.
+
+    """
+
+    __props__ = ("dense",)
+
+    def __init__(self, dense=False, openmp=None):
+        super().__init__(openmp=openmp)
+        self.dense = dense
+
+    def make_node(self, a_val, a_ind, a_ptr, a_shape, b_val, b_ind, b_ptr, b_shape):
+        a_val, a_ind, a_ptr, a_shape, b_val, b_ind, b_ptr, b_shape = map(
+            as_tensor_variable,
+            [a_val, a_ind, a_ptr, a_shape, b_val, b_ind, b_ptr, b_shape],
+        )
+        for i in (a_ind, a_ptr, a_shape, b_ind, b_ptr, b_shape):
+            assert i.dtype == "int32" and i.ndim == 1
+        assert a_val.ndim == 1 and b_val.ndim == 1
+        dtype_out = aes.upcast(a_val.type.dtype, b_val.type.dtype)
+        if self.dense:
+            outputs = [tensor(dtype_out, (False, False))]
+        else:
+            outputs = [tensor(dtype_out, (False,)), ivector(), ivector()]
+        return Apply(
+            self, [a_val, a_ind, a_ptr, a_shape, b_val, b_ind, b_ptr, b_shape], outputs
+        )
+
+    def perform(self, node, inputs, outputs):
+        a_val, a_ind, a_ptr, a_shape, b_val, b_ind, b_ptr, b_shape = inputs
+        if a_shape[1] != b_shape[0]:
+            raise ValueError("shape mismatch in SpGEMMCSR", (a_shape, b_shape))
+        a = scipy.sparse.csr_matrix((a_val, a_ind, a_ptr), tuple(a_shape))
+        b = scipy.sparse.csr_matrix((b_val, b_ind, b_ptr), tuple(b_shape))
+        z = scipy.sparse.csr_matrix(a * b)
+        dtype = node.outputs[0].type.dtype
+        if self.dense:
+            outputs[0][0] = _asarray(z.toarray(), dtype=dtype)
+        else:
+            z.sort_indices()
+            z.eliminate_zeros()
+            outputs[0][0] = _asarray(z.data, dtype=dtype)
+            outputs[1][0] = _asarray(z.indices, dtype="int32")
+            outputs[2][0] = _asarray(z.indptr, dtype="int32")
+
+    def c_support_code(self, **kwargs):
+        return _csx_c_support_code + _spgemm_c_support_code
+
+    def c_headers(self, **kwargs):
+        return ["<algorithm>"] + super().c_headers(**kwargs)
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        a_val, a_ind, a_ptr, a_shape, b_val, b_ind, b_ptr, b_shape = inputs
+        for i in (node.inputs[0], node.inputs[4]):
+            if (
+                i.type.dtype
+                not in sparse.float_dtypes + sparse.int_dtypes + sparse.uint_dtypes
+            ):
+                raise NotImplementedError(f"{i.type.dtype} is not supported")
+        fail = sub["fail"]
+        typenum_z = node.outputs[0].type.dtype_specs()[2]
+        dtype_z = node.outputs[0].type.dtype_specs()[1]
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            parallel = f"(M > 1 && PyArray_DIMS({a_val})[0] + PyArray_DIMS({b_val})[0] >= {minsize})"
+        else:
+            parallel = "0"
+
+        code = f"""
+        {{
+            if (PyArray_NDIM({a_shape}) != 1 || PyArray_DIMS({a_shape})[0] != 2
+                || PyArray_NDIM({b_shape}) != 1 || PyArray_DIMS({b_shape})[0] != 2)
+            {{PyErr_SetString(PyExc_ValueError, "shapes must have two elements"); {fail};}}
+            const npy_intp M = *(npy_int32*)PyArray_GETPTR1({a_shape}, 0);
+            const npy_intp K = *(npy_int32*)PyArray_GETPTR1({a_shape}, 1);
+            const npy_intp N = *(npy_int32*)PyArray_GETPTR1({b_shape}, 1);
+            if (K != *(npy_int32*)PyArray_GETPTR1({b_shape}, 0))
+            {{PyErr_SetString(PyExc_ValueError, "shape mismatch in SpGEMMCSR"); {fail};}}
+
+            aesara_csx<dtype_{a_val}> a = aesara_csx_from<dtype_{a_val}>({a_val}, {a_ind}, {a_ptr});
+            aesara_csx<dtype_{b_val}> b = aesara_csx_from<dtype_{b_val}>({b_val}, {b_ind}, {b_ptr});
+            if (aesara_csx_check("a", a, {a_val}, {a_ind}, {a_ptr}, M, K)
+                || aesara_csx_check("b", b, {b_val}, {b_ind}, {b_ptr}, K, N))
+            {{{fail};}}
+        """
+        if self.dense:
+            (z,) = outputs
+            code += f"""
+            if (!{z} || PyArray_DIMS({z})[0] != M || PyArray_DIMS({z})[1] != N)
+            {{
+                Py_XDECREF({z});
+                npy_intp dims[2] = {{M, N}};
+                {z} = (PyArrayObject*)PyArray_SimpleNew(2, dims, {typenum_z});
+                if (!{z}) {{{fail};}}
+            }}
+            aesara_spgemm_dense<{dtype_z}>(
+                M, N, a, b, PyArray_BYTES({z}), PyArray_STRIDES({z})[0],
+                PyArray_STRIDES({z})[1] / PyArray_DESCR({z})->elsize, {parallel});
+        }}
+        """
+        else:
+            z_val, z_ind, z_ptr = outputs
+            code += f"""
+            Py_XDECREF({z_ptr});
+            npy_intp dims[1] = {{M + 1}};
+            {z_ptr} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            if (!{z_ptr}) {{{fail};}}
+            npy_int32* zptr = (npy_int32*)PyArray_DATA({z_ptr});
+            if (aesara_spgemm_symbolic(M, N, a, b, zptr, {parallel}))
+            {{PyErr_NoMemory(); {fail};}}
+            dims[0] = aesara_csx_cumsum(zptr, M);
+            if (dims[0] < 0)
+            {{PyErr_SetString(PyExc_ValueError, "too many nonzeros (overflows int32 index)"); {fail};}}
+
+            Py_XDECREF({z_ind});
+            Py_XDECREF({z_val});
+            {z_ind} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            {z_val} = (PyArrayObject*)PyArray_SimpleNew(1, dims, {typenum_z});
+            npy_int32* znnz = (npy_int32*)malloc((M + 1) * sizeof(npy_int32));
+            if (!{z_ind} || !{z_val} || !znnz)
+            {{
+                free(znnz);
+                PyErr_NoMemory();
+                {fail};
+            }}
+            npy_int32* zind = (npy_int32*)PyArray_DATA({z_ind});
+            {dtype_z}* zval = ({dtype_z}*)PyArray_DATA({z_val});
+            if (aesara_spgemm_numeric(M, N, a, b, zptr, zind, zval, znnz, {parallel}))
+            {{
+                free(znnz);
+                PyErr_NoMemory();
+                {fail};
+            }}
+
+            // Entries that cancelled out leave gaps to close.
+            npy_intp nnz = 0;
+            for (npy_intp m = 0; m < M; ++m)
+            {{
+                if (nnz != zptr[m])
+                {{
+                    memmove(zind + nnz, zind + zptr[m], znnz[m] * sizeof(npy_int32));
+                    memmove(zval + nnz, zval + zptr[m], znnz[m] * sizeof({dtype_z}));
+                }}
+                zptr[m] = (npy_int32)nnz;
+                nnz += znnz[m];
+            }}
+            free(znnz);
+            if (nnz != zptr[M])
+            {{
+                zptr[M] = (npy_int32)nnz;
+                PyArray_Dims shape = {{&nnz, 1}};
+                PyObject* resized = PyArray_Resize({z_ind}, &shape, 0, NPY_CORDER);
+                if (!resized) {{{fail};}}
+                Py_DECREF(resized);
+                resized = PyArray_Resize({z_val}, &shape, 0, NPY_CORDER);
+                if (!resized) {{{fail};}}
+                Py_DECREF(resized);
+            }}
+        }}
+        """
+        return code
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
+
+# register a specialization to replace Dot, StructuredDot and TrueDot of two
+# sparse matrices with the same format -> SpGEMMCSR
+@local_optimizer([sparse._dot, sparse._structured_dot, sparse.TrueDot])
+def local_spgemm_csr(fgraph, node):
+    if isinstance(node.op, (sparse.Dot, sparse.StructuredDot, sparse.TrueDot)):
+        x, y = node.inputs
+        if not (_is_sparse_variable(x) and _is_sparse_variable(y)):
+            return False
+        if x.type.format != y.type.format or not _csx_supported(x, y):
+            return False
+        dense = isinstance(node.op, sparse.Dot)
+        x_val, x_ind, x_ptr, x_shape = csm_properties(x)
+        y_val, y_ind, y_ptr, y_shape = csm_properties(y)
+        if x.type.format == "csr":
+            z = SpGEMMCSR(dense=dense)(
+                x_val, x_ind, x_ptr, x_shape, y_val, y_ind, y_ptr, y_shape
+            )
+        else:
+            # The csc structure of x * y is the csr structure of y.T * x.T
+            z = SpGEMMCSR(dense=dense)(
+                y_val, y_ind, y_ptr, y_shape[::-1], x_val, x_ind, x_ptr, x_shape[::-1]
+            )
+        if dense:
+            if x.type.format == "csc":
+                z = z.T
+            return [z]
+        CSx = sparse.CSC if x.type.format == "csc" else sparse.CSR
+        z_shape = as_tensor_variable([x_shape[0], y_shape[1]])
+        return [CSx(*z, z_shape)]
+    return False
+
+
+register_specialize(local_spgemm_csr, "cxx_only")
+
+
+_csx_copy_c_support_code = """
+#ifndef _AESARA_CSX_COPY
+#define _AESARA_CSX_COPY
+
+// Copy of the rows [m0, m1) of x in z, from the entry *nnz on.  zptr points
+// to the start of the first copied row and *nnz is advanced past the copy.
+template <typename Tz, typename T>
+static void aesara_csx_copy_rows(const aesara_csx<T>& x, npy_intp m0, npy_intp m1,
+                                 npy_int32* zptr, npy_int32* zind, Tz* zval,
+                                 npy_intp* nnz)
+{
+    npy_intp p = *nnz;
+    for (npy_intp m = m0; m < m1; ++m)
+    {
+        *zptr++ = (npy_int32)p;
+        for (npy_intp j = x.begin(m); j < x.end(m); ++j)
+        {
+            zind[p] = x.index(j);
+            zval[p] = (Tz)x.at(j);
+            ++p;
+        }
+    }
+    *zptr = (npy_int32)p;
+    *nnz = p;
+}
+
+#endif
+"""
+
+
+_csx_sort_c_support_code = """
+#ifndef _AESARA_CSX_SORT
+#define _AESARA_CSX_SORT
+
+// Copy of x in z where the indices of each row are sorted.  The entries keep
+// their position in the arrays, so that x.ptr is also the indptr of z.
+template <typename T>
+static void aesara_csx_sort_indices(npy_intp nmajor, npy_intp nnz,
+                                    const aesara_csx<T>& x, npy_int32* zind,
+                                    T* zval, int parallel)
+{
+    for (npy_intp j = 0; j < nnz; ++j)
+    {
+        zind[j] = x.index(j);
+        zval[j] = x.at(j);
+    }
+    #pragma omp parallel if(parallel)
+    {
+        std::vector<std::pair<npy_int32, npy_intp> > perm;
+        #pragma omp for schedule(dynamic, 64)
+        for (npy_intp m = 0; m < nmajor; ++m)
+        {
+            const npy_intp p0 = x.begin(m), p1 = x.end(m);
+            npy_intp j = p0 + 1;
+            while (j < p1 && x.index(j - 1) <= x.index(j))
+                ++j;
+            if (j >= p1)
+                continue;
+            perm.clear();
+            for (j = p0; j < p1; ++j)
+                perm.push_back(std::make_pair(x.index(j), j));
+            std::sort(perm.begin(), perm.end());
+            for (j = p0; j < p1; ++j)
+            {
+                zind[j] = perm[j - p0].first;
+                zval[j] = x.at(perm[j - p0].second);
+            }
+        }
+    }
+}
+
+#endif
+"""
+
+
+class EnsureSortedIndicesCSx(OpenMPOp):
+    """
+    Sort the indices of each row (csr) or column (csc) of a sparse matrix, on
+    its (data, indices, indptr) triplet.
+
+    Returns
+    -------
+    The data and indices of the sorted matrix.  Its indptr is the one of the
+    input.
+
+    Notes
+    -----
+    This op is used as an optimization for EnsureSortedIndices.  Only the
+    rows whose indices are not already sorted are sorted.
+
+    """
+
+    __props__ = ()
+
+    def make_node(self, x_val, x_ind, x_ptr):
+        x_val, x_ind, x_ptr = map(as_tensor_variable, [x_val, x_ind, x_ptr])
+        assert x_ind.dtype == "int32" and x_ind.ndim == 1
+        assert x_ptr.dtype == "int32" and x_ptr.ndim == 1
+        assert x_val.ndim == 1
+        return Apply(self, [x_val, x_ind, x_ptr], [x_val.type(), ivector()])
+
+    def perform(self, node, inputs, outputs):
+        x_val, x_ind, x_ptr = inputs
+        z_val, z_ind = x_val.copy(), x_ind.copy()
+        for m in range(len(x_ptr) - 1):
+            p0, p1 = x_ptr[m], x_ptr[m + 1]
+            perm = np.argsort(x_ind[p0:p1], kind="stable")
+            z_val[p0:p1] = x_val[p0:p1][perm]
+            z_ind[p0:p1] = x_ind[p0:p1][perm]
+        outputs[0][0] = z_val
+        outputs[1][0] = z_ind
+
+    def c_support_code(self, **kwargs):
+        return _csx_c_support_code + _csx_sort_c_support_code
+
+    def c_headers(self, **kwargs):
+        return ["<algorithm>", "<vector>"] + super().c_headers(**kwargs)
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        x_val, x_ind, x_ptr = inputs
+        z_val, z_ind = outputs
+        if node.inputs[0].type.dtype in sparse.complex_dtypes:
+            raise NotImplementedError("Complex types are not supported")
+        fail = sub["fail"]
+        typenum = node.inputs[0].type.dtype_specs()[2]
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            parallel = f"(PyArray_DIMS({x_val})[0] >= {minsize})"
+        else:
+            parallel = "0"
+
+        return f"""
+        {{
+            npy_intp nmajor = PyArray_DIMS({x_ptr})[0] - 1;
+            aesara_csx<dtype_{x_val}> x = aesara_csx_from<dtype_{x_val}>({x_val}, {x_ind}, {x_ptr});
+            if (nmajor < 0)
+            {{PyErr_SetString(PyExc_ValueError, "x: indptr is empty"); {fail};}}
+            // The number of columns is not known: only the rows are checked.
+            if (aesara_csx_check("x", x, {x_val}, {x_ind}, {x_ptr}, nmajor, NPY_MAX_INT32))
+            {{{fail};}}
+
+            npy_intp dims[1] = {{PyArray_DIMS({x_val})[0]}};
+            Py_XDECREF({z_val});
+            Py_XDECREF({z_ind});
+            {z_val} = (PyArrayObject*)PyArray_SimpleNew(1, dims, {typenum});
+            {z_ind} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            if (!{z_val} || !{z_ind}) {{{fail};}}
+            aesara_csx_sort_indices(nmajor, dims[0], x,
+                                    (npy_int32*)PyArray_DATA({z_ind}),
+                                    (dtype_{z_val}*)PyArray_DATA({z_val}), {parallel});
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
+
+# register a specialization to replace EnsureSortedIndices{no_inplace}
+# -> EnsureSortedIndicesCSx
+@local_optimizer([sparse.EnsureSortedIndices])
+def local_ensure_sorted_indices_csx(fgraph, node):
+    if isinstance(node.op, sparse.EnsureSortedIndices) and not node.op.inplace:
+        (x,) = node.inputs
+        if not _csx_supported(x):
+            return False
+        CSx = sparse.CSC if x.type.format == "csc" else sparse.CSR
+        x_val, x_ind, x_ptr, x_shape = csm_properties(x)
+        z_val, z_ind = EnsureSortedIndicesCSx()(x_val, x_ind, x_ptr)
+        return [CSx(z_val, z_ind, x_ptr, x_shape)]
+    return False
+
+
+register_specialize(local_ensure_sorted_indices_csx, "cxx_only")
+
+
+class StackCSx(COp):
+    """
+    Stack sparse matrices along their major axis, on their (data, indices,
+    indptr, shape) quadruplets: vertically for csr, horizontally for csc.
+
+    Parameters
+    ----------
+    format
+        ``"csr"`` or ``"csc"``, the format of all the blocks and the output.
+    dtype
+        The output dtype.
+
+    Returns
+    -------
+    The data, indices, indptr and shape of the stacked matrix.
+
+    Notes
+    -----
+    This op is used as an optimization for VStack to csr and HStack to csc.
+    Along the major axis, stacking only concatenates the rows.
+
+    """
+
+    __props__ = ("format", "dtype")
+
+    def __init__(self, format, dtype):
+        if format not in ("csr", "csc"):
+            raise ValueError(f"Unknown format {format}")
+        self.format = format
+        self.dtype = dtype
+
+    def make_node(self, *blocks):
+        if not blocks or len(blocks) % 4:
+            raise ValueError("Expected (data, indices, indptr, shape) for each block.")
+        blocks = [as_tensor_variable(b) for b in blocks]
+        for i, b in enumerate(blocks):
+            assert b.ndim == 1
+            if i % 4:
+                assert b.dtype == "int32"
+        return Apply(
+            self,
+            blocks,
+            [tensor(self.dtype, (False,)), ivector(), ivector(), ivector()],
+        )
+
+    def perform(self, node, inputs, outputs):
+        cls = getattr(scipy.sparse, self.format + "_matrix")
+        blocks = [
+            cls(tuple(inputs[i : i + 3]), tuple(inputs[i + 3]))
+            for i in range(0, len(inputs), 4)
+        ]
+        stack = scipy.sparse.vstack if self.format == "csr" else scipy.sparse.hstack
+        z = stack(blocks, format=self.format, dtype=self.dtype)
+        outputs[0][0] = _asarray(z.data, dtype=self.dtype)
+        outputs[1][0] = _asarray(z.indices, dtype="int32")
+        outputs[2][0] = _asarray(z.indptr, dtype="int32")
+        outputs[3][0] = _asarray(z.shape, dtype="int32")
+
+    def c_support_code(self, **kwargs):
+        return _csx_c_support_code + _csx_copy_c_support_code
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        z_val, z_ind, z_ptr, z_shape = outputs
+        if self.dtype in sparse.complex_dtypes or any(
+            i.type.dtype in sparse.complex_dtypes for i in node.inputs[::4]
+        ):
+            raise NotImplementedError("Complex types are not supported")
+        fail = sub["fail"]
+        typenum_z = node.outputs[0].type.dtype_specs()[2]
+        major, minor = (0, 1) if self.format == "csr" else (1, 0)
+        blocks = [inputs[i : i + 4] for i in range(0, len(inputs), 4)]
+
+        code = """
+        {
+            npy_intp nmajor = 0, nminor = -1, nnz = 0;
+        """
+        for i, (val, ind, ptr, shp) in enumerate(blocks):
+            code += f"""
+            if (PyArray_NDIM({shp}) != 1 || PyArray_DIMS({shp})[0] != 2)
+            {{PyErr_SetString(PyExc_ValueError, "shapes must have two elements"); {fail};}}
+            npy_intp nmajor_{i} = *(npy_int32*)PyArray_GETPTR1({shp}, {major});
+            if (nminor < 0)
+                nminor = *(npy_int32*)PyArray_GETPTR1({shp}, {minor});
+            else if (nminor != *(npy_int32*)PyArray_GETPTR1({shp}, {minor}))
+            {{PyErr_SetString(PyExc_ValueError, "mismatched dimensions in StackCSx"); {fail};}}
+            aesara_csx<dtype_{val}> x_{i} = aesara_csx_from<dtype_{val}>({val}, {ind}, {ptr});
+            if (aesara_csx_check("block", x_{i}, {val}, {ind}, {ptr}, nmajor_{i}, nminor))
+            {{{fail};}}
+            nmajor += nmajor_{i};
+            nnz += x_{i}.begin(nmajor_{i}) - x_{i}.begin(0);
+            """
+        code += f"""
+            if (nnz > NPY_MAX_INT32 || nmajor > NPY_MAX_INT32)
+            {{PyErr_SetString(PyExc_ValueError, "too many nonzeros (overflows int32 index)"); {fail};}}
+            Py_XDECREF({z_val});
+            Py_XDECREF({z_ind});
+            Py_XDECREF({z_ptr});
+            Py_XDECREF({z_shape});
+            npy_intp dims[1] = {{nnz}};
+            {z_val} = (PyArrayObject*)PyArray_SimpleNew(1, dims, {typenum_z});
+            {z_ind} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            dims[0] = nmajor + 1;
+            {z_ptr} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            dims[0] = 2;
+            {z_shape} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            if (!{z_val} || !{z_ind} || !{z_ptr} || !{z_shape}) {{{fail};}}
+            ((npy_int32*)PyArray_DATA({z_shape}))[{major}] = (npy_int32)nmajor;
+            ((npy_int32*)PyArray_DATA({z_shape}))[{minor}] = (npy_int32)nminor;
+
+            npy_int32* zptr = (npy_int32*)PyArray_DATA({z_ptr});
+            npy_int32* zind = (npy_int32*)PyArray_DATA({z_ind});
+            dtype_{z_val}* zval = (dtype_{z_val}*)PyArray_DATA({z_val});
+            zptr[0] = 0;
+            nnz = 0;
+        """
+        for i in range(len(blocks)):
+            code += f"""
+            aesara_csx_copy_rows(x_{i}, 0, nmajor_{i}, zptr, zind, zval, &nnz);
+            zptr += nmajor_{i};
+            """
+        code += """
+        }
+        """
+        return code
+
+    def c_code_cache_version(self):
+        return (1,)
+
+
+# register a specialization to replace VStack to csr and HStack to csc of
+# blocks in the same format -> StackCSx
+@local_optimizer([sparse.HStack, sparse.VStack])
+def local_stack_csx(fgraph, node):
+    if isinstance(node.op, sparse.HStack):
+        format = "csr" if isinstance(node.op, sparse.VStack) else "csc"
+        if node.op.format != format or not _csx_supported(*node.inputs, *node.outputs):
+            return False
+        if any(b.type.format != format for b in node.inputs):
+            return False
+        CSx = sparse.CSC if format == "csc" else sparse.CSR
+        blocks = [p for b in node.inputs for p in csm_properties(b)]
+        return [CSx(*StackCSx(format, node.op.dtype)(*blocks))]
+    return False
+
+
+register_specialize(local_stack_csx, "cxx_only")
+
+
+class SliceCSx(COp):
+    """
+    Slice of the rows (csr) or columns (csc) of a sparse matrix, on its
+    (data, indices, indptr, shape) quadruplet.
+
+    Parameters
+    ----------
+    format
+        ``"csr"`` or ``"csc"``, the format of the matrix.
+
+    Returns
+    -------
+    The data, indices, indptr and shape of the slice ``start:stop`` of the
+    matrix along its major axis.  As in Python, ``start`` and ``stop`` can be
+    negative or out of bounds.
+
+    Notes
+    -----
+    This op is used as an optimization for GetItem2d, when only the major
+    axis is sliced, without a step.
+
+    """
+
+    __props__ = ("format",)
+
+    def __init__(self, format):
+        if format not in ("csr", "csc"):
+            raise ValueError(f"Unknown format {format}")
+        self.format = format
+
+    def make_node(self, x_val, x_ind, x_ptr, x_shape, start, stop):
+        x_val, x_ind, x_ptr, x_shape = map(
+            as_tensor_variable, [x_val, x_ind, x_ptr, x_shape]
+        )
+        for i in (x_ind, x_ptr, x_shape):
+            assert i.dtype == "int32" and i.ndim == 1
+        assert x_val.ndim == 1
+        start = cast(as_tensor_variable(start), "int64")
+        stop = cast(as_tensor_variable(stop), "int64")
+        assert start.ndim == 0 and stop.ndim == 0
+        return Apply(
+            self,
+            [x_val, x_ind, x_ptr, x_shape, start, stop],
+            [x_val.type(), ivector(), ivector(), ivector()],
+        )
+
+    def perform(self, node, inputs, outputs):
+        x_val, x_ind, x_ptr, x_shape, start, stop = inputs
+        major = 0 if self.format == "csr" else 1
+        start, stop, _ = slice(int(start), int(stop)).indices(x_shape[major])
+        stop = max(start, stop)
+        p0, p1 = x_ptr[start], x_ptr[stop]
+        z_shape = np.array(x_shape, dtype="int32")
+        z_shape[major] = stop - start
+        outputs[0][0] = x_val[p0:p1].copy()
+        outputs[1][0] = x_ind[p0:p1].copy()
+        outputs[2][0] = _asarray(x_ptr[start : stop + 1] - p0, dtype="int32")
+        outputs[3][0] = z_shape
+
+    def c_support_code(self, **kwargs):
+        return _csx_c_support_code + _csx_copy_c_support_code
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        x_val, x_ind, x_ptr, x_shape, start, stop = inputs
+        z_val, z_ind, z_ptr, z_shape = outputs
+        if node.inputs[0].type.dtype in sparse.complex_dtypes:
+            raise NotImplementedError("Complex types are not supported")
+        fail = sub["fail"]
+        typenum = node.inputs[0].type.dtype_specs()[2]
+        major, minor = (0, 1) if self.format == "csr" else (1, 0)
+
+        return f"""
+        {{
+            if (PyArray_NDIM({x_shape}) != 1 || PyArray_DIMS({x_shape})[0] != 2)
+            {{PyErr_SetString(PyExc_ValueError, "shape must have two elements"); {fail};}}
+            npy_intp nmajor = *(npy_int32*)PyArray_GETPTR1({x_shape}, {major});
+            npy_intp nminor = *(npy_int32*)PyArray_GETPTR1({x_shape}, {minor});
+            aesara_csx<dtype_{x_val}> x = aesara_csx_from<dtype_{x_val}>({x_val}, {x_ind}, {x_ptr});
+            if (aesara_csx_check("x", x, {x_val}, {x_ind}, {x_ptr}, nmajor, nminor))
+            {{{fail};}}
+
+            npy_int64 start = *(npy_int64*)PyArray_DATA({start});
+            npy_int64 stop = *(npy_int64*)PyArray_DATA({stop});
+            if (start < 0)
+                start += nmajor;
+            if (stop < 0)
+                stop += nmajor;
+            start = std::min<npy_int64>(std::max<npy_int64>(start, 0), nmajor);
+            stop = std::min<npy_int64>(std::max<npy_int64>(stop, start), nmajor);
+
+            Py_XDECREF({z_val});
+            Py_XDECREF({z_ind});
+            Py_XDECREF({z_ptr});
+            Py_XDECREF({z_shape});
+            npy_intp dims[1] = {{x.begin(stop) - x.begin(start)}};
+            {z_val} = (PyArrayObject*)PyArray_SimpleNew(1, dims, {typenum});
+            {z_ind} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            dims[0] = stop - start + 1;
+            {z_ptr} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            dims[0] = 2;
+            {z_shape} = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+            if (!{z_val} || !{z_ind} || !{z_ptr} || !{z_shape}) {{{fail};}}
+            ((npy_int32*)PyArray_DATA({z_shape}))[{major}] = (npy_int32)(stop - start);
+            ((npy_int32*)PyArray_DATA({z_shape}))[{minor}] = (npy_int32)nminor;
+
+            npy_intp nnz = 0;
+            aesara_csx_copy_rows(x, start, stop, (npy_int32*)PyArray_DATA({z_ptr}),
+                                 (npy_int32*)PyArray_DATA({z_ind}),
+                                 (dtype_{z_val}*)PyArray_DATA({z_val}), &nnz);
+        }}
+        """
+
+    def c_headers(self, **kwargs):
+        return ["<algorithm>"]
+
+    def c_code_cache_version(self):
+        return (1,)
+
+
+def _is_none_constant(v):
+    return isinstance(v, Constant) and v.data is None
+
+
+# register a specialization to replace GetItem2d of a slice of the major
+# axis -> SliceCSx
+@local_optimizer([sparse.GetItem2d])
+def local_get_item_2d_csx(fgraph, node):
+    if isinstance(node.op, sparse.GetItem2d):
+        x = node.inputs[0]
+        if not _csx_supported(x):
+            return False
+        if x.type.format == "csr":
+            (start, stop, step), minor = node.inputs[1:4], node.inputs[4:]
+        else:
+            (start, stop, step), minor = node.inputs[4:], node.inputs[1:4]
+        if not (_is_none_constant(step) and all(map(_is_none_constant, minor))):
+            return False
+        if _is_none_constant(start):
+            start = 0
+        if _is_none_constant(stop):
+            stop = np.iinfo(np.int64).max
+        CSx = sparse.CSC if x.type.format == "csc" else sparse.CSR
+        return [CSx(*SliceCSx(x.type.format)(*csm_properties(x), start, stop))]
+    return False
+
+
+register_specialize(local_get_item_2d_csx, "cxx_only")
+
+
+_bsr_dense_c_support_code = """
+#ifndef _AESARA_BSR_DENSE
+#define _AESARA_BSR_DENSE
+
+// z[r, :] = sum over the blocks j of block row br of a[j] . b[block rows]
+// for the block rows br_begin <= br < br_end of a bsr matrix with R x C
+// blocks.  b and z are row-major with contiguous rows Sb and Sz elements
+// apart.  When RT and CT are not 0 they are the block shape, known at
+// compile time: each row of a block is then kept in registers while the
+// loop over the columns of b is vectorised.
+template <int RT, int CT, typename Tz, typename Ta, typename Tb>
+static void aesara_bsr_dense_rows(npy_intp br_begin, npy_intp br_end,
+                                  npy_intp Rr, npy_intp Cr, npy_intp N,
+                                  const npy_int32* __restrict__ ptr,
+                                  const npy_int32* __restrict__ ind,
+                                  const Ta* __restrict__ data,
+                                  const Tb* __restrict__ b, npy_intp Sb,
+                                  Tz* __restrict__ z, npy_intp Sz)
+{
+    const npy_intp R = RT ? RT : Rr;
+    const npy_intp C = CT ? CT : Cr;
+    for (npy_intp br = br_begin; br < br_end; ++br)
+    {
+        Tz* __restrict__ zb = z + br * R * Sz;
+        for (npy_intp r = 0; r < R; ++r)
+            memset(zb + r * Sz, 0, N * sizeof(Tz));
+        for (npy_int32 j = ptr[br]; j < ptr[br + 1]; ++j)
+        {
+            const Ta* __restrict__ a = data + j * R * C;
+            const Tb* __restrict__ bb = b + ind[j] * C * Sb;
+            if (N == 1)
+            {
+                for (npy_intp r = 0; r < R; ++r)
+                {
+                    Tz acc = 0;
+                    for (npy_intp c = 0; c < C; ++c)
+                        acc += a[r * C + c] * bb[c * Sb];
+                    zb[r * Sz] += acc;
+                }
+                continue;
+            }
+            for (npy_intp r = 0; r < R; ++r)
+            {
+                Tz* __restrict__ zr = zb + r * Sz;
+                const Ta* __restrict__ ar = a + r * C;
+                #pragma omp simd
+                for (npy_intp n = 0; n < N; ++n)
+                {
+                    Tz acc = zr[n];
+                    for (npy_intp c = 0; c < C; ++c)
+                        acc += ar[c] * bb[c * Sb + n];
+                    zr[n] = acc;
+                }
+            }
+        }
+    }
+}
+
+// z[perm[p], n] = sum_k val[k] * b[col[k], n] over the entries k of the
+// row stored in lane p % CH of slice p / CH of a SELL-CH-sigma matrix.
+// The entries of a slice are stored column by column, CH at a time, so
+// that the lanes of a slice are processed together.  The lanes past the
+// length rlen[p] of their row are padding, which is skipped rather than
+// multiplied, so that non-finite values of b don't leak into other rows.
+// The columns of b are contiguous, Sbn elements apart.
+template <int CH, typename Tz, typename Ta, typename Tb>
+static void aesara_sell_dense_slices(npy_intp s_begin, npy_intp s_end,
+                                     npy_intp M, npy_intp N,
+                                     const npy_int32* __restrict__ sptr,
+                                     const npy_int32* __restrict__ col,
+                                     const npy_int32* __restrict__ perm,
+                                     const npy_int32* __restrict__ rlen,
+                                     const Ta* __restrict__ val,
+                                     const Tb* __restrict__ b, npy_intp Sbn,
+                                     Tz* __restrict__ z,
+                                     npy_intp Szm, npy_intp Szn)
+{
+    for (npy_intp s = s_begin; s < s_end; ++s)
+    {
+        npy_intp width = (sptr[s + 1] - sptr[s]) / CH;
+        npy_int32 len[CH];
+        for (int l = 0; l < CH; ++l)
+            len[l] = s * CH + l < M ? rlen[s * CH + l] : 0;
+        for (npy_intp n = 0; n < N; ++n)
+        {
+            const Tb* __restrict__ bn = b + n * Sbn;
+            Tz acc[CH] = {0};
+            for (npy_intp k = 0; k < width; ++k)
+            {
+                const Ta* __restrict__ v = val + sptr[s] + k * CH;
+                const npy_int32* __restrict__ c = col + sptr[s] + k * CH;
+                #pragma omp simd
+                for (int l = 0; l < CH; ++l)
+                    acc[l] += k < len[l] ? (Tz)(v[l] * bn[c[l]]) : (Tz)0;
+            }
+            for (int l = 0; l < CH && s * CH + l < M; ++l)
+                z[perm[s * CH + l] * Szm + n * Szn] = acc[l];
+        }
+    }
+}
+
+#endif
+"""
+
+
+class StructuredDotBSR(OpenMPOp):
+    """
+    Structured Dot of a bsr matrix, given by its properties, and a dense
+    matrix.
+
+    Parameters
+    ----------
+    a_data
+        The R x C blocks of the sparse matrix, of shape (nblocks, R, C).
+    a_ind
+        The block column of each block.
+    a_ptr
+        Indicates the blocks of block row i are in the range
+        a_ptr[i]:a_ptr[i+1].
+    b
+        Dense matrix to perform dot product with, as in dot(a, b).
+
+    Returns
+    -------
+    matrix
+        The dot product of `a` and `b`.
+
+    Notes
+    -----
+    This op is used as an optimization for StructuredDot, and Dot with a
+    constant sparse matrix whose nonzeros come in dense blocks.
+
+    The blocks are multiplied with a dense micro-kernel, specialized for
+    the usual block shapes, that keeps the rows of a block in registers and
+    runs over the columns of `b` with SIMD instructions, instead of
+    indexing `b` once per nonzero.  When OpenMP is enabled, the block rows
+    are split between the threads.
+
+    """
+
+    __props__ = ()
+
+    # Block shapes with a specialized micro-kernel
+    block_shapes = [(2, 2), (3, 3), (4, 4), (6, 6), (8, 8), (4, 1), (8, 1), (1, 4)]
+
+    def make_node(self, a_data, a_ind, a_ptr, b):
+        a_data, a_ind, a_ptr, b = map(as_tensor_variable, [a_data, a_ind, a_ptr, b])
+        assert a_data.ndim == 3 and b.ndim == 2
+        assert a_ind.dtype == "int32" and a_ptr.dtype == "int32"
+        dtype_out = aes.upcast(a_data.type.dtype, b.type.dtype)
+        return Apply(
+            self,
+            [a_data, a_ind, a_ptr, b],
+            [tensor(dtype_out, (False, b.type.broadcastable[1]))],
+        )
+
+    def perform(self, node, inputs, outputs):
+        (a_data, a_ind, a_ptr, b) = inputs
+        (out,) = outputs
+        R, C = a_data.shape[1:]
+        a = scipy.sparse.bsr_matrix(
+            (a_data, a_ind, a_ptr), shape=((len(a_ptr) - 1) * R, b.shape[0])
+        )
+        out[0] = _asarray(a @ b, dtype=node.outputs[0].dtype)
+
+    def _check_structure(self, a_ind, a_ptr):
+        """Raise a ValueError if the arrays are not a bsr structure.
+
+        Returns the largest block column index.
+
+        """
+        if (
+            len(a_ptr) == 0
+            or a_ptr[0] != 0
+            or a_ptr[-1] != len(a_ind)
+            or np.any(np.diff(a_ptr) < 0)
+            or np.any(a_ind < 0)
+        ):
+            raise ValueError("invalid bsr structure")
+        return int(a_ind.max()) if len(a_ind) else -1
+
+    def c_support_code(self, **kwargs):
+        return _csr_dense_c_support_code + _bsr_dense_c_support_code
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        (a_data, a_ind, a_ptr, b) = inputs
+        (z,) = outputs
+        if any(i.type.dtype in sparse.complex_dtypes for i in node.inputs):
+            raise NotImplementedError("Complex types are not supported")
+        fail = sub["fail"]
+        typenum_z = node.outputs[0].type.dtype_specs()[2]
+        ta, tb, tz = (f"dtype_{a_data}", f"dtype_{b}", f"dtype_{z}")
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            omp_parallel = (
+                f"#pragma omp parallel if(PyArray_SIZE(a_data) * N >= {minsize})"
+            )
+        else:
+            omp_parallel = ""
+        if all(isinstance(v, Constant) for v in node.inputs[1:3]):
+            # Check constant structures once, here, rather than at each call
+            max_col = self._check_structure(node.inputs[1].data, node.inputs[2].data)
+            check = f"err = err || ({max_col} + 1) * C > K;"
+        else:
+            check = """
+            err = err || ptr[0] != 0;
+            for (npy_intp i = 0; !err && i < nbr; ++i)
+                err = ptr[i] > ptr[i + 1];
+            for (npy_intp j = 0; !err && j < nblocks; ++j)
+                err = ind[j] < 0 || (ind[j] + 1) * C > K;
+            """
+        args = "br_begin, br_end, R, C, N, ptr, ind, data, bd, Sb, zd, Sz"
+        dispatch = "".join(
+            f"if (R == {r} && C == {c}) "
+            f"aesara_bsr_dense_rows<{r}, {c}, {tz}, {ta}, {tb}>({args});\n"
+            "                else "
+            for r, c in self.block_shapes
+        )
+        dispatch += f"aesara_bsr_dense_rows<0, 0, {tz}, {ta}, {tb}>({args});"
+
+        return f"""
+        {{
+            if (PyArray_NDIM({a_ind}) != 1 || PyArray_NDIM({a_ptr}) != 1)
+            {{PyErr_SetString(PyExc_ValueError, "a_ind and a_ptr must be vectors"); {fail};}}
+            npy_intp nbr = PyArray_DIMS({a_ptr})[0] - 1;
+            npy_intp nblocks = PyArray_DIMS({a_data})[0];
+            npy_intp R = PyArray_DIMS({a_data})[1];
+            npy_intp C = PyArray_DIMS({a_data})[2];
+            npy_intp K = PyArray_DIMS({b})[0];
+            npy_intp N = PyArray_DIMS({b})[1];
+            if (nbr < 0 || PyArray_DIMS({a_ind})[0] != nblocks)
+            {{PyErr_SetString(PyExc_ValueError, "a_data, a_ind and a_ptr do not match"); {fail};}}
+            if (K % (C ? C : 1) != 0 || (C == 0 && K != 0))
+            {{PyErr_SetString(PyExc_ValueError, "the number of rows of b is not a multiple of the block width"); {fail};}}
+
+            PyArrayObject* a_data = PyArray_GETCONTIGUOUS({a_data});
+            PyArrayObject* a_ind = PyArray_GETCONTIGUOUS({a_ind});
+            PyArrayObject* a_ptr = PyArray_GETCONTIGUOUS({a_ptr});
+            PyArrayObject* b = PyArray_GETCONTIGUOUS({b});
+            const npy_int32* ptr = (const npy_int32*)PyArray_DATA(a_ptr);
+            const npy_int32* ind = (const npy_int32*)PyArray_DATA(a_ind);
+            int err = ptr[nbr] != nblocks;
+            {check}
+            if (err)
+            {{
+                Py_DECREF(a_data); Py_DECREF(a_ind); Py_DECREF(a_ptr); Py_DECREF(b);
+                PyErr_SetString(PyExc_ValueError, "invalid bsr structure");
+                {fail};
+            }}
+
+            if (!{z} || !PyArray_IS_C_CONTIGUOUS({z})
+                || PyArray_DIMS({z})[0] != nbr * R || PyArray_DIMS({z})[1] != N)
+            {{
+                Py_XDECREF({z});
+                npy_intp dims[2] = {{nbr * R, N}};
+                {z} = (PyArrayObject*)PyArray_SimpleNew(2, dims, {typenum_z});
+            }}
+            if (!{z})
+            {{
+                Py_DECREF(a_data); Py_DECREF(a_ind); Py_DECREF(a_ptr); Py_DECREF(b);
+                {fail};
+            }}
+
+            const {ta}* data = (const {ta}*)PyArray_DATA(a_data);
+            const {tb}* bd = (const {tb}*)PyArray_DATA(b);
+            {tz}* zd = ({tz}*)PyArray_DATA({z});
+            npy_intp Sb = N, Sz = N;
+            {omp_parallel}
+            {{
+                npy_intp br_begin, br_end;
+                aesara_csr_thread_rows(ptr, 1, nbr, &br_begin, &br_end);
+                {dispatch}
+            }}
+            Py_DECREF(a_data); Py_DECREF(a_ind); Py_DECREF(a_ptr); Py_DECREF(b);
+        }}
+        """
+
+    def c_compile_args(self, **kwargs):
+        return super().c_compile_args(**kwargs) + ["-fopenmp-simd"]
+
+    def c_code_cache_version(self):
+        return (2, self.openmp, config.openmp_elemwise_minsize)
+
+
+sd_bsr = StructuredDotBSR()
+
+
+def _csr_to_sell(a, chunk, sigma):
+    """
+    Pack a csr matrix in the SELL-`chunk`-`sigma` format.
+
+    The rows are sorted by decreasing number of nonzeros within windows of
+    `sigma` rows, then grouped in slices of `chunk` rows, each padded to its
+    longest row and stored column by column.
+
+    Returns
+    -------
+    (val, col, slice_ptr, perm, row_len)
+        `perm[p]` is the row of `a` stored at position ``p``, `row_len[p]`
+        its number of entries, and the entries of slice ``s`` are
+        ``val[slice_ptr[s]:slice_ptr[s + 1]]``.  The padding lanes are zeros.
+
+    """
+    M = a.shape[0]
+    lengths = np.diff(a.indptr)
+    perm = np.arange(M)
+    for w in range(0, M, sigma):
+        window = perm[w : w + sigma]
+        perm[w : w + sigma] = window[np.argsort(-lengths[window], kind="stable")]
+    n_slices = -(-M // chunk)
+    padded = np.zeros(n_slices * chunk, dtype=lengths.dtype)
+    padded[:M] = lengths[perm]
+    widths = padded.reshape(n_slices, chunk).max(axis=1)
+    slice_ptr = np.zeros(n_slices + 1, dtype="int32")
+    np.cumsum(widths * chunk, out=slice_ptr[1:])
+
+    # Position of each entry of each stored row
+    row_len = lengths[perm]
+    p = np.repeat(np.arange(M), row_len)
+    k = np.arange(len(p)) - np.repeat(np.cumsum(row_len) - row_len, row_len)
+    dest = slice_ptr[p // chunk] + k * chunk + p % chunk
+    src = np.repeat(a.indptr[perm], row_len) + k
+
+    val = np.zeros(slice_ptr[-1], dtype=a.dtype)
+    col = np.zeros(slice_ptr[-1], dtype="int32")
+    val[dest] = a.data[src]
+    col[dest] = a.indices[src]
+    return val, col, slice_ptr, perm.astype("int32"), row_len.astype("int32")
+
+
+class StructuredDotSELL(OpenMPOp):
+    """
+    Structured Dot of a sparse matrix in the SELL-C-sigma format and a
+    dense matrix.
+
+    Parameters
+    ----------
+    chunk
+        The number C of rows per slice. The lanes of a slice are computed
+        with SIMD instructions.
+
+    Notes
+    -----
+    The inputs are the arrays returned by `_csr_to_sell` and the dense
+    matrix `b`.  The padding of the rows is skipped using their lengths, so
+    that it never multiplies `b`.  This op is used as an optimization for matrix-vector
+    products with a constant sparse matrix: unlike csr, the inner loop runs
+    over the rows of a slice, so it stays vectorised whatever the length of
+    the rows.  When OpenMP is enabled, the slices are split between the
+    threads.
+
+    """
+
+    __props__ = ("chunk",)
+
+    def __init__(self, chunk=8, openmp=None):
+        super().__init__(openmp=openmp)
+        self.chunk = chunk
+
+    def make_node(self, val, col, slice_ptr, perm, row_len, b):
+        val, col, slice_ptr, perm, row_len, b = map(
+            as_tensor_variable, [val, col, slice_ptr, perm, row_len, b]
+        )
+        assert val.ndim == 1 and b.ndim == 2
+        for i in (col, slice_ptr, perm, row_len):
+            assert i.dtype == "int32" and i.ndim == 1
+        dtype_out = aes.upcast(val.type.dtype, b.type.dtype)
+        return Apply(
+            self,
+            [val, col, slice_ptr, perm, row_len, b],
+            [tensor(dtype_out, (False, b.type.broadcastable[1]))],
+        )
+
+    def perform(self, node, inputs, outputs):
+        (val, col, slice_ptr, perm, row_len, b) = inputs
+        (out,) = outputs
+        M, C = len(perm), self.chunk
+        n_slices = len(slice_ptr) - 1
+        z = np.zeros((n_slices * C, b.shape[1]), dtype=node.outputs[0].dtype)
+        lengths = np.zeros(n_slices * C, dtype=row_len.dtype)
+        lengths[:M] = row_len
+        for s in range(n_slices):
+            v = val[slice_ptr[s] : slice_ptr[s + 1]].reshape(-1, C)
+            c = col[slice_ptr[s] : slice_ptr[s + 1]].reshape(-1, C)
+            mask = np.arange(len(v))[:, None] < lengths[s * C : (s + 1) * C]
+            terms = np.where(mask[:, :, None], v[:, :, None] * b[c], 0)
+            z[s * C : (s + 1) * C] = terms.sum(axis=0)
+        out[0] = np.empty_like(z[:M])
+        out[0][perm] = z[:M]
+
+    def _check_structure(self, col, slice_ptr, perm, row_len):
+        """Raise a ValueError if the arrays are not a SELL structure.
+
+        Returns the largest column index.
+
+        """
+        widths = np.diff(slice_ptr)
+        if (
+            len(slice_ptr) != -(-len(perm) // self.chunk) + 1
+            or slice_ptr[0] != 0
+            or slice_ptr[-1] != len(col)
+            or np.any(widths < 0)
+            or np.any(widths % self.chunk)
+            or np.any(col < 0)
+            or not np.array_equal(np.sort(perm), np.arange(len(perm)))
+            or len(row_len) != len(perm)
+            or np.any(row_len < 0)
+            or np.any(
+                row_len > np.repeat(widths // self.chunk, self.chunk)[: len(row_len)]
+            )
+        ):
+            raise ValueError("invalid SELL structure")
+        return int(col.max()) if len(col) else -1
+
+    def c_support_code(self, **kwargs):
+        return _bsr_dense_c_support_code
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        (val, col, slice_ptr, perm, row_len, b) = inputs
+        (z,) = outputs
+        if any(i.type.dtype in sparse.complex_dtypes for i in node.inputs):
+            raise NotImplementedError("Complex types are not supported")
+        fail = sub["fail"]
+        typenum_z = node.outputs[0].type.dtype_specs()[2]
+        ta, tb, tz = (f"dtype_{val}", f"dtype_{b}", f"dtype_{z}")
+        CH = self.chunk
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            omp_parallel = (
+                "#pragma omp parallel for schedule(static) "
+                f"if(PyArray_SIZE(val) * N >= {minsize})"
+            )
+        else:
+            omp_parallel = ""
+        if all(isinstance(v, Constant) for v in node.inputs[1:5]):
+            # Check constant structures once, here, rather than at each call
+            max_col = self._check_structure(*[v.data for v in node.inputs[1:5]])
+            check = f"err = err || {max_col} >= K;"
+        else:
+            check = f"""
+            err = err || sp[0] != 0;
+            for (npy_intp s = 0; !err && s < n_slices; ++s)
+                err = sp[s] > sp[s + 1] || (sp[s + 1] - sp[s]) % {CH};
+            for (npy_intp k = 0; !err && k < PyArray_DIMS(col)[0]; ++k)
+                err = c[k] < 0 || c[k] >= K;
+            for (npy_intp p = 0; !err && p < M; ++p)
+                err = rl[p] < 0 || rl[p] > (sp[p / {CH} + 1] - sp[p / {CH}]) / {CH};
+            // perm must be a permutation, for every row of z to be written
+            char* seen = (char*)calloc(M + 1, 1);
+            err = err || !seen;
+            for (npy_intp p = 0; !err && p < M; ++p)
+            {{
+                err = pm[p] < 0 || pm[p] >= M || seen[pm[p]];
+                if (!err)
+                    seen[pm[p]] = 1;
+            }}
+            free(seen);
+            """
+
+        return f"""
+        {{
+            npy_intp n_slices = PyArray_DIMS({slice_ptr})[0] - 1;
+            npy_intp M = PyArray_DIMS({perm})[0];
+            npy_intp K = PyArray_DIMS({b})[0];
+            npy_intp N = PyArray_DIMS({b})[1];
+            if (n_slices < 0 || (M + {CH} - 1) / {CH} != n_slices
+                || PyArray_DIMS({col})[0] != PyArray_DIMS({val})[0]
+                || PyArray_DIMS({row_len})[0] != M)
+            {{PyErr_SetString(PyExc_ValueError, "inconsistent SELL arrays"); {fail};}}
+
+            PyArrayObject* val = PyArray_GETCONTIGUOUS({val});
+            PyArrayObject* col = PyArray_GETCONTIGUOUS({col});
+            PyArrayObject* sptr = PyArray_GETCONTIGUOUS({slice_ptr});
+            PyArrayObject* perm = PyArray_GETCONTIGUOUS({perm});
+            PyArrayObject* rlen = PyArray_GETCONTIGUOUS({row_len});
+            const npy_int32* sp = (const npy_int32*)PyArray_DATA(sptr);
+            const npy_int32* c = (const npy_int32*)PyArray_DATA(col);
+            const npy_int32* pm = (const npy_int32*)PyArray_DATA(perm);
+            const npy_int32* rl = (const npy_int32*)PyArray_DATA(rlen);
+            int err = sp[n_slices] != PyArray_DIMS(val)[0];
+            {check}
+            if (err)
+            {{
+                Py_DECREF(val); Py_DECREF(col); Py_DECREF(sptr); Py_DECREF(perm); Py_DECREF(rlen);
+                PyErr_SetString(PyExc_ValueError, "invalid SELL structure");
+                {fail};
+            }}
+
+            if (!{z} || PyArray_DIMS({z})[0] != M || PyArray_DIMS({z})[1] != N)
+            {{
+                Py_XDECREF({z});
+                npy_intp dims[2] = {{M, N}};
+                {z} = (PyArrayObject*)PyArray_SimpleNew(2, dims, {typenum_z});
+            }}
+            if (!{z})
+            {{
+                Py_DECREF(val); Py_DECREF(col); Py_DECREF(sptr); Py_DECREF(perm); Py_DECREF(rlen);
+                {fail};
+            }}
+
+            const {ta}* v = (const {ta}*)PyArray_DATA(val);
+            // Fortran order makes the gathered columns of b contiguous
+            PyArrayObject* b = (PyArrayObject*)PyArray_FromArray(
+                {b}, NULL, NPY_ARRAY_F_CONTIGUOUS | NPY_ARRAY_ALIGNED);
+            if (!b)
+            {{
+                Py_DECREF(val); Py_DECREF(col); Py_DECREF(sptr); Py_DECREF(perm); Py_DECREF(rlen);
+                {fail};
+            }}
+            const {tb}* bd = (const {tb}*)PyArray_DATA(b);
+            npy_intp Szm = PyArray_STRIDES({z})[0] / (npy_intp)sizeof({tz});
+            npy_intp Szn = PyArray_STRIDES({z})[1] / (npy_intp)sizeof({tz});
+            {tz}* zd = ({tz}*)PyArray_DATA({z});
+            {omp_parallel}
+            for (npy_intp s = 0; s < n_slices; ++s)
+                aesara_sell_dense_slices<{CH}, {tz}, {ta}, {tb}>(
+                    s, s + 1, M, N, sp, c, pm, rl, v, bd, K, zd, Szm, Szn);
+            Py_DECREF(val); Py_DECREF(col); Py_DECREF(sptr); Py_DECREF(perm); Py_DECREF(rlen);
+            Py_DECREF(b);
+        }}
+        """
+
+    def c_compile_args(self, **kwargs):
+        return super().c_compile_args(**kwargs) + ["-fopenmp-simd"]
+
+    def c_code_cache_version(self):
+        return (4, self.openmp, config.openmp_elemwise_minsize)
+
+
+# Block shapes tried for constant sparse matrices, largest first.  Only
+# blocks filled with nonzeros are used: the zeros that bsr stores in the
+# other ones would multiply the dense operand, and turn its inf and NaN
+# into NaN in rows where they don't belong.
+_bsr_block_shapes = [(8, 8), (4, 4), (2, 2)]
+# Rows per slice and sorting window of the SELL format
+_sell_chunk = 8
+_sell_sigma = 256
+
+
+def _bsr_blocksize(a):
+    """The largest block shape of `_bsr_block_shapes` that `a` fills."""
+    M, K = a.shape
+    rows = np.repeat(np.arange(M, dtype="int64"), np.diff(a.indptr))
+    for R, C in _bsr_block_shapes:
+        if M % R or K % C:
+            continue
+        n_blocks = len(np.unique(rows // R * (K // C) + a.indices // C))
+        if a.nnz == n_blocks * R * C:
+            return (R, C)
+    return None
+
+
+# register a specialization to replace StructuredDot and Dot of a bsr
+# matrix, or of a constant sparse matrix, and a dense one ->
+# StructuredDotBSR or StructuredDotSELL
+@local_optimizer([sparse._structured_dot, sparse._dot])
+def local_structured_dot_blocked(fgraph, node):
+    """
+    A bsr matrix goes to StructuredDotBSR.  A constant csr or csc matrix is
+    converted at compile time: to SELL for products with a vector, and to
+    bsr for products with a matrix when its nonzeros fill whole blocks.
+
+    """
+    if node.op not in (sparse._structured_dot, sparse._dot):
+        return False
+    a, b = node.inputs
+    if not _is_sparse_variable(a) or _is_sparse_variable(b):
+        return False
+    if a.type.dtype in sparse.complex_dtypes or b.type.dtype in sparse.complex_dtypes:
+        return False
+    is_vector = b.type.ndim == 1
+    if is_vector:
+        b = b.dimshuffle(0, "x")
+
+    if a.type.format == "bsr":
+        a_data, a_ind, a_ptr, _ = sparse.bsr_properties(a)
+        out = sd_bsr(a_data, a_ind, a_ptr, b)
+    elif isinstance(a, Constant):
+        value = a.data.tocsr(copy=True)
+        value.sum_duplicates()
+        if is_vector or b.type.broadcastable[1]:
+            sell = _csr_to_sell(value, _sell_chunk, _sell_sigma)
+            out = StructuredDotSELL(_sell_chunk)(*sell, b)
+        else:
+            blocksize = _bsr_blocksize(value)
+            if blocksize is None:
+                return False
+            value = value.tobsr(blocksize=blocksize)
+            out = sd_bsr(
+                value.data,
+                _asarray(value.indices, dtype="int32"),
+                _asarray(value.indptr, dtype="int32"),
+                b,
+            )
+    else:
+        return False
+
+    if is_vector:
+        out = out[:, 0]
+    if out.type != node.outputs[0].type:
+        return False
+    return [out]
+
+
+register_specialize(local_structured_dot_blocked, "cxx_only")
@@ -33,7 +33,7 @@ class SparseTensorType(TensorType, HasDataType):
     dtype : numpy dtype string such as 'int64' or 'float64' (among others)
         Type of numbers in the matrix.
     format: str
-        The sparse storage strategy.
+        The sparse storage strategy: ``"csr"``, ``"csc"`` or ``"bsr"``.
 
     Returns
     -------
@@ -227,6 +227,134 @@ class SparseTensorType(TensorType, HasDataType):
 
         return False
 
+    def c_declare(self, name, sub, check_input=True):
+        declaration = f"""
+        PyObject* {name};
+        """
+        if check_input:
+            declaration += f"""
+            typedef {self.dtype_specs()[1]} dtype_{name};
+            """
+        return declaration
+
+    def c_init(self, name, sub):
+        return f"""
+        {name} = NULL;
+        """
+
+    def c_extract(self, name, sub, check_input=True, **kwargs):
+        if check_input:
+            check = f"""
+            {name} = NULL;
+            if (aesara_sparse_check(py_{name}, "{self.format}", {self.dtype_specs()[2]}))
+            {{
+                {sub["fail"]}
+            }}
+            """
+        else:
+            check = ""
+        return (
+            check
+            + f"""
+        {name} = py_{name};
+        Py_XINCREF({name});
+        """
+        )
+
+    def c_cleanup(self, name, sub):
+        return f"""
+        Py_XDECREF({name});
+        """
+
+    def c_sync(self, name, sub):
+        return f"""
+        Py_XDECREF(py_{name});
+        py_{name} = {name} ? {name} : Py_None;
+        Py_INCREF(py_{name});
+        """
+
+    def c_support_code(self, **kwargs):
+        return super().c_support_code(**kwargs) + _sparse_c_support_code
+
+    def c_code_cache_version(self):
+        version = super().c_code_cache_version()
+        if version:
+            return (2,) + version
+        return ()
+
+
+# In C, a sparse variable is the `PyObject*` of its SciPy matrix.
+_sparse_c_support_code = """
+#ifndef _AESARA_SPARSE_TYPE
+#define _AESARA_SPARSE_TYPE
+
+// 0 if x is a SciPy sparse matrix of the given format whose data has
+// type type_num, else -1 with an exception set.
+static int aesara_sparse_check(PyObject* x, const char* format, int type_num)
+{
+    if (x == Py_None)
+    {
+        PyErr_SetString(PyExc_ValueError, "expected a sparse matrix, not None");
+        return -1;
+    }
+    PyObject* x_format = PyObject_GetAttrString(x, "format");
+    if (!x_format)
+    {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_TypeError, "expected a sparse matrix");
+        return -1;
+    }
+    int same = PyUnicode_Check(x_format)
+               && PyUnicode_CompareWithASCIIString(x_format, format) == 0;
+    Py_DECREF(x_format);
+    if (!same)
+    {
+        PyErr_Format(PyExc_TypeError, "expected a %s matrix", format);
+        return -1;
+    }
+    PyObject* data = PyObject_GetAttrString(x, "data");
+    if (!data)
+        return -1;
+    same = PyArray_Check(data) && PyArray_TYPE((PyArrayObject*)data) == type_num;
+    Py_DECREF(data);
+    if (!same)
+    {
+        PyErr_Format(PyExc_TypeError, "expected a sparse matrix of type_num %d", type_num);
+        return -1;
+    }
+    return 0;
+}
+
+// New reference to the SciPy sparse matrix of the given format with these
+// arrays and shape, built by its constructor without copying the arrays.
+static PyObject* aesara_sparse_new(const char* format, PyObject* data,
+                                   PyObject* indices, PyObject* indptr,
+                                   npy_intp M, npy_intp N)
+{
+    static PyObject* module = NULL;
+    if (!module)
+    {
+        module = PyImport_ImportModule("scipy.sparse");
+        if (!module)
+            return NULL;
+    }
+    PyObject* name = PyUnicode_FromFormat("%s_matrix", format);
+    PyObject* cls = name ? PyObject_GetAttr(module, name) : NULL;
+    Py_XDECREF(name);
+    if (!cls)
+        return NULL;
+    PyObject* args = Py_BuildValue("((OOO)(nn))", data, indices, indptr, M, N);
+    PyObject* kwargs = Py_BuildValue("{s:O}", "copy", Py_False);
+    PyObject* res = (args && kwargs) ? PyObject_Call(cls, args, kwargs) : NULL;
+    Py_XDECREF(args);
+    Py_XDECREF(kwargs);
+    Py_DECREF(cls);
+    return res;
+}
+
+#endif
+"""
+
 
 aesara.compile.register_view_op_c_code(
     SparseTensorType,
@@ -238,5 +366,18 @@ aesara.compile.register_view_op_c_code(
     1,
 )
 
+aesara.compile.register_deep_copy_op_c_code(
+    SparseTensorType,
+    """
+    Py_XDECREF(%(oname)s);
+    %(oname)s = PyObject_CallMethod(%(iname)s, "copy", NULL);
+    if (!%(oname)s)
+    {
+        %(fail)s;
+    }
+    """,
+    version=1,
+)
+
 # This is a deprecated alias used for (temporary) backward-compatibility
 SparseType = SparseTensorType
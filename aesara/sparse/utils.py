@@ -10,7 +10,7 @@ def hash_from_sparse(data):
 
     # Python hash is not strong, so use sha256 instead. To avoid having a too
     # long hash, I call it again on the contatenation of all parts.
-    return hash_from_code(
+    parts = (
         hash_from_code(data.data)
         + hash_from_code(data.indices)
         + hash_from_code(data.indptr)
@@ -18,3 +18,7 @@ def hash_from_sparse(data):
         + hash_from_code(str(data.dtype))
         + hash_from_code(data.format)
     )
+    if data.format == "bsr":
+        # Different block sizes can share the same buffers
+        parts += hash_from_code(str(data.blocksize))
+    return hash_from_code(parts)
@@ -113,6 +113,7 @@ from aesara.tensor import linalg  # noqa
 # For backward compatibility
 from aesara.tensor import nlinalg  # noqa
 from aesara.tensor import slinalg  # noqa
+from aesara.tensor import linalg_opt  # noqa
 
 # isort: on
 from aesara.tensor.basic import *  # noqa
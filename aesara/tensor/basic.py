@@ -1208,15 +1208,15 @@ def tril(m, k=0):
 
     Parameters
     ----------
-    m : array_like, shape (M, N)
-        Input array.
+    m : array_like, shape (..., M, N)
+        Input array.  Leading dimensions are treated as a stack of matrices.
     k : int, optional
         Diagonal above which to zero elements.  `k = 0` (the default) is the
         main diagonal, `k < 0` is below it and `k > 0` is above.
 
     Returns
     -------
-    array, shape (M, N)
+    array, shape (..., M, N)
         Lower triangle of `m`, of same shape and data-type as `m`.
 
     See Also
@@ -1224,7 +1224,7 @@ def tril(m, k=0):
     triu : Same thing, only for the upper triangle.
 
     """
-    return m * tri(m.shape[0], m.shape[1], k=k, dtype=m.dtype)
+    return m * tri(m.shape[-2], m.shape[-1], k=k, dtype=m.dtype)
 
 
 def triu(m, k=0):
@@ -1242,7 +1242,8 @@ def triu(m, k=0):
 
     """
     return m * (
-        constant(1, dtype=m.dtype) - tri(m.shape[0], m.shape[1], k=k - 1, dtype=m.dtype)
+        constant(1, dtype=m.dtype)
+        - tri(m.shape[-2], m.shape[-1], k=k - 1, dtype=m.dtype)
     )
 
 
@@ -70,7 +70,7 @@ from aesara.tensor.basic import (
     zeros,
     zeros_like,
 )
-from aesara.tensor.elemwise import DimShuffle, Elemwise
+from aesara.tensor.elemwise import CAReduce, DimShuffle, Elemwise, FusedCAReduce
 from aesara.tensor.exceptions import NotScalarConstantError, ShapeError
 from aesara.tensor.extra_ops import BroadcastTo, Repeat, Unique, broadcast_shape
 from aesara.tensor.math import all as at_all
@@ -3385,6 +3385,49 @@ else:
     )
 
 
+@local_optimizer([CAReduce])
+def local_careduce_fusion(fgraph, node):
+    """Fuse a `CAReduce` with the `Elemwise` that computes its input.
+
+    Only the Numba backend implements `FusedCAReduce` without creating the
+    intermediate array, hence the ``numba`` tag of this rewrite.
+    """
+    if not isinstance(node.op, CAReduce) or not isinstance(
+        node.op.scalar_op,
+        (
+            aes.Add,
+            aes.Mul,
+            aes.ScalarMaximum,
+            aes.ScalarMinimum,
+            aes.AND,
+            aes.OR,
+            aes.XOR,
+        ),
+    ):
+        return
+    (x,) = node.inputs
+    if (
+        not x.owner
+        or not isinstance(x.owner.op, Elemwise)
+        or len(x.owner.outputs) > 1
+        or x.owner.op.inplace_pattern
+        or len(fgraph.clients[x]) > 1
+    ):
+        return
+    fused = FusedCAReduce(x.owner.op, node.op)(*x.owner.inputs)
+    if fused.type != node.outputs[0].type:
+        return
+    return [fused]
+
+
+compile.optdb.register(
+    "careduce_fusion",
+    in2out(local_careduce_fusion),
+    "numba",
+    position=49.1,
+)
+
+
 @register_canonicalize
 @local_optimizer([Elemwise])
 def local_useless_composite(fgraph, node):
@@ -3483,6 +3526,7 @@ def local_useless_topk(fgraph, node):
         idx_dtype=op.idx_dtype,
         return_values=ret_val,
         return_indices=ret_idx,
+        openmp=op.openmp,
     )(x, k)
     copy_stack_trace(node.outputs[0], new_output)
     return {old_output: new_output}
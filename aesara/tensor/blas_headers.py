@@ -1073,6 +1073,92 @@ def blas_header_version():
     return version
 
 
+def detect_lapack():
+    """
+    Check that the libraries in ``config.blas__ldflags`` also provide LAPACK.
+
+    The result is cached in ``detect_lapack.present``.
+
+    """
+    if detect_lapack.tested:
+        return detect_lapack.present
+    detect_lapack.tested = True
+
+    if not config.blas__ldflags or not config.cxx:
+        detect_lapack.present = False
+        return False
+
+    test_code = textwrap.dedent(
+        """\
+        extern "C" void dgetrf_(const int*, const int*, double*, const int*, int*, int*);
+        int main(int argc, char** argv)
+        {
+            int n = 2, ipiv[2], info;
+            double a[4] = {4, 2, 2, 3};
+            dgetrf_(&n, &n, a, &n, ipiv, &info);
+            return info;
+        }
+        """
+    )
+    flags = config.blas__ldflags.split()
+    flags += ["-Wl,-rpath," + f[2:] for f in flags if f.startswith("-L")]
+    compilation_ok, run_ok = GCC_compiler.try_compile_tmp(
+        test_code, tmp_prefix="detect_lapack_", flags=flags, try_run=True
+    )
+    detect_lapack.present = bool(compilation_ok and run_ok)
+    if not detect_lapack.present:
+        _logger.info("The BLAS libraries do not provide LAPACK.")
+    return detect_lapack.present
+
+
+detect_lapack.tested = False
+detect_lapack.present = False
+
+
+def lapack_header_text():
+    """C header for the Fortran LAPACK routines, with overloads on the dtype."""
+    return """
+    extern "C"
+    {
+        void spotrf_(const char*, const int*, float*, const int*, int*);
+        void dpotrf_(const char*, const int*, double*, const int*, int*);
+        void spotrs_(const char*, const int*, const int*, const float*, const int*, float*, const int*, int*);
+        void dpotrs_(const char*, const int*, const int*, const double*, const int*, double*, const int*, int*);
+        void sgetrf_(const int*, const int*, float*, const int*, int*, int*);
+        void dgetrf_(const int*, const int*, double*, const int*, int*, int*);
+        void sgetrs_(const char*, const int*, const int*, const float*, const int*, const int*, float*, const int*, int*);
+        void dgetrs_(const char*, const int*, const int*, const double*, const int*, const int*, double*, const int*, int*);
+        void strtrs_(const char*, const char*, const char*, const int*, const int*, const float*, const int*, float*, const int*, int*);
+        void dtrtrs_(const char*, const char*, const char*, const int*, const int*, const double*, const int*, double*, const int*, int*);
+    }
+
+    static inline void aesara_potrf(char uplo, int n, float* a, int* info)
+    { int lda = n > 1 ? n : 1; spotrf_(&uplo, &n, a, &lda, info); }
+    static inline void aesara_potrf(char uplo, int n, double* a, int* info)
+    { int lda = n > 1 ? n : 1; dpotrf_(&uplo, &n, a, &lda, info); }
+
+    static inline void aesara_potrs(char uplo, int n, int k, const float* a, float* b, int* info)
+    { int lda = n > 1 ? n : 1; spotrs_(&uplo, &n, &k, a, &lda, b, &lda, info); }
+    static inline void aesara_potrs(char uplo, int n, int k, const double* a, double* b, int* info)
+    { int lda = n > 1 ? n : 1; dpotrs_(&uplo, &n, &k, a, &lda, b, &lda, info); }
+
+    static inline void aesara_getrf(int n, float* a, int* ipiv, int* info)
+    { int lda = n > 1 ? n : 1; sgetrf_(&n, &n, a, &lda, ipiv, info); }
+    static inline void aesara_getrf(int n, double* a, int* ipiv, int* info)
+    { int lda = n > 1 ? n : 1; dgetrf_(&n, &n, a, &lda, ipiv, info); }
+
+    static inline void aesara_getrs(char trans, int n, int k, const float* a, const int* ipiv, float* b, int* info)
+    { int lda = n > 1 ? n : 1; sgetrs_(&trans, &n, &k, a, &lda, ipiv, b, &lda, info); }
+    static inline void aesara_getrs(char trans, int n, int k, const double* a, const int* ipiv, double* b, int* info)
+    { int lda = n > 1 ? n : 1; dgetrs_(&trans, &n, &k, a, &lda, ipiv, b, &lda, info); }
+
+    static inline void aesara_trtrs(char uplo, char trans, char diag, int n, int k, const float* a, float* b, int* info)
+    { int lda = n > 1 ? n : 1; strtrs_(&uplo, &trans, &diag, &n, &k, a, &lda, b, &lda, info); }
+    static inline void aesara_trtrs(char uplo, char trans, char diag, int n, int k, const double* a, double* b, int* info)
+    { int lda = n > 1 ? n : 1; dtrtrs_(&uplo, &trans, &diag, &n, &k, a, &lda, b, &lda, info); }
+    """
+
+
 def ____gemm_code(check_ab, a_init, b_init):
     mod = "%"
     return (
@@ -0,0 +1,544 @@
+#ifndef AESARA_FFT_C
+#define AESARA_FFT_C
+
+/*
+ * Fast Fourier transforms for `aesara.tensor.fft`.
+ *
+ * Complex transforms use a mixed-radix, decimation-in-time Cooley-Tukey
+ * algorithm, with radix-2, 3 and 4 butterflies and a generic butterfly for
+ * the other prime factors.  Lengths with a prime factor larger than
+ * AESARA_FFT_MAX_RADIX go through Bluestein's algorithm instead, which turns
+ * the transform into a convolution of power-of-two length.  Real transforms
+ * of even length n are complex transforms of length n / 2 on the even and
+ * odd samples.
+ *
+ * A plan holds the factorization and the twiddle factors of one transform,
+ * so that they are computed once per length.  Plans are only read while
+ * transforming, so that the threads share them; each thread brings its own
+ * `work` buffer of `aesara_fft_work_size` elements.
+ *
+ * Transforms are unnormalized, and forward ones use exp(-2 pi i j k / n).
+ */
+
+#define AESARA_FFT_MAX_RADIX 61
+#define AESARA_FFT_MAX_FACTORS 64
+#define AESARA_FFT_CACHE_SIZE 64
+
+template <typename T>
+struct aesara_cplx
+{
+    T r, i;
+};
+
+template <typename T>
+static inline aesara_cplx<T> aesara_cmul(aesara_cplx<T> a, aesara_cplx<T> b)
+{
+    aesara_cplx<T> c = {a.r * b.r - a.i * b.i, a.r * b.i + a.i * b.r};
+    return c;
+}
+
+template <typename T>
+static inline aesara_cplx<T> aesara_cadd(aesara_cplx<T> a, aesara_cplx<T> b)
+{
+    aesara_cplx<T> c = {a.r + b.r, a.i + b.i};
+    return c;
+}
+
+template <typename T>
+static inline aesara_cplx<T> aesara_csub(aesara_cplx<T> a, aesara_cplx<T> b)
+{
+    aesara_cplx<T> c = {a.r - b.r, a.i - b.i};
+    return c;
+}
+
+template <typename T>
+static inline aesara_cplx<T> aesara_conj(aesara_cplx<T> a)
+{
+    aesara_cplx<T> c = {a.r, -a.i};
+    return c;
+}
+
+template <typename T>
+struct aesara_fft_plan
+{
+    npy_intp n;
+    int inverse;
+    int real;
+    // Work elements `aesara_fft_c2c`, `aesara_fft_r2c` or `aesara_fft_c2r` use
+    npy_intp work_size;
+
+    // Pairs of a radix and the length left after it
+    int n_factors;
+    npy_intp factors[2 * AESARA_FFT_MAX_FACTORS];
+    // exp(-+2 pi i k / n), for k < n
+    aesara_cplx<T>* twiddles;
+
+    // Bluestein's algorithm, when `m` isn't zero: the chirp
+    // exp(-+pi i k^2 / n), and the transform of its conjugate, divided by
+    // the power-of-two length `m` of the convolution
+    npy_intp m;
+    aesara_fft_plan<T>* sub;
+    aesara_cplx<T>* chirp;
+    aesara_cplx<T>* chirp_fft;
+
+    // Real plans: the complex plan of length n / 2, for even n, or n, and
+    // exp(-+2 pi i k / n), for k <= n / 2
+    aesara_fft_plan<T>* half;
+    aesara_cplx<T>* real_twiddles;
+};
+
+template <typename T>
+static void aesara_fft_plan_free(aesara_fft_plan<T>* plan)
+{
+    if (!plan)
+        return;
+    aesara_fft_plan_free(plan->sub);
+    aesara_fft_plan_free(plan->half);
+    free(plan->twiddles);
+    free(plan->chirp);
+    free(plan->chirp_fft);
+    free(plan->real_twiddles);
+    free(plan);
+}
+
+template <typename T>
+static aesara_cplx<T>* aesara_fft_exp_table(npy_intp count, npy_intp n, int inverse)
+{
+    aesara_cplx<T>* table = (aesara_cplx<T>*)malloc(sizeof(aesara_cplx<T>) * (count > 0 ? count : 1));
+    if (!table)
+        return NULL;
+    const double sign = inverse ? 1.0 : -1.0;
+    for (npy_intp k = 0; k < count; ++k)
+    {
+        double angle = sign * 2.0 * M_PI * (double)k / (double)n;
+        table[k].r = (T)cos(angle);
+        table[k].i = (T)sin(angle);
+    }
+    return table;
+}
+
+template <typename T>
+static void aesara_fft_c2c(const aesara_fft_plan<T>* plan, const aesara_cplx<T>* in,
+                           aesara_cplx<T>* out, aesara_cplx<T>* work);
+
+// Return a complex plan of length `n`, or NULL when out of memory
+template <typename T>
+static aesara_fft_plan<T>* aesara_fft_plan_c2c(npy_intp n, int inverse)
+{
+    aesara_fft_plan<T>* plan = (aesara_fft_plan<T>*)calloc(1, sizeof(aesara_fft_plan<T>));
+    if (!plan)
+        return NULL;
+    plan->n = n;
+    plan->inverse = inverse;
+
+    // Radix 4 first, then 2, 3 and the other primes
+    npy_intp left = n, p = 4, max_radix = 1;
+    npy_intp floor_sqrt = (npy_intp)floor(sqrt((double)n));
+    do
+    {
+        while (left % p)
+        {
+            if (p == 4)
+                p = 2;
+            else if (p == 2)
+                p = 3;
+            else
+                p += 2;
+            if (p > floor_sqrt)
+                p = left;
+        }
+        left /= p;
+        plan->factors[2 * plan->n_factors] = p;
+        plan->factors[2 * plan->n_factors + 1] = left;
+        plan->n_factors++;
+        if (p > max_radix)
+            max_radix = p;
+    } while (left > 1);
+
+    if (max_radix <= AESARA_FFT_MAX_RADIX)
+    {
+        plan->twiddles = aesara_fft_exp_table<T>(n, n, inverse);
+        if (!plan->twiddles)
+        {
+            aesara_fft_plan_free(plan);
+            return NULL;
+        }
+        return plan;
+    }
+
+    // Bluestein's algorithm
+    npy_intp m = 1;
+    while (m < 2 * n - 1)
+        m *= 2;
+    plan->m = m;
+    plan->sub = aesara_fft_plan_c2c<T>(m, 0);
+    plan->chirp = (aesara_cplx<T>*)malloc(sizeof(aesara_cplx<T>) * n);
+    plan->chirp_fft = (aesara_cplx<T>*)malloc(sizeof(aesara_cplx<T>) * m);
+    aesara_cplx<T>* b = (aesara_cplx<T>*)calloc(2 * m, sizeof(aesara_cplx<T>));
+    if (!plan->sub || !plan->chirp || !plan->chirp_fft || !b)
+    {
+        free(b);
+        aesara_fft_plan_free(plan);
+        return NULL;
+    }
+    const double sign = inverse ? 1.0 : -1.0;
+    for (npy_intp k = 0; k < n; ++k)
+    {
+        // k^2 mod 2n keeps the angle accurate for large k
+        unsigned long long k2 = ((unsigned long long)k * (unsigned long long)k) % (unsigned long long)(2 * n);
+        double angle = sign * M_PI * (double)k2 / (double)n;
+        plan->chirp[k].r = (T)cos(angle);
+        plan->chirp[k].i = (T)sin(angle);
+        b[k] = aesara_conj(plan->chirp[k]);
+        if (k > 0)
+            b[m - k] = b[k];
+    }
+    aesara_fft_c2c(plan->sub, b, b + m, (aesara_cplx<T>*)NULL);
+    for (npy_intp k = 0; k < m; ++k)
+    {
+        plan->chirp_fft[k].r = b[m + k].r / (T)m;
+        plan->chirp_fft[k].i = b[m + k].i / (T)m;
+    }
+    free(b);
+    plan->work_size = 2 * m;
+    return plan;
+}
+
+// Return a real plan of length `n`: real-to-complex when forward, and
+// complex-to-real when inverse
+template <typename T>
+static aesara_fft_plan<T>* aesara_fft_plan_real(npy_intp n, int inverse)
+{
+    aesara_fft_plan<T>* plan = (aesara_fft_plan<T>*)calloc(1, sizeof(aesara_fft_plan<T>));
+    if (!plan)
+        return NULL;
+    plan->n = n;
+    plan->inverse = inverse;
+    plan->real = 1;
+    npy_intp len = n % 2 ? n : n / 2;
+    plan->half = aesara_fft_plan_c2c<T>(len, inverse);
+    plan->real_twiddles = aesara_fft_exp_table<T>(n / 2 + 1, n, 0);
+    if (!plan->half || !plan->real_twiddles)
+    {
+        aesara_fft_plan_free(plan);
+        return NULL;
+    }
+    plan->work_size = 2 * len + plan->half->work_size;
+    return plan;
+}
+
+template <typename T>
+static void aesara_fft_bfly2(aesara_cplx<T>* F, const aesara_cplx<T>* tw, npy_intp fstride, npy_intp m)
+{
+    for (npy_intp k = 0; k < m; ++k)
+    {
+        aesara_cplx<T> t = aesara_cmul(F[m + k], tw[k * fstride]);
+        F[m + k] = aesara_csub(F[k], t);
+        F[k] = aesara_cadd(F[k], t);
+    }
+}
+
+template <typename T>
+static void aesara_fft_bfly3(aesara_cplx<T>* F, const aesara_cplx<T>* tw, npy_intp fstride, npy_intp m)
+{
+    const T epi3 = tw[fstride * m].i;
+    for (npy_intp k = 0; k < m; ++k)
+    {
+        aesara_cplx<T> s1 = aesara_cmul(F[k + m], tw[k * fstride]);
+        aesara_cplx<T> s2 = aesara_cmul(F[k + 2 * m], tw[2 * k * fstride]);
+        aesara_cplx<T> s3 = aesara_cadd(s1, s2);
+        aesara_cplx<T> s0 = aesara_csub(s1, s2);
+        aesara_cplx<T> h = {F[k].r - s3.r / 2, F[k].i - s3.i / 2};
+        s0.r *= epi3;
+        s0.i *= epi3;
+        F[k] = aesara_cadd(F[k], s3);
+        F[k + 2 * m].r = h.r + s0.i;
+        F[k + 2 * m].i = h.i - s0.r;
+        F[k + m].r = h.r - s0.i;
+        F[k + m].i = h.i + s0.r;
+    }
+}
+
+template <typename T>
+static void aesara_fft_bfly4(aesara_cplx<T>* F, const aesara_cplx<T>* tw, npy_intp fstride, npy_intp m, int inverse)
+{
+    for (npy_intp k = 0; k < m; ++k)
+    {
+        aesara_cplx<T> s0 = aesara_cmul(F[k + m], tw[k * fstride]);
+        aesara_cplx<T> s1 = aesara_cmul(F[k + 2 * m], tw[2 * k * fstride]);
+        aesara_cplx<T> s2 = aesara_cmul(F[k + 3 * m], tw[3 * k * fstride]);
+        aesara_cplx<T> s5 = aesara_csub(F[k], s1);
+        aesara_cplx<T> f0 = aesara_cadd(F[k], s1);
+        aesara_cplx<T> s3 = aesara_cadd(s0, s2);
+        aesara_cplx<T> s4 = aesara_csub(s0, s2);
+        F[k + 2 * m] = aesara_csub(f0, s3);
+        F[k] = aesara_cadd(f0, s3);
+        if (inverse)
+        {
+            F[k + m].r = s5.r - s4.i;
+            F[k + m].i = s5.i + s4.r;
+            F[k + 3 * m].r = s5.r + s4.i;
+            F[k + 3 * m].i = s5.i - s4.r;
+        }
+        else
+        {
+            F[k + m].r = s5.r + s4.i;
+            F[k + m].i = s5.i - s4.r;
+            F[k + 3 * m].r = s5.r - s4.i;
+            F[k + 3 * m].i = s5.i + s4.r;
+        }
+    }
+}
+
+template <typename T>
+static void aesara_fft_bfly_generic(aesara_cplx<T>* F, const aesara_cplx<T>* tw, npy_intp fstride, npy_intp m,
+                                    npy_intp p, npy_intp n)
+{
+    aesara_cplx<T> scratch[AESARA_FFT_MAX_RADIX];
+    for (npy_intp u = 0; u < m; ++u)
+    {
+        for (npy_intp q = 0; q < p; ++q)
+            scratch[q] = F[u + q * m];
+        for (npy_intp q1 = 0; q1 < p; ++q1)
+        {
+            npy_intp k = u + q1 * m;
+            npy_intp twidx = 0;
+            aesara_cplx<T> acc = scratch[0];
+            for (npy_intp q = 1; q < p; ++q)
+            {
+                twidx += fstride * k;
+                if (twidx >= n)
+                    twidx -= n;
+                acc = aesara_cadd(acc, aesara_cmul(scratch[q], tw[twidx]));
+            }
+            F[k] = acc;
+        }
+    }
+}
+
+template <typename T>
+static void aesara_fft_recurse(const aesara_fft_plan<T>* plan, aesara_cplx<T>* out, const aesara_cplx<T>* in,
+                               npy_intp fstride, const npy_intp* factors)
+{
+    const npy_intp p = factors[0], m = factors[1];
+    if (m == 1)
+    {
+        for (npy_intp q = 0; q < p; ++q)
+            out[q] = in[q * fstride];
+    }
+    else
+    {
+        for (npy_intp q = 0; q < p; ++q)
+            aesara_fft_recurse(plan, out + q * m, in + q * fstride, fstride * p, factors + 2);
+    }
+    switch (p)
+    {
+    case 2:
+        aesara_fft_bfly2(out, plan->twiddles, fstride, m);
+        break;
+    case 3:
+        aesara_fft_bfly3(out, plan->twiddles, fstride, m);
+        break;
+    case 4:
+        aesara_fft_bfly4(out, plan->twiddles, fstride, m, plan->inverse);
+        break;
+    default:
+        aesara_fft_bfly_generic(out, plan->twiddles, fstride, m, p, plan->n);
+        break;
+    }
+}
+
+// Transform `in` into `out`, which must not overlap
+template <typename T>
+static void aesara_fft_c2c(const aesara_fft_plan<T>* plan, const aesara_cplx<T>* in, aesara_cplx<T>* out,
+                           aesara_cplx<T>* work)
+{
+    const npy_intp n = plan->n;
+    if (!plan->m)
+    {
+        aesara_fft_recurse(plan, out, in, 1, plan->factors);
+        return;
+    }
+    // Bluestein: out = chirp * (a conv conj(chirp)), with a = chirp * in.
+    // The inverse transform of the convolution is conj(fft(conj(.))).
+    const npy_intp m = plan->m;
+    aesara_cplx<T>* a = work;
+    aesara_cplx<T>* b = work + m;
+    for (npy_intp k = 0; k < n; ++k)
+        a[k] = aesara_cmul(in[k], plan->chirp[k]);
+    memset(a + n, 0, sizeof(aesara_cplx<T>) * (m - n));
+    aesara_fft_c2c(plan->sub, a, b, (aesara_cplx<T>*)NULL);
+    for (npy_intp k = 0; k < m; ++k)
+        b[k] = aesara_conj(aesara_cmul(b[k], plan->chirp_fft[k]));
+    aesara_fft_c2c(plan->sub, b, a, (aesara_cplx<T>*)NULL);
+    for (npy_intp k = 0; k < n; ++k)
+        out[k] = aesara_cmul(plan->chirp[k], aesara_conj(a[k]));
+}
+
+// Transform the real `x`, zero-padded or truncated from `len` to `n`
+// samples, into the `n / 2 + 1` elements of `y`.  For even `n`, `y` holds
+// the samples during the transform.
+template <typename T>
+static void aesara_fft_r2c(const aesara_fft_plan<T>* plan, const T* x, npy_intp len, aesara_cplx<T>* y,
+                           aesara_cplx<T>* work)
+{
+    const npy_intp n = plan->n;
+    const npy_intp copied = len < n ? len : n;
+    if (n % 2)
+    {
+        aesara_cplx<T>* z = work;
+        aesara_cplx<T>* Z = work + n;
+        for (npy_intp k = 0; k < copied; ++k)
+        {
+            z[k].r = x[k];
+            z[k].i = 0;
+        }
+        memset(z + copied, 0, sizeof(aesara_cplx<T>) * (n - copied));
+        aesara_fft_c2c(plan->half, z, Z, work + 2 * n);
+        memcpy(y, Z, sizeof(aesara_cplx<T>) * (n / 2 + 1));
+        return;
+    }
+
+    // Pack the even and odd samples in the real and imaginary parts
+    const npy_intp h = n / 2;
+    T* yr = (T*)y;
+    memcpy(yr, x, sizeof(T) * copied);
+    memset(yr + copied, 0, sizeof(T) * (n - copied));
+    aesara_cplx<T>* Z = work;
+    aesara_fft_c2c(plan->half, y, Z, work + 2 * h);
+    for (npy_intp k = 0; k <= h; ++k)
+    {
+        aesara_cplx<T> zk = Z[k % h];
+        aesara_cplx<T> znk = aesara_conj(Z[(h - k) % h]);
+        aesara_cplx<T> even = {(zk.r + znk.r) / 2, (zk.i + znk.i) / 2};
+        // odd = (zk - znk) / (2 i)
+        aesara_cplx<T> odd = {(zk.i - znk.i) / 2, -(zk.r - znk.r) / 2};
+        y[k] = aesara_cadd(even, aesara_cmul(plan->real_twiddles[k], odd));
+    }
+}
+
+// Transform the `n / 2 + 1` first elements of the Hermitian `X`,
+// zero-padded or truncated from `len` elements, into the `n` samples of
+// `x`.  The imaginary parts of the zero and Nyquist frequencies are
+// ignored.
+template <typename T>
+static void aesara_fft_c2r(const aesara_fft_plan<T>* plan, const aesara_cplx<T>* X, npy_intp len, T* x,
+                           aesara_cplx<T>* work)
+{
+    const npy_intp n = plan->n;
+    const npy_intp h = n / 2;
+    aesara_cplx<T>* Y = work;
+    const npy_intp size = n % 2 ? n : h;
+    aesara_cplx<T>* y = work + size;
+    // Y holds X while it is read, with the padding and the real zero and
+    // Nyquist frequencies
+    const npy_intp copied = len < h + 1 ? len : h + 1;
+    aesara_cplx<T> zero = {0, 0};
+#define AESARA_FFT_X(k) ((k) < copied ? X[k] : zero)
+    if (n % 2)
+    {
+        for (npy_intp k = 0; k <= h; ++k)
+            Y[k] = AESARA_FFT_X(k);
+        Y[0].i = 0;
+        for (npy_intp k = 1; k <= h; ++k)
+            Y[n - k] = aesara_conj(Y[k]);
+        aesara_fft_c2c(plan->half, Y, y, work + 2 * n);
+        for (npy_intp k = 0; k < n; ++k)
+            x[k] = y[k].r;
+        return;
+    }
+
+    aesara_cplx<T> x0 = AESARA_FFT_X(0);
+    aesara_cplx<T> xh = AESARA_FFT_X(h);
+    x0.i = 0;
+    xh.i = 0;
+    for (npy_intp k = 0; k < h; ++k)
+    {
+        aesara_cplx<T> xk = k == 0 ? x0 : AESARA_FFT_X(k);
+        aesara_cplx<T> xnk = aesara_conj(k == 0 ? xh : AESARA_FFT_X(h - k));
+        aesara_cplx<T> even = aesara_cadd(xk, xnk);
+        aesara_cplx<T> odd = aesara_cmul(aesara_csub(xk, xnk), aesara_conj(plan->real_twiddles[k]));
+        // Y = even + i odd
+        Y[k].r = even.r - odd.i;
+        Y[k].i = even.i + odd.r;
+    }
+#undef AESARA_FFT_X
+    aesara_fft_c2c(plan->half, Y, y, work + 2 * h);
+    for (npy_intp k = 0; k < h; ++k)
+    {
+        x[2 * k] = y[k].r;
+        x[2 * k + 1] = y[k].i;
+    }
+}
+
+// Complex work elements needed by the transforms with `plan`.
+template <typename T>
+static npy_intp aesara_fft_work_size(const aesara_fft_plan<T>* plan)
+{
+    return plan->real ? plan->work_size : 2 * plan->n + plan->work_size;
+}
+
+// Transform, in place, line number `line` of `data` along an axis of
+// `plan->n` elements, which are `stride` elements apart.
+template <typename T>
+static void aesara_fft_line(const aesara_fft_plan<T>* plan, aesara_cplx<T>* data,
+                            npy_intp line, npy_intp stride, aesara_cplx<T>* work)
+{
+    const npy_intp n = plan->n;
+    aesara_cplx<T>* base = data + (line / stride) * n * stride + line % stride;
+    aesara_cplx<T>* a = work;
+    aesara_cplx<T>* b = work + n;
+    for (npy_intp k = 0; k < n; ++k)
+        a[k] = base[k * stride];
+    aesara_fft_c2c(plan, a, b, work + 2 * n);
+    for (npy_intp k = 0; k < n; ++k)
+        base[k * stride] = b[k];
+}
+
+// The plans of one `Apply` node, kept between calls
+template <typename T>
+struct aesara_fft_plan_cache
+{
+    aesara_fft_plan<T>* plans[AESARA_FFT_CACHE_SIZE];
+    int n_plans;
+    int next;
+
+    aesara_fft_plan_cache() : n_plans(0), next(0) {}
+    ~aesara_fft_plan_cache() { clear(); }
+
+    void clear()
+    {
+        for (int k = 0; k < n_plans; ++k)
+            aesara_fft_plan_free(plans[k]);
+        n_plans = 0;
+        next = 0;
+    }
+
+    // Return the plan for `n`, or NULL when out of memory.  A transform
+    // needs fewer plans than the cache holds, so that the plans it gets
+    // stay valid until it's done.
+    aesara_fft_plan<T>* get(npy_intp n, int inverse, int real)
+    {
+        for (int k = 0; k < n_plans; ++k)
+        {
+            aesara_fft_plan<T>* plan = plans[k];
+            if (plan->n == n && plan->inverse == inverse && plan->real == real)
+                return plan;
+        }
+        aesara_fft_plan<T>* plan =
+            real ? aesara_fft_plan_real<T>(n, inverse) : aesara_fft_plan_c2c<T>(n, inverse);
+        if (!plan)
+            return NULL;
+        if (n_plans < AESARA_FFT_CACHE_SIZE)
+            plans[n_plans++] = plan;
+        else
+        {
+            aesara_fft_plan_free(plans[next]);
+            plans[next] = plan;
+            next = (next + 1) % AESARA_FFT_CACHE_SIZE;
+        }
+        return plan;
+    }
+};
+
+#endif
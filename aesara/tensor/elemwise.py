@@ -8,6 +8,7 @@ from aesara.configdefaults import config
 from aesara.gradient import DisconnectedType
 from aesara.graph.basic import Apply
 from aesara.graph.null_type import NullType
+from aesara.graph.op import Op
 from aesara.graph.utils import MethodNotDefined
 from aesara.link.c.basic import failure_code
 from aesara.link.c.op import COp, ExternalCOp, OpenMPOp
@@ -1749,6 +1750,71 @@ class CAReduceDtype(CAReduce):
             return f"{prefix}{{acc_dtype={self.acc_dtype}}}"
 
 
+class FusedCAReduce(Op):
+    """A `CAReduce` applied to the output of an `Elemwise`, in one loop nest.
+
+    The inputs are the inputs of the `Elemwise`, and the intermediate
+    array is never created by the backends that implement this `Op`
+    (i.e. Numba).  `perform` simply applies both `Op`\\s in turn.
+
+    Parameters
+    ----------
+    elemwise
+        A single-output `Elemwise` without in-place pattern.
+    careduce
+        The `CAReduce` applied to its output.
+
+    """
+
+    __props__ = ("elemwise", "careduce")
+
+    def __init__(self, elemwise, careduce):
+        if not isinstance(elemwise, Elemwise) or elemwise.scalar_op.nout != 1:
+            raise TypeError("FusedCAReduce requires a single-output Elemwise")
+        if elemwise.inplace_pattern:
+            raise ValueError("FusedCAReduce requires an Elemwise without inplace")
+        if not isinstance(careduce, CAReduce):
+            raise TypeError("FusedCAReduce requires a CAReduce")
+        self.elemwise = elemwise
+        self.careduce = careduce
+
+    def inner_nodes(self, inputs):
+        """Return the `Elemwise` and the `CAReduce` nodes applied to `inputs`."""
+        elemwise_node = self.elemwise.make_node(*inputs)
+        careduce_node = self.careduce.make_node(elemwise_node.outputs[0])
+        return elemwise_node, careduce_node
+
+    def make_node(self, *inputs):
+        _, careduce_node = self.inner_nodes(inputs)
+        if careduce_node.op != self.careduce:
+            raise TypeError(
+                f"{self.careduce} doesn't fit the output of {self.elemwise}; "
+                "use the Op of the node returned by its make_node"
+            )
+        return Apply(
+            self,
+            careduce_node.inputs[0].owner.inputs,
+            [careduce_node.outputs[0].type()],
+        )
+
+    def perform(self, node, inputs, output_storage):
+        elemwise_node, careduce_node = self.inner_nodes(node.inputs)
+        storage = [[None]]
+        self.elemwise.perform(elemwise_node, inputs, storage)
+        self.careduce.perform(careduce_node, [storage[0][0]], output_storage)
+
+    def infer_shape(self, fgraph, node, shapes):
+        elemwise_node, careduce_node = self.inner_nodes(node.inputs)
+        return self.careduce.infer_shape(
+            fgraph,
+            careduce_node,
+            self.elemwise.infer_shape(fgraph, elemwise_node, shapes),
+        )
+
+    def __str__(self):
+        return f"{type(self).__name__}{{{self.careduce}, {self.elemwise}}}"
+
+
 def scalar_elemwise(*symbol, nfunc=None, nin=None, nout=None, symbolname=None):
     """Replace a symbol definition with an `Elemwise`-wrapped version of the corresponding scalar `Op`.
 
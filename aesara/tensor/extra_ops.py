@@ -5,6 +5,7 @@ import numpy as np
 import numpy.core.numeric
 
 import aesara
+from aesara.configdefaults import config
 from aesara.gradient import (
     DisconnectedType,
     _float_zeros_like,
@@ -13,7 +14,7 @@ from aesara.gradient import (
 )
 from aesara.graph.basic import Apply, Variable, equal_computations
 from aesara.graph.op import Op
-from aesara.link.c.op import COp
+from aesara.link.c.op import COp, OpenMPOp
 from aesara.link.c.params_type import ParamsType
 from aesara.link.c.type import EnumList, Generic
 from aesara.misc.safe_asarray import _asarray
@@ -97,11 +98,15 @@ class CpuContiguous(COp):
 cpu_contiguous = CpuContiguous()
 
 
-class SearchsortedOp(COp):
+class SearchsortedOp(OpenMPOp):
     """Wrapper for ``numpy.searchsorted``.
 
     For full documentation, see :func:`searchsorted`.
 
+    When `x` has more than one dimension, its leading dimensions are batch
+    dimensions: each row of `x` (and of `sorter`) is searched with the
+    corresponding row of `v`.
+
     See Also
     --------
     searchsorted : numpy-like function that uses `SearchsortedOp`
@@ -111,31 +116,45 @@ class SearchsortedOp(COp):
     params_type = Generic()
     __props__ = ("side",)
     check_input = False
+    # Rows at least this long are searched in an Eytzinger (BFS) layout,
+    # whose probes stay in the same few cache lines for the first levels.
+    c_eytzinger_minsize = 32768
 
-    def __init__(self, side="left"):
+    def __init__(self, side="left", openmp=None):
         if side == "left" or side == "right":
             self.side = side
         else:
             raise ValueError(f"'{side}' is an invalid value for keyword 'side'")
+        super().__init__(openmp=openmp)
 
     def get_params(self, node):
         return self.side
 
     def make_node(self, x, v, sorter=None):
-        x = at.as_tensor(x, ndim=1)
+        x = at.as_tensor(x)
+        if x.type.ndim == 0:
+            raise ValueError("`x` must have at least one dimension")
         v = at.as_tensor(v)
+        if x.type.ndim > 1 and v.type.ndim != x.type.ndim:
+            raise ValueError(
+                "`v` must have the same number of dimensions as a batched `x`"
+            )
         out_type = v.type.clone(dtype="int64")
         if sorter is None:
             return Apply(self, [x, v], [out_type()])
         else:
-            sorter = at.as_tensor(sorter, ndim=1)
+            sorter = at.as_tensor(sorter)
+            if sorter.type.ndim != x.type.ndim:
+                raise ValueError(
+                    "`sorter` must have the same number of dimensions as `x`"
+                )
             if PYTHON_INT_BITWIDTH == 32 and sorter.dtype == "int64":
                 raise TypeError(
                     "numpy.searchsorted with Python 32bit do not support a"
                     " sorter of int64."
                 )
-            if sorter.type.ndim == 1 and sorter.type.dtype not in int_dtypes:
-                raise TypeError("sorter must be an integer vector", sorter.type)
+            if sorter.type.dtype not in int_dtypes:
+                raise TypeError("sorter must be an integer tensor", sorter.type)
             return Apply(self, [x, v, sorter], [out_type()])
 
     def infer_shape(self, fgraph, node, shapes):
@@ -150,9 +169,110 @@ class SearchsortedOp(COp):
             sorter = None
         z = output_storage[0]
 
-        z[0] = np.searchsorted(x, v, side=params, sorter=sorter).astype(
-            node.outputs[0].dtype
-        )
+        if x.ndim == 1:
+            z[0] = np.searchsorted(x, v, side=params, sorter=sorter).astype(
+                node.outputs[0].dtype
+            )
+            return
+
+        if v.shape[:-1] != x.shape[:-1]:
+            raise ValueError("The leading dimensions of `x` and `v` must match")
+        if sorter is not None and sorter.shape != x.shape:
+            raise ValueError("sorter.size must equal a.size")
+        out = np.empty(v.shape, dtype=node.outputs[0].dtype)
+        for idx in np.ndindex(*x.shape[:-1]):
+            out[idx] = np.searchsorted(
+                x[idx],
+                v[idx],
+                side=params,
+                sorter=None if sorter is None else sorter[idx],
+            )
+        z[0] = out
+
+    def c_support_code(self, **kwargs):
+        return """
+        // NumPy's ordering: NaNs sort after every other value.
+        template <typename T>
+        static inline int aesara_searchsorted_lt(T a, T b)
+        {
+            return a < b;
+        }
+        template <>
+        inline int aesara_searchsorted_lt<npy_float32>(npy_float32 a, npy_float32 b)
+        {
+            return a < b || (b != b && a == a);
+        }
+        template <>
+        inline int aesara_searchsorted_lt<npy_float64>(npy_float64 a, npy_float64 b)
+        {
+            return a < b || (b != b && a == a);
+        }
+
+        // Whether the insertion point of `q` lies after the element `e`.
+        template <typename T, bool RIGHT>
+        static inline int aesara_searchsorted_after(T e, T q)
+        {
+            return RIGHT ? !aesara_searchsorted_lt<T>(q, e)
+                         : aesara_searchsorted_lt<T>(e, q);
+        }
+
+        #if defined(__GNUC__)
+        #define AESARA_SEARCHSORTED_PREFETCH(p) __builtin_prefetch(p)
+        #else
+        #define AESARA_SEARCHSORTED_PREFETCH(p)
+        #endif
+
+        // Binary search without a data-dependent branch: the comparison only
+        // selects the next base, which compiles to a conditional move.
+        template <typename T, bool RIGHT>
+        static inline npy_intp aesara_searchsorted_row(const T* a, npy_intp n, T q)
+        {
+            const T* base = a;
+            if (n == 0)
+                return 0;
+            while (n > 1) {
+                const npy_intp half = n >> 1;
+                AESARA_SEARCHSORTED_PREFETCH(base + (half >> 1));
+                AESARA_SEARCHSORTED_PREFETCH(base + half + (half >> 1));
+                base = aesara_searchsorted_after<T, RIGHT>(base[half], q) ? base + half : base;
+                n -= half;
+            }
+            return (base - a) + aesara_searchsorted_after<T, RIGHT>(*base, q);
+        }
+
+        // Store the sorted `a` in `eyt[1..n]` in breadth-first order, with
+        // the position of each element of `eyt` in `a` in `rank`.
+        template <typename T>
+        static npy_intp aesara_searchsorted_eytzinger(
+            const T* a, T* eyt, npy_intp* rank, npy_intp n, npy_intp i, npy_intp k)
+        {
+            if (k <= n) {
+                i = aesara_searchsorted_eytzinger<T>(a, eyt, rank, n, i, 2 * k);
+                eyt[k] = a[i];
+                rank[k] = i;
+                i++;
+                i = aesara_searchsorted_eytzinger<T>(a, eyt, rank, n, i, 2 * k + 1);
+            }
+            return i;
+        }
+
+        template <typename T, bool RIGHT>
+        static inline npy_intp aesara_searchsorted_eytzinger_row(
+            const T* eyt, const npy_intp* rank, npy_intp n, T q)
+        {
+            npy_intp k = 1;
+            while (k <= n) {
+                // The four levels below `k` fit in a few cache lines.
+                AESARA_SEARCHSORTED_PREFETCH(eyt + 16 * k);
+                k = 2 * k + aesara_searchsorted_after<T, RIGHT>(eyt[k], q);
+            }
+            // Undo the trailing right turns and the final left turn.
+            while (k & 1)
+                k >>= 1;
+            k >>= 1;
+            return k == 0 ? n : rank[k];
+        }
+        """
 
     def c_support_code_struct(self, node, name):
         return f"""
@@ -179,29 +299,200 @@ class SearchsortedOp(COp):
             x, v, sorter = inames
         else:
             x, v = inames
-        if not sorter:
-            sorter = "NULL"
         (z,) = onames
         fail = sub["fail"]
 
-        return (
+        dtype = upcast(node.inputs[0].dtype, node.inputs[1].dtype)
+        if dtype not in integer_dtypes + ["float32", "float64"]:
+            if node.inputs[0].ndim > 1:
+                raise NotImplementedError()
+            if not sorter:
+                sorter = "NULL"
+            return (
+                """
+                Py_XDECREF(%(z)s);
+                %(z)s = (PyArrayObject*) PyArray_SearchSorted(%(x)s, (PyObject*) %(v)s,
+                                                              right_%(name)s ? NPY_SEARCHLEFT : NPY_SEARCHRIGHT, (PyObject*) %(sorter)s);
+                if (!%(z)s)
+                    %(fail)s;
+                if (PyArray_TYPE(%(z)s) != NPY_INT64){
+                    PyObject * tmp = PyArray_Cast(%(z)s, NPY_INT64);
+                    Py_XDECREF(%(z)s);
+                    %(z)s = (PyArrayObject*) tmp;
+                }
             """
-            Py_XDECREF(%(z)s);
-            %(z)s = (PyArrayObject*) PyArray_SearchSorted(%(x)s, (PyObject*) %(v)s,
-                                                          right_%(name)s ? NPY_SEARCHLEFT : NPY_SEARCHRIGHT, (PyObject*) %(sorter)s);
-            if (!%(z)s)
-                %(fail)s;
-            if (PyArray_TYPE(%(z)s) != NPY_INT64){
-                PyObject * tmp = PyArray_Cast(%(z)s, NPY_INT64);
+                % locals()
+            )
+
+        dtype_t = "npy_" + dtype
+        typenum = "NPY_" + dtype.upper()
+        right = "true" if self.side == "right" else "false"
+        minsize = int(config.openmp_elemwise_minsize)
+        eytzinger_minsize = int(self.c_eytzinger_minsize)
+        if self.openmp:
+            omp_parallel_batch = (
+                f"#pragma omp parallel for schedule(static) if(batch * nq >= {minsize})"
+            )
+            omp_parallel_queries = (
+                f"#pragma omp parallel for schedule(static) if(nq >= {minsize})"
+            )
+        else:
+            omp_parallel_batch = omp_parallel_queries = ""
+        if sorter:
+            get_sorter = """
+                sorter_c = (PyArrayObject*)PyArray_FROMANY(
+                    (PyObject*)%(sorter)s, NPY_INTP, 0, 0, NPY_ARRAY_CARRAY_RO);
+                if (sorter_c == NULL) {
+                    err = 1;
+                    goto searchsorted_done_%(name)s;
+                }
+                if (!PyArray_CompareLists(PyArray_DIMS(sorter_c), PyArray_DIMS(%(x)s), x_nd)) {
+                    PyErr_SetString(PyExc_ValueError, "sorter.size must equal a.size");
+                    err = 1;
+                    goto searchsorted_done_%(name)s;
+                }
+                s_data = (const npy_intp*)PyArray_DATA(sorter_c);
+            """ % dict(
+                sorter=sorter, x=x, name=name
+            )
+        else:
+            get_sorter = ""
+
+        return """
+        {
+            const int x_nd = PyArray_NDIM(%(x)s);
+            const npy_intp m = PyArray_DIMS(%(x)s)[x_nd - 1];
+            npy_intp batch = 1, nq, b;
+            int d, err = 0;
+            PyArrayObject* x_c = NULL;
+            PyArrayObject* v_c = NULL;
+            PyArrayObject* sorter_c = NULL;
+            const npy_intp* s_data = NULL;
+            %(dtype_t)s* buffer = NULL;
+            %(dtype_t)s* eyt = NULL;
+            npy_intp* rank = NULL;
+            const %(dtype_t)s* x_data;
+            const %(dtype_t)s* v_data;
+            npy_int64* z_data;
+            int use_eytzinger;
+
+            for (d = 0; d < x_nd - 1; d++) {
+                if (PyArray_DIMS(%(v)s)[d] != PyArray_DIMS(%(x)s)[d]) {
+                    PyErr_SetString(PyExc_ValueError,
+                                    "The leading dimensions of `x` and `v` must match");
+                    %(fail)s
+                }
+                batch *= PyArray_DIMS(%(x)s)[d];
+            }
+            nq = batch > 0 ? PyArray_SIZE(%(v)s) / batch : 0;
+
+            if (!(%(z)s && PyArray_NDIM(%(z)s) == PyArray_NDIM(%(v)s) &&
+                  PyArray_CompareLists(PyArray_DIMS(%(z)s), PyArray_DIMS(%(v)s),
+                                       PyArray_NDIM(%(v)s)) &&
+                  PyArray_IS_C_CONTIGUOUS(%(z)s))) {
                 Py_XDECREF(%(z)s);
-                %(z)s = (PyArrayObject*) tmp;
+                %(z)s = (PyArrayObject*) PyArray_EMPTY(
+                    PyArray_NDIM(%(v)s), PyArray_DIMS(%(v)s), NPY_INT64, 0);
+                if (!%(z)s)
+                    %(fail)s
             }
-        """
-            % locals()
+
+            x_c = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*)%(x)s, %(typenum)s, 0, 0, NPY_ARRAY_CARRAY_RO | NPY_ARRAY_FORCECAST);
+            v_c = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*)%(v)s, %(typenum)s, 0, 0, NPY_ARRAY_CARRAY_RO | NPY_ARRAY_FORCECAST);
+            if (x_c == NULL || v_c == NULL) {
+                err = 1;
+                goto searchsorted_done_%(name)s;
+            }
+            %(get_sorter)s
+            x_data = (const %(dtype_t)s*)PyArray_DATA(x_c);
+            v_data = (const %(dtype_t)s*)PyArray_DATA(v_c);
+            z_data = (npy_int64*)PyArray_DATA(%(z)s);
+            use_eytzinger = m >= %(eytzinger_minsize)d && nq >= m / 16;
+
+            if (s_data == NULL && !use_eytzinger) {
+                %(omp_parallel_batch)s
+                for (b = 0; b < batch * nq; b++) {
+                    z_data[b] = aesara_searchsorted_row<%(dtype_t)s, %(right)s>(
+                        x_data + (b / nq) * m, m, v_data[b]);
+                }
+                goto searchsorted_done_%(name)s;
+            }
+
+            // Each row is first gathered through `sorter` and/or laid out in
+            // Eytzinger order, then its queries are searched in parallel.
+            buffer = (%(dtype_t)s*)malloc((m + 1) * sizeof(%(dtype_t)s));
+            if (use_eytzinger) {
+                eyt = (%(dtype_t)s*)malloc((m + 1) * sizeof(%(dtype_t)s));
+                rank = (npy_intp*)malloc((m + 1) * sizeof(npy_intp));
+            }
+            if (buffer == NULL || (use_eytzinger && (eyt == NULL || rank == NULL))) {
+                PyErr_NoMemory();
+                err = 1;
+                goto searchsorted_done_%(name)s;
+            }
+            for (b = 0; b < batch; b++) {
+                const %(dtype_t)s* row = x_data + b * m;
+                const %(dtype_t)s* queries = v_data + b * nq;
+                npy_int64* out = z_data + b * nq;
+                npy_intp j;
+                if (s_data != NULL) {
+                    const npy_intp* s_row = s_data + b * m;
+                    for (j = 0; j < m; j++) {
+                        if (s_row[j] < 0 || s_row[j] >= m) {
+                            PyErr_SetString(PyExc_ValueError, "Sorter index out of range.");
+                            err = 1;
+                            goto searchsorted_done_%(name)s;
+                        }
+                        buffer[j] = row[s_row[j]];
+                    }
+                    row = buffer;
+                }
+                if (use_eytzinger) {
+                    aesara_searchsorted_eytzinger<%(dtype_t)s>(row, eyt, rank, m, 0, 1);
+                    %(omp_parallel_queries)s
+                    for (j = 0; j < nq; j++) {
+                        out[j] = aesara_searchsorted_eytzinger_row<%(dtype_t)s, %(right)s>(
+                            eyt, rank, m, queries[j]);
+                    }
+                }
+                else {
+                    %(omp_parallel_queries)s
+                    for (j = 0; j < nq; j++) {
+                        out[j] = aesara_searchsorted_row<%(dtype_t)s, %(right)s>(
+                            row, m, queries[j]);
+                    }
+                }
+            }
+
+        searchsorted_done_%(name)s:
+            free(buffer);
+            free(eyt);
+            free(rank);
+            Py_XDECREF(x_c);
+            Py_XDECREF(v_c);
+            Py_XDECREF(sorter_c);
+            if (err)
+                %(fail)s
+        }
+        """ % dict(
+            x=x,
+            v=v,
+            z=z,
+            name=name,
+            fail=fail,
+            dtype_t=dtype_t,
+            typenum=typenum,
+            right=right,
+            eytzinger_minsize=eytzinger_minsize,
+            omp_parallel_batch=omp_parallel_batch,
+            omp_parallel_queries=omp_parallel_queries,
+            get_sorter=get_sorter,
         )
 
     def c_code_cache_version(self):
-        return (2,)
+        return (3, self.openmp, config.openmp_elemwise_minsize)
 
     def grad(self, inputs, output_gradients):
         num_ins = len(inputs)
@@ -227,20 +518,24 @@ def searchsorted(x, v, side="left", sorter=None):
 
     Parameters
     ----------
-    x : 1-D tensor (array-like)
+    x : tensor (array-like)
         Input array. If `sorter` is ``None``, then it must be sorted in
-        ascending order, otherwise `sorter` must be an array of indices
-        which sorts it.
+        ascending order along its last axis, otherwise `sorter` must be an
+        array of indices which sorts it. When `x` has more than one
+        dimension, the leading ones are batch dimensions and each row of `x`
+        is searched with the matching row of `v`.
     v : tensor (array-like)
-        Contains the values to be inserted into `x`.
+        Contains the values to be inserted into `x`. If `x` is batched, `v`
+        must have the same number of dimensions and the same leading
+        dimensions.
     side : {'left', 'right'}, optional.
         If ``'left'`` (default), the index of the first suitable
         location found is given. If ``'right'``, return the last such index. If
         there is no suitable index, return either 0 or N (where N is the length
         of `x`).
-    sorter : 1-D tensor of integers (array-like), optional
-        Contains indices that sort array `x` into ascending order.
-        They are typically the result of argsort.
+    sorter : tensor of integers (array-like), optional
+        Contains indices that sort array `x` into ascending order along its
+        last axis. They are typically the result of argsort.
 
     Returns
     -------
@@ -255,6 +550,8 @@ def searchsorted(x, v, side="left", sorter=None):
     -----
 
         * Binary search is used to find the required insertion points.
+          The C implementation searches the values of `v` in parallel when
+          OpenMP is enabled.
         * This Op is working **only on CPU** currently.
 
     Examples
@@ -271,6 +568,9 @@ def searchsorted(x, v, side="left", sorter=None):
     array(3)
     >>> extra_ops.searchsorted([1,2,3,4,5], [-10, 10, 2, 3]).eval()
     array([0, 5, 1, 2])
+    >>> extra_ops.searchsorted([[1,2,3], [4,5,6]], [[2], [2]]).eval()
+    array([[1],
+           [0]])
 
     .. versionadded:: 0.9
 
@@ -278,7 +578,7 @@ def searchsorted(x, v, side="left", sorter=None):
     return SearchsortedOp(side=side)(x, v, sorter)
 
 
-class CumOp(COp):
+class CumOp(OpenMPOp):
     # See function cumsum/cumprod for docstring
 
     __props__ = ("axis", "mode")
@@ -286,10 +586,12 @@ class CumOp(COp):
     params_type = ParamsType(
         c_axis=int_t, mode=EnumList(("MODE_ADD", "add"), ("MODE_MUL", "mul"))
     )
+    c_block_size = 1024
 
-    def __init__(self, axis=None, mode="add"):
+    def __init__(self, axis=None, mode="add", openmp=None):
         if mode not in ("add", "mul"):
             raise ValueError(f'{type(self).__name__}: Unknown mode "{mode}"')
+        super().__init__(openmp=openmp)
         self.axis = axis
         self.mode = mode
 
@@ -356,17 +658,20 @@ class CumOp(COp):
         axis = self.axis
         fail = sub["fail"]
         params = sub["params"]
+        scan = self.c_code_scan(node, x, z, sub)
 
         code = (
             """
+            {
                 int axis = %(params)s->c_axis;
+                int scanned = 0;
                 if (axis == 0 && PyArray_NDIM(%(x)s) == 1)
                     axis = NPY_MAXDIMS;
                 npy_intp shape[1] = { PyArray_SIZE(%(x)s) };
                 if(axis == NPY_MAXDIMS && !(%(z)s && PyArray_DIMS(%(z)s)[0] == shape[0]))
                 {
                     Py_XDECREF(%(z)s);
-                    %(z)s = (PyArrayObject*) PyArray_SimpleNew(1, shape, PyArray_TYPE((PyArrayObject*) py_%(x)s));
+                    %(z)s = (PyArrayObject*) PyArray_SimpleNew(1, shape, PyArray_TYPE(%(x)s));
                 }
 
                 else if(axis != NPY_MAXDIMS && !(%(z)s && PyArray_CompareLists(PyArray_DIMS(%(z)s), PyArray_DIMS(%(x)s), PyArray_NDIM(%(x)s))))
@@ -377,7 +682,10 @@ class CumOp(COp):
 
                 if (!%(z)s)
                     %(fail)s;
-                {
+
+                %(scan)s
+
+                if (!scanned) {
 
                     PyObject * t = NULL;
                     if(%(params)s->mode == MODE_ADD)
@@ -395,14 +703,168 @@ class CumOp(COp):
                     // Because PyArray_CumSum/CumProd returns a newly created reference on t.
                     Py_XDECREF(t);
                 }
+            }
             """
             % locals()
         )
 
         return code
 
+    def c_code_scan(self, node, x, z, sub):
+        """Return C code computing the scan of a C-contiguous `x` into `z`.
+
+        The array is seen as ``(outer, n, inner)`` around the axis.  When
+        ``inner > 1``, blocks of ``inner`` are scanned together so that the
+        inner loop is contiguous.  Otherwise the rows are split between
+        threads, and rows too long for that use a blocked two-pass scan: each
+        thread scans its block, then adds (or multiplies) the total of the
+        preceding blocks.  The two-pass scan changes the order of the floating
+        point operations, so it is only used with ``deterministic=default``.
+
+        """
+        dtype = node.inputs[0].dtype
+        if dtype not in integer_dtypes + ["float32", "float64"]:
+            return ""
+
+        dtype_t = "npy_" + dtype
+        op = "+" if self.mode == "add" else "*"
+        identity = "0" if self.mode == "add" else "1"
+        minsize = int(config.openmp_elemwise_minsize)
+        block_size = int(self.c_block_size)
+        if self.openmp:
+            omp_parallel_rows = (
+                f"#pragma omp parallel for schedule(static) if(outer * n >= {minsize})"
+            )
+            omp_parallel_blocks = (
+                "#pragma omp parallel for schedule(static) if(outer * n * inner >= %d)"
+                % (minsize)
+            )
+        else:
+            omp_parallel_rows = omp_parallel_blocks = ""
+
+        if self.openmp and config.deterministic == "default":
+            two_pass = """
+            if (outer < omp_get_max_threads() && n >= %(minsize)d) {
+                %(dtype_t)s* partial = (%(dtype_t)s*)malloc(
+                    omp_get_max_threads() * sizeof(%(dtype_t)s));
+                if (partial == NULL) {
+                    PyErr_NoMemory();
+                    %(fail)s
+                }
+                for (o = 0; o < outer; o++) {
+                    const %(dtype_t)s* x_row = x_data + o * n;
+                    %(dtype_t)s* z_row = z_data + o * n;
+                    #pragma omp parallel
+                    {
+                        const int n_threads = omp_get_num_threads();
+                        const int t = omp_get_thread_num();
+                        const npy_intp lo = n * t / n_threads;
+                        const npy_intp hi = n * (t + 1) / n_threads;
+                        %(dtype_t)s acc = %(identity)s;
+                        npy_intp i;
+                        int u;
+                        for (i = lo; i < hi; i++) {
+                            acc = acc %(op)s x_row[i];
+                            z_row[i] = acc;
+                        }
+                        partial[t] = acc;
+                        #pragma omp barrier
+                        if (t > 0) {
+                            acc = partial[0];
+                            for (u = 1; u < t; u++) {
+                                acc = acc %(op)s partial[u];
+                            }
+                            for (i = lo; i < hi; i++) {
+                                z_row[i] = acc %(op)s z_row[i];
+                            }
+                        }
+                    }
+                }
+                free(partial);
+                scanned = 1;
+            }
+            """ % dict(
+                dtype_t=dtype_t,
+                minsize=minsize,
+                identity=identity,
+                op=op,
+                fail=sub["fail"],
+            )
+        else:
+            two_pass = ""
+
+        code = """
+        if ((%(dtype_t)s*)PyArray_DATA(%(z)s) != (%(dtype_t)s*)PyArray_DATA(%(x)s) &&
+            PyArray_IS_C_CONTIGUOUS(%(x)s) && PyArray_ISALIGNED(%(x)s) &&
+            PyArray_ISNOTSWAPPED(%(x)s) && PyArray_IS_C_CONTIGUOUS(%(z)s) &&
+            PyArray_ISALIGNED(%(z)s) && PyArray_ISNOTSWAPPED(%(z)s))
+        {
+            const %(dtype_t)s* x_data = (const %(dtype_t)s*)PyArray_DATA(%(x)s);
+            %(dtype_t)s* z_data = (%(dtype_t)s*)PyArray_DATA(%(z)s);
+            npy_intp outer = 1, n = PyArray_SIZE(%(x)s), inner = 1, o;
+            int d;
+            if (axis != NPY_MAXDIMS) {
+                const int nd = PyArray_NDIM(%(x)s);
+                const int ax = axis < 0 ? axis + nd : axis;
+                n = PyArray_DIMS(%(x)s)[ax];
+                for (d = 0; d < ax; d++)
+                    outer *= PyArray_DIMS(%(x)s)[d];
+                for (d = ax + 1; d < nd; d++)
+                    inner *= PyArray_DIMS(%(x)s)[d];
+            }
+            if (inner == 1) {
+                %(two_pass)s
+                if (!scanned) {
+                    %(omp_parallel_rows)s
+                    for (o = 0; o < outer; o++) {
+                        const %(dtype_t)s* x_row = x_data + o * n;
+                        %(dtype_t)s* z_row = z_data + o * n;
+                        %(dtype_t)s acc = %(identity)s;
+                        npy_intp i;
+                        for (i = 0; i < n; i++) {
+                            acc = acc %(op)s x_row[i];
+                            z_row[i] = acc;
+                        }
+                    }
+                }
+            }
+            else if (n > 0) {
+                const npy_intp n_blocks = (inner + %(block_size)d - 1) / %(block_size)d;
+                npy_intp b;
+                %(omp_parallel_blocks)s
+                for (b = 0; b < outer * n_blocks; b++) {
+                    const npy_intp o = b / n_blocks;
+                    const npy_intp j0 = (b %% n_blocks) * %(block_size)d;
+                    const npy_intp j1 = j0 + %(block_size)d < inner ? j0 + %(block_size)d : inner;
+                    const %(dtype_t)s* x_o = x_data + o * n * inner;
+                    %(dtype_t)s* z_o = z_data + o * n * inner;
+                    npy_intp i, j;
+                    for (j = j0; j < j1; j++)
+                        z_o[j] = x_o[j];
+                    for (i = 1; i < n; i++) {
+                        for (j = j0; j < j1; j++) {
+                            z_o[i * inner + j] = z_o[(i - 1) * inner + j] %(op)s x_o[i * inner + j];
+                        }
+                    }
+                }
+            }
+            scanned = 1;
+        }
+        """ % dict(
+            x=x,
+            z=z,
+            dtype_t=dtype_t,
+            two_pass=two_pass,
+            omp_parallel_rows=omp_parallel_rows,
+            omp_parallel_blocks=omp_parallel_blocks,
+            identity=identity,
+            op=op,
+            block_size=block_size,
+        )
+        return code
+
     def c_code_cache_version(self):
-        return (8,)
+        return (9, self.openmp, config.deterministic, config.openmp_elemwise_minsize)
 
     def __str__(self):
         return f"{self.__class__.__name__}{{{self.axis}, {self.mode}}}"
@@ -468,12 +930,13 @@ class CumprodOp(Op):
         return obj
 
 
-class DiffOp(Op):
+class DiffOp(OpenMPOp):
     # See function diff for docstring
 
     __props__ = ("n", "axis")
 
-    def __init__(self, n=1, axis=-1):
+    def __init__(self, n=1, axis=-1, openmp=None):
+        super().__init__(openmp=openmp)
         self.n = n
         self.axis = axis
         # numpy return a view in that case.
@@ -527,6 +990,108 @@ class DiffOp(Op):
         out_shape[self.axis] = at_max((0, out_shape[self.axis] - self.n))
         return [out_shape]
 
+    def c_code(self, node, name, inames, onames, sub):
+        (x,) = inames
+        (z,) = onames
+        dtype = node.inputs[0].dtype
+        if self.n == 0 or dtype not in integer_dtypes + ["bool", "float32", "float64"]:
+            raise NotImplementedError()
+
+        nd = node.inputs[0].ndim
+        axis = numpy.core.numeric.normalize_axis_index(self.axis, nd)
+        n = int(self.n)
+        dtype_t = "npy_" + dtype
+        fail = sub["fail"]
+        if dtype == "bool":
+            diff = "a[inner + j] != a[j]"
+        else:
+            diff = "a[inner + j] - a[j]"
+        if self.openmp:
+            omp_parallel = (
+                "#pragma omp parallel for schedule(static) if(outer * rows_out * inner >= %d)"
+                % int(config.openmp_elemwise_minsize)
+            )
+        else:
+            omp_parallel = ""
+
+        # Each pass takes the first order difference of the previous one; the
+        # intermediate passes go through two temporary buffers.
+        code = (
+            """
+            {
+                PyArrayObject* xc = PyArray_GETCONTIGUOUS(%(x)s);
+                npy_intp dims[%(nd)d];
+                npy_intp outer = 1, inner = 1, m, len;
+                %(dtype_t)s* tmp[2] = {NULL, NULL};
+                int d, reuse;
+                if (xc == NULL)
+                    %(fail)s;
+                for (d = 0; d < %(nd)d; d++) {
+                    dims[d] = PyArray_DIMS(xc)[d];
+                    if (d < %(axis)d)
+                        outer *= dims[d];
+                    else if (d > %(axis)d)
+                        inner *= dims[d];
+                }
+                m = dims[%(axis)d];
+                len = m > %(n)d ? m - %(n)d : 0;
+                dims[%(axis)d] = len;
+
+                reuse = (%(z)s != NULL && PyArray_IS_C_CONTIGUOUS(%(z)s) &&
+                         PyArray_CompareLists(PyArray_DIMS(%(z)s), dims, %(nd)d));
+                if (!reuse) {
+                    Py_XDECREF(%(z)s);
+                    %(z)s = (PyArrayObject*) PyArray_SimpleNew(%(nd)d, dims, PyArray_TYPE(xc));
+                    if (!%(z)s) {
+                        Py_DECREF(xc);
+                        %(fail)s;
+                    }
+                }
+
+                if (len > 0 && outer * inner > 0) {
+                    const %(dtype_t)s* src = (const %(dtype_t)s*)PyArray_DATA(xc);
+                    npy_intp k;
+                    if (%(n)d > 1) {
+                        tmp[0] = (%(dtype_t)s*)malloc(outer * (m - 1) * inner * sizeof(%(dtype_t)s));
+                        if (%(n)d > 2)
+                            tmp[1] = (%(dtype_t)s*)malloc(outer * (m - 2) * inner * sizeof(%(dtype_t)s));
+                        if (tmp[0] == NULL || (%(n)d > 2 && tmp[1] == NULL)) {
+                            free(tmp[0]);
+                            free(tmp[1]);
+                            Py_DECREF(xc);
+                            PyErr_NoMemory();
+                            %(fail)s;
+                        }
+                    }
+                    for (k = 1; k <= %(n)d; k++) {
+                        const npy_intp rows_in = m - k + 1, rows_out = m - k;
+                        %(dtype_t)s* dst = (k == %(n)d) ? (%(dtype_t)s*)PyArray_DATA(%(z)s)
+                                                        : tmp[(k - 1) %% 2];
+                        npy_intp r;
+                        %(omp_parallel)s
+                        for (r = 0; r < outer * rows_out; r++) {
+                            const %(dtype_t)s* a = src + ((r / rows_out) * rows_in + r %% rows_out) * inner;
+                            %(dtype_t)s* out = dst + r * inner;
+                            npy_intp j;
+                            for (j = 0; j < inner; j++) {
+                                out[j] = %(diff)s;
+                            }
+                        }
+                        src = dst;
+                    }
+                    free(tmp[0]);
+                    free(tmp[1]);
+                }
+                Py_DECREF(xc);
+            }
+            """
+            % locals()
+        )
+        return code
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
 
 def diff(x, n=1, axis=-1):
     """Calculate the `n`-th order discrete difference along the given `axis`.
@@ -674,12 +1239,13 @@ def compress(condition, x, axis=None):
     return x.take(indices, axis=axis)
 
 
-class Repeat(Op):
+class Repeat(OpenMPOp):
     # See the repeat function for docstring
 
     __props__ = ("axis",)
 
-    def __init__(self, axis=None):
+    def __init__(self, axis=None, openmp=None):
+        super().__init__(openmp=openmp)
         self.axis = axis
 
     def make_node(self, x, repeats):
@@ -785,6 +1351,134 @@ class Repeat(Op):
                 out_shape[self.axis] = at_sum(repeats, dtype=dtype)
         return [out_shape]
 
+    def c_code(self, node, name, inames, onames, sub):
+        x, repeats = inames
+        (z,) = onames
+        nd = node.inputs[0].ndim
+        reps_ndim = node.inputs[1].ndim
+        if reps_ndim > 1 or (self.axis is not None and not -nd <= self.axis < nd):
+            raise NotImplementedError()
+
+        # `axis` is -1 when the flattened input is repeated.
+        axis = -1 if self.axis is None else self.axis % nd
+        out_nd = 1 if self.axis is None else nd
+        dtype_r = "npy_" + node.inputs[1].dtype
+        fail = sub["fail"]
+        if self.openmp:
+            omp_parallel = (
+                "#pragma omp parallel for schedule(static) if(outer * total * inner >= %d)"
+                % int(config.openmp_elemwise_minsize)
+            )
+        else:
+            omp_parallel = ""
+
+        # `offsets[i]` is the position of the first copy of the i-th element
+        # along the axis, so that every element is copied independently.
+        code = (
+            """
+            {
+                PyArrayObject* xc = PyArray_GETCONTIGUOUS(%(x)s);
+                npy_intp out_dims[%(out_nd)d + 1];
+                npy_intp outer = 1, n, inner = 1, total, i;
+                npy_intp* offsets = NULL;
+                int d, reuse;
+                if (xc == NULL)
+                    %(fail)s;
+                if (%(axis)d < 0) {
+                    n = PyArray_SIZE(xc);
+                }
+                else {
+                    n = PyArray_DIMS(xc)[%(axis)d];
+                    for (d = 0; d < %(axis)d; d++)
+                        outer *= PyArray_DIMS(xc)[d];
+                    for (d = %(axis)d + 1; d < PyArray_NDIM(xc); d++)
+                        inner *= PyArray_DIMS(xc)[d];
+                }
+
+                offsets = (npy_intp*)malloc((n + 1) * sizeof(npy_intp));
+                if (offsets == NULL) {
+                    Py_DECREF(xc);
+                    PyErr_NoMemory();
+                    %(fail)s;
+                }
+                offsets[0] = 0;
+                if (%(reps_ndim)d == 0 || PyArray_DIMS(%(repeats)s)[0] == 1) {
+                    npy_intp r = (npy_intp)*(%(dtype_r)s*)PyArray_DATA(%(repeats)s);
+                    if (r < 0) {
+                        PyErr_SetString(PyExc_ValueError,
+                                        "negative dimensions are not allowed");
+                    }
+                    for (i = 0; i < n; i++)
+                        offsets[i + 1] = offsets[i] + r;
+                }
+                else if (PyArray_DIMS(%(repeats)s)[0] != n) {
+                    PyErr_Format(PyExc_ValueError,
+                                 "operands could not be broadcast together with shape (%%ld,) (%%ld,)",
+                                 (long)n, (long)PyArray_DIMS(%(repeats)s)[0]);
+                }
+                else {
+                    for (i = 0; i < n; i++) {
+                        npy_intp r = (npy_intp)*(%(dtype_r)s*)PyArray_GETPTR1(%(repeats)s, i);
+                        if (r < 0) {
+                            PyErr_SetString(PyExc_ValueError,
+                                            "repeats may not contain negative values.");
+                            break;
+                        }
+                        offsets[i + 1] = offsets[i] + r;
+                    }
+                }
+                if (PyErr_Occurred()) {
+                    free(offsets);
+                    Py_DECREF(xc);
+                    %(fail)s;
+                }
+                total = offsets[n];
+
+                if (%(axis)d < 0) {
+                    out_dims[0] = total;
+                }
+                else {
+                    for (d = 0; d < %(out_nd)d; d++)
+                        out_dims[d] = (d == %(axis)d) ? total : PyArray_DIMS(xc)[d];
+                }
+                reuse = (%(z)s != NULL && PyArray_IS_C_CONTIGUOUS(%(z)s) &&
+                         PyArray_CompareLists(PyArray_DIMS(%(z)s), out_dims, %(out_nd)d));
+                if (!reuse) {
+                    Py_XDECREF(%(z)s);
+                    %(z)s = (PyArrayObject*) PyArray_SimpleNew(%(out_nd)d, out_dims, PyArray_TYPE(xc));
+                    if (!%(z)s) {
+                        free(offsets);
+                        Py_DECREF(xc);
+                        %(fail)s;
+                    }
+                }
+
+                {
+                    const npy_intp chunk = inner * PyArray_ITEMSIZE(xc);
+                    const char* x_data = PyArray_BYTES(xc);
+                    char* z_data = PyArray_BYTES(%(z)s);
+                    npy_intp t;
+                    %(omp_parallel)s
+                    for (t = 0; t < outer * n; t++) {
+                        const npy_intp o = t / n, j = t %% n;
+                        const char* src = x_data + t * chunk;
+                        char* dst = z_data + (o * total + offsets[j]) * chunk;
+                        npy_intp c;
+                        for (c = offsets[j]; c < offsets[j + 1]; c++, dst += chunk)
+                            memcpy(dst, src, chunk);
+                    }
+                }
+                free(offsets);
+                Py_DECREF(xc);
+            }
+            """
+            % locals()
+        )
+        return code
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
 
 def repeat(x, repeats, axis=None):
     """Repeat elements of an array.
@@ -916,7 +1610,7 @@ def bartlett(M):
     return bartlett_(M)
 
 
-class FillDiagonal(Op):
+class FillDiagonal(COp):
     # See function fill_diagonal for docstring
     __props__ = ()
 
@@ -980,6 +1674,58 @@ class FillDiagonal(Op):
         wr_val = at.diag(grad).sum()
         return [wr_a, wr_val]
 
+    def c_code(self, node, name, inames, onames, sub):
+        a, val = inames
+        (z,) = onames
+        nd = node.inputs[0].ndim
+        fail = sub["fail"]
+
+        code = (
+            """
+            {
+                npy_intp n_diag = PyArray_DIMS(%(a)s)[0], step = 0, i;
+                int d, reuse;
+                for (d = 0; d < %(nd)d; d++) {
+                    if (%(nd)d == 2) {
+                        // Rectangular matrices are accepted.
+                        if (PyArray_DIMS(%(a)s)[d] < n_diag)
+                            n_diag = PyArray_DIMS(%(a)s)[d];
+                    }
+                    else if (PyArray_DIMS(%(a)s)[d] != n_diag) {
+                        PyErr_SetString(PyExc_ValueError,
+                                        "All dimensions of input must be of equal length");
+                        %(fail)s;
+                    }
+                }
+
+                reuse = (%(z)s != NULL && %(z)s != %(a)s &&
+                         PyArray_CompareLists(PyArray_DIMS(%(z)s), PyArray_DIMS(%(a)s), %(nd)d));
+                if (reuse) {
+                    if (PyArray_CopyInto(%(z)s, %(a)s) != 0)
+                        %(fail)s;
+                }
+                else {
+                    Py_XDECREF(%(z)s);
+                    %(z)s = (PyArrayObject*) PyArray_NewCopy(%(a)s, NPY_CORDER);
+                    if (!%(z)s)
+                        %(fail)s;
+                }
+
+                for (d = 0; d < %(nd)d; d++)
+                    step += PyArray_STRIDES(%(z)s)[d];
+                for (i = 0; i < n_diag; i++) {
+                    memcpy(PyArray_BYTES(%(z)s) + i * step, PyArray_DATA(%(val)s),
+                           PyArray_ITEMSIZE(%(z)s));
+                }
+            }
+            """
+            % locals()
+        )
+        return code
+
+    def c_code_cache_version(self):
+        return (1,)
+
 
 fill_diagonal_ = FillDiagonal()
 
@@ -1190,10 +1936,15 @@ def to_one_hot(y, nb_class, dtype=None):
     return ret
 
 
-class Unique(Op):
+class Unique(OpenMPOp):
     """
     Wraps `numpy.unique`.
 
+    Without `axis`, the C implementation finds the distinct values with hash
+    tables and only sorts those.  When the input is large enough, each OpenMP
+    thread builds the table of the values whose hash falls in its partition.
+    Like NumPy, it considers all NaNs to be equal.
+
     Examples
     --------
     >>> import numpy as np
@@ -1214,8 +1965,14 @@ class Unique(Op):
     __props__ = ("return_index", "return_inverse", "return_counts", "axis")
 
     def __init__(
-        self, return_index=False, return_inverse=False, return_counts=False, axis=None
+        self,
+        return_index=False,
+        return_inverse=False,
+        return_counts=False,
+        axis=None,
+        openmp=None,
     ):
+        super().__init__(openmp=openmp)
         self.return_index = return_index
         self.return_inverse = return_inverse
         self.return_counts = return_counts
@@ -1305,12 +2062,389 @@ class Unique(Op):
         return ret
 
     def __setstate__(self, state):
-        self.__dict__.update(state)
+        super().__setstate__(state)
         # For backwards compatibility with pickled instances of Unique that
         # did not have the axis parameter specified
         if "axis" not in state:
             self.axis = None
 
+    def c_headers(self, **kwargs):
+        return ["<algorithm>"] + super().c_headers(**kwargs)
+
+    def c_support_code(self, **kwargs):
+        return """
+        // The finalizer of MurmurHash3.
+        static inline npy_uint64 aesara_unique_hash(npy_uint64 key)
+        {
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdULL;
+            key ^= key >> 33;
+            key *= 0xc4ceb9fe1a85ec53ULL;
+            key ^= key >> 33;
+            return key;
+        }
+
+        // Floats are hashed by value: all NaNs are equal, and so are 0 and -0.
+        static inline npy_uint64 aesara_unique_float_key(double v)
+        {
+            npy_uint64 key;
+            if (v != v)
+                return 0x7ff8000000000000ULL;
+            if (v == 0)
+                return 0;
+            memcpy(&key, &v, sizeof(key));
+            return key;
+        }
+
+        // An open addressing hash table mapping keys to the position of their
+        // first occurrence and to their number of occurrences.
+        typedef struct {
+            npy_intp* slots;  // entry + 1, or 0 for an empty slot
+            npy_intp capacity;  // a power of two, at least twice `size`
+            npy_intp size;
+            npy_uint64* keys;
+            npy_intp* first;
+            npy_intp* counts;
+        } aesara_unique_table;
+
+        static void aesara_unique_table_clear(aesara_unique_table* t)
+        {
+            free(t->slots);
+            free(t->keys);
+            free(t->first);
+            free(t->counts);
+            memset(t, 0, sizeof(*t));
+        }
+
+        static int aesara_unique_table_resize(aesara_unique_table* t, npy_intp capacity)
+        {
+            npy_intp* slots = (npy_intp*)calloc(capacity, sizeof(npy_intp));
+            npy_uint64* keys = (npy_uint64*)realloc(t->keys, capacity / 2 * sizeof(npy_uint64));
+            npy_intp e;
+            if (keys != NULL)
+                t->keys = keys;
+            npy_intp* first = (npy_intp*)realloc(t->first, capacity / 2 * sizeof(npy_intp));
+            if (first != NULL)
+                t->first = first;
+            npy_intp* counts = (npy_intp*)realloc(t->counts, capacity / 2 * sizeof(npy_intp));
+            if (counts != NULL)
+                t->counts = counts;
+            if (slots == NULL || keys == NULL || first == NULL || counts == NULL) {
+                free(slots);
+                return -1;
+            }
+            for (e = 0; e < t->size; e++) {
+                npy_intp s = (npy_intp)(aesara_unique_hash(t->keys[e]) & (capacity - 1));
+                while (slots[s])
+                    s = (s + 1) & (capacity - 1);
+                slots[s] = e + 1;
+            }
+            free(t->slots);
+            t->slots = slots;
+            t->capacity = capacity;
+            return 0;
+        }
+
+        static int aesara_unique_table_init(aesara_unique_table* t, npy_intp expected)
+        {
+            npy_intp capacity = 16;
+            memset(t, 0, sizeof(*t));
+            while (capacity < 2 * expected)
+                capacity *= 2;
+            return aesara_unique_table_resize(t, capacity);
+        }
+
+        // Return the entry of `key`, which is inserted if needed, or -1 when
+        // out of memory.
+        static npy_intp aesara_unique_table_insert(aesara_unique_table* t, npy_uint64 key,
+                                                   npy_uint64 hash, npy_intp pos)
+        {
+            npy_intp s = (npy_intp)(hash & (t->capacity - 1));
+            npy_intp e;
+            while (t->slots[s]) {
+                e = t->slots[s] - 1;
+                if (t->keys[e] == key) {
+                    t->counts[e]++;
+                    return e;
+                }
+                s = (s + 1) & (t->capacity - 1);
+            }
+            if (2 * (t->size + 1) > t->capacity) {
+                if (aesara_unique_table_resize(t, 2 * t->capacity))
+                    return -1;
+                return aesara_unique_table_insert(t, key, hash, pos);
+            }
+            e = t->size++;
+            t->keys[e] = key;
+            t->first[e] = pos;
+            t->counts[e] = 1;
+            t->slots[s] = e + 1;
+            return e;
+        }
+
+        // Orders entries by the value of their first occurrence, NaNs last.
+        template <typename T>
+        struct aesara_unique_less {
+            const T* x;
+            const npy_intp* first;
+            aesara_unique_less(const T* x, const npy_intp* first) : x(x), first(first) {}
+            bool operator()(npy_intp a, npy_intp b) const
+            {
+                const T u = x[first[a]], v = x[first[b]];
+                return u < v || (v != v && u == u);
+            }
+        };
+        """
+
+    def c_code(self, node, name, inames, onames, sub):
+        (x,) = inames
+        dtype = node.inputs[0].dtype
+        if self.axis is not None or dtype not in integer_dtypes + [
+            "bool",
+            "float32",
+            "float64",
+        ]:
+            raise NotImplementedError()
+
+        outs = list(onames)
+        z = outs.pop(0)
+        z_index = outs.pop(0) if self.return_index else None
+        z_inverse = outs.pop(0) if self.return_inverse else None
+        z_counts = outs.pop(0) if self.return_counts else None
+        dtype_t = "npy_" + dtype
+        if dtype.startswith("float"):
+            key = "aesara_unique_float_key((double)x_data[i])"
+        else:
+            key = "(npy_uint64)x_data[i]"
+        fail = sub["fail"]
+        if self.openmp:
+            n_parts = "(n >= %d ? omp_get_max_threads() : 1)" % int(
+                config.openmp_elemwise_minsize
+            )
+            omp_parallel_for = (
+                "#pragma omp parallel for schedule(static) if(n_parts > 1)"
+            )
+            omp_atomic_write = "#pragma omp atomic write"
+        else:
+            n_parts = "1"
+            omp_parallel_for = omp_atomic_write = ""
+
+        allocs = []
+        fills = []
+        for out, fill in (
+            (z, "((%s*)PyArray_DATA(%s))[r] = x_data[first[order[r]]];" % (dtype_t, z)),
+            (z_index, f"((npy_int64*)PyArray_DATA({z_index}))[r] = first[order[r]];"),
+            (
+                z_counts,
+                f"((npy_int64*)PyArray_DATA({z_counts}))[r] = counts[order[r]];",
+            ),
+        ):
+            if out is None:
+                continue
+            allocs.append(
+                """
+                Py_XDECREF(%(out)s);
+                %(out)s = (PyArrayObject*) PyArray_SimpleNew(1, &n_unique, %(typenum)s);
+                if (!%(out)s)
+                    failed = 1;
+                """
+                % dict(
+                    out=out,
+                    typenum="PyArray_TYPE(xc)" if out is z else "NPY_INT64",
+                )
+            )
+            fills.append(fill)
+        if z_inverse is not None:
+            allocs.append(
+                """
+                Py_XDECREF(%(z_inverse)s);
+                %(z_inverse)s = (PyArrayObject*) PyArray_SimpleNew(1, &n, NPY_INT64);
+                if (!%(z_inverse)s)
+                    failed = 1;
+                """
+                % dict(z_inverse=z_inverse)
+            )
+            inverse = """
+            {
+                npy_int64* inverse = (npy_int64*)PyArray_DATA(%(z_inverse)s);
+                %(omp_parallel_for)s
+                for (p = 0; p < n_parts; p++) {
+                    npy_intp j;
+                    for (j = starts[p]; j < starts[p + 1]; j++) {
+                        const npy_intp i = n_parts > 1 ? bucket[j] : j;
+                        inverse[i] = rank[offsets[p] + ids[i]];
+                    }
+                }
+            }
+            """ % dict(
+                z_inverse=z_inverse, omp_parallel_for=omp_parallel_for
+            )
+        else:
+            inverse = ""
+        allocs = "".join(allocs)
+        fills = "\n".join(fills)
+        return_inverse = int(bool(self.return_inverse))
+
+        code = (
+            """
+            {
+                PyArrayObject* xc = PyArray_GETCONTIGUOUS(%(x)s);
+                const %(dtype_t)s* x_data;
+                npy_intp n, n_unique = 0, r;
+                int n_parts, p, failed = 0;
+                aesara_unique_table* tables = NULL;
+                npy_intp *ids = NULL, *offsets = NULL, *order = NULL, *rank = NULL;
+                npy_intp *first = NULL, *counts = NULL;
+                npy_intp *starts = NULL, *positions = NULL, *bucket = NULL;
+                npy_uint64* hashes = NULL;
+                if (xc == NULL)
+                    %(fail)s;
+                x_data = (const %(dtype_t)s*)PyArray_DATA(xc);
+                n = PyArray_SIZE(xc);
+                n_parts = %(n_parts)s;
+
+                tables = (aesara_unique_table*)calloc(n_parts, sizeof(aesara_unique_table));
+                offsets = (npy_intp*)malloc((n_parts + 1) * sizeof(npy_intp));
+                starts = (npy_intp*)malloc((n_parts + 1) * sizeof(npy_intp));
+                if (%(return_inverse)d)
+                    ids = (npy_intp*)malloc((n > 0 ? n : 1) * sizeof(npy_intp));
+                if (tables == NULL || offsets == NULL || starts == NULL
+                        || (%(return_inverse)d && ids == NULL)) {
+                    failed = 1;
+                    goto unique_done_%(name)s;
+                }
+                starts[0] = 0;
+                starts[n_parts] = n;
+
+                // The values are partitioned by hash, with one table per
+                // partition.  Each chunk of the input is hashed once, and its
+                // indices are scattered, in order, to the buckets of the
+                // partitions.
+                if (n_parts > 1) {
+                    hashes = (npy_uint64*)malloc(n * sizeof(npy_uint64));
+                    bucket = (npy_intp*)malloc(n * sizeof(npy_intp));
+                    positions = (npy_intp*)calloc(n_parts * n_parts, sizeof(npy_intp));
+                    if (hashes == NULL || bucket == NULL || positions == NULL) {
+                        failed = 1;
+                        goto unique_done_%(name)s;
+                    }
+                    %(omp_parallel_for)s
+                    for (p = 0; p < n_parts; p++) {
+                        npy_intp* hist = positions + p * n_parts;
+                        npy_intp i;
+                        for (i = n * p / n_parts; i < n * (p + 1) / n_parts; i++) {
+                            const npy_uint64 key = %(key)s;
+                            hashes[i] = aesara_unique_hash(key);
+                            hist[(hashes[i] >> 32) %% (npy_uint64)n_parts]++;
+                        }
+                    }
+                    r = 0;
+                    for (p = 0; p < n_parts; p++) {
+                        int c;
+                        starts[p] = r;
+                        for (c = 0; c < n_parts; c++) {
+                            const npy_intp size = positions[c * n_parts + p];
+                            positions[c * n_parts + p] = r;
+                            r += size;
+                        }
+                    }
+                    %(omp_parallel_for)s
+                    for (p = 0; p < n_parts; p++) {
+                        npy_intp* position = positions + p * n_parts;
+                        npy_intp i;
+                        for (i = n * p / n_parts; i < n * (p + 1) / n_parts; i++)
+                            bucket[position[(hashes[i] >> 32) %% (npy_uint64)n_parts]++] = i;
+                    }
+                }
+
+                %(omp_parallel_for)s
+                for (p = 0; p < n_parts; p++) {
+                    aesara_unique_table* t = &tables[p];
+                    npy_intp j;
+                    if (aesara_unique_table_init(t, starts[p + 1] - starts[p])) {
+                        %(omp_atomic_write)s
+                        failed = 1;
+                        continue;
+                    }
+                    for (j = starts[p]; j < starts[p + 1]; j++) {
+                        const npy_intp i = n_parts > 1 ? bucket[j] : j;
+                        const npy_uint64 key = %(key)s;
+                        const npy_uint64 hash = n_parts > 1 ? hashes[i] : aesara_unique_hash(key);
+                        const npy_intp e = aesara_unique_table_insert(t, key, hash, i);
+                        if (e < 0) {
+                            %(omp_atomic_write)s
+                            failed = 1;
+                            break;
+                        }
+                        if (%(return_inverse)d)
+                            ids[i] = e;
+                    }
+                }
+                if (failed)
+                    goto unique_done_%(name)s;
+
+                for (p = 0; p < n_parts; p++) {
+                    offsets[p] = n_unique;
+                    n_unique += tables[p].size;
+                }
+                offsets[n_parts] = n_unique;
+                first = (npy_intp*)malloc((n_unique > 0 ? n_unique : 1) * sizeof(npy_intp));
+                counts = (npy_intp*)malloc((n_unique > 0 ? n_unique : 1) * sizeof(npy_intp));
+                order = (npy_intp*)malloc((n_unique > 0 ? n_unique : 1) * sizeof(npy_intp));
+                rank = (npy_intp*)malloc((n_unique > 0 ? n_unique : 1) * sizeof(npy_intp));
+                if (first == NULL || counts == NULL || order == NULL || rank == NULL) {
+                    failed = 1;
+                    goto unique_done_%(name)s;
+                }
+                for (p = 0; p < n_parts; p++) {
+                    memcpy(first + offsets[p], tables[p].first, tables[p].size * sizeof(npy_intp));
+                    memcpy(counts + offsets[p], tables[p].counts, tables[p].size * sizeof(npy_intp));
+                }
+                for (r = 0; r < n_unique; r++)
+                    order[r] = r;
+                std::sort(order, order + n_unique, aesara_unique_less<%(dtype_t)s>(x_data, first));
+                for (r = 0; r < n_unique; r++)
+                    rank[order[r]] = r;
+
+                %(allocs)s
+                if (failed)
+                    goto unique_done_%(name)s;
+                for (r = 0; r < n_unique; r++) {
+                    %(fills)s
+                }
+                %(inverse)s
+
+              unique_done_%(name)s:
+                if (tables != NULL) {
+                    for (p = 0; p < n_parts; p++)
+                        aesara_unique_table_clear(&tables[p]);
+                }
+                free(tables);
+                free(offsets);
+                free(starts);
+                free(positions);
+                free(bucket);
+                free(hashes);
+                free(ids);
+                free(first);
+                free(counts);
+                free(order);
+                free(rank);
+                Py_DECREF(xc);
+                if (failed) {
+                    if (!PyErr_Occurred())
+                        PyErr_NoMemory();
+                    %(fail)s;
+                }
+            }
+            """
+            % locals()
+        )
+        return code
+
+    def c_code_cache_version(self):
+        return (2, self.openmp, config.openmp_elemwise_minsize)
+
 
 def unique(
     ar, return_index=False, return_inverse=False, return_counts=False, axis=None
@@ -1328,11 +2462,12 @@ def unique(
     return Unique(return_index, return_inverse, return_counts, axis)(ar)
 
 
-class UnravelIndex(Op):
+class UnravelIndex(OpenMPOp):
     __props__ = ("order",)
 
-    def __init__(self, order="C"):
+    def __init__(self, order="C", openmp=None):
         assert order in ("C", "F")
+        super().__init__(openmp=openmp)
         self.order = order
 
     def make_node(self, indices, dims):
@@ -1372,6 +2507,107 @@ class UnravelIndex(Op):
                 ret = ret.copy()
             out[i][0] = ret
 
+    def c_code(self, node, name, inames, onames, sub):
+        indices, dims = inames
+        n_dims = len(onames)
+        if n_dims == 0:
+            raise NotImplementedError()
+
+        dtype_i = "npy_" + node.inputs[0].dtype
+        dtype_d = "npy_" + node.inputs[1].dtype
+        out_list = ", ".join(onames)
+        first_dim, last_dim, dim_step = (
+            (n_dims - 1, -1, -1) if self.order == "C" else (0, n_dims, 1)
+        )
+        fail = sub["fail"]
+        if self.openmp:
+            omp_parallel = (
+                "#pragma omp parallel for schedule(static) if(n >= %d)"
+                % int(config.openmp_elemwise_minsize)
+            )
+            omp_atomic_write = "#pragma omp atomic write"
+        else:
+            omp_parallel = omp_atomic_write = ""
+
+        code = """
+            {
+                PyArrayObject* ic = NULL;
+                PyArrayObject** outs[%(n_dims)d] = {%(out_refs)s};
+                npy_int64* out_data[%(n_dims)d];
+                npy_int64 dim_values[%(n_dims)d];
+                npy_int64 size = 1;
+                npy_intp n, i, bad = -1;
+                int d;
+                if (PyArray_DIMS(%(dims)s)[0] != %(n_dims)d) {
+                    PyErr_Format(PyExc_ValueError,
+                                 "dims must have %(n_dims)d elements, got %%ld",
+                                 (long)PyArray_DIMS(%(dims)s)[0]);
+                    %(fail)s;
+                }
+                for (d = 0; d < %(n_dims)d; d++) {
+                    dim_values[d] = (npy_int64)*(%(dtype_d)s*)PyArray_GETPTR1(%(dims)s, d);
+                    if (dim_values[d] < 0) {
+                        PyErr_SetString(PyExc_ValueError,
+                                        "dimensions must be non-negative");
+                        %(fail)s;
+                    }
+                    size *= dim_values[d];
+                }
+
+                ic = PyArray_GETCONTIGUOUS(%(indices)s);
+                if (ic == NULL)
+                    %(fail)s;
+                n = PyArray_SIZE(ic);
+                for (d = 0; d < %(n_dims)d; d++) {
+                    PyArrayObject* out = *outs[d];
+                    if (!(out != NULL && PyArray_IS_C_CONTIGUOUS(out) &&
+                          PyArray_NDIM(out) == PyArray_NDIM(ic) &&
+                          PyArray_CompareLists(PyArray_DIMS(out), PyArray_DIMS(ic), PyArray_NDIM(ic)))) {
+                        Py_XDECREF(out);
+                        *outs[d] = (PyArrayObject*) PyArray_SimpleNew(
+                            PyArray_NDIM(ic), PyArray_DIMS(ic), NPY_INT64);
+                        if (!*outs[d]) {
+                            Py_DECREF(ic);
+                            %(fail)s;
+                        }
+                    }
+                    out_data[d] = (npy_int64*)PyArray_DATA(*outs[d]);
+                }
+
+                {
+                    const %(dtype_i)s* i_data = (const %(dtype_i)s*)PyArray_DATA(ic);
+                    %(omp_parallel)s
+                    for (i = 0; i < n; i++) {
+                        npy_int64 idx = (npy_int64)i_data[i];
+                        int d;
+                        if (idx < 0 || idx >= size) {
+                            %(omp_atomic_write)s
+                            bad = i;
+                            continue;
+                        }
+                        for (d = %(first_dim)d; d != %(last_dim)d; d += %(dim_step)d) {
+                            out_data[d][i] = idx %% dim_values[d];
+                            idx /= dim_values[d];
+                        }
+                    }
+                    if (bad >= 0) {
+                        PyErr_Format(PyExc_ValueError,
+                                     "index %%lld is out of bounds for array with size %%lld",
+                                     (long long)i_data[bad], (long long)size);
+                    }
+                }
+                Py_DECREF(ic);
+                if (bad >= 0)
+                    %(fail)s;
+            }
+            """ % dict(
+            locals(), out_refs=", ".join(f"&{o}" for o in onames)
+        )
+        return code
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
 
 def unravel_index(indices, dims, order="C"):
     """
@@ -1407,7 +2643,7 @@ def unravel_index(indices, dims, order="C"):
         return tuple(res)
 
 
-class RavelMultiIndex(Op):
+class RavelMultiIndex(COp):
     __props__ = ("mode", "order")
 
     def __init__(self, mode="raise", order="C"):
@@ -1442,6 +2678,118 @@ class RavelMultiIndex(Op):
         res = np.ravel_multi_index(multi_index, dims, mode=self.mode, order=self.order)
         out[0][0] = _asarray(res, node.outputs[0].dtype)
 
+    def c_code(self, node, name, inames, onames, sub):
+        multi_index, dims = inames[:-1], inames[-1]
+        (z,) = onames
+        n_dims = len(multi_index)
+        out_nd = node.outputs[0].ndim
+        dtype_d = "npy_" + node.inputs[-1].dtype
+        fail = sub["fail"]
+        # Coordinates are combined from the slowest to the fastest varying
+        # dimension.
+        dim_order = range(n_dims) if self.order == "C" else reversed(range(n_dims))
+        combine = []
+        for d in dim_order:
+            if self.mode == "raise":
+                check = """
+                if (idx < 0 || idx >= dim_values[%(d)d]) {
+                    PyErr_SetString(PyExc_ValueError, "invalid entry in coordinates array");
+                    break;
+                }
+                """
+            elif self.mode == "wrap":
+                check = """
+                idx %%= dim_values[%(d)d];
+                if (idx < 0)
+                    idx += dim_values[%(d)d];
+                """
+            else:
+                check = """
+                if (idx < 0)
+                    idx = 0;
+                else if (idx >= dim_values[%(d)d])
+                    idx = dim_values[%(d)d] - 1;
+                """
+            combine.append(
+                (
+                    """
+                {
+                    npy_int64 idx = (npy_int64)*(npy_%(dtype)s*)PyArray_MultiIter_DATA(mit, %(d)d);
+                    """
+                    + check
+                    + """
+                    flat = flat * dim_values[%(d)d] + idx;
+                }
+                """
+                )
+                % dict(d=d, dtype=node.inputs[d].dtype)
+            )
+        combine = "".join(combine)
+
+        code = """
+            {
+                PyObject* arrays[%(n_dims)d] = {%(arrays)s};
+                PyArrayMultiIterObject* mit = NULL;
+                npy_int64 dim_values[%(n_dims)d];
+                npy_int64* z_data;
+                int d;
+                if (PyArray_DIMS(%(dims)s)[0] != %(n_dims)d) {
+                    PyErr_Format(PyExc_ValueError,
+                                 "parameter multi_index must be a sequence of length %%ld",
+                                 (long)PyArray_DIMS(%(dims)s)[0]);
+                    %(fail)s;
+                }
+                for (d = 0; d < %(n_dims)d; d++) {
+                    dim_values[d] = (npy_int64)*(%(dtype_d)s*)PyArray_GETPTR1(%(dims)s, d);
+                    if (dim_values[d] == 0) {
+                        PyErr_SetString(PyExc_ValueError,
+                                        "cannot unravel if shape has zero entries (is empty).");
+                        %(fail)s;
+                    }
+                }
+
+                mit = (PyArrayMultiIterObject*)PyArray_MultiIterFromObjects(arrays, %(n_dims)d, 0);
+                if (mit == NULL)
+                    %(fail)s;
+                if (mit->nd != %(out_nd)d) {
+                    PyErr_SetString(PyExc_ValueError,
+                                    "the broadcast multi_index has the wrong number of dimensions");
+                    Py_DECREF(mit);
+                    %(fail)s;
+                }
+                if (!(%(z)s != NULL && PyArray_IS_C_CONTIGUOUS(%(z)s) &&
+                      PyArray_CompareLists(PyArray_DIMS(%(z)s), mit->dimensions, %(out_nd)d))) {
+                    Py_XDECREF(%(z)s);
+                    %(z)s = (PyArrayObject*) PyArray_SimpleNew(%(out_nd)d, mit->dimensions, NPY_INT64);
+                    if (!%(z)s) {
+                        Py_DECREF(mit);
+                        %(fail)s;
+                    }
+                }
+                z_data = (npy_int64*)PyArray_DATA(%(z)s);
+                while (PyArray_MultiIter_NOTDONE(mit)) {
+                    npy_int64 flat = 0;
+                    do {
+                        %(combine)s
+                    } while (0);
+                    if (PyErr_Occurred())
+                        break;
+                    z_data[mit->index] = flat;
+                    PyArray_MultiIter_NEXT(mit);
+                }
+                Py_DECREF(mit);
+                if (PyErr_Occurred())
+                    %(fail)s;
+            }
+            """ % dict(
+            locals(),
+            arrays=", ".join(f"(PyObject*){i}" for i in multi_index),
+        )
+        return code
+
+    def c_code_cache_version(self):
+        return (1,)
+
 
 def ravel_multi_index(multi_index, dims, mode="raise", order="C"):
     """
@@ -1,15 +1,182 @@
+import os
+
 import numpy as np
 
+from aesara.configdefaults import config
 from aesara.gradient import DisconnectedType
 from aesara.graph.basic import Apply
-from aesara.graph.op import Op
+from aesara.link.c.op import OpenMPOp
 from aesara.tensor.basic import as_tensor_variable
 from aesara.tensor.math import sqrt
 from aesara.tensor.subtensor import set_subtensor
 from aesara.tensor.type import TensorType, integer_dtypes
 
 
-class RFFTOp(Op):
+def _fft_c_support_code():
+    with open(os.path.join(os.path.dirname(__file__), "c_code", "fft.c")) as f:
+        return f.read()
+
+
+class RealFFTBase(OpenMPOp):
+    """Base class for the real FFT `Op`\\s and their C implementation.
+
+    The C code transforms float32 and float64 arrays with the mixed-radix
+    FFT of ``c_code/fft.c``.  Each `Apply` node keeps the plans of the
+    lengths it transformed, so that later calls with the same shapes don't
+    compute twiddle factors again.  With OpenMP, the transforms along each
+    axis are spread over the threads.
+
+    """
+
+    def __init__(self, openmp=None):
+        super().__init__(openmp=openmp)
+
+    def c_fft_check(self, node):
+        """Raise `NotImplementedError` when the C code can't be used for `node`."""
+        dtype = node.inputs[0].type.dtype
+        if dtype not in ("float32", "float64") or node.outputs[0].type.dtype != dtype:
+            raise NotImplementedError("Only float32 and float64 are supported")
+
+    def c_read_s(self, s, ndim, dims, fail):
+        """C code setting ``n_axes`` from `s`, and the last dimensions of `dims` to its values."""
+        return f"""
+        npy_intp n_axes = PyArray_DIMS({s})[0];
+        if (n_axes < 1 || n_axes > {ndim})
+        {{
+            PyErr_Format(PyExc_ValueError,
+                         "expected between 1 and %d transformed axes, got %ld",
+                         {ndim}, (long)n_axes);
+            {fail};
+        }}
+        for (npy_intp j = 0; j < n_axes; ++j)
+        {{
+            npy_intp len = (npy_intp)*(dtype_{s}*)PyArray_GETPTR1({s}, j);
+            if (len < 1)
+            {{
+                PyErr_Format(PyExc_ValueError,
+                             "Invalid number of FFT data points (%ld) specified.",
+                             (long)len);
+                {fail};
+            }}
+            {dims}[{ndim} - n_axes + j] = len;
+        }}
+        """
+
+    def c_parallel_for(self, count, cost, work_size, body, ctype, fail):
+        """C code running `body` for each ``i`` below `count`.
+
+        `body` gets a ``work`` buffer of `work_size` complex elements per
+        thread.  `cost` is the work for each ``i`` compared against the
+        OpenMP threshold.
+
+        """
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            omp_parallel = (
+                "#pragma omp parallel if (omp_get_max_threads() > 1"
+                f" && ({count}) > 1 && ({count}) * (double)({cost}) >= {minsize})"
+            )
+            omp_for = "#pragma omp for schedule(static)"
+            omp_critical = "#pragma omp critical (aesara_fft)"
+        else:
+            omp_parallel = omp_for = omp_critical = ""
+        return f"""
+        {{
+            int nomem = 0;
+            const npy_intp count = {count};
+            const npy_intp work_size = {work_size};
+            {omp_parallel}
+            {{
+                aesara_cplx<{ctype}>* work = (aesara_cplx<{ctype}>*)malloc(
+                    sizeof(aesara_cplx<{ctype}>) * (work_size > 0 ? work_size : 1));
+                if (!work)
+                {{
+                    {omp_critical}
+                    nomem = 1;
+                }}
+                {omp_for}
+                for (npy_intp i = 0; i < count; ++i)
+                {{
+                    if (work)
+                    {{
+                        {body}
+                    }}
+                }}
+                free(work);
+            }}
+            if (nomem)
+            {{
+                PyErr_NoMemory();
+                {fail};
+            }}
+        }}
+        """
+
+    def c_axis_transforms(self, data, dims, ndim, plans, ctype, fail):
+        """C code transforming the complex `data`, of dimensions `dims`, along its
+        axes ``ndim - n_axes`` to ``ndim - 2`` with the matching `plans`."""
+        lines = self.c_parallel_for(
+            "n_lines",
+            "plan->n",
+            "aesara_fft_work_size(plan)",
+            f"aesara_fft_line(plan, {data}, i, stride, work);",
+            ctype,
+            fail,
+        )
+        return f"""
+        for (int d = {ndim} - (int)n_axes; d < {ndim - 1}; ++d)
+        {{
+            aesara_fft_plan<{ctype}>* plan = {plans}[d];
+            npy_intp stride = 1, n_lines = 1;
+            for (int e = 0; e < {ndim}; ++e)
+            {{
+                if (e > d)
+                    stride *= {dims}[e];
+                if (e != d)
+                    n_lines *= {dims}[e];
+            }}
+            {lines}
+        }}
+        """
+
+    def c_get_plans(self, node, name, dims, ndim, inverse, fail):
+        """C code getting ``real_plan`` for the last dimension in `dims`, and
+        ``axis_plans`` for the other transformed ones."""
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        return f"""
+        aesara_fft_plan<{ctype}>* axis_plans[{ndim}];
+        aesara_fft_plan<{ctype}>* real_plan = plans_{name}.get({dims}[{ndim - 1}], {inverse}, 1);
+        int plans_ok = real_plan != NULL;
+        for (int d = {ndim} - (int)n_axes; plans_ok && d < {ndim - 1}; ++d)
+        {{
+            axis_plans[d] = plans_{name}.get({dims}[d], {inverse}, 0);
+            plans_ok = axis_plans[d] != NULL;
+        }}
+        if (!plans_ok)
+        {{
+            PyErr_NoMemory();
+            {fail};
+        }}
+        """
+
+    def c_support_code(self, **kwargs):
+        return _fft_c_support_code()
+
+    def c_support_code_struct(self, node, name):
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        return f"aesara_fft_plan_cache<{ctype}> plans_{name};"
+
+    def c_cleanup_code_struct(self, node, name):
+        return f"plans_{name}.clear();"
+
+    def c_headers(self, **kwargs):
+        return super().c_headers(**kwargs) + ["<math.h>", "<stdlib.h>", "<string.h>"]
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
+
+class RFFTOp(RealFFTBase):
 
     __props__ = ()
 
@@ -48,6 +215,80 @@ class RFFTOp(Op):
         out[..., 0], out[..., 1] = np.real(A), np.imag(A)
         output_storage[0][0] = out
 
+    def c_code(self, node, name, inputs, outputs, sub):
+        self.c_fft_check(node)
+        a, s = inputs
+        (z,) = outputs
+        fail = sub["fail"]
+        ndim = node.inputs[0].type.ndim
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        typenum = node.outputs[0].type.dtype_specs()[2]
+        release_fail = f"Py_DECREF(ac); {fail}"
+        # The rows of the output hold the samples of the real transforms
+        rows = self.c_parallel_for(
+            "n_rows",
+            "n",
+            "aesara_fft_work_size(real_plan)",
+            f"""
+            npy_intp rem = i, offset = 0;
+            int inside = 1;
+            for (int d = {ndim - 2}; d >= 0; --d)
+            {{
+                npy_intp idx = rem % odims[d];
+                rem /= odims[d];
+                inside &= idx < PyArray_DIMS(ac)[d];
+                offset += idx * in_strides[d];
+            }}
+            aesara_cplx<{ctype}>* y = (aesara_cplx<{ctype}>*)PyArray_DATA({z}) + i * n_out;
+            if (inside)
+                aesara_fft_r2c(real_plan, ({ctype}*)PyArray_DATA(ac) + offset,
+                               PyArray_DIMS(ac)[{ndim - 1}], y, work);
+            else
+                memset(y, 0, sizeof(aesara_cplx<{ctype}>) * n_out);
+            """,
+            ctype,
+            release_fail,
+        )
+        return f"""
+        {{
+            npy_intp odims[{ndim + 1}];
+            for (int d = 0; d < {ndim}; ++d)
+                odims[d] = PyArray_DIMS({a})[d];
+            {self.c_read_s(s, ndim, "odims", fail)}
+            {self.c_get_plans(node, name, "odims", ndim, 0, fail)}
+            const npy_intp n = odims[{ndim - 1}];
+            const npy_intp n_out = n / 2 + 1;
+            npy_intp n_rows = 1;
+            for (int d = 0; d < {ndim - 1}; ++d)
+                n_rows *= odims[d];
+            odims[{ndim - 1}] = n_out;
+            odims[{ndim}] = 2;
+            {{
+                int alloc = {z} == NULL || !PyArray_IS_C_CONTIGUOUS({z});
+                for (int d = 0; !alloc && d < {ndim + 1}; ++d)
+                    alloc = PyArray_DIMS({z})[d] != odims[d];
+                if (alloc)
+                {{
+                    Py_XDECREF({z});
+                    {z} = (PyArrayObject*)PyArray_EMPTY({ndim + 1}, odims, {typenum}, 0);
+                    if (!{z}) {{{fail};}}
+                }}
+            }}
+            PyArrayObject* ac = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*){a}, {typenum}, 0, 0, NPY_ARRAY_CARRAY_RO);
+            if (!ac) {{{fail};}}
+            npy_intp in_strides[{ndim}];
+            in_strides[{ndim - 1}] = 1;
+            for (int d = {ndim - 2}; d >= 0; --d)
+                in_strides[d] = in_strides[d + 1] * PyArray_DIMS(ac)[d + 1];
+            {rows}
+            {self.c_axis_transforms(
+                f"(aesara_cplx<{ctype}>*)PyArray_DATA({z})",
+                "odims", ndim, "axis_plans", ctype, release_fail)}
+            Py_DECREF(ac);
+        }}
+        """
+
     def grad(self, inputs, output_grads):
         (gout,) = output_grads
         s = inputs[1]
@@ -70,7 +311,7 @@ class RFFTOp(Op):
 rfft_op = RFFTOp()
 
 
-class IRFFTOp(Op):
+class IRFFTOp(RealFFTBase):
 
     __props__ = ()
 
@@ -110,6 +351,116 @@ class IRFFTOp(Op):
         # Cast to input type (numpy outputs float64 by default)
         output_storage[0][0] = (out * s.prod()).astype(a.dtype)
 
+    def c_code(self, node, name, inputs, outputs, sub):
+        self.c_fft_check(node)
+        a, s = inputs
+        (z,) = outputs
+        fail = sub["fail"]
+        ndim = node.outputs[0].type.ndim
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        typenum = node.outputs[0].type.dtype_specs()[2]
+        cplx = f"aesara_cplx<{ctype}>"
+        release_fail = f"Py_DECREF(ac); free(t); {fail}"
+        # With several transformed axes, the other axes are transformed in
+        # `t`, which holds the `n_in` first frequencies of each row
+        fill = self.c_parallel_for(
+            "n_rows",
+            "n_in",
+            "0",
+            f"""
+            npy_intp rem = i, offset = 0;
+            int inside = 1;
+            for (int d = {ndim - 2}; d >= 0; --d)
+            {{
+                npy_intp idx = rem % odims[d];
+                rem /= odims[d];
+                inside &= idx < PyArray_DIMS(ac)[d];
+                offset += idx * in_strides[d];
+            }}
+            {cplx}* row = t + i * n_in;
+            npy_intp copied = inside ? n_copied : 0;
+            memcpy(row, ({cplx}*)PyArray_DATA(ac) + offset, sizeof({cplx}) * copied);
+            memset(row + copied, 0, sizeof({cplx}) * (n_in - copied));
+            """,
+            ctype,
+            release_fail,
+        )
+        rows = self.c_parallel_for(
+            "n_rows",
+            "n",
+            "aesara_fft_work_size(real_plan)",
+            f"""
+            aesara_fft_c2r(real_plan, src + i * n_src, n_src,
+                           ({ctype}*)PyArray_DATA({z}) + i * n, work);
+            """,
+            ctype,
+            release_fail,
+        )
+        return f"""
+        {{
+            if (PyArray_DIMS({a})[{ndim}] != 2)
+            {{
+                PyErr_SetString(PyExc_ValueError,
+                                "the last dimension of the input must hold the "
+                                "real and imaginary parts");
+                {fail};
+            }}
+            npy_intp odims[{ndim}], tdims[{ndim}];
+            for (int d = 0; d < {ndim}; ++d)
+                odims[d] = PyArray_DIMS({a})[d];
+            {self.c_read_s(s, ndim, "odims", fail)}
+            {self.c_get_plans(node, name, "odims", ndim, 1, fail)}
+            const npy_intp n = odims[{ndim - 1}];
+            const npy_intp n_in = n / 2 + 1;
+            npy_intp n_rows = 1;
+            for (int d = 0; d < {ndim - 1}; ++d)
+            {{
+                n_rows *= odims[d];
+                tdims[d] = odims[d];
+            }}
+            tdims[{ndim - 1}] = n_in;
+            {{
+                int alloc = {z} == NULL || !PyArray_IS_C_CONTIGUOUS({z});
+                for (int d = 0; !alloc && d < {ndim}; ++d)
+                    alloc = PyArray_DIMS({z})[d] != odims[d];
+                if (alloc)
+                {{
+                    Py_XDECREF({z});
+                    {z} = (PyArrayObject*)PyArray_EMPTY({ndim}, odims, {typenum}, 0);
+                    if (!{z}) {{{fail};}}
+                }}
+            }}
+            PyArrayObject* ac = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*){a}, {typenum}, 0, 0, NPY_ARRAY_CARRAY_RO);
+            if (!ac) {{{fail};}}
+            {cplx}* t = NULL;
+            const npy_intp n_copied = PyArray_DIMS(ac)[{ndim - 1}] < n_in
+                ? PyArray_DIMS(ac)[{ndim - 1}] : n_in;
+            const {cplx}* src = (const {cplx}*)PyArray_DATA(ac);
+            npy_intp n_src = PyArray_DIMS(ac)[{ndim - 1}];
+            if (n_axes > 1)
+            {{
+                npy_intp in_strides[{ndim}];
+                in_strides[{ndim - 1}] = 1;
+                for (int d = {ndim - 2}; d >= 0; --d)
+                    in_strides[d] = in_strides[d + 1] * PyArray_DIMS(ac)[d + 1];
+                t = ({cplx}*)malloc(sizeof({cplx}) * (n_rows * n_in > 0 ? n_rows * n_in : 1));
+                if (!t)
+                {{
+                    PyErr_NoMemory();
+                    {release_fail};
+                }}
+                {fill}
+                {self.c_axis_transforms("t", "tdims", ndim, "axis_plans", ctype, release_fail)}
+                src = t;
+                n_src = n_in;
+            }}
+            {rows}
+            free(t);
+            Py_DECREF(ac);
+        }}
+        """
+
     def grad(self, inputs, output_grads):
         (gout,) = output_grads
         s = inputs[1]
@@ -1,9 +1,19 @@
+import mmap
+import multiprocessing
+import os
+import queue
+import threading
+import time
+import uuid
+from multiprocessing import shared_memory
+
 import numpy as np
 
 from aesara.graph.basic import Apply, Constant, Variable
 from aesara.graph.op import Op
 from aesara.graph.sched import key_to_cmp
 from aesara.link.c.type import Generic
+from aesara.tensor.basic import as_tensor_variable
 from aesara.tensor.type import tensor
 
 
@@ -94,6 +104,220 @@ def load(path, dtype, broadcastable, mmap_mode=None):
     return LoadFromDisk(dtype, broadcastable, mmap_mode)(path)
 
 
+def _array_file_layout(path, dtype, shape, offset):
+    """Return the dtype, shape and data offset of an .npy or raw binary file."""
+    if path.endswith(".npy"):
+        with open(path, "rb") as f:
+            version = np.lib.format.read_magic(f)
+            if version == (1, 0):
+                shape, fortran_order, dtype = np.lib.format.read_array_header_1_0(f)
+            elif version == (2, 0):
+                shape, fortran_order, dtype = np.lib.format.read_array_header_2_0(f)
+            else:
+                raise ValueError(f"Unsupported .npy format version {version}")
+            if fortran_order and len(shape) > 1:
+                raise ValueError(
+                    f"Can't read {path} in chunks of rows: it's in Fortran order"
+                )
+            if dtype.hasobject:
+                raise ValueError(f"Can't read {path}: it holds Python objects")
+            return dtype, tuple(shape), f.tell()
+
+    if dtype is None:
+        raise ValueError("The dtype of raw binary files must be given")
+    dtype = np.dtype(dtype)
+    row_shape = () if shape is None else tuple(shape[1:])
+    row_size = dtype.itemsize * int(np.prod(row_shape))
+    n_bytes = os.path.getsize(path) - offset
+    if shape is None or shape[0] in (None, -1):
+        if row_size == 0 or n_bytes % row_size:
+            raise ValueError(
+                f"The size of {path} isn't a multiple of the size of its rows"
+            )
+        shape = (n_bytes // row_size,) + row_shape
+    elif shape[0] * row_size > n_bytes:
+        raise ValueError(f"{path} is too small for an array of shape {shape}")
+    return dtype, tuple(shape), offset
+
+
+class ChunkReader:
+    """
+    Read an array from an .npy or raw binary file in chunks of rows.
+
+    A background thread reads the next chunks while the previous ones are
+    being processed, so that the reads overlap with the computations.  The
+    chunks are NumPy arrays that can be passed to compiled functions as is:
+    their inputs aren't copied.
+
+    Parameters
+    ----------
+    path
+        The path of the file.  Files whose name ends with ``.npy`` are read
+        as .npy files, and the others as raw binary data.
+    chunk_size
+        The number of rows, along the first dimension, of each chunk.  The
+        last chunk may have fewer rows.
+    dtype
+        The data type of a raw binary file.
+    shape
+        The shape of the array in a raw binary file.  By default, it's a
+        vector of the whole file; the first dimension can be -1 to fit the
+        file size.
+    offset
+        The number of bytes before the data in a raw binary file.
+    mmap_mode
+        None to read each chunk into a new array, or 'r' to return read-only
+        views of a memory map of the file.  With 'r', the thread asks the
+        operating system to read the next chunks ahead.
+    prefetch
+        The number of chunks read ahead.
+    start, stop
+        The range of rows to read.
+
+    Examples
+    --------
+    >>> x = matrix("x")
+    >>> fn = function([x], x.sum(axis=0))
+    >>> with ChunkReader("data.npy", 4096) as chunks:  # doctest: +SKIP
+    ...     total = sum(fn(chunk) for chunk in chunks)
+
+    """
+
+    def __init__(
+        self,
+        path,
+        chunk_size,
+        dtype=None,
+        shape=None,
+        offset=0,
+        mmap_mode=None,
+        prefetch=2,
+        start=0,
+        stop=None,
+    ):
+        if mmap_mode not in (None, "r"):
+            raise ValueError(
+                f"The only supported values for mmap_mode are None and 'r', got {mmap_mode}"
+            )
+        if chunk_size < 1 or prefetch < 1:
+            raise ValueError("chunk_size and prefetch must be positive")
+        self.path = os.fspath(path)
+        self.dtype, self.shape, self.offset = _array_file_layout(
+            self.path, dtype, shape, offset
+        )
+        if not self.shape:
+            raise ValueError(f"Can't read {self.path} in chunks: it holds a scalar")
+        self.chunk_size = chunk_size
+        self.mmap_mode = mmap_mode
+        self.prefetch = prefetch
+        self.start, self.stop, _ = slice(start, stop).indices(self.shape[0])
+        self.stop = max(self.start, self.stop)
+        self.row_size = self.dtype.itemsize * int(np.prod(self.shape[1:]))
+        self._thread = None
+        self._stopping = None
+
+    def __len__(self):
+        return -(-(self.stop - self.start) // self.chunk_size)
+
+    def __iter__(self):
+        self.close()
+        chunks = queue.Queue(self.prefetch)
+        stopping = threading.Event()
+        thread = threading.Thread(
+            target=self._read, args=(chunks, stopping), daemon=True
+        )
+        self._thread, self._stopping = thread, stopping
+        thread.start()
+        try:
+            while True:
+                chunk = chunks.get()
+                if chunk is None:
+                    break
+                if isinstance(chunk, BaseException):
+                    raise chunk
+                yield chunk
+        finally:
+            if self._thread is thread:
+                self.close()
+
+    def _read(self, chunks, stopping):
+        def put(item):
+            # Wait for room in the queue, unless the reader is closed
+            while not stopping.is_set():
+                try:
+                    chunks.put(item, timeout=0.1)
+                    return True
+                except queue.Full:
+                    pass
+            return False
+
+        try:
+            with open(self.path, "rb", buffering=0) as f:
+                if self.mmap_mode is None:
+                    self._read_chunks(f, put)
+                else:
+                    self._map_chunks(f, put)
+        except BaseException as e:
+            put(e)
+        else:
+            put(None)
+
+    def _bounds(self):
+        for begin in range(self.start, self.stop, self.chunk_size):
+            yield begin, min(begin + self.chunk_size, self.stop)
+
+    def _read_chunks(self, f, put):
+        f.seek(self.offset + self.start * self.row_size)
+        for begin, end in self._bounds():
+            chunk = np.empty((end - begin,) + self.shape[1:], dtype=self.dtype)
+            buffer = memoryview(chunk.reshape(-1).view(np.uint8))
+            while buffer:
+                # `readinto` releases the GIL while waiting for the disk
+                n_read = f.readinto(buffer)
+                if not n_read:
+                    raise EOFError(f"{self.path} ended before row {end}")
+                buffer = buffer[n_read:]
+            if not put(chunk):
+                return
+
+    def _map_chunks(self, f, put):
+        if self.row_size * (self.stop - self.start) == 0:
+            # Empty files can't be mapped
+            for begin, end in self._bounds():
+                if not put(np.empty((end - begin,) + self.shape[1:], self.dtype)):
+                    return
+            return
+        mapped = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        array = np.frombuffer(
+            mapped, self.dtype, int(np.prod(self.shape)), self.offset
+        ).reshape(self.shape)
+        for begin, end in self._bounds():
+            if hasattr(mapped, "madvise"):
+                pos = self.offset + begin * self.row_size
+                aligned = pos - pos % mmap.PAGESIZE
+                mapped.madvise(
+                    mmap.MADV_WILLNEED,
+                    aligned,
+                    pos - aligned + (end - begin) * self.row_size,
+                )
+            if not put(array[begin:end]):
+                return
+        # The map is closed once the last view is released
+
+    def close(self):
+        """Stop the background thread."""
+        if self._thread is not None:
+            self._stopping.set()
+            self._thread.join()
+            self._thread = self._stopping = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc_info):
+        self.close()
+
+
 ##########################
 # MPI
 ##########################
@@ -143,7 +367,9 @@ class MPIRecv(Op):
 
     def perform(self, node, inp, out):
 
-        data = np.zeros(self.shape, dtype=self.dtype)
+        data = out[1][0]
+        if data is None or data.shape != tuple(self.shape):
+            data = np.empty(self.shape, dtype=self.dtype)
         request = comm.Irecv(data, self.source, self.tag)
 
         out[0][0] = request
@@ -295,6 +521,518 @@ def recv(shape, dtype, source, tag):
     return MPIRecvWait(tag)(*irecv(shape, dtype, source, tag))
 
 
+##########################
+# Shared memory
+##########################
+
+_shm_groups = {}
+
+_shm_reductions = {
+    "sum": np.add,
+    "prod": np.multiply,
+    "max": np.maximum,
+    "min": np.minimum,
+    "mean": np.add,
+}
+
+
+class ShmRequest:
+    """A collective operation queued on a `SharedMemoryGroup`."""
+
+    def __init__(self, method, args):
+        self.method = method
+        self.args = args
+        self.done = threading.Event()
+        self.error = None
+
+    def wait(self):
+        """Wait for the operation, and raise its error if it failed."""
+        self.done.wait()
+        if self.error is not None:
+            raise self.error
+
+
+class SharedMemoryGroup:
+    """
+    A group of local processes that exchange arrays through POSIX shared
+    memory.
+
+    Each process of the group creates a `SharedMemoryGroup` with the same
+    `name`, `size` and `capacity`, and its own `rank`.  The collective
+    operations must be called in the same order by all the processes.  They
+    run in a background thread, so that the computations of the caller can
+    overlap with them, and go through a shared segment allocated once: one
+    slot of `capacity` bytes per process, plus one for the results.
+    Larger arrays are processed in pieces.
+
+    Each process copies its array in its slot; then each one reduces its
+    share of the slots, as in a ring all-reduce, except that all the slots
+    are directly readable; and all the processes read the result.
+
+    Parameters
+    ----------
+    name
+        The name of the shared memory segment.
+    rank
+        The rank of the process, from 0 to ``size - 1``.  The process of
+        rank 0 creates the segment, and removes it when closed.
+    size
+        The number of processes in the group.
+    capacity
+        The size in bytes of the slots.
+    timeout
+        The number of seconds to wait for the other processes before
+        raising a `TimeoutError`, or None to wait indefinitely.
+
+    """
+
+    def __init__(self, name, rank, size, capacity=2**22, timeout=None):
+        if not 0 <= rank < size:
+            raise ValueError(f"Invalid rank {rank} for a group of size {size}")
+        self.name = name
+        self.rank = rank
+        self.size = size
+        # Slots are aligned on cache lines
+        self.capacity = -(-capacity // 64) * 64
+        self.timeout = timeout
+        n_bytes = 64 * size + (size + 1) * self.capacity
+        if rank == 0:
+            self._shm = shared_memory.SharedMemory(name, create=True, size=n_bytes)
+        else:
+            deadline = None if timeout is None else time.monotonic() + timeout
+            while True:
+                try:
+                    self._shm = shared_memory.SharedMemory(name)
+                    break
+                except FileNotFoundError:
+                    if deadline is not None and time.monotonic() > deadline:
+                        raise TimeoutError(f"No shared memory segment named {name}")
+                    time.sleep(0.001)
+            # Only the creator removes the segment
+            from multiprocessing import resource_tracker
+
+            resource_tracker.unregister(self._shm._name, "shared_memory")
+        # One barrier counter per process, on separate cache lines
+        self._arrived = np.ndarray(
+            (size,), dtype=np.int64, buffer=self._shm.buf, strides=(64,)
+        )
+        self._epoch = 0
+        self._requests = queue.Queue()
+        self._thread = None
+        _shm_groups[name] = self
+        # The segment is zero-filled at creation, and may only be used once
+        # all the processes are attached
+        self._barrier()
+
+    def _barrier(self):
+        """Wait for all the processes to reach the same barrier."""
+        self._epoch += 1
+        self._arrived[self.rank] = self._epoch
+        deadline = None if self.timeout is None else time.monotonic() + self.timeout
+        # The other processes are usually close behind, so the delay between
+        # checks starts short and doubles, up to a millisecond
+        delay = 1e-6
+        while self._arrived.min() < self._epoch:
+            time.sleep(delay)
+            delay = min(2 * delay, 1e-3)
+            if deadline is not None and time.monotonic() > deadline:
+                raise TimeoutError(
+                    f"Timed out waiting for the processes of group {self.name}"
+                )
+
+    def _slot(self, index, dtype, count):
+        offset = 64 * self.size + index * self.capacity
+        return np.ndarray((count,), dtype=dtype, buffer=self._shm.buf, offset=offset)
+
+    def _piece(self, dtype, n_slots=1):
+        return max(1, self.capacity // (dtype.itemsize * n_slots))
+
+    def _share(self, count, rank):
+        return count * rank // self.size, count * (rank + 1) // self.size
+
+    def _all_reduce(self, x, out, op):
+        reduce = _shm_reductions[op]
+        x = x.reshape(-1)
+        flat = out.reshape(-1)
+        piece = self._piece(x.dtype)
+        for begin in range(0, max(x.size, 1), piece):
+            end = min(begin + piece, x.size)
+            count = end - begin
+            self._slot(self.rank, x.dtype, count)[...] = x[begin:end]
+            self._barrier()
+            lo, hi = self._share(count, self.rank)
+            result = self._slot(self.size, x.dtype, count)[lo:hi]
+            # The same order of reduction for every piece on every process
+            result[...] = self._slot(0, x.dtype, count)[lo:hi]
+            for rank in range(1, self.size):
+                reduce(result, self._slot(rank, x.dtype, count)[lo:hi], out=result)
+            if op == "mean":
+                result /= self.size
+            self._barrier()
+            flat[begin:end] = self._slot(self.size, x.dtype, count)
+        # The results are read before the next operation overwrites them
+        self._barrier()
+
+    def _broadcast(self, x, out, root):
+        x = x.reshape(-1)
+        flat = out.reshape(-1)
+        piece = self._piece(out.dtype)
+        for begin in range(0, max(flat.size, 1), piece):
+            end = min(begin + piece, flat.size)
+            if self.rank == root:
+                self._slot(root, x.dtype, end - begin)[...] = x[begin:end]
+            self._barrier()
+            if self.rank != root:
+                flat[begin:end] = self._slot(root, out.dtype, end - begin)
+            else:
+                flat[begin:end] = x[begin:end]
+            self._barrier()
+
+    def _all_gather(self, x, out):
+        x = x.reshape(-1)
+        flat = out.reshape(self.size, -1)
+        piece = self._piece(x.dtype)
+        for begin in range(0, max(x.size, 1), piece):
+            end = min(begin + piece, x.size)
+            self._slot(self.rank, x.dtype, end - begin)[...] = x[begin:end]
+            self._barrier()
+            for rank in range(self.size):
+                flat[rank, begin:end] = self._slot(rank, x.dtype, end - begin)
+            self._barrier()
+
+    def _reduce_scatter(self, x, out, op):
+        reduce = _shm_reductions[op]
+        x = x.reshape(self.size, -1)
+        flat = out.reshape(-1)
+        share = x.shape[1]
+        # Each slot holds a piece of the share of every process
+        piece = self._piece(x.dtype, self.size)
+        for begin in range(0, max(share, 1), piece):
+            end = min(begin + piece, share)
+            count = end - begin
+            slot = self._slot(self.rank, x.dtype, self.size * count)
+            slot.reshape(self.size, count)[...] = x[:, begin:end]
+            self._barrier()
+            mine = slice(self.rank * count, (self.rank + 1) * count)
+            result = flat[begin:end]
+            result[...] = self._slot(0, x.dtype, self.size * count)[mine]
+            for rank in range(1, self.size):
+                slot = self._slot(rank, x.dtype, self.size * count)
+                reduce(result, slot[mine], out=result)
+            if op == "mean":
+                result /= self.size
+            self._barrier()
+
+    def _run(self):
+        while True:
+            request = self._requests.get()
+            if request is None:
+                return
+            try:
+                request.method(*request.args)
+            except BaseException as e:
+                request.error = e
+            request.done.set()
+
+    def start(self, kind, x, out, op="sum", root=0):
+        """Queue a collective operation, and return its `ShmRequest`.
+
+        `kind` is ``"all_reduce"``, ``"broadcast"``, ``"all_gather"`` or
+        ``"reduce_scatter"``.  `x` is copied, so it can be modified as soon
+        as this returns.  `out` receives the result, and must not be used
+        before the request is done.  See `all_reduce` and the other functions
+        for the shapes of the results.
+
+        """
+        if op not in _shm_reductions:
+            raise ValueError(f"Unknown reduction {op}")
+        if op == "mean" and kind in ("all_reduce", "reduce_scatter"):
+            if np.dtype(x.dtype).kind not in "fc":
+                raise ValueError("Only floating-point arrays can be averaged")
+        if not 0 <= root < self.size:
+            raise ValueError(f"Invalid root {root} for a group of size {self.size}")
+        # The operation runs later, in the background thread
+        x = np.array(x, order="C")
+        if not out.flags.c_contiguous or out.dtype != x.dtype:
+            raise ValueError(
+                "The output must be a C-contiguous array of the input dtype"
+            )
+        method, args = {
+            "all_reduce": (self._all_reduce, (x, out, op)),
+            "broadcast": (self._broadcast, (x, out, root)),
+            "all_gather": (self._all_gather, (x, out)),
+            "reduce_scatter": (self._reduce_scatter, (x, out, op)),
+        }[kind]
+        expected = x.size * self.size if kind == "all_gather" else x.size
+        if out.size * (self.size if kind == "reduce_scatter" else 1) != expected:
+            raise ValueError(f"The output of {kind} doesn't match the input size")
+        if self._thread is None:
+            self._thread = threading.Thread(target=self._run, daemon=True)
+            self._thread.start()
+        request = ShmRequest(method, args)
+        self._requests.put(request)
+        return request
+
+    def _collective(self, kind, x, shape, op="sum", root=0):
+        x = np.asarray(x)
+        out = np.empty(shape, dtype=x.dtype)
+        self.start(kind, x, out, op, root).wait()
+        return out
+
+    def all_reduce(self, x, op="sum"):
+        """Reduce `x` over the processes with `op`: ``"sum"``, ``"prod"``,
+        ``"max"``, ``"min"`` or ``"mean"``."""
+        return self._collective("all_reduce", x, np.shape(x), op)
+
+    def broadcast(self, x, root=0):
+        """Return the `x` of the process of rank `root`."""
+        return self._collective("broadcast", x, np.shape(x), root=root)
+
+    def all_gather(self, x):
+        """Concatenate the `x` of all the processes along their first axis."""
+        x = np.asarray(x)
+        return self._collective("all_gather", x, _gather_shape(x.shape, self.size))
+
+    def reduce_scatter(self, x, op="sum"):
+        """Reduce `x` over the processes with `op`, and return the part of the
+        result of this process along the first axis."""
+        x = np.asarray(x)
+        return self._collective(
+            "reduce_scatter", x, _scatter_shape(x.shape, self.size), op
+        )
+
+    def close(self):
+        """Stop the background thread, and release the shared memory."""
+        if self._thread is not None:
+            self._requests.put(None)
+            self._thread.join()
+            self._thread = None
+        if _shm_groups.get(self.name) is self:
+            del _shm_groups[self.name]
+        del self._arrived
+        self._shm.close()
+        if self.rank == 0:
+            self._shm.unlink()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc_info):
+        self.close()
+
+
+def _gather_shape(shape, size):
+    if not shape:
+        raise ValueError("Can't gather scalars")
+    return (shape[0] * size,) + tuple(shape[1:])
+
+
+def _scatter_shape(shape, size):
+    if not shape or shape[0] % size:
+        raise ValueError(
+            f"The first dimension must be a multiple of the group size {size}"
+        )
+    return (shape[0] // size,) + tuple(shape[1:])
+
+
+def _launch_worker(fn, name, rank, size, capacity, timeout, args, results):
+    try:
+        with SharedMemoryGroup(name, rank, size, capacity, timeout) as group:
+            results.put((rank, True, fn(group, *args)))
+    except BaseException as e:
+        results.put((rank, False, repr(e)))
+
+
+def launch(fn, size, args=(), capacity=2**22, timeout=None):
+    """
+    Run ``fn(group, *args)`` in `size` new processes, and return the results.
+
+    `group` is the `SharedMemoryGroup` of the processes, and the results are
+    ordered by rank.  `fn` and the results are sent to and from the
+    processes, so they must be picklable with the default start method.
+
+    """
+    name = f"aesara_{uuid.uuid4().hex[:16]}"
+    results = multiprocessing.Queue()
+    processes = [
+        multiprocessing.Process(
+            target=_launch_worker,
+            args=(fn, name, rank, size, capacity, timeout, args, results),
+        )
+        for rank in range(size)
+    ]
+    for process in processes:
+        process.start()
+    outputs = [None] * size
+    errors = []
+    for _ in range(size):
+        rank, ok, value = results.get()
+        if ok:
+            outputs[rank] = value
+        else:
+            errors.append(f"rank {rank}: {value}")
+    for process in processes:
+        process.join()
+    if errors:
+        raise RuntimeError("Processes of the group failed: " + "; ".join(errors))
+    return outputs
+
+
+class ShmCollective(Op):
+    """
+    An operation to start a collective operation on an array, over the
+    processes of a `SharedMemoryGroup`.
+
+    The second output receives the result once the first one, a request, is
+    waited on by `ShmWait`.
+
+    See Also
+    --------
+    all_reduce, broadcast, all_gather, reduce_scatter
+
+    Notes
+    -----
+    Non-differentiable.
+
+    """
+
+    __props__ = ("group", "kind", "reduce_op", "root", "tag")
+
+    def __init__(self, group, kind, reduce_op="sum", root=0, tag=0):
+        if kind not in ("all_reduce", "broadcast", "all_gather", "reduce_scatter"):
+            raise ValueError(f"Unknown collective operation {kind}")
+        if reduce_op not in _shm_reductions:
+            raise ValueError(f"Unknown reduction {reduce_op}")
+        self.group = group
+        self.kind = kind
+        self.reduce_op = reduce_op
+        self.root = root
+        self.tag = tag
+
+    def make_node(self, data):
+        data = as_tensor_variable(data)
+        if self.kind in ("all_gather", "reduce_scatter") and data.ndim == 0:
+            raise TypeError(f"{self.kind} requires arrays of at least one dimension")
+        shape = data.broadcastable
+        if self.kind in ("all_gather", "reduce_scatter"):
+            shape = (False,) + shape[1:]
+        return Apply(
+            self, [data], [Variable(Generic()), tensor(data.dtype, shape=shape)]
+        )
+
+    def perform(self, node, inp, out):
+        group = _shm_groups.get(self.group)
+        if group is None:
+            raise RuntimeError(f"No shared memory group named {self.group}")
+        data = np.asarray(inp[0])
+        shape = data.shape
+        if self.kind == "all_gather":
+            shape = _gather_shape(shape, group.size)
+        elif self.kind == "reduce_scatter":
+            shape = _scatter_shape(shape, group.size)
+        result = out[1][0]
+        if result is None or result.shape != shape:
+            result = np.empty(shape, dtype=data.dtype)
+        out[0][0] = group.start(self.kind, data, result, self.reduce_op, self.root)
+        out[1][0] = result
+
+    def __str__(self):
+        return f"ShmCollective{{{self.kind}, group: {self.group}, tag: {self.tag}}}"
+
+    def do_constant_folding(self, fgraph, node):
+        return False
+
+
+class ShmWait(Op):
+    """
+    An operation to wait on a collective operation started by `ShmCollective`.
+
+    Notes
+    -----
+    Non-differentiable.
+
+    """
+
+    __props__ = ("tag",)
+
+    def __init__(self, tag):
+        self.tag = tag
+
+    def make_node(self, request, data):
+        return Apply(self, [request, data], [data.type()])
+
+    def perform(self, node, inp, out):
+        request, data = inp
+        request.wait()
+        out[0][0] = data
+
+    def infer_shape(self, fgraph, node, shapes):
+        return [shapes[1]]
+
+    view_map = {0: [1]}
+
+
+def _collective(var, group, kind, reduce_op="sum", root=0, tag=0):
+    if isinstance(group, SharedMemoryGroup):
+        group = group.name
+    request, data = ShmCollective(group, kind, reduce_op, root, tag)(var)
+    return ShmWait(tag)(request, data)
+
+
+def all_reduce(var, group, op="sum", tag=0):
+    """
+    Reduce `var` over the processes of `group`, a `SharedMemoryGroup` or its
+    name, with `op`: ``"sum"``, ``"prod"``, ``"max"``, ``"min"`` or
+    ``"mean"``.
+
+    The operation starts as soon as `var` is computed and is waited on when
+    its result is needed, so that it overlaps with the computations in
+    between when the function is scheduled with `shm_cmps`.  `tag` orders
+    the operations that are ready at the same time; it must be the same
+    in all the processes.
+
+    """
+    return _collective(var, group, "all_reduce", op, tag=tag)
+
+
+def broadcast(var, group, root=0, tag=0):
+    """Return the `var` of the process of rank `root` in `group`.
+
+    See `all_reduce` for the other parameters.
+    """
+    return _collective(var, group, "broadcast", root=root, tag=tag)
+
+
+def all_gather(var, group, tag=0):
+    """Concatenate the `var` of all the processes of `group` along the first
+    axis.
+
+    See `all_reduce` for the other parameters.
+    """
+    return _collective(var, group, "all_gather", tag=tag)
+
+
+def reduce_scatter(var, group, op="sum", tag=0):
+    """Reduce `var` over the processes of `group`, and return the part of the
+    result of this process, split along the first axis.
+
+    See `all_reduce` for the other parameters.
+    """
+    return _collective(var, group, "reduce_scatter", op, tag=tag)
+
+
+def all_reduce_gradients(grads, group, op="mean", tag=0):
+    """
+    All-reduce `grads`, each one as soon as it is computed.
+
+    With `shm_cmps`, the reduction of the gradients of the last layers
+    overlaps with the backpropagation through the first ones.  The tags of
+    the reductions start at `tag`.
+
+    """
+    return [all_reduce(g, group, op, tag + i) for i, g in enumerate(grads)]
+
+
 # Ordering keys for scheduling
 def mpi_send_wait_key(a):
     """Wait as long as possible on Waits, Start Send/Recvs early."""
@@ -319,4 +1057,27 @@ mpi_tag_cmp = key_to_cmp(mpi_tag_key)
 mpi_keys = (mpi_send_wait_key, mpi_tag_key)
 mpi_cmps = (mpi_send_wait_cmp, mpi_tag_cmp)
 
+
+def shm_start_wait_key(a):
+    """Start collective operations early, and wait on them late."""
+    if isinstance(a.op, ShmWait):
+        return 1
+    if isinstance(a.op, ShmCollective):
+        return -1
+    return 0
+
+
+def shm_tag_key(a):
+    """Break ties between collective operations by their tags."""
+    if isinstance(a.op, (ShmCollective, ShmWait)):
+        return a.op.tag
+    return 0
+
+
+shm_start_wait_cmp = key_to_cmp(shm_start_wait_key)
+shm_tag_cmp = key_to_cmp(shm_tag_key)
+
+shm_keys = (shm_start_wait_key, shm_tag_key)
+shm_cmps = (shm_start_wait_cmp, shm_tag_cmp)
+
 __all__ = ["load"]
@@ -0,0 +1,325 @@
+"""Base class for `Op`s whose C code calls LAPACK on a batch of matrices.
+
+The C code sees the last two dimensions of an input as the matrices and the
+leading ones as the batch.  Each matrix is handed to the Fortran routine
+through its row-major buffer, which LAPACK reads as the transpose of the
+matrix; the `Op`s swap triangles and transposition flags accordingly.
+
+"""
+
+from aesara.configdefaults import config
+from aesara.link.c.op import OpenMPOp
+from aesara.tensor.blas import ldflags
+from aesara.tensor.blas_headers import detect_lapack, lapack_header_text
+
+
+_lapack_support_code = """
+#ifndef _AESARA_LAPACK_SUPPORT
+#define _AESARA_LAPACK_SUPPORT
+
+// Raise `numpy.linalg.LinAlgError`, which SciPy raises as well.
+static void aesara_linalg_error(const char* fmt, long value)
+{
+    PyObject* module = PyImport_ImportModule("numpy.linalg");
+    PyObject* exc = module ? PyObject_GetAttrString(module, "LinAlgError") : NULL;
+    Py_XDECREF(module);
+    if (exc)
+    {
+        PyErr_Format(exc, fmt, value);
+        Py_DECREF(exc);
+    }
+}
+
+// x * 0 is NaN for infinities and NaNs only.
+template <typename T>
+static int aesara_lapack_all_finite(const T* x, npy_intp size)
+{
+    T acc = 0;
+    for (npy_intp i = 0; i < size; ++i)
+        acc += x[i] * 0;
+    return acc == acc;
+}
+
+// Copy a row-major `n` x `k` matrix to column-major order, and back.
+template <typename T>
+static void aesara_lapack_to_fortran(const T* src, T* dst, int n, int k)
+{
+    if (k == 1)
+    {
+        memcpy(dst, src, n * sizeof(T));
+        return;
+    }
+    for (int r = 0; r < n; ++r)
+        for (int c = 0; c < k; ++c)
+            dst[(npy_intp)c * n + r] = src[(npy_intp)r * k + c];
+}
+
+template <typename T>
+static void aesara_lapack_from_fortran(const T* src, T* dst, int n, int k)
+{
+    if (k == 1)
+    {
+        memcpy(dst, src, n * sizeof(T));
+        return;
+    }
+    for (int r = 0; r < n; ++r)
+        for (int c = 0; c < k; ++c)
+            dst[(npy_intp)r * k + c] = src[(npy_intp)c * n + r];
+}
+
+// Zero the strict upper (`lower`) or lower triangle of a row-major matrix.
+template <typename T>
+static void aesara_lapack_zero_triangle(T* a, int n, int lower)
+{
+    for (int r = 0; r < n; ++r)
+    {
+        if (lower)
+            for (int c = r + 1; c < n; ++c)
+                a[(npy_intp)r * n + c] = 0;
+        else
+            for (int c = 0; c < r; ++c)
+                a[(npy_intp)r * n + c] = 0;
+    }
+}
+
+#endif
+"""
+
+
+class LapackOp(OpenMPOp):
+    """Base class for `Op`s with a batched LAPACK C implementation.
+
+    The C code is only used for float32 and float64 inputs, and when the
+    libraries in ``config.blas__ldflags`` provide LAPACK; `perform` is used
+    otherwise.  With OpenMP, the matrices of a batch are processed in
+    parallel once the batch holds enough work.
+
+    """
+
+    def c_lapack_check(self, node, variables=None):
+        """Raise `NotImplementedError` when the C code can't be used for `node`.
+
+        `variables` are the floating-point inputs and outputs of `node`; all
+        of them by default.
+
+        """
+        if not detect_lapack():
+            raise NotImplementedError("LAPACK is not available")
+        if variables is None:
+            variables = node.inputs + node.outputs
+        dtypes = {v.type.dtype for v in variables}
+        if len(dtypes) != 1 or dtypes.pop() not in ("float32", "float64"):
+            raise NotImplementedError("Only float32 and float64 are supported")
+
+    def c_batch_dims(self, x, ndim, fail):
+        """C code setting ``n`` and ``n_batch`` for the square matrices in `x`."""
+        return f"""
+        if (PyArray_DIMS({x})[{ndim - 1}] != PyArray_DIMS({x})[{ndim - 2}])
+        {{
+            PyErr_SetString(PyExc_ValueError, "expected square matrices");
+            {fail};
+        }}
+        if (PyArray_DIMS({x})[{ndim - 1}] > NPY_MAX_INT)
+        {{
+            PyErr_SetString(PyExc_ValueError, "matrices too large for LAPACK");
+            {fail};
+        }}
+        int n = (int)PyArray_DIMS({x})[{ndim - 1}];
+        npy_intp n_batch = 1;
+        for (int d = 0; d < {ndim - 2}; ++d)
+            n_batch *= PyArray_DIMS({x})[d];
+        """
+
+    def c_alloc(self, z, ndim, dims, typenum, fail):
+        """C code making `z` a C-contiguous array with the dimensions `dims`."""
+        return f"""
+        {{
+            int alloc = {z} == NULL || !PyArray_IS_C_CONTIGUOUS({z});
+            for (int d = 0; !alloc && d < {ndim}; ++d)
+                alloc = PyArray_DIMS({z})[d] != ({dims})[d];
+            if (alloc)
+            {{
+                Py_XDECREF({z});
+                {z} = (PyArrayObject*)PyArray_EMPTY({ndim}, {dims}, {typenum}, 0);
+                if (!{z}) {{{fail};}}
+            }}
+        }}
+        """
+
+    def c_batch_loop(self, work, cost, body, error, fail):
+        """C code running `body` once for each matrix ``i`` of the batch.
+
+        `work` lists per-thread scratch buffers as ``(ctype, name, count)``.
+        `body` sets ``info`` to a non-zero value when the matrix fails:
+        ``INT_MIN`` for non-finite values, a negative LAPACK ``info`` for an
+        invalid argument, and a positive one for the errors that `error`
+        reports, given the ``err_info`` of the first failing matrix.  `cost`
+        is the work per matrix compared against the OpenMP threshold.
+
+        """
+        decls = "\n".join(
+            f"{ctype}* {wname} = ({ctype}*)malloc(sizeof({ctype}) * "
+            f"(({count}) > 0 ? ({count}) : 1));"
+            for ctype, wname, count in work
+        )
+        have_work = " && ".join(f"{wname} != NULL" for _, wname, _ in work) or "1"
+        frees = "\n".join(f"free({wname});" for _, wname, _ in work)
+        if self.openmp:
+            minsize = int(config.openmp_elemwise_minsize)
+            omp_parallel = (
+                "#pragma omp parallel if (omp_get_max_threads() > 1 && n_batch > 1"
+                f" && n_batch * ({cost}) >= {minsize})"
+            )
+            omp_for = "#pragma omp for schedule(static)"
+            omp_critical = "#pragma omp critical (aesara_lapack)"
+        else:
+            omp_parallel = omp_for = omp_critical = ""
+
+        return f"""
+        {{
+            int err_info = 0;
+            npy_intp err_i = -1;
+            int nomem = 0;
+            {omp_parallel}
+            {{
+                {decls}
+                int have_work = {have_work};
+                if (!have_work)
+                {{
+                    {omp_critical}
+                    nomem = 1;
+                }}
+                {omp_for}
+                for (npy_intp i = 0; i < n_batch; ++i)
+                {{
+                    int info = 0;
+                    if (have_work)
+                    {{
+                        {body}
+                    }}
+                    if (info)
+                    {{
+                        {omp_critical}
+                        if (err_i < 0 || i < err_i)
+                        {{
+                            err_i = i;
+                            err_info = info;
+                        }}
+                    }}
+                }}
+                {frees}
+            }}
+            if (nomem)
+            {{
+                PyErr_NoMemory();
+                {fail};
+            }}
+            if (err_i >= 0)
+            {{
+                if (err_info == INT_MIN)
+                    PyErr_SetString(PyExc_ValueError,
+                                    "array must not contain infs or NaNs");
+                else if (err_info < 0)
+                    PyErr_Format(PyExc_RuntimeError,
+                                 "illegal value in argument %d of a LAPACK routine",
+                                 -err_info);
+                else
+                {{
+                    {error}
+                }}
+                {fail};
+            }}
+        }}
+        """
+
+    def c_solve_code(self, node, inputs, outputs, sub, work, body, error):
+        """C code solving ``A x = b`` for each matrix of `A`.
+
+        `A` and `b` are the first and last of `inputs`.  `b` holds a vector
+        per matrix of `A` when it has one dimension less, and a matrix
+        otherwise.  `body` solves for matrix ``i``: it reads the
+        row-major ``n`` x ``n`` matrix ``a`` and the ``n`` x ``k`` right-hand
+        side ``bb``, and writes ``xx``.  See `c_batch_loop` for the other
+        arguments.
+
+        """
+        A, b = inputs[0], inputs[-1]
+        (x,) = outputs
+        fail = sub["fail"]
+        ndim = node.inputs[0].type.ndim
+        vector_b = int(node.inputs[-1].type.ndim == ndim - 1)
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        typenum = node.outputs[0].type.dtype_specs()[2]
+        release_fail = f"Py_DECREF(Ac); Py_DECREF(bc); {fail};"
+        loop = self.c_batch_loop(
+            work=work,
+            cost="(double)n * n * (n + k)",
+            body=f"""
+            const {ctype}* a = (const {ctype}*)PyArray_DATA(Ac) + i * n * n;
+            const {ctype}* bb = (const {ctype}*)PyArray_DATA(bc) + i * n * k;
+            {ctype}* xx = ({ctype}*)PyArray_DATA({x}) + i * n * k;
+            {body}
+            """,
+            error=error,
+            fail=release_fail,
+        )
+        return f"""
+        {{
+            {self.c_batch_dims(A, ndim, fail)}
+            for (int d = 0; d < {ndim - 2}; ++d)
+            {{
+                if (PyArray_DIMS({b})[d] != PyArray_DIMS({A})[d])
+                {{
+                    PyErr_SetString(PyExc_ValueError,
+                                    "the batch dimensions of `A` and `b` must match");
+                    {fail};
+                }}
+            }}
+            if (PyArray_DIMS({b})[{ndim - 2}] != n)
+            {{
+                PyErr_SetString(PyExc_ValueError, "incompatible dimensions of `A` and `b`");
+                {fail};
+            }}
+            if (!{vector_b} && PyArray_DIMS({b})[{ndim - 1}] > NPY_MAX_INT)
+            {{
+                PyErr_SetString(PyExc_ValueError, "matrices too large for LAPACK");
+                {fail};
+            }}
+            int k = {vector_b} ? 1 : (int)PyArray_DIMS({b})[{ndim - 1}];
+            {self.c_alloc(x, ndim - vector_b, f"PyArray_DIMS({b})", typenum, fail)}
+            PyArrayObject* Ac = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*){A}, {typenum}, 0, 0, NPY_ARRAY_CARRAY_RO);
+            PyArrayObject* bc = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*){b}, {typenum}, 0, 0, NPY_ARRAY_CARRAY_RO);
+            if (!Ac || !bc)
+            {{
+                Py_XDECREF(Ac);
+                Py_XDECREF(bc);
+                {fail};
+            }}
+            {loop}
+            Py_DECREF(Ac);
+            Py_DECREF(bc);
+        }}
+        """
+
+    def c_support_code(self, **kwargs):
+        return lapack_header_text() + _lapack_support_code
+
+    def c_headers(self, **kwargs):
+        return super().c_headers(**kwargs) + ["<limits.h>", "<math.h>", "<string.h>"]
+
+    def c_libraries(self, **kwargs):
+        return ldflags()
+
+    def c_compile_args(self, **kwargs):
+        return super().c_compile_args(**kwargs) + ldflags(libs=False, flags=True)
+
+    def c_lib_dirs(self, **kwargs):
+        return ldflags(libs=False, libs_dir=True)
+
+    def c_header_dirs(self, **kwargs):
+        return ldflags(libs=False, include_dir=True)
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
@@ -0,0 +1,159 @@
+"""Rewrites for the `Op`\\s of `aesara.tensor.nlinalg` and `aesara.tensor.slinalg`.
+
+Products with a matrix inverse become solves, and the factorizations behind
+the solves, inverses and determinants of one matrix are shared: the
+consumers of a matrix are rewritten to use the same `Cholesky` or `LUFactor`
+node, which the merge optimizer then deduplicates.  Factorizations of
+matrices that only depend on shared variables are wrapped in
+`CachedFactorization`, so that they are skipped while those values don't
+change.
+
+The shared and cached factorizations introduce `Op`\\s without JAX or Numba
+implementations, hence the ``cxx_only`` tag on their rewrites.
+
+"""
+
+from aesara.compile.sharedvalue import SharedVariable
+from aesara.graph.basic import Constant, graph_inputs
+from aesara.graph.opt import local_optimizer
+from aesara.tensor import basic as at
+from aesara.tensor import math as atm
+from aesara.tensor.basic_opt import register_specialize, register_stabilize
+from aesara.tensor.blas import Dot22
+from aesara.tensor.extra_ops import broadcast_to
+from aesara.tensor.math import Dot
+from aesara.tensor.nlinalg import Det, MatrixInverse
+from aesara.tensor.slinalg import (
+    CachedFactorization,
+    Cholesky,
+    LUFactor,
+    Solve,
+    cho_solve,
+    lu_factor,
+    lu_solve,
+    solve,
+)
+
+
+@register_stabilize
+@local_optimizer([Dot, Dot22])
+def inv_as_solve(fgraph, node):
+    """Replace the product of a matrix inverse and a matrix with a `Solve`.
+
+    This utilizes a boolean `symmetric` tag on the matrices.
+    """
+    if isinstance(node.op, (Dot, Dot22)):
+        l, r = node.inputs
+        if l.owner and isinstance(l.owner.op, MatrixInverse):
+            return [solve(l.owner.inputs[0], r)]
+        if r.owner and isinstance(r.owner.op, MatrixInverse):
+            x = r.owner.inputs[0]
+            if getattr(x.tag, "symmetric", None) is True:
+                return [solve(x, l.T).T]
+            else:
+                return [solve(x.T, l.T).T]
+
+
+def _factor_op(op):
+    """Return the factorization `Op` wrapped by a `CachedFactorization`, if any."""
+    if isinstance(op, CachedFactorization):
+        return op.op
+    return op
+
+
+def _is_cacheable(A):
+    """Tell whether `A` only depends on shared variables and constants."""
+    inputs = list(graph_inputs([A]))
+    return all(isinstance(v, (SharedVariable, Constant)) for v in inputs) and any(
+        isinstance(v, SharedVariable) for v in inputs
+    )
+
+
+def _uses_cholesky(node, lower):
+    op = _factor_op(node.op)
+    if isinstance(op, Cholesky):
+        return op.lower == lower and op.on_error == "raise"
+    return isinstance(op, Solve) and op.assume_a == "pos" and op.lower == lower
+
+
+def _uses_lu(node):
+    op = _factor_op(node.op)
+    if isinstance(op, Solve):
+        return op.assume_a == "gen"
+    return isinstance(op, (LUFactor, MatrixInverse, Det))
+
+
+def _share_factorization(fgraph, A, uses_factorization):
+    """Tell whether the factorization of `A` is worth computing on its own.
+
+    That's the case when several consumers of `A` factor it, or when the
+    factorization can be cached.
+    """
+    n_uses = sum(
+        1
+        for client, i in fgraph.clients[A]
+        if client != "output" and i == 0 and uses_factorization(client)
+    )
+    return n_uses > 1 or _is_cacheable(A)
+
+
+@register_specialize("cxx_only")
+@local_optimizer([Solve])
+def local_solve_share_cholesky(fgraph, node):
+    """Solve positive definite systems with the Cholesky factor of their matrix.
+
+    The factor is shared with the other solves of the same matrix, and the
+    `Cholesky` nodes that already compute it.
+    """
+    if not isinstance(node.op, Solve) or node.op.assume_a != "pos":
+        return
+    A, b = node.inputs
+    lower = node.op.lower
+    if not _share_factorization(fgraph, A, lambda n: _uses_cholesky(n, lower)):
+        return
+    x = cho_solve((Cholesky(lower=lower)(A), lower), b, node.op.check_finite)
+    if x.type != node.outputs[0].type:
+        return
+    return [x]
+
+
+@register_specialize("cxx_only")
+@local_optimizer([Solve, MatrixInverse, Det])
+def local_share_lu_factor(fgraph, node):
+    """Compute general solves, inverses and determinants from one `LUFactor`."""
+    if isinstance(node.op, Solve) and node.op.assume_a != "gen":
+        return
+    if not isinstance(node.op, (Solve, MatrixInverse, Det)):
+        return
+    A = node.inputs[0]
+    if A.dtype not in ("float32", "float64"):
+        return
+    if not _share_factorization(fgraph, A, _uses_lu):
+        return
+
+    # `LUSolve` checks the factors, so that all the consumers share one
+    # `LUFactor`; NumPy doesn't check the inputs of inverses and determinants
+    lu, piv = lu_factor(A, check_finite=False)
+    if isinstance(node.op, Solve):
+        out = lu_solve((lu, piv), node.inputs[1], check_finite=node.op.check_finite)
+    elif isinstance(node.op, MatrixInverse):
+        eye = at.eye(A.shape[-1], dtype=A.dtype)
+        if A.ndim > 2:
+            eye = broadcast_to(eye, A.shape)
+        out = lu_solve((lu, piv), eye, check_finite=False)
+    else:
+        # Each row interchange flips the sign of the determinant
+        n_swaps = atm.neq(piv, at.arange(A.shape[-1], dtype=piv.dtype)).sum(axis=-1)
+        det = atm.prod(at.diagonal(lu, axis1=A.ndim - 2, axis2=A.ndim - 1), axis=-1)
+        out = at.switch(atm.eq(n_swaps % 2, 1), -det, det)
+    if out.type != node.outputs[0].type:
+        return
+    return [out]
+
+
+@register_specialize("cxx_only")
+@local_optimizer([Cholesky, LUFactor])
+def local_cache_factorization(fgraph, node):
+    """Cache the factorizations of matrices that only depend on shared variables."""
+    if isinstance(node.op, (Cholesky, LUFactor)) and _is_cacheable(node.inputs[0]):
+        return CachedFactorization(node.op)(*node.inputs, return_list=True)
@@ -5,13 +5,15 @@ from typing import Tuple, Union
 import numpy as np
 
 from aesara import scalar as aes
-from aesara.gradient import DisconnectedType
+from aesara.gradient import DisconnectedType, grad_not_implemented
 from aesara.graph.basic import Apply
 from aesara.graph.op import Op
 from aesara.tensor import basic as at
 from aesara.tensor import math as tm
 from aesara.tensor.basic import as_tensor_variable, extract_diag
-from aesara.tensor.type import dvector, lscalar, matrix, scalar, vector
+from aesara.tensor.lapack import LapackOp
+from aesara.tensor.shape import shape_padaxis, shape_padright
+from aesara.tensor.type import dvector, lscalar, matrix, tensor, vector
 
 
 logger = logging.getLogger(__name__)
@@ -101,12 +103,48 @@ class Inv(Op):
 inv = Inv()
 
 
-class MatrixInverse(Op):
+def _batched_matrix(x):
+    x = as_tensor_variable(x)
+    if x.ndim < 2:
+        raise ValueError(
+            f"The input must be a matrix or a batch of matrices; got {x.type} instead."
+        )
+    return x
+
+
+def _T(x):
+    """Transpose the matrices in the last two dimensions of `x`."""
+    return x.T if x.ndim == 2 else at.swapaxes(x, -1, -2)
+
+
+def _matmul(a, b):
+    """Multiply the matrices in the last two dimensions of `a` and `b`."""
+    if a.ndim <= 2 and b.ndim <= 2:
+        return tm.dot(a, b)
+    return tm.sum(shape_padright(a) * shape_padaxis(b, -3), axis=-2)
+
+
+def _outer(a, b):
+    """Outer products of the vectors in the last dimension of `a` and `b`."""
+    if a.ndim == 1:
+        return tm.outer(a, b)
+    return shape_padright(a) * shape_padaxis(b, -2)
+
+
+def _diag_part(x):
+    """Zero all but the diagonals of the matrices in `x`."""
+    if x.ndim == 2:
+        return at.diag(at.diagonal(x))
+    return x * at.eye(x.shape[-1], dtype=x.dtype)
+
+
+class MatrixInverse(LapackOp):
     r"""Computes the inverse of a matrix :math:`A`.
 
     Given a square matrix :math:`A`, ``matrix_inverse`` returns a square
     matrix :math:`A_{inv}` such that the dot product :math:`A \cdot A_{inv}`
     and :math:`A_{inv} \cdot A` equals the identity matrix :math:`I`.
+    Leading dimensions of :math:`A` index a batch of matrices.
 
     Notes
     -----
@@ -117,12 +155,11 @@ class MatrixInverse(Op):
 
     __props__ = ()
 
-    def __init__(self):
-        pass
+    def __init__(self, openmp=None):
+        super().__init__(openmp=openmp)
 
     def make_node(self, x):
-        x = as_tensor_variable(x)
-        assert x.ndim == 2
+        x = _batched_matrix(x)
         return Apply(self, [x], [x.type()])
 
     def perform(self, node, inputs, outputs):
@@ -130,6 +167,51 @@ class MatrixInverse(Op):
         (z,) = outputs
         z[0] = np.linalg.inv(x).astype(x.dtype)
 
+    def c_code(self, node, name, inputs, outputs, sub):
+        self.c_lapack_check(node)
+        (x,) = inputs
+        (z,) = outputs
+        fail = sub["fail"]
+        ndim = node.inputs[0].type.ndim
+        ctype = node.inputs[0].type.dtype_specs()[1]
+        typenum = node.outputs[0].type.dtype_specs()[2]
+        # Like NumPy, solve against the identity.  The column-major inverse
+        # of the transpose LAPACK sees is the row-major inverse.
+        loop = self.c_batch_loop(
+            work=[("int", "ipiv", "n"), (ctype, "aw", "(npy_intp)n * n")],
+            cost="(double)n * n * n",
+            body=f"""
+            const {ctype}* a = (const {ctype}*)PyArray_DATA(xc) + i * n * n;
+            {ctype}* inv = ({ctype}*)PyArray_DATA({z}) + i * n * n;
+            memcpy(aw, a, sizeof({ctype}) * n * n);
+            memset(inv, 0, sizeof({ctype}) * n * n);
+            for (int j = 0; j < n; ++j)
+                inv[(npy_intp)j * n + j] = 1;
+            if (n > 0)
+            {{
+                aesara_getrf(n, aw, ipiv, &info);
+                if (info == 0)
+                    aesara_getrs('N', n, n, aw, ipiv, inv, &info);
+            }}
+            """,
+            error='aesara_linalg_error("Singular matrix", 0);',
+            fail=f"Py_DECREF(xc); {fail};",
+        )
+        return f"""
+        {{
+            {self.c_batch_dims(x, ndim, fail)}
+            {self.c_alloc(z, ndim, f"PyArray_DIMS({x})", typenum, fail)}
+            PyArrayObject* xc = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*){x}, {typenum}, 0, 0, NPY_ARRAY_CARRAY_RO);
+            if (!xc) {{{fail};}}
+            {loop}
+            Py_DECREF(xc);
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (1,) + super().c_code_cache_version()
+
     def grad(self, inputs, g_outputs):
         r"""The gradient function should return
 
@@ -146,6 +228,8 @@ class MatrixInverse(Op):
         (x,) = inputs
         xi = self(x)
         (gz,) = g_outputs
+        if x.ndim > 2:
+            return [-_batched_matmul(_T(xi), gz, _T(xi))]
         # tm.dot(gz.T,xi)
         return [-matrix_dot(xi, gz.T, xi).T]
 
@@ -167,6 +251,8 @@ class MatrixInverse(Op):
         (ev,) = eval_points
         if ev is None:
             return [None]
+        if x.ndim > 2:
+            return [-_batched_matmul(xi, ev, xi)]
         return [-matrix_dot(xi, ev, xi)]
 
     def infer_shape(self, fgraph, node, shapes):
@@ -190,6 +276,14 @@ def matrix_dot(*args):
     return rval
 
 
+def _batched_matmul(*args):
+    """`matrix_dot` for the matrices in the last two dimensions of `args`."""
+    rval = args[0]
+    for a in args[1:]:
+        rval = _matmul(rval, a)
+    return rval
+
+
 def trace(X):
     """
     Returns the sum of diagonal elements of matrix X.
@@ -197,18 +291,20 @@ def trace(X):
     return extract_diag(X).sum()
 
 
-class Det(Op):
+class Det(LapackOp):
     """
-    Matrix determinant. Input should be a square matrix.
+    Matrix determinant. Input should be a square matrix, or a batch of them.
 
     """
 
     __props__ = ()
 
+    def __init__(self, openmp=None):
+        super().__init__(openmp=openmp)
+
     def make_node(self, x):
-        x = as_tensor_variable(x)
-        assert x.ndim == 2
-        o = scalar(dtype=x.dtype)
+        x = _batched_matrix(x)
+        o = tensor(dtype=x.dtype, shape=x.broadcastable[:-2])
         return Apply(self, [x], [o])
 
     def perform(self, node, inputs, outputs):
@@ -220,13 +316,65 @@ class Det(Op):
             print("Failed to compute determinant", x)
             raise
 
+    def c_code(self, node, name, inputs, outputs, sub):
+        self.c_lapack_check(node)
+        (x,) = inputs
+        (z,) = outputs
+        fail = sub["fail"]
+        ndim = node.inputs[0].type.ndim
+        ctype = node.inputs[0].type.dtype_specs()[1]
+        typenum = node.outputs[0].type.dtype_specs()[2]
+        # A singular matrix is reported through `info` and has a zero
+        # determinant, as in NumPy
+        loop = self.c_batch_loop(
+            work=[("int", "ipiv", "n"), (ctype, "aw", "(npy_intp)n * n")],
+            cost="(double)n * n * n",
+            body=f"""
+            const {ctype}* a = (const {ctype}*)PyArray_DATA(xc) + i * n * n;
+            {ctype} det = 1;
+            memcpy(aw, a, sizeof({ctype}) * n * n);
+            if (n > 0)
+                aesara_getrf(n, aw, ipiv, &info);
+            if (info > 0)
+            {{
+                det = 0;
+                info = 0;
+            }}
+            else
+            {{
+                for (int j = 0; j < n; ++j)
+                    det *= ipiv[j] != j + 1 ? -aw[(npy_intp)j * n + j]
+                                            : aw[(npy_intp)j * n + j];
+            }}
+            (({ctype}*)PyArray_DATA({z}))[i] = det;
+            """,
+            error="",
+            fail=f"Py_DECREF(xc); {fail};",
+        )
+        return f"""
+        {{
+            {self.c_batch_dims(x, ndim, fail)}
+            {self.c_alloc(z, ndim - 2, f"PyArray_DIMS({x})", typenum, fail)}
+            PyArrayObject* xc = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*){x}, {typenum}, 0, 0, NPY_ARRAY_CARRAY_RO);
+            if (!xc) {{{fail};}}
+            {loop}
+            Py_DECREF(xc);
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (1,) + super().c_code_cache_version()
+
     def grad(self, inputs, g_outputs):
         (gz,) = g_outputs
         (x,) = inputs
+        if x.ndim > 2:
+            return [shape_padright(gz * self(x), 2) * _T(matrix_inverse(x))]
         return [gz * self(x) * matrix_inverse(x).T]
 
     def infer_shape(self, fgraph, node, shapes):
-        return [()]
+        return [tuple(shapes[0][:-2])]
 
     def __str__(self):
         return "Det"
@@ -245,10 +393,9 @@ class Eig(Op):
     __props__: Union[Tuple, Tuple[str]] = ()
 
     def make_node(self, x):
-        x = as_tensor_variable(x)
-        assert x.ndim == 2
-        w = vector(dtype=x.dtype)
-        v = matrix(dtype=x.dtype)
+        x = _batched_matrix(x)
+        w = tensor(dtype=x.dtype, shape=(False,) * (x.ndim - 1))
+        v = tensor(dtype=x.dtype, shape=(False,) * x.ndim)
         return Apply(self, [x], [w, v])
 
     def perform(self, node, inputs, outputs):
@@ -257,8 +404,8 @@ class Eig(Op):
         w[0], v[0] = [z.astype(x.dtype) for z in self._numop(x)]
 
     def infer_shape(self, fgraph, node, shapes):
-        n = shapes[0][0]
-        return [(n,), (n, n)]
+        *batch, n = shapes[0][:-1]
+        return [(*batch, n), (*batch, n, n)]
 
 
 eig = Eig()
@@ -278,16 +425,15 @@ class Eigh(Eig):
         self.UPLO = UPLO
 
     def make_node(self, x):
-        x = as_tensor_variable(x)
-        assert x.ndim == 2
+        x = _batched_matrix(x)
         # Numpy's linalg.eigh may return either double or single
         # presision eigenvalues depending on installed version of
         # LAPACK.  Rather than trying to reproduce the (rather
         # involved) logic, we just probe linalg.eigh with a trivial
         # input.
         w_dtype = self._numop([[np.dtype(x.dtype).type()]])[0].dtype.name
-        w = vector(dtype=w_dtype)
-        v = matrix(dtype=w_dtype)
+        w = tensor(dtype=w_dtype, shape=(False,) * (x.ndim - 1))
+        v = tensor(dtype=w_dtype, shape=(False,) * x.ndim)
         return Apply(self, [x], [w, v])
 
     def perform(self, node, inputs, outputs):
@@ -319,6 +465,8 @@ class Eigh(Eig):
 
         """
         (x,) = inputs
+        if x.ndim > 2:
+            return [grad_not_implemented(self, 0, x, "batched inputs")]
         w, v = self(x)
         # Replace gradients wrt disconnected variables with
         # zeros. This is a work-around for issue #1063.
@@ -525,24 +673,22 @@ class SVD(Op):
         self.compute_uv = compute_uv
 
     def make_node(self, x):
-        x = as_tensor_variable(x)
-        assert x.ndim == 2, "The input of svd function should be a matrix."
+        x = _batched_matrix(x)
 
         in_dtype = x.type.numpy_dtype
         out_dtype = np.dtype(f"f{in_dtype.itemsize}")
 
-        s = vector(dtype=out_dtype)
+        s = tensor(dtype=out_dtype, shape=(False,) * (x.ndim - 1))
 
         if self.compute_uv:
-            u = matrix(dtype=out_dtype)
-            vt = matrix(dtype=out_dtype)
+            u = tensor(dtype=out_dtype, shape=(False,) * x.ndim)
+            vt = tensor(dtype=out_dtype, shape=(False,) * x.ndim)
             return Apply(self, [x], [u, s, vt])
         else:
             return Apply(self, [x], [s])
 
     def perform(self, node, inputs, outputs):
         (x,) = inputs
-        assert x.ndim == 2, "The input of svd function should be a matrix."
         if self.compute_uv:
             u, s, vt = outputs
             u[0], s[0], vt[0] = self._numop(x, self.full_matrices, self.compute_uv)
@@ -552,12 +698,12 @@ class SVD(Op):
 
     def infer_shape(self, fgraph, node, shapes):
         (x_shape,) = shapes
-        M, N = x_shape
+        *batch, M, N = x_shape
         K = tm.minimum(M, N)
-        s_shape = (K,)
+        s_shape = (*batch, K)
         if self.compute_uv:
-            u_shape = (M, M) if self.full_matrices else (M, K)
-            vt_shape = (N, N) if self.full_matrices else (K, N)
+            u_shape = (*batch, M, M) if self.full_matrices else (*batch, M, K)
+            vt_shape = (*batch, N, N) if self.full_matrices else (*batch, K, N)
             return [u_shape, s_shape, vt_shape]
         else:
             return [s_shape]
@@ -0,0 +1,241 @@
+"""
+2D convolutions computed with FFTs.
+
+The cost of a direct convolution grows with the number of kernel elements,
+while the cost of an FFT convolution only grows logarithmically with it, so
+the latter wins for large kernels.  Long inputs are split into blocks that
+are convolved separately and summed back where they overlap (overlap-add),
+which keeps the transforms short when the kernel is much smaller than the
+input.
+
+"""
+
+import math
+
+import numpy as np
+import scipy.fft
+
+from aesara.graph.basic import Apply
+from aesara.graph.op import Op
+from aesara.tensor.basic import as_tensor_variable
+from aesara.tensor.nnet.abstract_conv import (
+    AbstractConv2d,
+    get_conv_output_shape,
+)
+from aesara.tensor.type import TensorType
+
+
+__docformat__ = "restructuredtext en"
+
+
+def _fft_len(n):
+    return scipy.fft.next_fast_len(n, real=True)
+
+
+def fft_conv_block(n, k):
+    """Return the block and FFT lengths used to convolve `n` samples with `k`.
+
+    The input is split into blocks of the returned block length, which are
+    padded to the FFT length.  The lengths minimize a rough estimate of the
+    cost of the transforms; a single block is used when the kernel is about
+    as long as the input.
+
+    """
+    n, k = int(n), int(k)
+    fft_len = _fft_len(n + k - 1)
+    best = (n, fft_len)
+    best_cost = fft_len * math.log2(fft_len + 1)
+    # Shorter blocks cost more to split and sum than they save
+    length = max(64, 1 << max(4 * k - 4, 1).bit_length())
+    while length < fft_len:
+        block = length - k + 1
+        cost = -(-n // block) * length * math.log2(length + 1)
+        if cost < best_cost:
+            best, best_cost = (block, length), cost
+        length *= 2
+    return best
+
+
+def fft_conv_cost(imshp, kshp, border_mode="valid"):
+    """Return the estimated costs of a direct and an FFT convolution.
+
+    `imshp` and `kshp` are the 4D shapes of the input and the filters, with
+    ``None`` for the unknown batch size and numbers of channels.  The costs
+    are rough operation counts, in comparable units.
+
+    """
+    b, c = (1 if s is None else s for s in imshp[:2])
+    f = 1 if kshp[0] is None else kshp[0]
+    pads = _pads(border_mode, kshp[2:])
+    in_len = [s + 2 * p for s, p in zip(imshp[2:], pads)]
+    out_len = [n - k + 1 for n, k in zip(in_len, kshp[2:])]
+    direct = b * c * f * np.prod(out_len) * np.prod(kshp[2:])
+
+    blocks = [fft_conv_block(n, k) for n, k in zip(in_len, kshp[2:])]
+    n_blocks = np.prod([-(-n // block) for n, (block, _) in zip(in_len, blocks)])
+    size = np.prod([length for _, length in blocks])
+    transform = size * math.log2(size + 1)
+    # The transforms of the blocks of each input and output channel, of each
+    # filter, and the products summed over the input channels
+    fft = (b * c + b * f) * n_blocks * transform + f * c * transform
+    fft += 4 * b * c * f * n_blocks * size
+    return direct, fft
+
+
+def _pads(border_mode, kshp):
+    if border_mode == "valid":
+        return (0, 0)
+    if border_mode == "full":
+        return tuple(k - 1 for k in kshp)
+    if border_mode == "half":
+        return tuple(k // 2 for k in kshp)
+    return tuple(border_mode)
+
+
+def _overlap_add(y, block):
+    """Sum the blocks of `y`, along its last two axes, at `block` samples apart."""
+    n_blocks, length = y.shape[-2:]
+    n_shifts = -(-length // block)
+    out = np.zeros(y.shape[:-2] + (n_blocks + n_shifts - 1, block), dtype=y.dtype)
+    for s in range(n_shifts):
+        segment = y[..., s * block : (s + 1) * block]
+        out[..., s : s + n_blocks, : segment.shape[-1]] += segment
+    return out.reshape(y.shape[:-2] + (-1,))[..., : (n_blocks - 1) * block + length]
+
+
+class FFTConv2d(Op):
+    """
+    2D convolution of a batch of multi-channel images with a set of filters,
+    computed with FFTs.
+
+    The inputs and the output follow `AbstractConv2d`: images of shape
+    (batch size, input channels, rows, columns), filters of shape
+    (output channels, input channels, rows, columns) and outputs of shape
+    (batch size, output channels, rows, columns).  Only unit strides and
+    dilations are supported.
+
+    Parameters
+    ----------
+    border_mode
+        ``'valid'``, ``'full'``, ``'half'`` or a pair of non-negative
+        integers: the zero padding of the rows and columns of the images.
+    filter_flip
+        Flip the filters, which computes a convolution instead of a
+        cross-correlation.
+
+    """
+
+    __props__ = ("border_mode", "filter_flip")
+
+    def __init__(self, border_mode="valid", filter_flip=True):
+        if isinstance(border_mode, int):
+            border_mode = (border_mode, border_mode)
+        if isinstance(border_mode, tuple):
+            if len(border_mode) != 2 or not all(
+                isinstance(p, (int, np.integer)) and p >= 0 for p in border_mode
+            ):
+                raise ValueError(
+                    f"invalid border_mode {border_mode}, which must be a pair "
+                    "of non-negative integers"
+                )
+            border_mode = tuple(int(p) for p in border_mode)
+        elif border_mode not in ("valid", "full", "half"):
+            raise ValueError(
+                f"invalid border_mode {border_mode}, which must be 'valid', "
+                "'full', 'half' or a pair of integers"
+            )
+        self.border_mode = border_mode
+        self.filter_flip = filter_flip
+
+    def make_node(self, img, kern):
+        img = as_tensor_variable(img)
+        kern = as_tensor_variable(kern)
+        if img.ndim != 4 or kern.ndim != 4:
+            raise TypeError("FFTConv2d requires 4D images and filters")
+        if img.dtype != kern.dtype:
+            raise TypeError("The images and the filters must have the same dtype")
+        if img.dtype not in ("float32", "float64"):
+            raise TypeError("FFTConv2d only supports float32 and float64")
+        out = TensorType(
+            img.dtype, shape=(img.broadcastable[0], kern.broadcastable[0], False, False)
+        )()
+        return Apply(self, [img, kern], [out])
+
+    def perform(self, node, inputs, output_storage):
+        img, kern = inputs
+        if img.shape[1] != kern.shape[1]:
+            raise ValueError(
+                "the images and the filters must have the same number of channels"
+            )
+        pads = _pads(self.border_mode, kern.shape[2:])
+        if any(pads):
+            img = np.pad(img, ((0, 0), (0, 0)) + tuple((p, p) for p in pads))
+        in_len = img.shape[2:]
+        k_len = kern.shape[2:]
+        if any(n < k for n, k in zip(in_len, k_len)):
+            raise ValueError("the filters must not be larger than the padded images")
+        if not self.filter_flip:
+            kern = kern[:, :, ::-1, ::-1]
+        b, c = img.shape[:2]
+        f = kern.shape[0]
+
+        # Split the rows and the columns into blocks, and transform each
+        # block of each image
+        blocks = [fft_conv_block(n, k) for n, k in zip(in_len, k_len)]
+        (block_r, len_r), (block_c, len_c) = blocks
+        n_r, n_c = (-(-n // block) for n, (block, _) in zip(in_len, blocks))
+        img = np.pad(
+            img,
+            (
+                (0, 0),
+                (0, 0),
+                (0, n_r * block_r - in_len[0]),
+                (0, n_c * block_c - in_len[1]),
+            ),
+        )
+        img = img.reshape(b, c, n_r, block_r, n_c, block_c).transpose(0, 2, 4, 1, 3, 5)
+        img_f = scipy.fft.rfft2(img, (len_r, len_c))
+        kern_f = scipy.fft.rfft2(kern, (len_r, len_c))
+
+        # Sum the products over the input channels, with one matrix product
+        # per frequency when there are enough channels
+        freqs = img_f.shape[-2:]
+        if c >= 8:
+            img_f = img_f.reshape(b * n_r * n_c, c, -1).transpose(2, 0, 1)
+            kern_f = kern_f.reshape(f, c, -1).transpose(2, 1, 0)
+            out_f = np.matmul(img_f, kern_f).transpose(1, 2, 0)
+            out_f = out_f.reshape((b, n_r, n_c, f) + freqs)
+        else:
+            out_f = img_f[:, :, :, 0, None] * kern_f[:, 0]
+            for i in range(1, c):
+                out_f += img_f[:, :, :, i, None] * kern_f[:, i]
+        out = scipy.fft.irfft2(out_f, (len_r, len_c))
+
+        # Overlap-add the blocks along the columns, then the rows, and keep
+        # the samples where the filters fully overlap the images
+        out = _overlap_add(out.transpose(0, 3, 1, 4, 2, 5), block_c)
+        out = _overlap_add(out.transpose(0, 1, 4, 2, 3), block_r)
+        out = out[:, :, k_len[1] - 1 : in_len[1], k_len[0] - 1 : in_len[0]]
+        output_storage[0][0] = np.ascontiguousarray(
+            out.transpose(0, 1, 3, 2), dtype=node.outputs[0].dtype
+        )
+
+    def infer_shape(self, fgraph, node, shapes):
+        return [get_conv_output_shape(shapes[0], shapes[1], self.border_mode, (1, 1))]
+
+    def grad(self, inputs, output_grads):
+        return AbstractConv2d(
+            border_mode=self.border_mode, filter_flip=self.filter_flip
+        ).grad(inputs, output_grads)
+
+
+def fft_conv2d(input, filters, border_mode="valid", filter_flip=True):
+    """
+    2D convolution of `input` with `filters`, computed with FFTs.
+
+    See `FFTConv2d` for the parameters.  The convolution optimizer already
+    selects this implementation for the convolutions with large kernels
+    when their shapes are known, so calling it directly is rarely needed.
+
+    """
+    return FFTConv2d(border_mode=border_mode, filter_flip=filter_flip)(input, filters)
@@ -34,6 +34,7 @@ from aesara.tensor.nnet.blocksparse import (
 from aesara.tensor.nnet.conv import ConvOp, conv2d
 from aesara.tensor.nnet.corr import CorrMM, CorrMM_gradInputs, CorrMM_gradWeights
 from aesara.tensor.nnet.corr3d import Corr3dMM, Corr3dMMGradInputs, Corr3dMMGradWeights
+from aesara.tensor.nnet.fftconv import FFTConv2d, fft_conv_cost
 from aesara.tensor.type import TensorType
 
 
@@ -490,11 +491,112 @@ def local_conv2d_gradinputs_cpu(fgraph, node):
     return [din]
 
 
+def _static_shape(var, op_shape):
+    """Return the shape of `var`, completed with the shape given to its `Op`."""
+    shape = list(var.type.shape)
+    if op_shape is not None:
+        shape = [s if s is not None else o for s, o in zip(shape, op_shape)]
+    return shape
+
+
+def _use_fft_conv(imshp, kshp, border_mode):
+    """Tell whether the FFT convolution is expected to be faster.
+
+    The spatial shapes must be known; the costs compared by `fft_conv_cost`
+    are rough, so the FFT is only picked when it wins by a clear margin.
+
+    """
+    if None in imshp[2:] or None in kshp[2:]:
+        return False
+    direct, fft = fft_conv_cost(imshp, kshp, border_mode)
+    return direct > 5 * fft
+
+
+@local_optimizer([AbstractConv2d])
+def local_abstractconv_fft(fgraph, node):
+    if not isinstance(node.op, AbstractConv2d):
+        return None
+    img, kern = node.inputs
+    if not isinstance(img.type, TensorType) or not isinstance(kern.type, TensorType):
+        return None
+    if img.dtype not in ("float32", "float64") or img.dtype != kern.dtype:
+        return None
+    if node.op.subsample != (1, 1) or node.op.filter_dilation != (1, 1):
+        return None
+    if node.op.num_groups > 1 or node.op.unshared:
+        return None
+    border_mode = node.op.border_mode
+    if isinstance(border_mode, tuple) and not all(
+        isinstance(p, int) for p in border_mode
+    ):
+        # Asymmetric padding
+        return None
+    if not _use_fft_conv(
+        _static_shape(img, node.op.imshp),
+        _static_shape(kern, node.op.kshp),
+        border_mode,
+    ):
+        return None
+
+    rval = FFTConv2d(border_mode=border_mode, filter_flip=node.op.filter_flip)(
+        img, kern
+    )
+    rval = aesara.tensor.patternbroadcast(rval, node.outputs[0].broadcastable)
+    copy_stack_trace(node.outputs[0], rval)
+    return [rval]
+
+
+@local_optimizer([ConvOp])
+def local_conv2d_fft(fgraph, node):
+    """Compute the `ConvOp`\\s with large kernels with FFTs.
+
+    This covers `aesara.tensor.signal.conv.conv2d`, which builds `ConvOp`\\s
+    directly.
+
+    """
+    if not isinstance(node.op, ConvOp):
+        return None
+    op = node.op
+    img, kern = node.inputs
+    if img.dtype not in ("float32", "float64"):
+        return None
+    if (op.dx, op.dy) != (1, 1) or op.out_mode not in ("valid", "full"):
+        return None
+    if op.imshp_logical != op.imshp or op.kshp_logical != op.kshp:
+        return None
+    imshp = _static_shape(img, (op.bsize,) + tuple(op.imshp or (None,) * 3))
+    kshp = _static_shape(kern, (op.nkern, None) + tuple(op.kshp or (None,) * 2))
+    if not _use_fft_conv(imshp, kshp, op.out_mode):
+        return None
+
+    rval = FFTConv2d(border_mode=op.out_mode)(img, kern)
+    rval = aesara.tensor.patternbroadcast(rval, node.outputs[0].broadcastable)
+    copy_stack_trace(node.outputs[0], rval)
+    return [rval]
+
+
 # Register Cpu Optimization
 conv_groupopt = aesara.graph.optdb.LocalGroupDB()
 conv_groupopt.__name__ = "conv_opts"
 register_specialize_device(conv_groupopt, "fast_compile", "fast_run")
 
+# FFT-based convolution, for the large kernels
+# It can be disabled by excluding 'conv_fft'.
+conv_groupopt.register(
+    "local_abstractconv_fft",
+    local_abstractconv_fft,
+    "conv_fft",
+    "fast_run",
+    position=20,
+)
+conv_groupopt.register(
+    "local_conv2d_fft",
+    local_conv2d_fft,
+    "conv_fft",
+    "fast_run",
+    position=20,
+)
+
 # GEMM-based convolution
 # It can be disabled by excluding 'conv_gemm'.
 conv_groupopt.register(
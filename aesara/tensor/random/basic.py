@@ -6,6 +6,7 @@ import scipy.stats as stats
 
 import aesara
 from aesara.tensor.basic import as_tensor_variable
+from aesara.tensor.random import philox
 from aesara.tensor.random.op import RandomVariable, default_supp_shape_from_params
 from aesara.tensor.random.type import RandomGeneratorType, RandomStateType
 from aesara.tensor.random.utils import broadcast_params
@@ -71,6 +72,12 @@ class UniformRV(RandomVariable):
     def __call__(self, low=0.0, high=1.0, size=None, **kwargs):
         return super().__call__(low, high, size=size, **kwargs)
 
+    def philox_rng_fn(self, stream, low, high):
+        return low + (high - low) * stream.uniform()
+
+    def c_philox_code(self, node, stream, low, high):
+        return f"{low} + ({high} - {low}) * aesara_philox_uniform({stream})", []
+
 
 uniform = UniformRV()
 
@@ -93,6 +100,21 @@ class BetaRV(RandomVariable):
     dtype = "floatX"
     _print_name = ("Beta", "\\operatorname{Beta}")
 
+    def philox_rng_fn(self, stream, a, b):
+        if np.any(a <= 0):
+            raise ValueError("a <= 0")
+        if np.any(b <= 0):
+            raise ValueError("b <= 0")
+        log_x = philox.log_standard_gamma(stream, a)
+        log_y = philox.log_standard_gamma(stream.substream(1), b)
+        return 1.0 / (1.0 + np.exp(log_y - log_x))
+
+    def c_philox_code(self, node, stream, a, b):
+        return f"aesara_philox_beta({stream}, {a}, {b})", [
+            (f"{a} <= 0", "a <= 0"),
+            (f"{b} <= 0", "b <= 0"),
+        ]
+
 
 beta = BetaRV()
 
@@ -107,6 +129,16 @@ class NormalRV(RandomVariable):
     def __call__(self, loc=0.0, scale=1.0, size=None, **kwargs):
         return super().__call__(loc, scale, size=size, **kwargs)
 
+    def philox_rng_fn(self, stream, loc, scale):
+        if np.any(scale < 0):
+            raise ValueError("scale < 0")
+        return loc + scale * stream.normal()
+
+    def c_philox_code(self, node, stream, loc, scale):
+        return f"{loc} + {scale} * aesara_philox_normal({stream})", [
+            (f"{scale} < 0", "scale < 0")
+        ]
+
 
 normal = NormalRV()
 
@@ -165,6 +197,19 @@ class GammaRV(ScipyRandomVariable):
     def rng_fn_scipy(cls, rng, shape, scale, size):
         return stats.gamma.rvs(shape, scale=scale, size=size, random_state=rng)
 
+    def philox_rng_fn(self, stream, shape, scale):
+        if np.any(shape < 0):
+            raise ValueError("shape < 0")
+        if np.any(scale < 0):
+            raise ValueError("scale < 0")
+        return np.exp(philox.log_standard_gamma(stream, shape)) * scale
+
+    def c_philox_code(self, node, stream, shape, scale):
+        return f"exp(aesara_philox_log_standard_gamma({stream}, {shape})) * {scale}", [
+            (f"{shape} < 0", "shape < 0"),
+            (f"{scale} < 0", "scale < 0"),
+        ]
+
 
 gamma = GammaRV()
 
@@ -401,6 +446,19 @@ class PoissonRV(RandomVariable):
     def __call__(self, lam=1.0, size=None, **kwargs):
         return super().__call__(lam, size=size, **kwargs)
 
+    def philox_rng_fn(self, stream, lam):
+        if np.any(lam < 0):
+            raise ValueError("lam < 0")
+        if np.any(lam > 1e18):
+            raise ValueError("lam value too large")
+        return philox.poisson(stream, lam)
+
+    def c_philox_code(self, node, stream, lam):
+        return f"aesara_philox_poisson({stream}, {lam})", [
+            (f"{lam} < 0", "lam < 0"),
+            (f"{lam} > 1e18", "lam value too large"),
+        ]
+
 
 poisson = PoissonRV()
 
@@ -542,6 +600,25 @@ class BinomialRV(RandomVariable):
     dtype = "int64"
     _print_name = ("Binom", "\\operatorname{Binom}")
 
+    def philox_rng_fn(self, stream, n, p):
+        if np.any(n < 0):
+            raise ValueError("n < 0")
+        if np.any(p < 0):
+            raise ValueError("p < 0")
+        if np.any(p > 1):
+            raise ValueError("p > 1")
+        if np.any(np.isnan(p)):
+            raise ValueError("p is nan")
+        return philox.binomial(stream, n, p)
+
+    def c_philox_code(self, node, stream, n, p):
+        return f"aesara_philox_binomial({stream}, {n}, {p})", [
+            (f"{n} < 0", "n < 0"),
+            (f"{p} < 0", "p < 0"),
+            (f"{p} > 1", "p > 1"),
+            (f"{p} != {p}", "p is nan"),
+        ]
+
 
 binomial = BinomialRV()
 
@@ -652,6 +729,13 @@ class CategoricalRV(RandomVariable):
 
         return samples
 
+    def philox_rng_fn(self, stream, p):
+        return philox.categorical(stream, p)
+
+    def c_philox_code(self, node, stream, p):
+        p_t = f"npy_{node.inputs[3].dtype}"
+        return f"aesara_philox_categorical<{p_t}>({stream}, {p})", []
+
 
 categorical = CategoricalRV()
 
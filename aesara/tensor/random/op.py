@@ -7,6 +7,7 @@ import aesara
 from aesara.configdefaults import config
 from aesara.graph.basic import Apply, Variable
 from aesara.graph.op import Op
+from aesara.link.c.op import OpenMPOp
 from aesara.misc.safe_asarray import _asarray
 from aesara.scalar import ScalarVariable
 from aesara.tensor.basic import (
@@ -16,7 +17,13 @@ from aesara.tensor.basic import (
     get_vector_length,
     infer_broadcastable,
 )
-from aesara.tensor.random.type import RandomGeneratorType, RandomStateType, RandomType
+from aesara.tensor.random import philox
+from aesara.tensor.random.type import (
+    RandomGeneratorType,
+    RandomPhiloxType,
+    RandomStateType,
+    RandomType,
+)
 from aesara.tensor.random.utils import normalize_size_param, params_broadcast_shapes
 from aesara.tensor.shape import shape_tuple
 from aesara.tensor.type import TensorType, all_dtypes
@@ -84,18 +91,48 @@ def default_supp_shape_from_params(
         return ref_param.shape[-ndim_supp:]
 
 
-class RandomVariable(Op):
+class RandomVariable(OpenMPOp):
     """An `Op` that produces a sample from a random variable.
 
     This is essentially `RandomFunction`, except that it removes the
     `outtype` dependency and handles shape dimension information more
     directly.
 
+    When its ``rng`` is a `RandomPhiloxType` and it implements
+    `RandomVariable.philox_rng_fn` and `RandomVariable.c_philox_code`, the
+    sample is drawn by the counter-based engine of
+    `aesara.tensor.random.philox`, which has a C implementation that fills
+    the sample in parallel.  Otherwise, it is drawn by the `Generator` or
+    `RandomState` methods in `RandomVariable.perform`.
+
     """
 
     __props__ = ("name", "ndim_supp", "ndims_params", "dtype", "inplace")
     default_output = 1
 
+    philox_rng_fn = None
+    """Draw a sample with the counter-based engine.
+
+    ``philox_rng_fn(stream, *dist_params)`` receives the
+    `aesara.tensor.random.philox.PhiloxStream` of the elements of the sample
+    and the parameters as ``float64`` arrays broadcast to the shape of the
+    sample (plus their support dimensions) and flattened.  It returns the
+    flattened sample and raises a ``ValueError`` for invalid parameters.
+
+    """
+
+    c_philox_code = None
+    """Return the C code of `RandomVariable.philox_rng_fn`.
+
+    ``c_philox_code(node, stream, *dist_params)`` receives the
+    ``aesara_philox_stream*`` of an element and a ``double`` expression for
+    each scalar parameter (or the ``ptr, length, stride`` arguments of a
+    vector one).  It returns an expression for the element and a list of
+    ``(condition, message)`` pairs which raise a ``ValueError`` when the
+    condition holds for one of the elements.
+
+    """
+
     def __init__(
         self,
         name=None,
@@ -103,6 +140,7 @@ class RandomVariable(Op):
         ndims_params=None,
         dtype=None,
         inplace=None,
+        openmp=None,
     ):
         """Create a random variable `Op`.
 
@@ -126,9 +164,12 @@ class RandomVariable(Op):
         inplace: boolean (optional)
             Determine whether or not the underlying rng state is updated
             in-place or not (i.e. copied).
+        openmp: boolean (optional)
+            Whether the C implementation draws in parallel.  Defaults to
+            ``config.openmp``.
 
         """
-        super().__init__()
+        super().__init__(openmp=openmp)
 
         self.name = name or getattr(self, "name")
         self.ndim_supp = (
@@ -365,7 +406,10 @@ class RandomVariable(Op):
 
         rng_var_out[0] = rng
 
-        smpl_val = self.rng_fn(rng, *(args + [size]))
+        if self.uses_philox(node):
+            smpl_val = self.philox_sample(rng, size, *args)
+        else:
+            smpl_val = self.rng_fn(rng, *(args + [size]))
 
         if (
             not isinstance(smpl_val, np.ndarray)
@@ -375,6 +419,274 @@ class RandomVariable(Op):
 
         smpl_out[0] = smpl_val
 
+    def uses_philox(self, node):
+        """Whether `node` draws with the counter-based engine."""
+        return self.philox_rng_fn is not None and isinstance(
+            node.inputs[0].type, RandomPhiloxType
+        )
+
+    def philox_sample(self, rng, size, *args):
+        """Draw a sample with the counter-based engine and advance `rng`."""
+        key, c2, c3 = philox.philox_reserve(rng)
+
+        batch_shapes = [
+            np.shape(p)[: np.ndim(p) - n] for p, n in zip(args, self.ndims_params)
+        ]
+        if size is None:
+            shape = np.broadcast_shapes(*batch_shapes)
+        else:
+            shape = size
+        params = [
+            np.broadcast_to(
+                np.asarray(p, dtype=np.float64), shape + np.shape(p)[np.ndim(p) - n :]
+            ).reshape((-1,) + np.shape(p)[np.ndim(p) - n :])
+            for p, n in zip(args, self.ndims_params)
+        ]
+
+        stream = philox.PhiloxStream(key, c2, c3, int(np.prod(shape, dtype=np.int64)))
+        return np.reshape(self.philox_rng_fn(stream, *params), shape)
+
+    def make_thunk(self, node, storage_map, compute_map, no_recycling, impl=None):
+        if not self.uses_philox(node):
+            impl = "py"
+        return super().make_thunk(
+            node, storage_map, compute_map, no_recycling, impl=impl
+        )
+
+    def c_support_code(self, **kwargs):
+        return philox.c_support_code
+
+    def c_compile_args(self, **kwargs):
+        # Keep the rounding of the C and NumPy implementations the same
+        return super().c_compile_args(**kwargs) + ["-ffp-contract=off"]
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        if not self.uses_philox(node):
+            raise NotImplementedError()
+
+        rng, size, _, *params = inputs
+        rng_out, out = outputs
+        fail = sub["fail"]
+        out_nd = node.outputs[1].ndim
+        out_dtype = node.outputs[1].dtype
+
+        mismatch = f"""{{
+            PyErr_SetString(PyExc_ValueError,
+                            "shape mismatch: objects cannot be broadcast to a single shape");
+            {fail}
+        }}"""
+        decls = []
+        broadcast = []
+        strides = []
+        offsets = []
+        flat = []
+        flat_offsets = []
+        param_decls = []
+        param_exprs = []
+        for k, (p, var, n_supp) in enumerate(
+            zip(params, node.inputs[3:], self.ndims_params)
+        ):
+            p_nd = var.ndim
+            b_nd = p_nd - n_supp
+            p_t = f"npy_{var.dtype}"
+            decls.append(
+                f"npy_intp pstr_{k}[{max(out_nd, 1)}], pstep_{k};\n"
+                f"const char* pdata_{k} = PyArray_BYTES({p});"
+            )
+            if b_nd > out_nd:
+                strides.append(mismatch)
+                b_nd = out_nd
+            for b in range(b_nd):
+                d = out_nd - b_nd + b
+                broadcast.append(
+                    f"""
+                    if (PyArray_DIMS({p})[{b}] != 1) {{
+                        if (odims[{d}] == 1)
+                            odims[{d}] = PyArray_DIMS({p})[{b}];
+                        else if (odims[{d}] != PyArray_DIMS({p})[{b}])
+                            {mismatch}
+                    }}"""
+                )
+            strides.append(f"for (d = 0; d < {out_nd}; d++) pstr_{k}[d] = 0;")
+            for b in range(b_nd):
+                d = out_nd - b_nd + b
+                strides.append(
+                    f"""
+                    if (PyArray_DIMS({p})[{b}] == odims[{d}])
+                        pstr_{k}[{d}] = PyArray_STRIDES({p})[{b}];
+                    else if (PyArray_DIMS({p})[{b}] != 1)
+                        {mismatch}"""
+                )
+            offsets.append(f"off_{k} += j * pstr_{k}[dd];")
+            flat_offsets.append(f"off_{k} = i * pstep_{k};")
+            # Parameters broadcast from a scalar or with the layout of the
+            # output don't need the index of the element along each axis
+            flat.append(
+                f"""
+                {{
+                    npy_intp expected = PyArray_ITEMSIZE({p});
+                    int zero = 1, contiguous = 1;
+                    for (d = {out_nd} - 1; d >= 0; d--) {{
+                        zero = zero && (pstr_{k}[d] == 0 || odims[d] == 1);
+                        contiguous = contiguous && (pstr_{k}[d] == expected || odims[d] == 1);
+                        expected *= odims[d];
+                    }}
+                    pstep_{k} = zero ? 0 : PyArray_ITEMSIZE({p});
+                    flat = flat && (zero || contiguous);
+                }}"""
+            )
+            if n_supp == 0:
+                param_decls.append(
+                    f"const double param_{k} = (double)*(const {p_t}*)(pdata_{k} + off_{k});"
+                )
+                param_exprs.append(f"param_{k}")
+            elif n_supp == 1:
+                param_exprs.append(
+                    f"pdata_{k} + off_{k}, PyArray_DIMS({p})[{p_nd - 1}], "
+                    f"PyArray_STRIDES({p})[{p_nd - 1}]"
+                )
+            else:
+                raise NotImplementedError()
+
+        sample, checks = self.c_philox_code(node, "&stream", *param_exprs)
+        check_code = "\n".join(
+            f"if ({cond}) {{ invalid |= {1 << j}; out_data[i] = 0; continue; }}"
+            for j, (cond, _) in enumerate(checks)
+        )
+        raise_code = "\n".join(
+            f"""if (invalid & {1 << j}) {{
+                PyErr_SetString(PyExc_ValueError, "{msg}");
+                {fail}
+            }}"""
+            for j, (_, msg) in enumerate(checks)
+        )
+
+        if self.inplace:
+            copy_rng = f"""
+            {rng_out} = {rng};
+            Py_INCREF({rng_out});
+            """
+        else:
+            copy_rng = f"""
+            {{
+                PyObject* copy_module = PyImport_ImportModule("copy");
+                if (copy_module == NULL)
+                    {fail}
+                {rng_out} = PyObject_CallMethod(copy_module, "copy", "O", {rng});
+                Py_DECREF(copy_module);
+            }}
+            """
+
+        if self.openmp:
+            omp = (
+                "#pragma omp parallel for schedule(static) reduction(|:invalid) "
+                f"if(n_out >= {int(config.openmp_elemwise_minsize)})"
+            )
+        else:
+            omp = ""
+
+        return """
+        {
+            npy_uint64 key[2], c2, c3;
+            npy_intp odims[%(n_dims)s];
+            npy_intp n_out = 1, i;
+            int d, invalid = 0, flat = 1;
+            npy_%(out_dtype)s* out_data;
+            %(decls)s
+
+            Py_XDECREF(%(rng_out)s);
+            %(copy_rng)s
+            if (%(rng_out)s == NULL)
+                %(fail)s
+            if (aesara_philox_reserve(%(rng)s, %(rng_out)s, key, &c2, &c3) < 0)
+                %(fail)s
+
+            if (PyArray_DIMS(%(size)s)[0] > 0) {
+                if (PyArray_DIMS(%(size)s)[0] != %(out_nd)s) {
+                    PyErr_SetString(PyExc_ValueError, "size does not match the number of dimensions of the output");
+                    %(fail)s
+                }
+                for (d = 0; d < %(out_nd)s; d++) {
+                    odims[d] = *(npy_int64*)PyArray_GETPTR1(%(size)s, d);
+                    if (odims[d] < 0) {
+                        PyErr_SetString(PyExc_ValueError, "negative dimensions are not allowed");
+                        %(fail)s
+                    }
+                }
+            }
+            else {
+                for (d = 0; d < %(out_nd)s; d++)
+                    odims[d] = 1;
+                %(broadcast)s
+            }
+            %(strides)s
+            for (d = 0; d < %(out_nd)s; d++)
+                n_out *= odims[d];
+            %(flat)s
+
+            if (!(%(out)s && PyArray_NDIM(%(out)s) == %(out_nd)s &&
+                  PyArray_CompareLists(PyArray_DIMS(%(out)s), odims, %(out_nd)s) &&
+                  PyArray_IS_C_CONTIGUOUS(%(out)s))) {
+                Py_XDECREF(%(out)s);
+                %(out)s = (PyArrayObject*)PyArray_EMPTY(%(out_nd)s, odims, NPY_%(OUT_DTYPE)s, 0);
+                if (!%(out)s)
+                    %(fail)s
+            }
+            out_data = (npy_%(out_dtype)s*)PyArray_DATA(%(out)s);
+
+            %(omp)s
+            for (i = 0; i < n_out; i++) {
+                npy_intp r = i;
+                %(off_decls)s
+                int dd;
+                aesara_philox_stream stream;
+                if (flat) {
+                    %(flat_offsets)s
+                }
+                else {
+                    for (dd = %(out_nd)s - 1; dd >= 0; dd--) {
+                        const npy_intp j = r %% odims[dd];
+                        r /= odims[dd];
+                        %(offsets)s
+                    }
+                }
+                {
+                    %(param_decls)s
+                    aesara_philox_stream_init(&stream, key, (npy_uint64)i, 0, c2, c3);
+                    %(check_code)s
+                    out_data[i] = (npy_%(out_dtype)s)(%(sample)s);
+                }
+            }
+            %(raise_code)s
+        }
+        """ % dict(
+            rng=rng,
+            rng_out=rng_out,
+            size=size,
+            out=out,
+            fail=fail,
+            out_nd=out_nd,
+            n_dims=max(out_nd, 1),
+            out_dtype=out_dtype,
+            OUT_DTYPE=out_dtype.upper(),
+            decls="\n".join(decls),
+            copy_rng=copy_rng,
+            broadcast="\n".join(broadcast),
+            strides="\n".join(strides),
+            omp=omp,
+            off_decls="".join(f"npy_intp off_{k} = 0;" for k in range(len(params))),
+            offsets="\n".join(offsets),
+            flat="\n".join(flat),
+            flat_offsets="\n".join(flat_offsets),
+            param_decls="\n".join(param_decls),
+            check_code=check_code,
+            sample=sample,
+            raise_code=raise_code,
+        )
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
     def grad(self, inputs, outputs):
         return [
             aesara.gradient.grad_undefined(
@@ -0,0 +1,680 @@
+r"""A counter-based sampling engine built on Philox4x64-10.
+
+`RandomVariable`\s that implement `RandomVariable.philox_rng_fn` and whose
+``rng`` is a `Generator` backed by a `numpy.random.Philox` bit generator (see
+`RandomPhiloxType`) are sampled by this engine instead of the `Generator`
+methods.
+
+The key of the bit generator and the high words of its counter identify a
+draw.  Element ``i`` of a sample uses its own stream of blocks
+``philox((i, sub << 32 | block, c2, c3), key)``, where ``sub`` separates the
+streams of distributions built from several others (e.g. the two gamma draws
+of a beta).  A sample therefore only depends on the state of the bit
+generator, and not on the order or the number of threads used to fill it.
+After a draw, the counter of the bit generator is moved to the next
+``(c2, c3)``, so that draws made with the `Generator` methods never overlap
+with the ones made here.
+
+This module contains the NumPy implementation used by
+`RandomVariable.perform` and the C support code used by
+`RandomVariable.c_code`; both give the same values.
+
+"""
+
+import numpy as np
+import scipy.special
+
+
+_M0 = np.uint64(0xD2E7470EE14C6C93)
+_M1 = np.uint64(0xCA5A826395121157)
+_W0 = np.uint64(0x9E3779B97F4A7C15)
+_W1 = np.uint64(0xBB67AE8584CAA73B)
+_LO32 = np.uint64(0xFFFFFFFF)
+_MASK64 = (1 << 64) - 1
+
+_TWO_PI = 6.283185307179586476925286766559
+_TO_DOUBLE = 1.0 / 9007199254740992.0
+
+# `log(k!) - (k + 1 / 2) log(k + 1) + (k + 1) - log(2 pi) / 2` for `k < 10`
+_STIRLING_TAIL = np.array(
+    [
+        0.0810614667953272,
+        0.0413406959554092,
+        0.0276779256849983,
+        0.02079067210376509,
+        0.0166446911898211,
+        0.0138761288230707,
+        0.0118967099458917,
+        0.0104112652619720,
+        0.00925546218271273,
+        0.00833056343336287,
+    ]
+)
+
+
+def _mulhilo64(a, b):
+    """Return the high and low words of the 128-bit products of `a` and `b`."""
+    a_lo, a_hi = a & _LO32, a >> np.uint64(32)
+    b_lo, b_hi = b & _LO32, b >> np.uint64(32)
+    lo_lo = a_lo * b_lo
+    hi_lo = a_hi * b_lo
+    lo_hi = a_lo * b_hi
+    mid = (lo_lo >> np.uint64(32)) + (hi_lo & _LO32) + (lo_hi & _LO32)
+    hi = (
+        a_hi * b_hi
+        + (hi_lo >> np.uint64(32))
+        + (lo_hi >> np.uint64(32))
+        + (mid >> np.uint64(32))
+    )
+    return hi, a * b
+
+
+def philox4x64(counter, key, rounds=10):
+    """Compute the Philox4x64 blocks of an ``(n, 4)`` array of counters."""
+    c0, c1, c2, c3 = (counter[:, i].copy() for i in range(4))
+    k0, k1 = np.uint64(key[0]), np.uint64(key[1])
+    with np.errstate(over="ignore"):
+        for r in range(rounds):
+            if r > 0:
+                k0 = k0 + _W0
+                k1 = k1 + _W1
+            hi0, lo0 = _mulhilo64(_M0, c0)
+            hi1, lo1 = _mulhilo64(_M1, c2)
+            c0, c1, c2, c3 = hi1 ^ c1 ^ k0, lo1, hi0 ^ c3 ^ k1, lo0
+    return np.stack([c0, c1, c2, c3], axis=1)
+
+
+def philox_reserve(rng):
+    """Reserve the counters of a draw from the `Philox` generator `rng`.
+
+    The state of `rng` is advanced past the reserved counters.
+
+    Returns
+    -------
+    The key of `rng` and the two high words of the counters of the draw.
+
+    """
+    bit_gen = rng.bit_generator
+    state = bit_gen.state
+    key = np.array(state["state"]["key"], dtype=np.uint64)
+    c0, c1, c2, c3 = (int(c) for c in state["state"]["counter"])
+    # The `Generator` methods used the low words of the current counter.
+    if c0 or c1:
+        c2 = (c2 + 1) & _MASK64
+        c3 = (c3 + (c2 == 0)) & _MASK64
+    next_c2 = (c2 + 1) & _MASK64
+    next_c3 = (c3 + (next_c2 == 0)) & _MASK64
+    state["state"]["counter"] = np.array([0, 0, next_c2, next_c3], dtype=np.uint64)
+    state["buffer_pos"] = 4
+    state["has_uint32"] = 0
+    state["uinteger"] = 0
+    bit_gen.state = state
+    return key, c2, c3
+
+
+class PhiloxStream:
+    """The Philox streams of the elements of a sample.
+
+    The methods draw one value for each element in `idx` (all the elements
+    by default) and advance the streams of these elements.
+
+    """
+
+    def __init__(self, key, c2, c3, size, sub=0):
+        self.key = key
+        self.c2 = c2
+        self.c3 = c3
+        self.sub = sub
+        self.pos = np.zeros(size, dtype=np.uint64)
+
+    def substream(self, sub):
+        """Return the streams numbered `sub` of the same elements."""
+        return type(self)(self.key, self.c2, self.c3, self.pos.shape[0], sub)
+
+    def next_uint64(self, idx=None):
+        if idx is None:
+            idx = np.arange(self.pos.shape[0])
+        pos = self.pos[idx]
+        counter = np.empty((idx.shape[0], 4), dtype=np.uint64)
+        counter[:, 0] = idx
+        counter[:, 1] = np.uint64(self.sub << 32) | (pos >> np.uint64(2))
+        counter[:, 2] = self.c2
+        counter[:, 3] = self.c3
+        blocks = philox4x64(counter, self.key)
+        self.pos[idx] = pos + np.uint64(1)
+        return blocks[np.arange(idx.shape[0]), (pos & np.uint64(3)).astype(np.intp)]
+
+    def uniform(self, idx=None):
+        """Draw from ``[0, 1)``."""
+        return (self.next_uint64(idx) >> np.uint64(11)).astype(np.float64) * _TO_DOUBLE
+
+    def uniform_pos(self, idx=None):
+        """Draw from ``(0, 1]``."""
+        bits = (self.next_uint64(idx) >> np.uint64(11)) + np.uint64(1)
+        return bits.astype(np.float64) * _TO_DOUBLE
+
+    def normal(self, idx=None):
+        """Draw from a standard normal with the Box-Muller transform."""
+        u1 = self.uniform_pos(idx)
+        u2 = self.uniform(idx)
+        return np.sqrt(-2.0 * np.log(u1)) * np.cos(_TWO_PI * u2)
+
+
+def log_standard_gamma(stream, a):
+    """Draw the logarithm of standard gamma variates of shape `a`.
+
+    This uses the squeeze method of Marsaglia and Tsang, with the boost
+    ``Gamma(a) = Gamma(a + 1) * U ** (1 / a)`` for ``a < 1``.  Working in log
+    space keeps the small draws of small shapes (e.g. for a beta) from
+    underflowing.
+
+    """
+    a = np.asarray(a, dtype=np.float64)
+    res = np.empty(a.shape[0])
+    valid = a > 0
+    res[~valid] = np.where(a[~valid] == 0, -np.inf, np.nan)
+    idx = np.flatnonzero(valid)
+    aa = np.where(a < 1, a + 1, a)
+    d = aa - 1.0 / 3.0
+    with np.errstate(divide="ignore", invalid="ignore"):
+        c = 1.0 / np.sqrt(9.0 * d)
+
+        pending = idx
+        while pending.shape[0]:
+            x = stream.normal(pending)
+            u = stream.uniform(pending)
+            d_p = d[pending]
+            v = 1.0 + c[pending] * x
+            positive = v > 0.0
+            v = np.where(positive, v * v * v, 1.0)
+            xx = x * x
+            accept = positive & (
+                (u < 1.0 - 0.0331 * xx * xx)
+                | (np.log(u) < 0.5 * xx + d_p * (1.0 - v + np.log(v)))
+            )
+            res[pending[accept]] = np.log(d_p[accept] * v[accept])
+            pending = pending[~accept]
+
+        boost = idx[a[idx] < 1]
+        res[boost] += np.log(stream.uniform_pos(boost)) / a[boost]
+    return res
+
+
+def poisson(stream, lam):
+    """Draw Poisson variates.
+
+    Small rates multiply uniforms until their product drops below
+    ``exp(-lam)``; rates of at least 10 use Hörmann's transformed rejection
+    (PTRS).
+
+    """
+    lam = np.asarray(lam, dtype=np.float64)
+    res = np.zeros(lam.shape[0], dtype=np.int64)
+
+    with np.errstate(divide="ignore", invalid="ignore", over="ignore"):
+        pending = np.flatnonzero(~(lam >= 10.0))
+        enlam = np.exp(-lam[pending])
+        prod = np.ones(pending.shape[0])
+        while pending.shape[0]:
+            prod = prod * stream.uniform(pending)
+            more = prod > enlam
+            res[pending[more]] += 1
+            pending, enlam, prod = pending[more], enlam[more], prod[more]
+
+        pending = np.flatnonzero(lam >= 10.0)
+        lam = lam[pending]
+        slam = np.sqrt(lam)
+        loglam = np.log(lam)
+        b = 0.931 + 2.53 * slam
+        a = -0.059 + 0.02483 * b
+        invalpha = 1.1239 + 1.1328 / (b - 3.4)
+        vr = 0.9277 - 3.6224 / (b - 2.0)
+        while pending.shape[0]:
+            u = stream.uniform(pending) - 0.5
+            v = stream.uniform(pending)
+            us = 0.5 - np.abs(u)
+            k = np.floor((2.0 * a / us + b) * u + lam + 0.43)
+            accept = (us >= 0.07) & (v <= vr)
+            retry = ~accept & ((k < 0) | ((us < 0.013) & (v > us)))
+            test = ~accept & ~retry
+            accept[test] = (
+                np.log(v[test])
+                + np.log(invalpha[test])
+                - np.log(a[test] / (us[test] * us[test]) + b[test])
+            ) <= (
+                -lam[test]
+                + k[test] * loglam[test]
+                - scipy.special.gammaln(k[test] + 1.0)
+            )
+            res[pending[accept]] = k[accept]
+            keep = ~accept
+            pending, lam, slam, loglam = (
+                pending[keep],
+                lam[keep],
+                slam[keep],
+                loglam[keep],
+            )
+            b, a, invalpha, vr = b[keep], a[keep], invalpha[keep], vr[keep]
+    return res
+
+
+def _stirling_tail(k):
+    k = np.asarray(k, dtype=np.float64)
+    small = k <= 9
+    kp1sq = (k + 1.0) * (k + 1.0)
+    res = (1.0 / 12 - (1.0 / 360 - 1.0 / 1260 / kp1sq) / kp1sq) / (k + 1.0)
+    res[small] = _STIRLING_TAIL[k[small].astype(np.intp)]
+    return res
+
+
+def binomial(stream, n, p):
+    """Draw binomial variates.
+
+    With ``p`` replaced by ``min(p, 1 - p)``, small means ``n p < 10`` are
+    drawn by inversion and the others with Hörmann's transformed rejection
+    (BTRS).
+
+    """
+    n = np.asarray(n, dtype=np.float64)
+    p = np.asarray(p, dtype=np.float64)
+    flip = p > 0.5
+    p = np.where(flip, 1.0 - p, p)
+    q = 1.0 - p
+    res = np.zeros(n.shape[0], dtype=np.int64)
+
+    with np.errstate(divide="ignore", invalid="ignore"):
+        pending = np.flatnonzero(n * p < 10.0)
+        u = stream.uniform(pending)
+        f = np.power(q[pending], n[pending])
+        x = np.zeros(pending.shape[0])
+        while pending.shape[0]:
+            more = (u > f) & (x < n[pending])
+            res[pending[~more]] = x[~more]
+            pending, u, f, x = pending[more], u[more], f[more], x[more]
+            u = u - f
+            x = x + 1.0
+            f = f * ((n[pending] - x + 1.0) * p[pending] / (x * q[pending]))
+
+        pending = np.flatnonzero(n * p >= 10.0)
+        n_p, p_p, q_p = n[pending], p[pending], q[pending]
+        spq = np.sqrt(n_p * p_p * q_p)
+        b = 1.15 + 2.53 * spq
+        a = -0.0873 + 0.0248 * b + 0.01 * p_p
+        c = n_p * p_p + 0.5
+        vr = 0.92 - 4.2 / b
+        r = p_p / q_p
+        alpha = (2.83 + 5.1 / b) * spq
+        m = np.floor((n_p + 1.0) * p_p)
+        while pending.shape[0]:
+            u = stream.uniform(pending) - 0.5
+            v = stream.uniform(pending)
+            us = 0.5 - np.abs(u)
+            k = np.floor((2.0 * a / us + b) * u + c)
+            in_range = (k >= 0) & (k <= n_p)
+            accept = in_range & (us >= 0.07) & (v <= vr)
+            t = in_range & ~accept
+            v_t = np.log(v[t] * alpha[t] / (a[t] / (us[t] * us[t]) + b[t]))
+            m_t, n_t, k_t, r_t = m[t], n_p[t], k[t], r[t]
+            upper = (
+                (m_t + 0.5) * np.log((m_t + 1.0) / (r_t * (n_t - m_t + 1.0)))
+                + (n_t + 1.0) * np.log((n_t - m_t + 1.0) / (n_t - k_t + 1.0))
+                + (k_t + 0.5) * np.log(r_t * (n_t - k_t + 1.0) / (k_t + 1.0))
+                + _stirling_tail(m_t)
+                + _stirling_tail(n_t - m_t)
+                - _stirling_tail(k_t)
+                - _stirling_tail(n_t - k_t)
+            )
+            accept[t] = v_t <= upper
+            res[pending[accept]] = k[accept]
+            keep = ~accept
+            pending, n_p, b, a, c = pending[keep], n_p[keep], b[keep], a[keep], c[keep]
+            vr, r, alpha, m = vr[keep], r[keep], alpha[keep], m[keep]
+
+    return np.where(flip, n.astype(np.int64) - res, res)
+
+
+def categorical(stream, p):
+    """Draw the index of the first cumulated probability above a uniform."""
+    u = stream.uniform()
+    cumsum = np.cumsum(np.asarray(p, dtype=np.float64), axis=-1)
+    above = cumsum >= u[:, None]
+    return np.where(above.any(axis=-1), above.argmax(axis=-1), p.shape[-1] - 1)
+
+
+c_support_code = """
+#include <math.h>
+
+struct aesara_philox_stream {
+    npy_uint64 key[2];
+    npy_uint64 counter[4];
+    npy_uint64 block[4];
+    npy_uint64 sub;
+    npy_uint64 pos;
+};
+
+static inline npy_uint64 aesara_philox_mulhilo(npy_uint64 a, npy_uint64 b, npy_uint64* hi)
+{
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 prod = (unsigned __int128)a * b;
+    *hi = (npy_uint64)(prod >> 64);
+    return (npy_uint64)prod;
+#else
+    const npy_uint64 a_lo = a & 0xFFFFFFFFULL, a_hi = a >> 32;
+    const npy_uint64 b_lo = b & 0xFFFFFFFFULL, b_hi = b >> 32;
+    const npy_uint64 lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi;
+    const npy_uint64 mid = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFULL) + (lo_hi & 0xFFFFFFFFULL);
+    *hi = a_hi * b_hi + (hi_lo >> 32) + (lo_hi >> 32) + (mid >> 32);
+    return a * b;
+#endif
+}
+
+static inline void aesara_philox4x64(const npy_uint64* counter, const npy_uint64* key, npy_uint64* out)
+{
+    npy_uint64 c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    npy_uint64 k0 = key[0], k1 = key[1];
+    int r;
+    for (r = 0; r < 10; r++) {
+        npy_uint64 hi0, hi1, lo0, lo1;
+        if (r > 0) {
+            k0 += 0x9E3779B97F4A7C15ULL;
+            k1 += 0xBB67AE8584CAA73BULL;
+        }
+        lo0 = aesara_philox_mulhilo(0xD2E7470EE14C6C93ULL, c0, &hi0);
+        lo1 = aesara_philox_mulhilo(0xCA5A826395121157ULL, c2, &hi1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+static inline void aesara_philox_stream_init(
+    aesara_philox_stream* s, const npy_uint64* key, npy_uint64 element,
+    npy_uint64 sub, npy_uint64 c2, npy_uint64 c3)
+{
+    s->key[0] = key[0];
+    s->key[1] = key[1];
+    s->counter[0] = element;
+    s->counter[1] = 0;
+    s->counter[2] = c2;
+    s->counter[3] = c3;
+    s->sub = sub;
+    s->pos = 0;
+}
+
+static inline aesara_philox_stream aesara_philox_substream(const aesara_philox_stream* s, npy_uint64 sub)
+{
+    aesara_philox_stream t;
+    aesara_philox_stream_init(&t, s->key, s->counter[0], sub, s->counter[2], s->counter[3]);
+    return t;
+}
+
+static inline npy_uint64 aesara_philox_next(aesara_philox_stream* s)
+{
+    if ((s->pos & 3) == 0) {
+        s->counter[1] = (s->sub << 32) | (s->pos >> 2);
+        aesara_philox4x64(s->counter, s->key, s->block);
+    }
+    return s->block[s->pos++ & 3];
+}
+
+// Uniform on [0, 1)
+static inline double aesara_philox_uniform(aesara_philox_stream* s)
+{
+    return (double)(aesara_philox_next(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Uniform on (0, 1]
+static inline double aesara_philox_uniform_pos(aesara_philox_stream* s)
+{
+    return (double)((aesara_philox_next(s) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static inline double aesara_philox_normal(aesara_philox_stream* s)
+{
+    const double u1 = aesara_philox_uniform_pos(s);
+    const double u2 = aesara_philox_uniform(s);
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586476925286766559 * u2);
+}
+
+static double aesara_philox_log_standard_gamma(aesara_philox_stream* s, double a)
+{
+    const double aa = a < 1.0 ? a + 1.0 : a;
+    const double d = aa - 1.0 / 3.0;
+    const double c = 1.0 / sqrt(9.0 * d);
+    double x, u, v, xx, res;
+    if (!(a > 0.0))
+        return a == 0.0 ? -INFINITY : NAN;
+    for (;;) {
+        x = aesara_philox_normal(s);
+        u = aesara_philox_uniform(s);
+        v = 1.0 + c * x;
+        if (!(v > 0.0))
+            continue;
+        v = v * v * v;
+        xx = x * x;
+        if (u < 1.0 - 0.0331 * xx * xx)
+            break;
+        if (log(u) < 0.5 * xx + d * (1.0 - v + log(v)))
+            break;
+    }
+    res = log(d * v);
+    if (a < 1.0)
+        res += log(aesara_philox_uniform_pos(s)) / a;
+    return res;
+}
+
+static double aesara_philox_beta(aesara_philox_stream* s, double a, double b)
+{
+    aesara_philox_stream t = aesara_philox_substream(s, 1);
+    const double log_x = aesara_philox_log_standard_gamma(s, a);
+    const double log_y = aesara_philox_log_standard_gamma(&t, b);
+    return 1.0 / (1.0 + exp(log_y - log_x));
+}
+
+static npy_int64 aesara_philox_poisson(aesara_philox_stream* s, double lam)
+{
+    if (!(lam >= 10.0)) {
+        const double enlam = exp(-lam);
+        double prod = 1.0;
+        npy_int64 x = 0;
+        for (;;) {
+            prod = prod * aesara_philox_uniform(s);
+            if (!(prod > enlam))
+                return x;
+            x += 1;
+        }
+    }
+    else {
+        const double slam = sqrt(lam);
+        const double loglam = log(lam);
+        const double b = 0.931 + 2.53 * slam;
+        const double a = -0.059 + 0.02483 * b;
+        const double invalpha = 1.1239 + 1.1328 / (b - 3.4);
+        const double vr = 0.9277 - 3.6224 / (b - 2.0);
+        for (;;) {
+            const double u = aesara_philox_uniform(s) - 0.5;
+            const double v = aesara_philox_uniform(s);
+            const double us = 0.5 - fabs(u);
+            const double k = floor((2.0 * a / us + b) * u + lam + 0.43);
+            if ((us >= 0.07) && (v <= vr))
+                return (npy_int64)k;
+            if ((k < 0) || ((us < 0.013) && (v > us)))
+                continue;
+            if ((log(v) + log(invalpha) - log(a / (us * us) + b)) <=
+                (-lam + k * loglam - lgamma(k + 1.0)))
+                return (npy_int64)k;
+        }
+    }
+}
+
+static inline double aesara_philox_stirling_tail(double k)
+{
+    static const double tail[10] = {
+        0.0810614667953272, 0.0413406959554092, 0.0276779256849983,
+        0.02079067210376509, 0.0166446911898211, 0.0138761288230707,
+        0.0118967099458917, 0.0104112652619720, 0.00925546218271273,
+        0.00833056343336287};
+    double kp1sq;
+    if (k <= 9)
+        return tail[(int)k];
+    kp1sq = (k + 1.0) * (k + 1.0);
+    return (1.0 / 12 - (1.0 / 360 - 1.0 / 1260 / kp1sq) / kp1sq) / (k + 1.0);
+}
+
+static npy_int64 aesara_philox_binomial(aesara_philox_stream* s, double n, double p0)
+{
+    const int flip = p0 > 0.5;
+    const double p = flip ? 1.0 - p0 : p0;
+    const double q = 1.0 - p;
+    npy_int64 res;
+    if (n * p < 10.0) {
+        double u = aesara_philox_uniform(s);
+        double f = pow(q, n);
+        double x = 0.0;
+        while ((u > f) && (x < n)) {
+            u = u - f;
+            x = x + 1.0;
+            f = f * ((n - x + 1.0) * p / (x * q));
+        }
+        res = (npy_int64)x;
+    }
+    else {
+        const double spq = sqrt(n * p * q);
+        const double b = 1.15 + 2.53 * spq;
+        const double a = -0.0873 + 0.0248 * b + 0.01 * p;
+        const double c = n * p + 0.5;
+        const double vr = 0.92 - 4.2 / b;
+        const double r = p / q;
+        const double alpha = (2.83 + 5.1 / b) * spq;
+        const double m = floor((n + 1.0) * p);
+        for (;;) {
+            const double u = aesara_philox_uniform(s) - 0.5;
+            double v = aesara_philox_uniform(s);
+            const double us = 0.5 - fabs(u);
+            const double k = floor((2.0 * a / us + b) * u + c);
+            double upper;
+            if (!((k >= 0) && (k <= n)))
+                continue;
+            if ((us >= 0.07) && (v <= vr)) {
+                res = (npy_int64)k;
+                break;
+            }
+            v = log(v * alpha / (a / (us * us) + b));
+            upper = (m + 0.5) * log((m + 1.0) / (r * (n - m + 1.0)))
+                + (n + 1.0) * log((n - m + 1.0) / (n - k + 1.0))
+                + (k + 0.5) * log(r * (n - k + 1.0) / (k + 1.0))
+                + aesara_philox_stirling_tail(m)
+                + aesara_philox_stirling_tail(n - m)
+                - aesara_philox_stirling_tail(k)
+                - aesara_philox_stirling_tail(n - k);
+            if (v <= upper) {
+                res = (npy_int64)k;
+                break;
+            }
+        }
+    }
+    return flip ? (npy_int64)n - res : res;
+}
+
+template <typename T>
+static npy_int64 aesara_philox_categorical(
+    aesara_philox_stream* s, const char* p, npy_intp k, npy_intp stride)
+{
+    const double u = aesara_philox_uniform(s);
+    double cumsum = 0.0;
+    npy_intp i;
+    for (i = 0; i < k; i++) {
+        cumsum += (double)*(const T*)(p + i * stride);
+        if (cumsum >= u)
+            return i;
+    }
+    return k - 1;
+}
+
+// Reserve the counters of a draw from the `Philox` generator `rng`, like
+// `philox_reserve`, and store the advanced state in `rng_out`.
+static int aesara_philox_reserve(
+    PyObject* rng, PyObject* rng_out, npy_uint64* key, npy_uint64* c2, npy_uint64* c3)
+{
+    PyObject* bit_gen = NULL;
+    PyObject* state = NULL;
+    PyObject* inner;
+    PyObject* zero = NULL;
+    PyObject* four = NULL;
+    PyArrayObject* counter = NULL;
+    PyArrayObject* key_arr = NULL;
+    npy_uint64* ctr;
+    int res = -1;
+
+    bit_gen = PyObject_GetAttrString(rng, "bit_generator");
+    if (bit_gen == NULL)
+        goto done;
+    state = PyObject_GetAttrString(bit_gen, "state");
+    if (state == NULL)
+        goto done;
+    inner = PyDict_Check(state) ? PyDict_GetItemString(state, "state") : NULL;
+    if (inner == NULL || !PyDict_Check(inner) ||
+        PyDict_GetItemString(inner, "counter") == NULL ||
+        PyDict_GetItemString(inner, "key") == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Expected a Generator with a Philox bit generator");
+        goto done;
+    }
+    counter = (PyArrayObject*)PyArray_FROMANY(
+        PyDict_GetItemString(inner, "counter"), NPY_UINT64, 1, 1,
+        NPY_ARRAY_CARRAY | NPY_ARRAY_ENSURECOPY);
+    key_arr = (PyArrayObject*)PyArray_FROMANY(
+        PyDict_GetItemString(inner, "key"), NPY_UINT64, 1, 1, NPY_ARRAY_CARRAY_RO);
+    if (counter == NULL || key_arr == NULL)
+        goto done;
+    if (PyArray_SIZE(counter) != 4 || PyArray_SIZE(key_arr) != 2) {
+        PyErr_SetString(PyExc_TypeError, "Expected a Generator with a Philox bit generator");
+        goto done;
+    }
+    key[0] = ((npy_uint64*)PyArray_DATA(key_arr))[0];
+    key[1] = ((npy_uint64*)PyArray_DATA(key_arr))[1];
+
+    ctr = (npy_uint64*)PyArray_DATA(counter);
+    if (ctr[0] || ctr[1]) {
+        if (++ctr[2] == 0)
+            ++ctr[3];
+    }
+    *c2 = ctr[2];
+    *c3 = ctr[3];
+    ctr[0] = 0;
+    ctr[1] = 0;
+    if (++ctr[2] == 0)
+        ++ctr[3];
+
+    zero = PyLong_FromLong(0);
+    four = PyLong_FromLong(4);
+    if (zero == NULL || four == NULL ||
+        PyDict_SetItemString(inner, "counter", (PyObject*)counter) < 0 ||
+        PyDict_SetItemString(state, "buffer_pos", four) < 0 ||
+        PyDict_SetItemString(state, "has_uint32", zero) < 0 ||
+        PyDict_SetItemString(state, "uinteger", zero) < 0)
+        goto done;
+    if (rng_out != rng) {
+        Py_DECREF(bit_gen);
+        bit_gen = PyObject_GetAttrString(rng_out, "bit_generator");
+        if (bit_gen == NULL)
+            goto done;
+    }
+    if (PyObject_SetAttrString(bit_gen, "state", state) < 0)
+        goto done;
+    res = 0;
+
+done:
+    Py_XDECREF(bit_gen);
+    Py_XDECREF(state);
+    Py_XDECREF(zero);
+    Py_XDECREF(four);
+    Py_XDECREF(counter);
+    Py_XDECREF(key_arr);
+    return res;
+}
+"""
@@ -2,6 +2,7 @@ import numpy as np
 
 import aesara
 from aesara.graph.type import Type
+from aesara.link.c.type import Generic
 
 
 gen_states_keys = {
@@ -199,3 +200,47 @@ aesara.compile.register_view_op_c_code(
 )
 
 random_generator_type = RandomGeneratorType()
+
+
+class RandomPhiloxType(RandomGeneratorType, Generic):
+    r"""A Type wrapper for `numpy.random.Generator`\s backed by `numpy.random.Philox`.
+
+    `RandomVariable`\s that support it draw from these generators with the
+    counter-based engine of `aesara.tensor.random.philox`, which has a C
+    implementation.  Inherit from `Generic` so that `COp`\s can receive the
+    generators as ``PyObject*``.
+
+    This is opt-in, with ``shared(rng, counter_based=True)`` or
+    ``RandomStream(seed, counter_based=True)``, since it doesn't draw the same
+    values as NumPy.
+
+    """
+
+    def __repr__(self):
+        return "RandomPhiloxType"
+
+    @staticmethod
+    def is_valid_value(a, strict):
+        if isinstance(a, np.random.Generator):
+            return isinstance(a.bit_generator, np.random.Philox)
+
+        if not strict and isinstance(a, dict):
+            return a.get("bit_generator") == "Philox" and (
+                RandomGeneratorType.is_valid_value(a, strict)
+            )
+
+        return False
+
+
+# Register `RandomPhiloxType`'s C code for `ViewOp`.
+aesara.compile.register_view_op_c_code(
+    RandomPhiloxType,
+    """
+    Py_XDECREF(%(oname)s);
+    %(oname)s = %(iname)s;
+    Py_XINCREF(%(oname)s);
+    """,
+    1,
+)
+
+random_philox_type = RandomPhiloxType()
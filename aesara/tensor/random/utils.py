@@ -139,6 +139,11 @@ def normalize_size_param(
     return size
 
 
+def philox_generator(seed=None):
+    """Return a `Generator` backed by `np.random.Philox`."""
+    return np.random.Generator(np.random.Philox(seed))
+
+
 class RandomStream:
     """Module component with similar interface to `numpy.random.Generator`.
 
@@ -157,11 +162,15 @@ class RandomStream:
         streams.
     rng_ctor: type
         Constructor used to create the underlying RNG objects.  The default
-        is `np.random.default_rng`.
+        is `np.random.default_rng`, or a `Generator` backed by
+        `np.random.Philox` when `counter_based` is ``True``.
+    counter_based: bool
+        Draw from the counter-based engine of `aesara.tensor.random.philox`
+        (see `randomgen_constructor`), which has parallel C implementations.
 
     """
 
-    def __init__(self, seed=None, namespace=None, rng_ctor=np.random.default_rng):
+    def __init__(self, seed=None, namespace=None, rng_ctor=None, counter_based=False):
         if namespace is None:
             from aesara.tensor.random import basic  # pylint: disable=import-self
 
@@ -172,7 +181,10 @@ class RandomStream:
         self.default_instance_seed = seed
         self.state_updates = []
         self.gen_seedgen = np.random.default_rng(seed)
+        if rng_ctor is None:
+            rng_ctor = philox_generator if counter_based else np.random.default_rng
         self.rng_ctor = rng_ctor
+        self.counter_based = counter_based
 
     def __getattr__(self, obj):
 
@@ -251,7 +263,10 @@ class RandomStream:
 
         # Generate a new random state
         seed = int(self.gen_seedgen.integers(2**30))
-        random_state_variable = shared(self.rng_ctor(seed))
+        if self.counter_based:
+            random_state_variable = shared(self.rng_ctor(seed), counter_based=True)
+        else:
+            random_state_variable = shared(self.rng_ctor(seed))
 
         # Distinguish it from other shared variables (why?)
         random_state_variable.tag.is_rng = True
@@ -3,7 +3,11 @@ import copy
 import numpy as np
 
 from aesara.compile.sharedvalue import SharedVariable, shared_constructor
-from aesara.tensor.random.type import random_generator_type, random_state_type
+from aesara.tensor.random.type import (
+    random_generator_type,
+    random_philox_type,
+    random_state_type,
+)
 
 
 class RandomStateSharedVariable(SharedVariable):
@@ -18,15 +22,43 @@ class RandomGeneratorSharedVariable(SharedVariable):
 
 @shared_constructor
 def randomgen_constructor(
-    value, name=None, strict=False, allow_downcast=None, borrow=False
+    value,
+    name=None,
+    strict=False,
+    allow_downcast=None,
+    borrow=False,
+    counter_based=False,
 ):
-    r"""`SharedVariable` Constructor for NumPy's `Generator` and/or `RandomState`."""
+    r"""`SharedVariable` Constructor for NumPy's `Generator` and/or `RandomState`.
+
+    Parameters
+    ----------
+    counter_based
+        Give a `Generator` backed by `numpy.random.Philox` a `RandomPhiloxType`,
+        so that the `RandomVariable`\s that support it draw from the
+        counter-based engine of `aesara.tensor.random.philox` instead of the
+        `Generator` methods.  This gives different values than NumPy.
+
+    """
+    if (
+        counter_based
+        and isinstance(value, (np.random.RandomState, np.random.Generator))
+        and not (
+            isinstance(value, np.random.Generator)
+            and isinstance(value.bit_generator, np.random.Philox)
+        )
+    ):
+        raise ValueError(
+            "A counter-based shared variable requires a `Generator` backed by "
+            f"`numpy.random.Philox`, got {value!r}"
+        )
+
     if isinstance(value, np.random.RandomState):
         rng_sv_type = RandomStateSharedVariable
         rng_type = random_state_type
     elif isinstance(value, np.random.Generator):
         rng_sv_type = RandomGeneratorSharedVariable
-        rng_type = random_generator_type
+        rng_type = random_philox_type if counter_based else random_generator_type
     else:
         raise TypeError()
 
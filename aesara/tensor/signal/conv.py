@@ -32,7 +32,9 @@ def conv2d(
     containing a set of images. Similarly, filters can be a single 2D filter or
     a 3D tensor, corresponding to a set of 2D filters.
 
-    Shape parameters are optional and will result in faster execution.
+    Shape parameters are optional and will result in faster execution.  In
+    particular, the convolutions with large filters are computed with FFTs
+    when the shapes are known (see `aesara.tensor.nnet.fftconv`).
 
     Parameters
     ----------
@@ -7,10 +7,12 @@ import scipy.linalg
 
 import aesara.tensor
 from aesara.graph.basic import Apply
-from aesara.graph.op import Op
+from aesara.graph.op import Op, is_thunk_type
 from aesara.tensor import as_tensor_variable
 from aesara.tensor import basic as at
 from aesara.tensor import math as atm
+from aesara.tensor.lapack import LapackOp
+from aesara.tensor.nlinalg import _diag_part, _matmul, _outer, _T
 from aesara.tensor.type import matrix, tensor, vector
 from aesara.tensor.var import TensorVariable
 
@@ -18,7 +20,7 @@ from aesara.tensor.var import TensorVariable
 logger = logging.getLogger(__name__)
 
 
-class Cholesky(Op):
+class Cholesky(LapackOp):
     """
     Return a triangular matrix square root of positive semi-definite `x`.
 
@@ -33,39 +35,102 @@ class Cholesky(Op):
         `scipy.linalg.LinAlgError` if the matrix is not positive definite.
         If on_error is set to 'nan', it will return a matrix containing
         nans instead.
+
+    The leading dimensions of `x`, if any, index a batch of matrices that
+    are factored independently.
     """
 
     # TODO: inplace
-    # TODO: for specific dtypes
-    # TODO: LAPACK wrapper with in-place behavior, for solve also
 
     __props__ = ("lower", "destructive", "on_error")
 
-    def __init__(self, lower=True, on_error="raise"):
+    def __init__(self, lower=True, on_error="raise", openmp=None):
         self.lower = lower
         self.destructive = False
         if on_error not in ("raise", "nan"):
             raise ValueError('on_error must be one of "raise" or ""nan"')
         self.on_error = on_error
+        super().__init__(openmp=openmp)
 
     def infer_shape(self, fgraph, node, shapes):
         return [shapes[0]]
 
     def make_node(self, x):
         x = as_tensor_variable(x)
-        assert x.ndim == 2
+        if x.ndim < 2:
+            raise ValueError(
+                f"`x` must be a matrix or a batch of matrices; got {x.type} instead."
+            )
         return Apply(self, [x], [x.type()])
 
-    def perform(self, node, inputs, outputs):
-        x = inputs[0]
-        z = outputs[0]
+    def _cholesky(self, x):
         try:
-            z[0] = scipy.linalg.cholesky(x, lower=self.lower).astype(x.dtype)
+            return scipy.linalg.cholesky(x, lower=self.lower).astype(x.dtype)
         except scipy.linalg.LinAlgError:
             if self.on_error == "raise":
                 raise
             else:
-                z[0] = (np.zeros(x.shape) * np.nan).astype(x.dtype)
+                return (np.zeros(x.shape) * np.nan).astype(x.dtype)
+
+    def perform(self, node, inputs, outputs):
+        x = inputs[0]
+        z = outputs[0]
+        if x.ndim == 2:
+            z[0] = self._cholesky(x)
+        else:
+            out = np.empty(x.shape, dtype=x.dtype)
+            for idx in np.ndindex(*x.shape[:-2]):
+                out[idx] = self._cholesky(x[idx])
+            z[0] = out
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        self.c_lapack_check(node)
+        (x,) = inputs
+        (z,) = outputs
+        fail = sub["fail"]
+        ndim = node.inputs[0].type.ndim
+        ctype = node.inputs[0].type.dtype_specs()[1]
+        typenum = node.outputs[0].type.dtype_specs()[2]
+        # LAPACK sees the transpose of the row-major matrix, whose triangles
+        # are swapped
+        uplo = "U" if self.lower else "L"
+        nan_on_error = int(self.on_error == "nan")
+        loop = self.c_batch_loop(
+            work=[],
+            cost="(double)n * n * n",
+            body=f"""
+            {ctype}* a = ({ctype}*)PyArray_DATA({z}) + i * n * n;
+            if (!aesara_lapack_all_finite(a, (npy_intp)n * n))
+                info = INT_MIN;
+            else if (n > 0)
+            {{
+                aesara_potrf('{uplo}', n, a, &info);
+                if (info > 0 && {nan_on_error})
+                {{
+                    for (npy_intp j = 0; j < (npy_intp)n * n; ++j)
+                        a[j] = NAN;
+                    info = 0;
+                }}
+                else if (info == 0)
+                    aesara_lapack_zero_triangle(a, n, {int(self.lower)});
+            }}
+            """,
+            error="""aesara_linalg_error(
+                "%ld-th leading minor of the array is not positive definite",
+                (long)err_info);""",
+            fail=fail,
+        )
+        return f"""
+        {{
+            {self.c_batch_dims(x, ndim, fail)}
+            {self.c_alloc(z, ndim, f"PyArray_DIMS({x})", typenum, fail)}
+            if (PyArray_CopyInto({z}, {x})) {{{fail};}}
+            {loop}
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (1,) + super().c_code_cache_version()
 
     def L_op(self, inputs, outputs, gradients):
         """
@@ -86,33 +151,33 @@ class Cholesky(Op):
         # Replace the cholesky decomposition with 1 if there are nans
         # or solve_upper_triangular will throw a ValueError.
         if self.on_error == "nan":
-            ok = ~atm.any(atm.isnan(chol_x))
+            ok = ~atm.any(atm.isnan(chol_x), axis=(-2, -1), keepdims=True)
             chol_x = at.switch(ok, chol_x, 1)
             dz = at.switch(ok, dz, 1)
 
         # deal with upper triangular by converting to lower triangular
         if not self.lower:
-            chol_x = chol_x.T
-            dz = dz.T
+            chol_x = _T(chol_x)
+            dz = _T(dz)
 
         def tril_and_halve_diagonal(mtx):
             """Extracts lower triangle of square matrix and halves diagonal."""
-            return at.tril(mtx) - at.diag(at.diagonal(mtx) / 2.0)
+            return at.tril(mtx) - _diag_part(mtx) / 2.0
 
         def conjugate_solve_triangular(outer, inner):
             """Computes L^{-T} P L^{-1} for lower-triangular L."""
             return solve_upper_triangular(
-                outer.T, solve_upper_triangular(outer.T, inner.T).T
+                _T(outer), _T(solve_upper_triangular(_T(outer), _T(inner)))
             )
 
         s = conjugate_solve_triangular(
-            chol_x, tril_and_halve_diagonal(chol_x.T.dot(dz))
+            chol_x, tril_and_halve_diagonal(_matmul(_T(chol_x), dz))
         )
 
         if self.lower:
-            grad = at.tril(s + s.T) - at.diag(at.diagonal(s))
+            grad = at.tril(s + _T(s)) - _diag_part(s)
         else:
-            grad = at.triu(s + s.T) - at.diag(at.diagonal(s))
+            grad = at.triu(s + _T(s)) - _diag_part(s)
 
         if self.on_error == "nan":
             return [at.switch(ok, grad, np.nan)]
@@ -190,53 +255,111 @@ class CholeskyGrad(Op):
         return [shapes[0]]
 
 
-class CholeskySolve(Op):
+def _solve_make_node(op, A, b):
+    A = as_tensor_variable(A)
+    b = as_tensor_variable(b)
+
+    if A.ndim < 2:
+        raise ValueError(
+            f"`A` must be a matrix or a batch of matrices; got {A.type} instead."
+        )
+    if b.ndim not in (A.ndim - 1, A.ndim):
+        raise ValueError(
+            "`b` must be a matrix or a vector, with the batch dimensions of "
+            f"`A`; got {b.type} instead."
+        )
+
+    # Infer dtype by solving the most simple case with 1x1 matrices
+    o_dtype = scipy.linalg.solve(
+        np.eye(1).astype(A.dtype), np.eye(1).astype(b.dtype)
+    ).dtype
+    x = tensor(shape=b.broadcastable, dtype=o_dtype)
+    return Apply(op, [A, b], [x])
+
+
+def _solve_infer_shape(shapes):
+    Ashape, Bshape = shapes
+    rows = Ashape[-1]
+    if len(Bshape) < len(Ashape):
+        return [(*Bshape[:-1], rows)]
+    else:
+        return [(*Bshape[:-2], rows, Bshape[-1])]
+
+
+def _solve_perform(solve_fn, node, A, b):
+    """Apply `solve_fn` to each matrix of `A` and the matching part of `b`."""
+    if A.ndim == 2:
+        return solve_fn(A, b)
+    if b.shape[: A.ndim - 2] != A.shape[:-2]:
+        raise ValueError("the batch dimensions of `A` and `b` must match")
+    out = np.empty(b.shape, dtype=node.outputs[0].dtype)
+    for idx in np.ndindex(*A.shape[:-2]):
+        out[idx] = solve_fn(A[idx], b[idx])
+    return out
+
+
+class CholeskySolve(LapackOp):
+    """Solve ``A x = b`` given the Cholesky factor `C` of `A`.
+
+    Leading dimensions of `C` index a batch of systems, with the matching
+    leading dimensions of `b`.
+    """
 
     __props__ = ("lower", "check_finite")
 
-    def __init__(
-        self,
-        lower=True,
-        check_finite=True,
-    ):
+    def __init__(self, lower=True, check_finite=True, openmp=None):
         self.lower = lower
         self.check_finite = check_finite
+        super().__init__(openmp=openmp)
 
     def __repr__(self):
         return "CholeskySolve{%s}" % str(self._props())
 
     def make_node(self, C, b):
-        C = as_tensor_variable(C)
-        b = as_tensor_variable(b)
-        assert C.ndim == 2
-        assert b.ndim in (1, 2)
-
-        # infer dtype by solving the most simple
-        # case with (1, 1) matrices
-        o_dtype = scipy.linalg.solve(
-            np.eye(1).astype(C.dtype), np.eye(1).astype(b.dtype)
-        ).dtype
-        x = tensor(shape=b.broadcastable, dtype=o_dtype)
-        return Apply(self, [C, b], [x])
+        return _solve_make_node(self, C, b)
 
     def perform(self, node, inputs, output_storage):
         C, b = inputs
-        rval = scipy.linalg.cho_solve(
-            (C, self.lower),
+        output_storage[0][0] = _solve_perform(
+            lambda C, b: scipy.linalg.cho_solve(
+                (C, self.lower), b, check_finite=self.check_finite
+            ),
+            node,
+            C,
             b,
-            check_finite=self.check_finite,
         )
 
-        output_storage[0][0] = rval
-
     def infer_shape(self, fgraph, node, shapes):
-        Cshape, Bshape = shapes
-        rows = Cshape[1]
-        if len(Bshape) == 1:  # b is a Vector
-            return [(rows,)]
-        else:
-            cols = Bshape[1]  # b is a Matrix
-            return [(rows, cols)]
+        return _solve_infer_shape(shapes)
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        self.c_lapack_check(node)
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        uplo = "U" if self.lower else "L"
+        return self.c_solve_code(
+            node,
+            inputs,
+            outputs,
+            sub,
+            work=[(ctype, "bw", "(npy_intp)n * k")],
+            body=f"""
+            if ({int(self.check_finite)}
+                && (!aesara_lapack_all_finite(a, (npy_intp)n * n)
+                    || !aesara_lapack_all_finite(bb, (npy_intp)n * k)))
+                info = INT_MIN;
+            else
+            {{
+                aesara_lapack_to_fortran(bb, bw, n, k);
+                if (n > 0 && k > 0)
+                    aesara_potrs('{uplo}', n, k, a, bw, &info);
+                aesara_lapack_from_fortran(bw, xx, n, k);
+            }}
+            """,
+            error="",
+        )
+
+    def c_code_cache_version(self):
+        return (1,) + super().c_code_cache_version()
 
 
 cho_solve = CholeskySolve()
@@ -261,49 +384,50 @@ def cho_solve(c_and_lower, b, check_finite=True):
     return CholeskySolve(lower=lower, check_finite=check_finite)(A, b)
 
 
-class SolveBase(Op):
-    """Base class for `scipy.linalg` matrix equation solvers."""
+class SolveBase(LapackOp):
+    """Base class for `scipy.linalg` matrix equation solvers.
+
+    Leading dimensions of `A` index a batch of systems, with the matching
+    leading dimensions of `b`; the remaining one or two dimensions of `b`
+    are a vector or a matrix for each system.
+    """
 
     __props__ = (
         "lower",
         "check_finite",
     )
 
-    def __init__(
-        self,
-        lower=False,
-        check_finite=True,
-    ):
+    def __init__(self, lower=False, check_finite=True, openmp=None):
         self.lower = lower
         self.check_finite = check_finite
+        super().__init__(openmp=openmp)
 
     def perform(self, node, inputs, outputs):
         pass
 
     def make_node(self, A, b):
-        A = as_tensor_variable(A)
-        b = as_tensor_variable(b)
-
-        if A.ndim != 2:
-            raise ValueError(f"`A` must be a matrix; got {A.type} instead.")
-        if b.ndim not in (1, 2):
-            raise ValueError(f"`b` must be a matrix or a vector; got {b.type} instead.")
-
-        # Infer dtype by solving the most simple case with 1x1 matrices
-        o_dtype = scipy.linalg.solve(
-            np.eye(1).astype(A.dtype), np.eye(1).astype(b.dtype)
-        ).dtype
-        x = tensor(shape=b.broadcastable, dtype=o_dtype)
-        return Apply(self, [A, b], [x])
+        return _solve_make_node(self, A, b)
 
     def infer_shape(self, fgraph, node, shapes):
-        Ashape, Bshape = shapes
-        rows = Ashape[1]
-        if len(Bshape) == 1:
-            return [(rows,)]
-        else:
-            cols = Bshape[1]
-            return [(rows, cols)]
+        return _solve_infer_shape(shapes)
+
+    def c_solve_kernel(self, node):
+        """Return the `work`, `body` and `error` arguments of `c_solve_code`."""
+        raise NotImplementedError()
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        self.c_lapack_check(node)
+        work, body, error = self.c_solve_kernel(node)
+        check = f"""
+        if ({int(self.check_finite)}
+            && (!aesara_lapack_all_finite(a, (npy_intp)n * n)
+                || !aesara_lapack_all_finite(bb, (npy_intp)n * k)))
+            info = INT_MIN;
+        else
+        """
+        return self.c_solve_code(
+            node, inputs, outputs, sub, work, check + f"{{{body}}}", error
+        )
 
     def L_op(self, inputs, outputs, output_gradients):
         r"""Reverse-mode gradient updates for matrix solve operation :math:`c = A^{-1} b`.
@@ -331,9 +455,9 @@ class SolveBase(Op):
                 for k in self.__props__
             }
         )
-        b_bar = trans_solve_op(A.T, c_bar)
+        b_bar = trans_solve_op(_T(A), c_bar)
         # force outer product if vector second input
-        A_bar = -atm.outer(b_bar, c) if c.ndim == 1 else -b_bar.dot(c.T)
+        A_bar = -_outer(b_bar, c) if c.ndim < A.ndim else -_matmul(b_bar, _T(c))
 
         return [A_bar, b_bar]
 
@@ -357,22 +481,48 @@ class SolveTriangular(SolveBase):
         lower=False,
         unit_diagonal=False,
         check_finite=True,
+        openmp=None,
     ):
-        super().__init__(lower=lower, check_finite=check_finite)
+        super().__init__(lower=lower, check_finite=check_finite, openmp=openmp)
         self.trans = trans
         self.unit_diagonal = unit_diagonal
 
     def perform(self, node, inputs, outputs):
         A, b = inputs
-        outputs[0][0] = scipy.linalg.solve_triangular(
+        outputs[0][0] = _solve_perform(
+            lambda A, b: scipy.linalg.solve_triangular(
+                A,
+                b,
+                lower=self.lower,
+                trans=self.trans,
+                unit_diagonal=self.unit_diagonal,
+                check_finite=self.check_finite,
+            ),
+            node,
             A,
             b,
-            lower=self.lower,
-            trans=self.trans,
-            unit_diagonal=self.unit_diagonal,
-            check_finite=self.check_finite,
         )
 
+    def c_solve_kernel(self, node):
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        # LAPACK sees the transposes of the row-major matrices
+        uplo = "U" if self.lower else "L"
+        trans = "T" if self.trans in (0, "N") else "N"
+        diag = "U" if self.unit_diagonal else "N"
+        body = f"""
+        aesara_lapack_to_fortran(bb, bw, n, k);
+        if (n > 0 && k > 0)
+            aesara_trtrs('{uplo}', '{trans}', '{diag}', n, k, a, bw, &info);
+        aesara_lapack_from_fortran(bw, xx, n, k);
+        """
+        error = """aesara_linalg_error(
+            "singular matrix: resolution failed at diagonal %ld",
+            (long)err_info - 1);"""
+        return [(ctype, "bw", "(npy_intp)n * k")], body, error
+
+    def c_code_cache_version(self):
+        return (1,) + super().c_code_cache_version()
+
     def L_op(self, inputs, outputs, output_gradients):
         res = super().L_op(inputs, outputs, output_gradients)
 
@@ -442,23 +592,63 @@ class Solve(SolveBase):
         assume_a="gen",
         lower=False,
         check_finite=True,
+        openmp=None,
     ):
         if assume_a not in ("gen", "sym", "her", "pos"):
             raise ValueError(f"{assume_a} is not a recognized matrix structure")
 
-        super().__init__(lower=lower, check_finite=check_finite)
+        super().__init__(lower=lower, check_finite=check_finite, openmp=openmp)
         self.assume_a = assume_a
 
     def perform(self, node, inputs, outputs):
         a, b = inputs
-        outputs[0][0] = scipy.linalg.solve(
-            a=a,
-            b=b,
-            lower=self.lower,
-            check_finite=self.check_finite,
-            assume_a=self.assume_a,
+        outputs[0][0] = _solve_perform(
+            lambda a, b: scipy.linalg.solve(
+                a=a,
+                b=b,
+                lower=self.lower,
+                check_finite=self.check_finite,
+                assume_a=self.assume_a,
+            ),
+            node,
+            a,
+            b,
         )
 
+    def c_solve_kernel(self, node):
+        # Unlike SciPy, the C code doesn't warn about ill-conditioned matrices
+        if self.assume_a not in ("gen", "pos"):
+            raise NotImplementedError()
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        if self.assume_a == "gen":
+            # Factoring the transpose of `a`, solve with the transpose of that
+            factor = "aesara_getrf(n, aw, ipiv, &info);"
+            solve = "aesara_getrs('T', n, k, aw, ipiv, bw, &info);"
+        else:
+            uplo = "U" if self.lower else "L"
+            factor = f"aesara_potrf('{uplo}', n, aw, &info);"
+            solve = f"aesara_potrs('{uplo}', n, k, aw, bw, &info);"
+        body = f"""
+        memcpy(aw, a, sizeof({ctype}) * n * n);
+        aesara_lapack_to_fortran(bb, bw, n, k);
+        if (n > 0 && k > 0)
+        {{
+            {factor}
+            if (info == 0)
+                {solve}
+        }}
+        aesara_lapack_from_fortran(bw, xx, n, k);
+        """
+        work = [
+            (ctype, "aw", "(npy_intp)n * n"),
+            (ctype, "bw", "(npy_intp)n * k"),
+            ("int", "ipiv", "n"),
+        ]
+        return work, body, 'aesara_linalg_error("Matrix is singular.", 0);'
+
+    def c_code_cache_version(self):
+        return (1,) + super().c_code_cache_version()
+
 
 solve = Solve()
 
@@ -507,14 +697,313 @@ def solve(a, b, assume_a="gen", lower=False, check_finite=True):
     )(a, b)
 
 
+class LUFactor(LapackOp):
+    """Compute the pivoted LU decomposition of `A`, like `scipy.linalg.lu_factor`.
+
+    The outputs are the packed ``L`` and ``U`` factors and the zero-based
+    row interchanges.  Leading dimensions of `A` index a batch of matrices
+    that are factored independently.  Singular matrices are factored without
+    a warning; `LUSolve` raises for them.
+    """
+
+    __props__ = ("check_finite",)
+
+    def __init__(self, check_finite=True, openmp=None):
+        self.check_finite = check_finite
+        super().__init__(openmp=openmp)
+
+    def make_node(self, A):
+        A = as_tensor_variable(A)
+        if A.ndim < 2:
+            raise ValueError(
+                f"`A` must be a matrix or a batch of matrices; got {A.type} instead."
+            )
+        o_dtype = scipy.linalg.lu_factor(np.eye(1).astype(A.dtype))[0].dtype
+        lu = tensor(shape=A.broadcastable, dtype=o_dtype)
+        piv = tensor(shape=A.broadcastable[:-1], dtype="int32")
+        return Apply(self, [A], [lu, piv])
+
+    def perform(self, node, inputs, outputs):
+        (A,) = inputs
+        lu = np.empty(A.shape, dtype=node.outputs[0].dtype)
+        piv = np.empty(A.shape[:-1], dtype="int32")
+        with warnings.catch_warnings():
+            warnings.simplefilter("ignore", scipy.linalg.LinAlgWarning)
+            for idx in np.ndindex(*A.shape[:-2]):
+                lu[idx], piv[idx] = scipy.linalg.lu_factor(
+                    A[idx], check_finite=self.check_finite
+                )
+        outputs[0][0] = lu
+        outputs[1][0] = piv
+
+    def infer_shape(self, fgraph, node, shapes):
+        return [shapes[0], shapes[0][:-1]]
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        self.c_lapack_check(node, [node.inputs[0], node.outputs[0]])
+        (x,) = inputs
+        lu, piv = outputs
+        fail = sub["fail"]
+        ndim = node.inputs[0].type.ndim
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        typenum = node.outputs[0].type.dtype_specs()[2]
+        # Factor the column-major copy of each matrix, to return the factors
+        # of the matrix rather than of its transpose
+        loop = self.c_batch_loop(
+            work=[(ctype, "aw", "(npy_intp)n * n"), ("int", "ipiv", "n")],
+            cost="(double)n * n * n",
+            body=f"""
+            const {ctype}* a = (const {ctype}*)PyArray_DATA(xc) + i * n * n;
+            {ctype}* f = ({ctype}*)PyArray_DATA({lu}) + i * n * n;
+            npy_int32* p = (npy_int32*)PyArray_DATA({piv}) + i * n;
+            if ({int(self.check_finite)}
+                && !aesara_lapack_all_finite(a, (npy_intp)n * n))
+                info = INT_MIN;
+            else
+            {{
+                aesara_lapack_to_fortran(a, aw, n, n);
+                if (n > 0)
+                    aesara_getrf(n, aw, ipiv, &info);
+                // A zero pivot still leaves a valid factorization
+                if (info > 0)
+                    info = 0;
+                aesara_lapack_from_fortran(aw, f, n, n);
+                for (int j = 0; j < n; ++j)
+                    p[j] = ipiv[j] - 1;
+            }}
+            """,
+            error="",
+            fail=f"Py_DECREF(xc); {fail};",
+        )
+        return f"""
+        {{
+            {self.c_batch_dims(x, ndim, fail)}
+            {self.c_alloc(lu, ndim, f"PyArray_DIMS({x})", typenum, fail)}
+            {self.c_alloc(piv, ndim - 1, f"PyArray_DIMS({x})", "NPY_INT32", fail)}
+            PyArrayObject* xc = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*){x}, {typenum}, 0, 0, NPY_ARRAY_CARRAY_RO);
+            if (!xc) {{{fail};}}
+            {loop}
+            Py_DECREF(xc);
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (1,) + super().c_code_cache_version()
+
+
+def lu_factor(a, check_finite=True):
+    """Compute the pivoted LU decomposition of `a`.
+
+    Returns the ``(lu, piv)`` pair `lu_solve` takes, as `scipy.linalg.lu_factor`.
+    """
+    return tuple(LUFactor(check_finite=check_finite)(a))
+
+
+class LUSolve(LapackOp):
+    """Solve ``A x = b`` given the pivoted LU decomposition of `A`.
+
+    The decomposition is the pair returned by `LUFactor`.  Unlike
+    `scipy.linalg.lu_solve`, a singular ``U`` raises a `LinAlgError`, as
+    `Solve` does.  Leading dimensions of `lu` index a batch of systems, with
+    the matching leading dimensions of `piv` and `b`.
+    """
+
+    __props__ = ("check_finite",)
+
+    def __init__(self, check_finite=True, openmp=None):
+        self.check_finite = check_finite
+        super().__init__(openmp=openmp)
+
+    def make_node(self, lu, piv, b):
+        node = _solve_make_node(self, lu, b)
+        piv = as_tensor_variable(piv)
+        if piv.dtype != "int32" or piv.ndim != node.inputs[0].ndim - 1:
+            raise TypeError(
+                "`piv` must be an int32 tensor with the batch dimensions of `lu` "
+                f"and one more; got {piv.type} instead."
+            )
+        return Apply(
+            self, [node.inputs[0], piv, node.inputs[1]], [node.outputs[0].type()]
+        )
+
+    def perform(self, node, inputs, outputs):
+        lu, piv, b = inputs
+        n = lu.shape[-1]
+        if piv.shape != lu.shape[:-1]:
+            raise ValueError("the shapes of `lu` and `piv` don't match")
+        if np.any((piv < 0) | (piv >= n)):
+            raise ValueError("`piv` holds invalid row interchanges")
+        if np.any(np.diagonal(lu, axis1=-2, axis2=-1) == 0):
+            raise np.linalg.LinAlgError("Matrix is singular.")
+        out = np.empty(b.shape, dtype=node.outputs[0].dtype)
+        if lu.ndim > 2 and b.shape[: lu.ndim - 2] != lu.shape[:-2]:
+            raise ValueError("the batch dimensions of `A` and `b` must match")
+        for idx in np.ndindex(*lu.shape[:-2]):
+            out[idx] = scipy.linalg.lu_solve(
+                (lu[idx], piv[idx]), b[idx], check_finite=self.check_finite
+            )
+        outputs[0][0] = out
+
+    def infer_shape(self, fgraph, node, shapes):
+        return _solve_infer_shape([shapes[0], shapes[2]])
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        lu_var, _, b_var = node.inputs
+        self.c_lapack_check(node, [lu_var, b_var, node.outputs[0]])
+        lu, piv, b = inputs
+        fail = sub["fail"]
+        ndim = lu_var.type.ndim
+        ctype = node.outputs[0].type.dtype_specs()[1]
+        solve = self.c_solve_code(
+            node,
+            inputs,
+            outputs,
+            dict(sub, fail=f"Py_DECREF(pc); {fail}"),
+            work=[
+                (ctype, "lw", "(npy_intp)n * n"),
+                (ctype, "bw", "(npy_intp)n * k"),
+                ("int", "ipiv", "n"),
+            ],
+            body=f"""
+            const npy_int32* p = (const npy_int32*)PyArray_DATA(pc) + i * n;
+            if ({int(self.check_finite)}
+                && (!aesara_lapack_all_finite(a, (npy_intp)n * n)
+                    || !aesara_lapack_all_finite(bb, (npy_intp)n * k)))
+                info = INT_MIN;
+            for (int j = 0; j < n && !info; ++j)
+            {{
+                if (a[(npy_intp)j * n + j] == 0)
+                    info = j + 1;
+                ipiv[j] = p[j] + 1;
+            }}
+            if (!info)
+            {{
+                aesara_lapack_to_fortran(a, lw, n, n);
+                aesara_lapack_to_fortran(bb, bw, n, k);
+                if (n > 0 && k > 0)
+                    aesara_getrs('N', n, k, lw, ipiv, bw, &info);
+                aesara_lapack_from_fortran(bw, xx, n, k);
+            }}
+            """,
+            error='aesara_linalg_error("Matrix is singular.", 0);',
+        )
+        return f"""
+        {{
+            for (int d = 0; d < {ndim - 1}; ++d)
+            {{
+                if (PyArray_DIMS({piv})[d] != PyArray_DIMS({lu})[d])
+                {{
+                    PyErr_SetString(PyExc_ValueError,
+                                    "the shapes of `lu` and `piv` don't match");
+                    {fail};
+                }}
+            }}
+            PyArrayObject* pc = (PyArrayObject*)PyArray_FROMANY(
+                (PyObject*){piv}, NPY_INT32, 0, 0, NPY_ARRAY_CARRAY_RO);
+            if (!pc) {{{fail};}}
+            {{
+                npy_intp n_piv = PyArray_SIZE(pc);
+                npy_intp n_row = PyArray_DIMS({lu})[{ndim - 1}];
+                const npy_int32* p = (const npy_int32*)PyArray_DATA(pc);
+                for (npy_intp j = 0; j < n_piv; ++j)
+                {{
+                    if (p[j] < 0 || p[j] >= n_row)
+                    {{
+                        PyErr_SetString(PyExc_ValueError,
+                                        "`piv` holds invalid row interchanges");
+                        Py_DECREF(pc);
+                        {fail};
+                    }}
+                }}
+            }}
+            {solve}
+            Py_DECREF(pc);
+        }}
+        """
+
+    def c_code_cache_version(self):
+        return (1,) + super().c_code_cache_version()
+
+
+def lu_solve(lu_and_piv, b, check_finite=True):
+    """Solve ``A x = b`` given the ``(lu, piv)`` decomposition of ``A`` from `lu_factor`."""
+    lu, piv = lu_and_piv
+    return LUSolve(check_finite=check_finite)(lu, piv, b)
+
+
+class CachedFactorization(Op):
+    """Reuse the last outputs of the factorization `op` while its input is unchanged.
+
+    The rewrites in `aesara.tensor.linalg_opt` use it for matrices computed
+    from shared variables only, so that calls which leave those values
+    unchanged skip the factorization.  Each thunk keeps a copy of the last
+    input and outputs; comparing the input with that copy costs
+    :math:`O(n^2)`, against the :math:`O(n^3)` of a factorization.
+    """
+
+    __props__ = ("op",)
+
+    def __init__(self, op):
+        self.op = op
+
+    def __str__(self):
+        return f"CachedFactorization{{{self.op}}}"
+
+    def make_node(self, *inputs):
+        node = self.op.make_node(*inputs)
+        return Apply(self, node.inputs, [o.type() for o in node.outputs])
+
+    def infer_shape(self, fgraph, node, shapes):
+        return self.op.infer_shape(fgraph, self.op.make_node(*node.inputs), shapes)
+
+    def perform(self, node, inputs, outputs):
+        self.op.perform(self.op.make_node(*node.inputs), inputs, outputs)
+
+    def make_thunk(self, node, storage_map, compute_map, no_recycling, impl=None):
+        inner = self.op.make_node(*node.inputs)
+        inner_storage = {v: storage_map[v] for v in node.inputs}
+        inner_compute = {v: compute_map[v] for v in node.inputs}
+        for v in inner.outputs:
+            inner_storage[v] = [None]
+            inner_compute[v] = [False]
+        inner_thunk = self.op.make_thunk(
+            inner, inner_storage, inner_compute, [], impl=impl
+        )
+
+        input_storage = [storage_map[v] for v in node.inputs]
+        output_storage = [storage_map[v] for v in node.outputs]
+        inner_output_storage = [inner_storage[v] for v in inner.outputs]
+        cache = {}
+
+        @is_thunk_type
+        def thunk():
+            inputs = [s[0] for s in input_storage]
+            cached_inputs = cache.get("inputs")
+            if cached_inputs is None or not all(
+                x.shape == c.shape and x.dtype == c.dtype and np.array_equal(x, c)
+                for x, c in zip(inputs, cached_inputs)
+            ):
+                inner_thunk()
+                cache["inputs"] = [np.array(x, copy=True) for x in inputs]
+                cache["outputs"] = [np.array(s[0]) for s in inner_output_storage]
+            # The outputs may be destroyed by the `Op`s that use them
+            for s, o in zip(output_storage, cache["outputs"]):
+                s[0] = o.copy()
+            for o in node.outputs:
+                compute_map[o][0] = True
+
+        thunk.inputs = input_storage
+        thunk.outputs = output_storage
+        thunk.lazy = False
+        return thunk
+
+
 # TODO: These are deprecated; emit a warning
 solve_lower_triangular = SolveTriangular(lower=True)
 solve_upper_triangular = SolveTriangular(lower=False)
 solve_symmetric = Solve(assume_a="sym")
 
-# TODO: Optimizations to replace multiplication by matrix inverse
-#      with solve() Op (still unwritten)
-
 
 class Eigvalsh(Op):
     """
@@ -748,6 +1237,8 @@ expm = Expm()
 __all__ = [
     "cholesky",
     "solve",
+    "lu_factor",
+    "lu_solve",
     "solve_lower_triangular",
     "solve_upper_triangular",
     "solve_symmetric",
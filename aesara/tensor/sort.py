@@ -1,14 +1,15 @@
 import numpy as np
 
+from aesara.configdefaults import config
 from aesara.gradient import grad_undefined
 from aesara.graph.basic import Apply, Constant
-from aesara.graph.op import Op
+from aesara.link.c.op import OpenMPOp
 from aesara.misc.safe_asarray import _asarray
 from aesara.tensor.basic import arange, as_tensor_variable, flatten, switch
 from aesara.tensor.math import eq, ge, mul
 from aesara.tensor.shape import shape
 from aesara.tensor.subtensor import set_subtensor
-from aesara.tensor.type import TensorType, integer_dtypes
+from aesara.tensor.type import TensorType, discrete_dtypes, integer_dtypes
 
 
 def _variable_is_none(var):
@@ -24,15 +25,311 @@ def _check_tensor_is_scalar(var):
         raise ValueError(msg % (var, var.ndim))
 
 
-class SortOp(Op):
+# The dtypes whose keys can be compared with the C `<` operator.
+_c_sort_dtypes = discrete_dtypes + ["float32", "float64"]
+
+
+def _sort_c_support_code():
+    """Return the C++ helpers shared by the sorting `Op`\\s.
+
+    Each row along the sorted axis is copied into a contiguous per-thread
+    buffer before being ordered.  NaNs compare greater than every other value,
+    as in NumPy, and ties between keys are broken by their position so that
+    the results do not depend on the algorithm or on the number of threads.
+
+    """
+    return """
+    // Byte offset of row `r` of an array whose rows run along `axis`.
+    static inline npy_intp aesara_sort_row_offset(npy_intp r, int nd, int axis,
+                                                  const npy_intp* dims,
+                                                  const npy_intp* strides)
+    {
+        npy_intp offset = 0;
+        int d;
+        for (d = nd - 1; d >= 0; d--) {
+            if (d == axis)
+                continue;
+            offset += (r % dims[d]) * strides[d];
+            r /= dims[d];
+        }
+        return offset;
+    }
+
+    template <typename T>
+    static inline bool aesara_sort_value_lt(T a, T b)
+    {
+        return a < b || (b != b && a == a);
+    }
+
+    template <typename T>
+    struct aesara_sort_pair {
+        T v;
+        npy_intp i;
+    };
+
+    template <typename T>
+    struct aesara_sort_pair_cmp {
+        bool largest;
+        aesara_sort_pair_cmp(bool largest) : largest(largest) {}
+        bool operator()(const aesara_sort_pair<T>& a,
+                        const aesara_sort_pair<T>& b) const
+        {
+            const T& lo = largest ? b.v : a.v;
+            const T& hi = largest ? a.v : b.v;
+            if (aesara_sort_value_lt(lo, hi))
+                return true;
+            if (aesara_sort_value_lt(hi, lo))
+                return false;
+            return a.i < b.i;
+        }
+    };
+
+    // Sort the `n` keys of a row into `buf`.  NaNs are moved to the end
+    // first, so the remaining keys are sorted with the plain `<` operator.
+    template <typename T>
+    static void aesara_sort_row(const char* src, npy_intp stride, npy_intp n,
+                                T* buf)
+    {
+        npy_intp i, m = 0, tail = n;
+        for (i = 0; i < n; i++) {
+            T v = *(const T*)(src + i * stride);
+            if (v == v)
+                buf[m++] = v;
+            else
+                buf[--tail] = v;
+        }
+        std::sort(buf, buf + m);
+    }
+
+    // Fill `buf` with the keys of a row and their positions.
+    template <typename T>
+    static void aesara_sort_load_pairs(const char* src, npy_intp stride,
+                                       npy_intp n, aesara_sort_pair<T>* buf)
+    {
+        npy_intp i;
+        for (i = 0; i < n; i++) {
+            buf[i].v = *(const T*)(src + i * stride);
+            buf[i].i = i;
+        }
+    }
+
+    template <typename T>
+    static void aesara_argsort_row(const char* src, npy_intp stride, npy_intp n,
+                                   aesara_sort_pair<T>* buf)
+    {
+        aesara_sort_load_pairs(src, stride, n, buf);
+        std::sort(buf, buf + n, aesara_sort_pair_cmp<T>(false));
+    }
+
+    // Move the `k` largest (or smallest) keys of a row to the front of `buf`.
+    // A heap selection is used when `k` is small compared to the row, and an
+    // introselect otherwise.  The heap selection always sorts its output.
+    template <typename T>
+    static void aesara_topk_row(const char* src, npy_intp stride, npy_intp n,
+                                npy_intp k, bool largest, bool sorted,
+                                aesara_sort_pair<T>* buf)
+    {
+        aesara_sort_pair_cmp<T> cmp(largest);
+        aesara_sort_load_pairs(src, stride, n, buf);
+        if (k < n && k <= n / 16) {
+            std::partial_sort(buf, buf + k, buf + n, cmp);
+        }
+        else {
+            if (k < n)
+                std::nth_element(buf, buf + k - 1, buf + n, cmp);
+            if (sorted)
+                std::sort(buf, buf + k, cmp);
+        }
+    }
+    """
+
+
+def _sort_rows_c_code(
+    node, x, outputs, setup_code, len_code, buf_t, kernel, openmp, sub
+):
+    """Return the C code applying `kernel` to every row along the sorted axis.
+
+    `setup_code` must set ``axis_value`` (and may declare variables used by
+    the kernel), and `len_code` must set ``out_n``, the output length along
+    the axis of length ``n``.  `outputs` is a list of ``(name,
+    typenum)`` pairs; the kernel reads the row at ``src`` (with stride
+    ``x_step``) into ``buf`` and writes it to ``dst0``, ``dst1``, ... (with
+    strides ``step0``, ``step1``, ...).
+
+    """
+    nd = node.inputs[0].ndim
+    if openmp:
+        omp_parallel = (
+            "#pragma omp parallel if(n_rows > 1 && PyArray_SIZE(%s) >= %d)"
+            % (x, int(config.openmp_elemwise_minsize))
+        )
+        omp_for = "#pragma omp for schedule(static)"
+        omp_atomic_write = "#pragma omp atomic write"
+    else:
+        omp_parallel = omp_for = omp_atomic_write = ""
+
+    alloc_outputs = []
+    row_pointers = []
+    for j, (z, typenum) in enumerate(outputs):
+        alloc_outputs.append(
+            """
+            reuse = (%(z)s != NULL && %(z)s != %(x)s && PyArray_IS_C_CONTIGUOUS(%(z)s));
+            for (d = 0; reuse && d < nd; d++) {
+                reuse = (PyArray_DIMS(%(z)s)[d] == out_dims[d]);
+            }
+            if (!reuse) {
+                Py_XDECREF(%(z)s);
+                %(z)s = (PyArrayObject*)PyArray_EMPTY(nd, out_dims, %(typenum)s, 0);
+                if (%(z)s == NULL) {
+                    %(fail)s
+                }
+            }
+            """
+            % dict(z=z, x=x, typenum=typenum, fail=sub["fail"])
+        )
+        row_pointers.append(
+            """
+            char* dst%(j)d = PyArray_BYTES(%(z)s) + aesara_sort_row_offset(
+                r, nd, ax, out_dims, PyArray_STRIDES(%(z)s));
+            const npy_intp step%(j)d = PyArray_STRIDES(%(z)s)[ax];
+            """
+            % dict(j=j, z=z)
+        )
+
+    return """
+    {
+        const int nd = %(nd)d;
+        npy_intp axis_value;
+        npy_intp n, n_rows, out_n, r;
+        npy_intp out_dims[%(nd)d];
+        int d, reuse, ax, failed = 0;
+
+        %(setup_code)s
+        if (axis_value < -nd || axis_value >= nd) {
+            PyErr_Format(PyExc_ValueError,
+                         "axis %%ld is out of bounds for array of dimension %%d",
+                         (long)axis_value, nd);
+            %(fail)s
+        }
+        ax = (int)(axis_value < 0 ? axis_value + nd : axis_value);
+        n = PyArray_DIMS(%(x)s)[ax];
+        n_rows = n > 0 ? PyArray_SIZE(%(x)s) / n : 0;
+        %(len_code)s
+        for (d = 0; d < nd; d++) {
+            out_dims[d] = (d == ax) ? out_n : PyArray_DIMS(%(x)s)[d];
+        }
+        %(alloc_outputs)s
+
+        %(omp_parallel)s
+        {
+            %(buf_t)s* buf = (%(buf_t)s*)malloc((n > 0 ? n : 1) * sizeof(%(buf_t)s));
+            if (buf == NULL) {
+                %(omp_atomic_write)s
+                failed = 1;
+            }
+            %(omp_for)s
+            for (r = 0; r < n_rows; r++) {
+                const char* src = PyArray_BYTES(%(x)s) + aesara_sort_row_offset(
+                    r, nd, ax, PyArray_DIMS(%(x)s), PyArray_STRIDES(%(x)s));
+                const npy_intp x_step = PyArray_STRIDES(%(x)s)[ax];
+                %(row_pointers)s
+                npy_intp i;
+                if (buf == NULL)
+                    continue;
+                %(kernel)s
+            }
+            free(buf);
+        }
+        if (failed) {
+            PyErr_NoMemory();
+            %(fail)s
+        }
+    }
+    """ % dict(
+        nd=nd,
+        x=x,
+        setup_code=setup_code,
+        len_code=len_code,
+        alloc_outputs="".join(alloc_outputs),
+        row_pointers="".join(row_pointers),
+        buf_t=buf_t,
+        kernel=kernel,
+        omp_parallel=omp_parallel,
+        omp_for=omp_for,
+        omp_atomic_write=omp_atomic_write,
+        fail=sub["fail"],
+    )
+
+
+def _sort_c_code(op, node, inputs, outputs, sub, return_indices):
+    """Return the C code of `SortOp` and `ArgSortOp`."""
+    x, axis = inputs
+    (z,) = outputs
+    x_type = node.inputs[0].type
+    axis_type = node.inputs[1].type
+    if (
+        op.order is not None
+        or x_type.dtype not in _c_sort_dtypes
+        or x_type.ndim == 0
+        or not isinstance(axis_type, TensorType)
+        or axis_type.ndim != 0
+        or axis_type.dtype not in integer_dtypes
+    ):
+        raise NotImplementedError()
+
+    dtype_x = "npy_" + x_type.dtype
+    axis_code = "axis_value = (npy_intp)((npy_%s*)PyArray_DATA(%s))[0];" % (
+        axis_type.dtype,
+        axis,
+    )
+    if return_indices:
+        buf_t = f"aesara_sort_pair<{dtype_x}>"
+        kernel = """
+        aesara_argsort_row(src, x_step, n, buf);
+        for (i = 0; i < n; i++) {
+            *(npy_%(dtype_z)s*)(dst0 + i * step0) = (npy_%(dtype_z)s)buf[i].i;
+        }
+        """ % dict(
+            dtype_z=node.outputs[0].dtype
+        )
+    else:
+        buf_t = dtype_x
+        kernel = """
+        aesara_sort_row(src, x_step, n, buf);
+        for (i = 0; i < n; i++) {
+            *(%(dtype_x)s*)(dst0 + i * step0) = buf[i];
+        }
+        """ % dict(
+            dtype_x=dtype_x
+        )
+
+    return _sort_rows_c_code(
+        node,
+        x,
+        [(z, node.outputs[0].type.dtype_specs()[2])],
+        axis_code,
+        "out_n = n;",
+        buf_t,
+        kernel,
+        op.openmp,
+        sub,
+    )
+
+
+class SortOp(OpenMPOp):
     """
     This class is a wrapper for numpy sort function.
 
+    The C implementation sorts each row along the axis in a contiguous
+    buffer, and the rows are split between OpenMP threads when the input is
+    large enough.  Structured arrays, float16 and complex inputs use NumPy.
+
     """
 
     __props__ = ("kind", "order")
 
-    def __init__(self, kind, order=None):
+    def __init__(self, kind, order=None, openmp=None):
+        super().__init__(openmp=openmp)
         self.kind = kind
         self.order = order
 
@@ -67,6 +364,18 @@ class SortOp(Op):
         assert inputs_shapes[1] == ()
         return [inputs_shapes[0]]
 
+    def c_headers(self, **kwargs):
+        return ["<algorithm>"] + super().c_headers(**kwargs)
+
+    def c_support_code(self, **kwargs):
+        return _sort_c_support_code()
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        return _sort_c_code(self, node, inputs, outputs, sub, return_indices=False)
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
     def grad(self, inputs, output_grads):
         a, axis = inputs
         indices = self.__get_argsort_indices(a, axis)
@@ -157,15 +466,20 @@ def sort(a, axis=-1, kind="quicksort", order=None):
     return SortOp(kind, order)(a, axis)
 
 
-class ArgSortOp(Op):
+class ArgSortOp(OpenMPOp):
     """
     This class is a wrapper for numpy argsort function.
 
+    The C implementation sorts each row along the axis in a contiguous
+    buffer, and the rows are split between OpenMP threads when the input is
+    large enough.  Structured arrays, float16 and complex inputs use NumPy.
+
     """
 
     __props__ = ("kind", "order")
 
-    def __init__(self, kind, order=None):
+    def __init__(self, kind, order=None, openmp=None):
+        super().__init__(openmp=openmp)
         self.kind = kind
         self.order = order
 
@@ -202,6 +516,18 @@ class ArgSortOp(Op):
         assert inputs_shapes[1] == ()
         return [inputs_shapes[0]]
 
+    def c_headers(self, **kwargs):
+        return ["<algorithm>"] + super().c_headers(**kwargs)
+
+    def c_support_code(self, **kwargs):
+        return _sort_c_support_code()
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        return _sort_c_code(self, node, inputs, outputs, sub, return_indices=True)
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
     def grad(self, inputs, output_grads):
         # No grad defined for integers.
         inp, axis = inputs
@@ -253,6 +579,21 @@ def _topk_py_impl(op, x, k, axis, idx_dtype):
         raise ValueError(
             f"topk: kth cannot be larger than the size of specified axis {int(axis)}"
         )
+    if op.sorted:
+        # Order the k largest values by decreasing value (the k smallest by
+        # increasing value), breaking ties by position as the C code does.
+        if k > 0:
+            zi = np.argsort(np.flip(x, axis), axis=axis, kind="stable")
+            zi = x.shape[axis] - 1 - np.flip(zi, axis)
+        else:
+            zi = np.argsort(x, axis=axis, kind="stable")
+        zi = np.take(zi, np.arange(abs(k)), axis=axis)
+        if not op.return_indices:
+            return np.take_along_axis(x, zi, axis)
+        elif op.return_values:
+            return np.take_along_axis(x, zi, axis), zi.astype(idx_dtype)
+        else:
+            return zi.astype(idx_dtype)
     if abs(k) == 1:
         # negative k means min instead of max
         fn_max = [None, np.max, np.min][k]
@@ -291,10 +632,10 @@ def _topk_py_impl(op, x, k, axis, idx_dtype):
     idx[axis] = slice(-k, None) if k > 0 else slice(-k)
 
     if not op.return_indices:
-        zv = np.partition(x, -k, axis=axis)[idx]
+        zv = np.partition(x, -k, axis=axis)[tuple(idx)]
         return zv
     elif op.return_values:
-        zi = np.argpartition(x, -k, axis=axis)[idx]
+        zi = np.argpartition(x, -k, axis=axis)[tuple(idx)]
         idx2 = tuple(
             np.arange(s).reshape((s,) + (1,) * (ndim - i - 1)) if i != axis else zi
             for i, s in enumerate(x.shape)
@@ -302,11 +643,11 @@ def _topk_py_impl(op, x, k, axis, idx_dtype):
         zv = x[idx2]
         return zv, zi.astype(idx_dtype)
     else:
-        zi = np.argpartition(x, -k, axis=axis)[idx]
+        zi = np.argpartition(x, -k, axis=axis)[tuple(idx)]
         return zi.astype(idx_dtype)
 
 
-class TopKOp(Op):
+class TopKOp(OpenMPOp):
     """Operations related to finding k-largest elements.
 
     Parameters
@@ -320,18 +661,19 @@ class TopKOp(Op):
         Specify output dtype for indices, defaults to ``int64``, must be integer type.
 
     sorted: bool
-        NOTE: NOT IMPLEMENTED YET
         Defaults to ``True``
 
-        If True, the result array would be sorted in descending order.
+        If True, the k-largest elements are returned in descending order (the
+        k-smallest ones in ascending order), and equal elements are ordered by
+        position.
 
 
     Notes
     -----
-    - The output order is not guaranteed. On the CPU, we use
-      ``np.partition`` and ``np.argpartition`` that only make sure the
-      k-th element is the correct one and that the other
-      elements are on the correct side.
+    - When ``sorted=False``, the output order is not guaranteed. The C
+      implementation uses a heap selection when k is small compared to
+      the axis length and an introselect otherwise, and splits the rows
+      between OpenMP threads.
     - By default, this Op gives two outputs: values and indices. However
       optimizers may remove a certain output if not needed.
     - Computing the gradient requests the computation of the indices in
@@ -356,7 +698,6 @@ class TopKOp(Op):
 
     """
 
-    # TODO c_code
     # TODO add opt, if k==1, use max/min reduce
     #      also if k is axis size, just copy input tensor
     # TODO add opt, to merge argtopk / topk
@@ -369,15 +710,13 @@ class TopKOp(Op):
         idx_dtype="int64",
         return_values=True,
         return_indices=True,
+        openmp=None,
     ):
+        super().__init__(openmp=openmp)
         # numpy always uses int64 as output dtype for arg*() routines
         # however, we add "idx_dtype" param as memory is more precious on gpu
         if not isinstance(axis, int):
             raise TypeError(f'"axis" parameter must be integer, got "{type(axis)}"')
-        if sorted:
-            raise NotImplementedError(
-                "The sorted parameter is not yet implemented. Use sorted=False for now."
-            )
         if idx_dtype not in integer_dtypes:
             raise TypeError(
                 f'"idx_dtype" parameter must be an integer dtype, got "{idx_dtype}"'
@@ -439,6 +778,73 @@ class TopKOp(Op):
         shp = tuple(shp)
         return [shp for i in [self.return_values, self.return_indices] if i]
 
+    def c_headers(self, **kwargs):
+        return ["<algorithm>"] + super().c_headers(**kwargs)
+
+    def c_support_code(self, **kwargs):
+        return _sort_c_support_code()
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        x, k = inputs
+        x_type = node.inputs[0].type
+        if x_type.dtype not in _c_sort_dtypes:
+            raise NotImplementedError()
+
+        dtype_x = "npy_" + x_type.dtype
+        len_code = """
+        {
+            npy_intp k = (npy_intp)((npy_%(dtype_k)s*)PyArray_DATA(%(k)s))[0];
+            if (k == 0) {
+                PyErr_SetString(PyExc_ValueError, "topk: kth cannot be zero");
+                %(fail)s
+            }
+            largest = k > 0;
+            out_n = largest ? k : -k;
+            if (out_n > n) {
+                PyErr_Format(PyExc_ValueError,
+                             "topk: kth cannot be larger than the size of specified axis %%d",
+                             ax);
+                %(fail)s
+            }
+        }
+        """ % dict(
+            dtype_k=node.inputs[1].dtype, k=k, fail=sub["fail"]
+        )
+
+        writes = []
+        if self.return_values:
+            writes.append(
+                f"*({dtype_x}*)(dst{len(writes)} + i * step{len(writes)}) = buf[i].v;"
+            )
+        if self.return_indices:
+            dtype_i = "npy_" + node.outputs[-1].dtype
+            writes.append(
+                f"*({dtype_i}*)(dst{len(writes)} + i * step{len(writes)}) = ({dtype_i})buf[i].i;"
+            )
+        kernel = """
+        aesara_topk_row(src, x_step, n, out_n, largest, %(sorted)s, buf);
+        for (i = 0; i < out_n; i++) {
+            %(writes)s
+        }
+        """ % dict(
+            sorted="true" if self.sorted else "false", writes="\n".join(writes)
+        )
+
+        return _sort_rows_c_code(
+            node,
+            x,
+            [(z, v.type.dtype_specs()[2]) for z, v in zip(outputs, node.outputs)],
+            "bool largest;\naxis_value = %d;" % self.axis,
+            len_code,
+            f"aesara_sort_pair<{dtype_x}>",
+            kernel,
+            self.openmp,
+            sub,
+        )
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
     def L_op(self, inputs, outputs, out_grads):
         x, k = inputs
         k_grad = grad_undefined(self, 1, k, "topk: k is not differentiable")
@@ -484,10 +890,10 @@ def topk(x, kth, axis=-1, sorted=True, idx_dtype="int64"):
         If ``None``, works on flattened array.
 
     sorted: bool
-        NOTE: NOT IMPLEMENTED YET, USE ``False`` FOR NOW.
         Defaults to ``True``
 
-        If True, the result array would be sorted in descending order.
+        If True, the result array would be sorted in descending order
+        (ascending order for the k-smallest elements).
 
     idx_dtype: string
         Specify output dtype used in indices, defaults to ``int64``, must be integer type.
@@ -497,10 +903,6 @@ def topk(x, kth, axis=-1, sorted=True, idx_dtype="int64"):
     -------
     Tensor variable with same dtype as `x`.
 
-    Notes
-    -----
-    - ``sorted=True`` is not supported yet.
-
     """
     if axis is None:
         x = flatten(x)
@@ -521,10 +923,10 @@ def argtopk(x, kth, axis=-1, sorted=True, idx_dtype="int64"):
         Must not be 0. If negative, gives k-smallest elements instead.
 
     sorted: bool
-        NOTE: NOT IMPLEMENTED YET, USE ``False`` FOR NOW.
         Defaults to ``True``
 
         If True, the result array of corresponding indices would be sorted in descending order.
+        Equal elements are then ordered by position.
 
 
     axis: integer, tuple/list of integers, or ``None``
@@ -540,10 +942,8 @@ def argtopk(x, kth, axis=-1, sorted=True, idx_dtype="int64"):
 
     Notes
     -----
-    - ``sorted=True`` is not supported yet.
-
-    - If the top-k-th value is not unique, we cannot guarantee the output
-      indices are deterministically chosen.
+    - If ``sorted=False`` and the top-k-th value is not unique, we cannot
+      guarantee the output indices are deterministically chosen.
 
     """
     if axis is None:
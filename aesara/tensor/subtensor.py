@@ -11,10 +11,9 @@ from aesara import scalar as aes
 from aesara.configdefaults import config
 from aesara.gradient import DisconnectedType
 from aesara.graph.basic import Apply, Constant, Variable
-from aesara.graph.op import Op
 from aesara.graph.type import Type
 from aesara.graph.utils import MethodNotDefined
-from aesara.link.c.op import COp
+from aesara.link.c.op import COp, OpenMPOp
 from aesara.link.c.params_type import ParamsType
 from aesara.misc.safe_asarray import _asarray
 from aesara.printing import Printer, pprint, set_precedence
@@ -1702,7 +1701,7 @@ class IncSubtensor(COp):
     def c_code_cache_version(self):
         hv = Subtensor.helper_c_code_cache_version()
         if hv:
-            return (3, hv)
+            return (4, hv)
         else:
             return ()
 
@@ -1730,7 +1729,7 @@ class IncSubtensor(COp):
         # max_depth: we pass 0 to have this parameter ignored
         # requirements: here we pass NPY_ARRAY_ENSURECOPY to force a copy
         # context: this is almost always NULL, I'm not sure what it's used for
-        return f"""(PyArrayObject*)PyArray_FromAny(py_{x}, NULL, 0, 0,
+        return f"""(PyArrayObject*)PyArray_FromAny((PyObject*){x}, NULL, 0, 0,
                 NPY_ARRAY_ENSURECOPY, NULL)"""
 
     def make_view_array(self, x, view_ndim):
@@ -1911,10 +1910,14 @@ def _sum_grad_over_bcasted_dims(x, gx):
     return gx
 
 
-class AdvancedSubtensor1(COp):
+class AdvancedSubtensor1(OpenMPOp):
     """
     Implement x[ilist] where ilist is a vector of integers.
 
+    When ``x`` is C-contiguous, the C implementation copies the selected
+    rows directly, checking the indices while it copies them.  The copy is
+    split between OpenMP threads when the output is large enough.
+
     """
 
     # sparse_grad doesn't go in here since it only affects the output
@@ -1923,7 +1926,8 @@ class AdvancedSubtensor1(COp):
     _f16_ok = True
     check_input = False
 
-    def __init__(self, sparse_grad=False):
+    def __init__(self, sparse_grad=False, openmp=None):
+        super().__init__(openmp=openmp)
         self.sparse_grad = sparse_grad
 
     def make_node(self, x, ilist):
@@ -2026,8 +2030,13 @@ class AdvancedSubtensor1(COp):
         a_name, i_name = input_names[0], input_names[1]
         output_name = output_names[0]
         fail = sub["fail"]
+        gather_rows = self.c_code_gather_rows(node, a_name, i_name, output_name, sub)
         return (
             """
+            {
+            int gathered = 0;
+            %(gather_rows)s
+            if (!gathered) {
             PyArrayObject *indices;
             int i_type = PyArray_TYPE(%(i_name)s);
             if (i_type != NPY_INTP) {
@@ -2102,35 +2111,185 @@ class AdvancedSubtensor1(COp):
                         %(a_name)s, (PyObject*)indices, 0, %(output_name)s, NPY_RAISE);
             Py_DECREF(indices);
             if (%(output_name)s == NULL) %(fail)s;
+            }
+            }
         """
             % locals()
         )
 
+    def c_code_gather_rows(self, node, a_name, i_name, output_name, sub):
+        """Return C code copying the selected rows of a C-contiguous array.
+
+        The generated code sets ``gathered`` to 1 when it handled the
+        indexing, and leaves it to 0 when `a_name` is not C-contiguous, in
+        which case ``PyArray_TakeFrom`` is used.
+
+        """
+        if self.openmp:
+            omp_parallel = (
+                "#pragma omp parallel for schedule(static) if(out_size >= min_size)"
+            )
+            omp_atomic_write = "#pragma omp atomic write"
+        else:
+            omp_parallel = omp_atomic_write = ""
+
+        idx_dtype = node.inputs[1].dtype
+        if idx_dtype in ("uint64",):
+            # Avoid wrapping around the largest unsigned values.
+            idx_check = "(npy_uint64)raw >= (npy_uint64)n_rows"
+        elif idx_dtype.startswith("uint"):
+            idx_check = "raw >= n_rows"
+        else:
+            idx_check = "raw < -n_rows || raw >= n_rows"
+
+        return """
+        if (PyArray_IS_C_CONTIGUOUS(%(a_name)s) && PyArray_ISALIGNED(%(a_name)s)) {
+            const int x_nd = PyArray_NDIM(%(a_name)s);
+            const npy_intp n_rows = PyArray_DIMS(%(a_name)s)[0];
+            const npy_intp n_idx = PyArray_DIMS(%(i_name)s)[0];
+            const char* idx_data = PyArray_BYTES(%(i_name)s);
+            const npy_intp idx_stride = PyArray_STRIDES(%(i_name)s)[0];
+            npy_intp out_dims[NPY_MAXDIMS];
+            npy_intp row_size = 1;
+            npy_intp out_size;
+            const npy_intp min_size = %(min_size)s;
+            // Position of an out of bounds index, if any.
+            npy_intp bad_pos = -1;
+            int d, reuse_out;
+            const %(dtype_t)s* x_data;
+            %(dtype_t)s* out_data;
+            npy_intp j;
+
+            out_dims[0] = n_idx;
+            for (d = 1; d < x_nd; d++) {
+                out_dims[d] = PyArray_DIMS(%(a_name)s)[d];
+                row_size *= out_dims[d];
+            }
+            out_size = n_idx * row_size;
+
+            reuse_out = (%(output_name)s != NULL &&
+                         PyArray_NDIM(%(output_name)s) == x_nd &&
+                         PyArray_IS_C_CONTIGUOUS(%(output_name)s) &&
+                         PyArray_ISALIGNED(%(output_name)s) &&
+                         %(output_name)s != %(a_name)s);
+            for (d = 0; reuse_out && d < x_nd; d++) {
+                reuse_out = (PyArray_DIMS(%(output_name)s)[d] == out_dims[d]);
+            }
+            if (!reuse_out) {
+                Py_XDECREF(%(output_name)s);
+                %(output_name)s = (PyArrayObject*)PyArray_EMPTY(
+                    x_nd, out_dims, PyArray_TYPE(%(a_name)s), 0);
+                if (%(output_name)s == NULL) {
+                    %(fail)s
+                }
+            }
+
+            x_data = (const %(dtype_t)s*)PyArray_DATA(%(a_name)s);
+            out_data = (%(dtype_t)s*)PyArray_DATA(%(output_name)s);
+
+            if (row_size == 1) {
+                %(omp_parallel)s
+                for (j = 0; j < n_idx; j++) {
+                    const %(idx_t)s raw = *(const %(idx_t)s*)(idx_data + j * idx_stride);
+                    npy_intp r = (npy_intp)raw;
+                    if (%(idx_check)s) {
+                        %(omp_atomic_write)s
+                        bad_pos = j;
+                        continue;
+                    }
+                    if (r < 0) r += n_rows;
+                    out_data[j] = x_data[r];
+                }
+            }
+            else {
+                const size_t row_bytes = row_size * sizeof(%(dtype_t)s);
+                %(omp_parallel)s
+                for (j = 0; j < n_idx; j++) {
+                    const %(idx_t)s raw = *(const %(idx_t)s*)(idx_data + j * idx_stride);
+                    npy_intp r = (npy_intp)raw;
+                    if (%(idx_check)s) {
+                        %(omp_atomic_write)s
+                        bad_pos = j;
+                        continue;
+                    }
+                    if (r < 0) r += n_rows;
+                    memcpy(out_data + j * row_size, x_data + r * row_size, row_bytes);
+                }
+            }
+
+            if (bad_pos >= 0) {
+                // Look up the first invalid index again for the message, as
+                // `bad_pos` is not the first one when the loop ran in parallel.
+                for (j = 0; j < n_idx; j++) {
+                    const %(idx_t)s raw = *(const %(idx_t)s*)(idx_data + j * idx_stride);
+                    if (%(idx_check)s) {
+                        PyErr_Format(PyExc_IndexError,
+                                     "index %%lld is out of bounds for axis 0 with size %%lld",
+                                     (long long)raw, (long long)n_rows);
+                        break;
+                    }
+                }
+                %(fail)s
+            }
+            gathered = 1;
+        }
+        """ % dict(
+            a_name=a_name,
+            i_name=i_name,
+            output_name=output_name,
+            dtype_t="npy_" + node.inputs[0].dtype,
+            idx_t="npy_" + idx_dtype,
+            idx_check=idx_check,
+            omp_parallel=omp_parallel,
+            omp_atomic_write=omp_atomic_write,
+            min_size=int(config.openmp_elemwise_minsize),
+            fail=sub["fail"],
+        )
+
     def c_code_cache_version(self):
-        return (0, 1, 2)
+        return (1, self.openmp, config.openmp_elemwise_minsize)
 
 
 advanced_subtensor1 = AdvancedSubtensor1()
 
 
-class AdvancedIncSubtensor1(COp):
+class AdvancedIncSubtensor1(OpenMPOp):
     """
     Increments a subtensor using advanced slicing (list of index).
 
+    When the output and ``y`` are C-contiguous and share a dtype, the C
+    implementation scatters whole rows with a dedicated kernel instead of
+    going through NumPy's mapping iterator.  With OpenMP enabled, the
+    flattened output is split between threads, so that each thread only
+    writes the part of the rows it owns and the updates are applied in the
+    same order as the sequential loop.  When ``config.deterministic`` is
+    ``"default"``, increments of narrow rows are instead distributed over the
+    indices and applied with atomic updates, which does not guarantee the
+    summation order for duplicated indices.
+
     """
 
     __props__ = ("inplace", "set_instead_of_inc")
     check_input = False
     params_type = ParamsType(inplace=aes.bool, set_instead_of_inc=aes.bool)
 
-    def __init__(self, inplace=False, set_instead_of_inc=False):
+    # Rows narrower than this are incremented with atomic updates distributed
+    # over the indices when non-deterministic results are allowed.
+    atomic_max_row_size = 16
+
+    def __init__(self, inplace=False, set_instead_of_inc=False, openmp=None):
+        super().__init__(openmp=openmp)
         self.inplace = bool(inplace)
         self.set_instead_of_inc = bool(set_instead_of_inc)
         if inplace:
             self.destroy_map = {0: [0]}
 
     def clone_inplace(self):
-        return self.__class__(inplace=True, set_instead_of_inc=self.set_instead_of_inc)
+        return self.__class__(
+            inplace=True,
+            set_instead_of_inc=self.set_instead_of_inc,
+            openmp=self.openmp,
+        )
 
     def __str__(self):
         if self.inplace:
@@ -2191,7 +2350,7 @@ class AdvancedIncSubtensor1(COp):
         # max_depth: we pass 0 to have this parameter ignored
         # requirements: here we pass NPY_ARRAY_ENSURECOPY to force a copy
         # context: this is almost always NULL, I'm not sure what it's used for
-        return f"""(PyArrayObject*)PyArray_FromAny(py_{x}, NULL, 0, 0,
+        return f"""(PyArrayObject*)PyArray_FromAny((PyObject*){x}, NULL, 0, 0,
                 NPY_ARRAY_ENSURECOPY, NULL)"""
 
     def c_support_code(self, **kwargs):
@@ -2414,8 +2573,13 @@ class AdvancedIncSubtensor1(COp):
                 %(fail)s
             }
         }
-        if (inplace_increment(%(out)s, (PyObject *)%(idx)s, %(y)s, (1 - %(params)s->set_instead_of_inc))) {
-            %(fail)s;
+        {
+            int scattered = 0;
+            %(scatter_rows)s
+            if (!scattered &&
+                inplace_increment(%(out)s, (PyObject *)%(idx)s, %(y)s, (1 - %(params)s->set_instead_of_inc))) {
+                %(fail)s;
+            }
         }
         Py_XDECREF(rval);
         """ % dict(
@@ -2424,12 +2588,208 @@ class AdvancedIncSubtensor1(COp):
             idx=idx,
             out=out,
             copy_of_x=copy_of_x,
+            scatter_rows=self.c_code_scatter_rows(node, x, y, idx, out, sub),
+            params=sub["params"],
+            fail=sub["fail"],
+        )
+
+    def c_code_scatter_rows(self, node, x, y, idx, out, sub):
+        """Return C code scattering contiguous rows of `y` into `out`.
+
+        The generated code sets ``scattered`` to 1 when it handled the
+        update.  It leaves it to 0 for layouts and dtypes it does not cover,
+        in which case the generic ``inplace_increment`` is used.
+
+        """
+        dtype = node.outputs[0].dtype
+        if (
+            self.__class__ is not AdvancedIncSubtensor1
+            or node.inputs[1].dtype != dtype
+            or dtype == "float16"
+            or dtype in complex_dtypes
+            or dtype == "bool"
+        ):
+            return ""
+
+        if self.openmp:
+            omp_owner = "#pragma omp parallel if(work >= min_work)"
+            omp_atomic_for = (
+                "#pragma omp parallel for schedule(static) if(work >= min_work)"
+            )
+            omp_atomic = "#pragma omp atomic"
+            n_threads = "omp_get_num_threads()"
+            thread_id = "omp_get_thread_num()"
+        else:
+            omp_owner = omp_atomic_for = omp_atomic = ""
+            n_threads = "1"
+            thread_id = "0"
+
+        # The `atomic` path reorders the additions of duplicated indices, so it
+        # is only compiled in when the user did not ask for determinism.
+        use_atomic = int(self.openmp and config.deterministic == "default")
+        idx_dtype = node.inputs[2].dtype
+        if idx_dtype in ("uint64",):
+            # Avoid wrapping around the largest unsigned values.
+            idx_check = "(npy_uint64)raw >= (npy_uint64)n_rows"
+        elif idx_dtype.startswith("uint"):
+            idx_check = "raw >= n_rows"
+        else:
+            idx_check = "raw < -n_rows || raw >= n_rows"
+
+        return """
+        {
+            const int x_nd = PyArray_NDIM(%(out)s);
+            const int y_nd = PyArray_NDIM(%(y)s);
+            const npy_intp n_rows = PyArray_DIMS(%(out)s)[0];
+            const npy_intp n_idx = PyArray_DIMS(%(idx)s)[0];
+            npy_intp row_size = 1;
+            // Distance, in elements, between the rows of `y` used for two
+            // consecutive indices.  -1 means the layout is not supported.
+            npy_intp y_row_stride = -1;
+            int d;
+
+            for (d = 1; d < x_nd; d++) {
+                row_size *= PyArray_DIMS(%(out)s)[d];
+            }
+
+            if (PyArray_IS_C_CONTIGUOUS(%(out)s) &&
+                PyArray_IS_C_CONTIGUOUS(%(y)s) &&
+                PyArray_ISALIGNED(%(out)s) && PyArray_ISALIGNED(%(y)s) &&
+                PyArray_ISNOTSWAPPED(%(out)s) && PyArray_ISNOTSWAPPED(%(y)s)) {
+                if (y_nd == x_nd &&
+                    (PyArray_DIMS(%(y)s)[0] == n_idx ||
+                     PyArray_DIMS(%(y)s)[0] == 1)) {
+                    y_row_stride = (PyArray_DIMS(%(y)s)[0] == 1) ? 0 : row_size;
+                    for (d = 1; d < x_nd; d++) {
+                        if (PyArray_DIMS(%(y)s)[d] != PyArray_DIMS(%(out)s)[d]) {
+                            y_row_stride = -1;
+                        }
+                    }
+                }
+                else if (y_nd == x_nd - 1) {
+                    y_row_stride = 0;
+                    for (d = 1; d < x_nd; d++) {
+                        if (PyArray_DIMS(%(y)s)[d - 1] != PyArray_DIMS(%(out)s)[d]) {
+                            y_row_stride = -1;
+                        }
+                    }
+                }
+            }
+
+            if (y_row_stride >= 0) {
+                // `y` may be a view of the destination when working inplace.
+                const char* x_begin = PyArray_BYTES(%(out)s);
+                const char* x_end = x_begin + PyArray_NBYTES(%(out)s);
+                const char* y_begin = PyArray_BYTES(%(y)s);
+                const char* y_end = y_begin + PyArray_NBYTES(%(y)s);
+                if (y_begin < x_end && x_begin < y_end) {
+                    y_row_stride = -1;
+                }
+            }
+
+            if (y_row_stride >= 0) {
+                const char* idx_data = PyArray_BYTES(%(idx)s);
+                const npy_intp idx_stride = PyArray_STRIDES(%(idx)s)[0];
+                %(dtype_t)s* out_data = (%(dtype_t)s*)PyArray_DATA(%(out)s);
+                const %(dtype_t)s* y_data = (const %(dtype_t)s*)PyArray_DATA(%(y)s);
+                const int set_instead_of_inc = %(params)s->set_instead_of_inc;
+                const npy_intp work = n_idx * row_size;
+                const npy_intp min_work = %(min_work)s;
+                npy_intp j;
+
+                // Validate all the indices before touching the output, so
+                // that an out of bounds index leaves it unchanged.
+                for (j = 0; j < n_idx; j++) {
+                    const %(idx_t)s raw = *(const %(idx_t)s*)(idx_data + j * idx_stride);
+                    if (%(idx_check)s) {
+                        PyErr_Format(PyExc_IndexError,
+                                     "index %%lld is out of bounds for axis 0 with size %%lld",
+                                     (long long)raw, (long long)n_rows);
+                        %(fail)s
+                    }
+                }
+
+                if (%(use_atomic)s && !set_instead_of_inc &&
+                    row_size < %(atomic_max_row_size)s) {
+                    %(omp_atomic_for)s
+                    for (j = 0; j < n_idx; j++) {
+                        npy_intp r = (npy_intp)*(const %(idx_t)s*)(idx_data + j * idx_stride);
+                        npy_intp k;
+                        %(dtype_t)s* dst;
+                        const %(dtype_t)s* src = y_data + j * y_row_stride;
+                        if (r < 0) r += n_rows;
+                        dst = out_data + r * row_size;
+                        for (k = 0; k < row_size; k++) {
+                            %(omp_atomic)s
+                            dst[k] += src[k];
+                        }
+                    }
+                }
+                else {
+                    // Each thread owns a contiguous block of the flattened
+                    // output and applies, in order, the part of every
+                    // selected row that falls in that block.
+                    %(omp_owner)s
+                    {
+                        const npy_intp n_threads = %(n_threads)s;
+                        const npy_intp tid = %(thread_id)s;
+                        const npy_intp total = n_rows * row_size;
+                        const npy_intp own_begin = total / n_threads * tid +
+                            (tid < total %% n_threads ? tid : total %% n_threads);
+                        const npy_intp own_end = own_begin + total / n_threads +
+                            (tid < total %% n_threads ? 1 : 0);
+                        npy_intp jj;
+                        for (jj = 0; jj < n_idx; jj++) {
+                            npy_intp r = (npy_intp)*(const %(idx_t)s*)(idx_data + jj * idx_stride);
+                            npy_intp begin, end, k;
+                            %(dtype_t)s* dst;
+                            const %(dtype_t)s* src;
+                            if (r < 0) r += n_rows;
+                            begin = r * row_size;
+                            end = begin + row_size;
+                            if (begin < own_begin) begin = own_begin;
+                            if (end > own_end) end = own_end;
+                            if (begin >= end) continue;
+                            dst = out_data + begin;
+                            src = y_data + jj * y_row_stride + (begin - r * row_size);
+                            if (set_instead_of_inc) {
+                                for (k = 0; k < end - begin; k++) {
+                                    dst[k] = src[k];
+                                }
+                            }
+                            else {
+                                for (k = 0; k < end - begin; k++) {
+                                    dst[k] += src[k];
+                                }
+                            }
+                        }
+                    }
+                }
+                scattered = 1;
+            }
+        }
+        """ % dict(
+            x=x,
+            y=y,
+            idx=idx,
+            out=out,
+            dtype_t="npy_" + dtype,
+            idx_t="npy_" + idx_dtype,
+            idx_check=idx_check,
+            use_atomic=use_atomic,
+            atomic_max_row_size=self.atomic_max_row_size,
+            min_work=int(config.openmp_elemwise_minsize),
+            omp_owner=omp_owner,
+            omp_atomic_for=omp_atomic_for,
+            omp_atomic=omp_atomic,
+            n_threads=n_threads,
+            thread_id=thread_id,
             params=sub["params"],
             fail=sub["fail"],
         )
 
     def c_code_cache_version(self):
-        return (8,)
+        return (10, self.openmp, config.deterministic, config.openmp_elemwise_minsize)
 
     def perform(self, node, inp, out_, params):
         x, y, idx = inp
@@ -2529,8 +2889,333 @@ def check_advanced_indexing_dimensions(input, idx_list):
             dim_seen += 1
 
 
-class AdvancedSubtensor(Op):
-    """Implements NumPy's advanced indexing."""
+def _advanced_indexing_c_support_code():
+    """Return the C helpers shared by `AdvancedSubtensor` and `AdvancedIncSubtensor`.
+
+    ``aesara_adv_index_init`` decomposes an indexing operation ``x[index]``
+    made of slices, integer arrays and boolean masks into three tables of
+    byte offsets into ``x``: one for the result dimensions that come before
+    the broadcasted index dimensions, one for the positions in the
+    broadcasted index arrays and one for the result dimensions that come
+    after them.  Every element of the result is then located at
+    ``outer_off[o] + pos_off[p] + inner_off[i]``.
+
+    """
+    return """
+    typedef struct {
+        int nd;
+        npy_intp dims[NPY_MAXDIMS];
+        // Number of result dimensions in each of the three groups.
+        int n_outer_dims, n_pos_dims, n_inner_dims;
+        npy_intp n_outer, n_pos, n_inner;
+        npy_intp *outer_off, *pos_off, *inner_off;
+    } aesara_adv_index;
+
+    static void aesara_adv_index_clear(aesara_adv_index* ai)
+    {
+        PyMem_Free(ai->outer_off);
+        PyMem_Free(ai->pos_off);
+        PyMem_Free(ai->inner_off);
+        ai->outer_off = ai->pos_off = ai->inner_off = NULL;
+    }
+
+    /* Fill `off` with the offsets of all the positions of a strided
+       block of `nd` dimensions, in C order. */
+    static void aesara_adv_index_block_offsets(int nd, const npy_intp* dims,
+                                               const npy_intp* strides,
+                                               npy_intp base, npy_intp* off)
+    {
+        npy_intp counter[NPY_MAXDIMS];
+        npy_intp n = 1, k;
+        int d;
+        for (d = 0; d < nd; d++) {
+            counter[d] = 0;
+            n *= dims[d];
+        }
+        for (k = 0; k < n; k++) {
+            off[k] = base;
+            for (d = nd - 1; d >= 0; d--) {
+                if (++counter[d] < dims[d]) {
+                    base += strides[d];
+                    break;
+                }
+                counter[d] = 0;
+                base -= strides[d] * (dims[d] - 1);
+            }
+        }
+    }
+
+    /* Fill the offset tables for an array whose dimensions match the
+       result of `ai`, given its byte strides along each result dimension. */
+    static int aesara_adv_index_strided_offsets(const aesara_adv_index* ai,
+                                                const npy_intp* strides,
+                                                npy_intp** outer_off,
+                                                npy_intp** pos_off,
+                                                npy_intp** inner_off)
+    {
+        *outer_off = (npy_intp*)PyMem_Malloc(sizeof(npy_intp) * (ai->n_outer + 1));
+        *pos_off = (npy_intp*)PyMem_Malloc(sizeof(npy_intp) * (ai->n_pos + 1));
+        *inner_off = (npy_intp*)PyMem_Malloc(sizeof(npy_intp) * (ai->n_inner + 1));
+        if (*outer_off == NULL || *pos_off == NULL || *inner_off == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        aesara_adv_index_block_offsets(ai->n_outer_dims, ai->dims, strides, 0,
+                                       *outer_off);
+        aesara_adv_index_block_offsets(ai->n_pos_dims,
+                                       ai->dims + ai->n_outer_dims,
+                                       strides + ai->n_outer_dims, 0, *pos_off);
+        aesara_adv_index_block_offsets(
+            ai->n_inner_dims, ai->dims + ai->n_outer_dims + ai->n_pos_dims,
+            strides + ai->n_outer_dims + ai->n_pos_dims, 0, *inner_off);
+        return 0;
+    }
+
+    /* `x[key] += y`, with NumPy's semantic for duplicated indices. */
+    static int aesara_adv_index_iadd(PyObject* x, PyObject* key, PyObject* y)
+    {
+        PyObject* sub = PyObject_GetItem(x, key);
+        PyObject* res;
+        int rval;
+        if (sub == NULL) {
+            return -1;
+        }
+        res = PyNumber_InPlaceAdd(sub, y);
+        Py_DECREF(sub);
+        if (res == NULL) {
+            return -1;
+        }
+        rval = PyObject_SetItem(x, key, res);
+        Py_DECREF(res);
+        return rval;
+    }
+
+    /* `numpy.add.at(x, key, y)`, which accumulates duplicated indices. */
+    static int aesara_adv_index_add_at(PyObject* x, PyObject* key, PyObject* y)
+    {
+        PyObject* numpy = PyImport_ImportModule("numpy");
+        PyObject* add;
+        PyObject* res;
+        if (numpy == NULL) {
+            return -1;
+        }
+        add = PyObject_GetAttrString(numpy, "add");
+        Py_DECREF(numpy);
+        if (add == NULL) {
+            return -1;
+        }
+        res = PyObject_CallMethod(add, "at", "OOO", x, key, y);
+        Py_DECREF(add);
+        if (res == NULL) {
+            return -1;
+        }
+        Py_DECREF(res);
+        return 0;
+    }
+
+    /* Returns 0 on success, -1 with an exception set on error, and 1 when
+       the index contains entries (e.g. `None`) that are not handled here. */
+    static int aesara_adv_index_init(aesara_adv_index* ai, PyArrayObject* x,
+                                     PyObject** index, int n_index)
+    {
+        const int x_nd = PyArray_NDIM(x);
+        const npy_intp* x_dims = PyArray_DIMS(x);
+        const npy_intp* x_strides = PyArray_STRIDES(x);
+        // Integer index arrays (boolean masks are converted to their
+        // nonzero coordinates), and the axis of `x` each one indexes.
+        PyObject* adv[NPY_MAXDIMS];
+        int adv_axis[NPY_MAXDIMS];
+        int n_adv = 0;
+        int is_sliced[NPY_MAXDIMS];
+        npy_intp sl_start[NPY_MAXDIMS], sl_step[NPY_MAXDIMS], sl_len[NPY_MAXDIMS];
+        npy_intp strides[NPY_MAXDIMS];
+        npy_intp base = 0;
+        PyArrayMultiIterObject* mit = NULL;
+        int first_adv = -1, last_adv = -1, adjacent = 1;
+        int axis = 0, k, d, j, nd;
+        int rval = -1;
+
+        ai->outer_off = ai->pos_off = ai->inner_off = NULL;
+
+        for (k = 0; k < n_index; k++) {
+            PyObject* obj = index[k];
+            if (PySlice_Check(obj)) {
+                Py_ssize_t start, stop, step;
+                if (axis >= x_nd) {
+                    PyErr_SetString(PyExc_IndexError, "too many indices for array");
+                    goto done;
+                }
+                if (PySlice_Unpack(obj, &start, &stop, &step) < 0) {
+                    goto done;
+                }
+                sl_len[axis] = PySlice_AdjustIndices(x_dims[axis], &start, &stop, step);
+                sl_start[axis] = start;
+                sl_step[axis] = step;
+                is_sliced[axis] = 1;
+                axis++;
+            }
+            else if (PyArray_Check(obj) &&
+                     PyArray_TYPE((PyArrayObject*)obj) == NPY_BOOL &&
+                     PyArray_NDIM((PyArrayObject*)obj) > 0) {
+                PyArrayObject* mask = (PyArrayObject*)obj;
+                PyObject* nonzero;
+                nd = PyArray_NDIM(mask);
+                if (axis + nd > x_nd) {
+                    PyErr_SetString(PyExc_IndexError, "too many indices for array");
+                    goto done;
+                }
+                for (d = 0; d < nd; d++) {
+                    if (PyArray_DIMS(mask)[d] != x_dims[axis + d]) {
+                        PyErr_Format(PyExc_IndexError,
+                                     "boolean index did not match indexed array "
+                                     "along dimension %d; dimension is %lld but "
+                                     "corresponding boolean dimension is %lld",
+                                     axis + d, (long long)x_dims[axis + d],
+                                     (long long)PyArray_DIMS(mask)[d]);
+                        goto done;
+                    }
+                }
+                nonzero = PyArray_Nonzero(mask);
+                if (nonzero == NULL) {
+                    goto done;
+                }
+                for (d = 0; d < nd; d++) {
+                    adv[n_adv] = PyTuple_GET_ITEM(nonzero, d);
+                    Py_INCREF(adv[n_adv]);
+                    adv_axis[n_adv++] = axis;
+                    is_sliced[axis++] = 0;
+                }
+                Py_DECREF(nonzero);
+            }
+            else if (PyArray_Check(obj) &&
+                     PyArray_ISINTEGER((PyArrayObject*)obj)) {
+                if (axis >= x_nd) {
+                    PyErr_SetString(PyExc_IndexError, "too many indices for array");
+                    goto done;
+                }
+                adv[n_adv] = PyArray_FROM_OTF(obj, NPY_INTP,
+                                              NPY_ARRAY_ALIGNED | NPY_ARRAY_FORCECAST);
+                if (adv[n_adv] == NULL) {
+                    goto done;
+                }
+                adv_axis[n_adv++] = axis;
+                is_sliced[axis++] = 0;
+            }
+            else {
+                rval = 1;
+                goto done;
+            }
+        }
+        for (; axis < x_nd; axis++) {
+            sl_start[axis] = 0;
+            sl_step[axis] = 1;
+            sl_len[axis] = x_dims[axis];
+            is_sliced[axis] = 1;
+        }
+
+        // NumPy puts the broadcasted index dimensions in place of the indexed
+        // axes when those are adjacent, and in front of the result otherwise.
+        for (d = 0; d < x_nd; d++) {
+            if (!is_sliced[d]) {
+                if (first_adv < 0) first_adv = d;
+                else if (last_adv != d - 1) adjacent = 0;
+                last_adv = d;
+            }
+        }
+        if (n_adv == 0 || !adjacent) {
+            first_adv = 0;
+        }
+
+        // Byte strides in `x` along the result dimensions, 0 for the
+        // dimensions coming from the index arrays.
+        ai->nd = 0;
+        ai->n_outer = ai->n_pos = ai->n_inner = 1;
+        ai->n_outer_dims = ai->n_pos_dims = ai->n_inner_dims = 0;
+        for (d = 0; d < x_nd; d++) {
+            if (is_sliced[d]) base += sl_start[d] * x_strides[d];
+        }
+        for (d = 0; d < first_adv; d++) {
+            strides[ai->nd] = x_strides[d] * sl_step[d];
+            ai->dims[ai->nd++] = sl_len[d];
+            ai->n_outer *= sl_len[d];
+            ai->n_outer_dims++;
+        }
+        if (n_adv > 0) {
+            mit = (PyArrayMultiIterObject*)PyArray_MultiIterFromObjects(adv, n_adv, 0);
+            if (mit == NULL) {
+                goto done;
+            }
+            if (ai->nd + mit->nd > NPY_MAXDIMS) {
+                PyErr_SetString(PyExc_IndexError, "too many dimensions in the result");
+                goto done;
+            }
+            for (d = 0; d < mit->nd; d++) {
+                strides[ai->nd] = 0;
+                ai->dims[ai->nd++] = mit->dimensions[d];
+            }
+            ai->n_pos_dims = mit->nd;
+            ai->n_pos = mit->size;
+        }
+        for (d = first_adv; d < x_nd; d++) {
+            if (!is_sliced[d]) continue;
+            strides[ai->nd] = x_strides[d] * sl_step[d];
+            ai->dims[ai->nd++] = sl_len[d];
+            ai->n_inner *= sl_len[d];
+            ai->n_inner_dims++;
+        }
+
+        if (aesara_adv_index_strided_offsets(ai, strides, &ai->outer_off,
+                                             &ai->pos_off, &ai->inner_off)) {
+            goto done;
+        }
+        for (j = 0; j < ai->n_outer; j++) {
+            ai->outer_off[j] += base;
+        }
+
+        if (mit != NULL) {
+            npy_intp p = 0;
+            while (PyArray_MultiIter_NOTDONE(mit)) {
+                npy_intp off = 0;
+                for (j = 0; j < n_adv; j++) {
+                    npy_intp i = *(npy_intp*)PyArray_MultiIter_DATA(mit, j);
+                    const npy_intp dim = x_dims[adv_axis[j]];
+                    if (i < -dim || i >= dim) {
+                        PyErr_Format(PyExc_IndexError,
+                                     "index %lld is out of bounds for axis %d with size %lld",
+                                     (long long)i, adv_axis[j], (long long)dim);
+                        goto done;
+                    }
+                    if (i < 0) i += dim;
+                    off += i * x_strides[adv_axis[j]];
+                }
+                ai->pos_off[p++] = off;
+                PyArray_MultiIter_NEXT(mit);
+            }
+        }
+        rval = 0;
+
+    done:
+        Py_XDECREF(mit);
+        for (j = 0; j < n_adv; j++) {
+            Py_DECREF(adv[j]);
+        }
+        if (rval != 0) {
+            aesara_adv_index_clear(ai);
+        }
+        return rval;
+    }
+    """
+
+
+class AdvancedSubtensor(OpenMPOp):
+    """Implements NumPy's advanced indexing.
+
+    The C implementation handles any combination of slices, integer arrays
+    and boolean masks, and uses NumPy's indexing for the other cases (e.g.
+    `None` entries).  The copy is split between OpenMP threads when the
+    result is large enough.
+
+    """
 
     __props__ = ()
 
@@ -2632,18 +3317,149 @@ class AdvancedSubtensor(Op):
             rest
         )
 
+    def c_support_code(self, **kwargs):
+        return _advanced_indexing_c_support_code()
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        x, *index = inputs
+        (out,) = outputs
+        if self.openmp:
+            omp_parallel = (
+                "#pragma omp parallel for schedule(static) if(n_outer * n_pos * n_inner >= %d)"
+                % int(config.openmp_elemwise_minsize)
+            )
+        else:
+            omp_parallel = ""
+
+        return """
+        {
+            PyObject* index[%(n_index)s + 1] = {%(index_objs)s};
+            aesara_adv_index ai;
+            int status = aesara_adv_index_init(&ai, %(x)s, index, %(n_index)s);
+            if (status < 0) {
+                %(fail)s
+            }
+            if (status == 1) {
+                // Let NumPy handle the indices we do not support.
+                PyObject* key = PyTuple_New(%(n_index)s);
+                PyObject* rval;
+                int k;
+                if (key == NULL) {
+                    %(fail)s
+                }
+                for (k = 0; k < %(n_index)s; k++) {
+                    Py_INCREF(index[k]);
+                    PyTuple_SET_ITEM(key, k, index[k]);
+                }
+                rval = PyObject_GetItem((PyObject*)%(x)s, key);
+                Py_DECREF(key);
+                if (rval == NULL) {
+                    %(fail)s
+                }
+                Py_XDECREF(%(out)s);
+                if (PyArray_Check(rval) && PyArray_BASE((PyArrayObject*)rval) == NULL) {
+                    %(out)s = (PyArrayObject*)rval;
+                }
+                else {
+                    // Basic indexing returned a view of `x`.
+                    %(out)s = (PyArrayObject*)PyArray_FromAny(
+                        rval, NULL, 0, 0, NPY_ARRAY_ENSUREARRAY | NPY_ARRAY_ENSURECOPY, NULL);
+                    Py_DECREF(rval);
+                    if (%(out)s == NULL) {
+                        %(fail)s
+                    }
+                }
+            }
+            else {
+                const npy_intp n_outer = ai.n_outer, n_pos = ai.n_pos, n_inner = ai.n_inner;
+                const char* x_data = PyArray_BYTES(%(x)s);
+                %(dtype_t)s* out_data;
+                int inner_contiguous = 1;
+                int d, reuse_out;
+                npy_intp t, i;
+
+                reuse_out = (%(out)s != NULL && PyArray_NDIM(%(out)s) == ai.nd &&
+                             PyArray_IS_C_CONTIGUOUS(%(out)s) &&
+                             PyArray_ISALIGNED(%(out)s));
+                for (d = 0; reuse_out && d < ai.nd; d++) {
+                    reuse_out = (PyArray_DIMS(%(out)s)[d] == ai.dims[d]);
+                }
+                if (!reuse_out) {
+                    Py_XDECREF(%(out)s);
+                    %(out)s = (PyArrayObject*)PyArray_EMPTY(ai.nd, ai.dims,
+                                                            PyArray_TYPE(%(x)s), 0);
+                    if (%(out)s == NULL) {
+                        aesara_adv_index_clear(&ai);
+                        %(fail)s
+                    }
+                }
+                out_data = (%(dtype_t)s*)PyArray_DATA(%(out)s);
+
+                for (i = 0; i < n_inner; i++) {
+                    if (ai.inner_off[i] != i * (npy_intp)sizeof(%(dtype_t)s)) {
+                        inner_contiguous = 0;
+                        break;
+                    }
+                }
+
+                %(omp_parallel)s
+                for (t = 0; t < n_outer * n_pos; t++) {
+                    const char* src = x_data + ai.outer_off[t / n_pos] + ai.pos_off[t %% n_pos];
+                    %(dtype_t)s* dst = out_data + t * n_inner;
+                    if (inner_contiguous) {
+                        memcpy(dst, src, n_inner * sizeof(%(dtype_t)s));
+                    }
+                    else {
+                        npy_intp ii;
+                        for (ii = 0; ii < n_inner; ii++) {
+                            dst[ii] = *(const %(dtype_t)s*)(src + ai.inner_off[ii]);
+                        }
+                    }
+                }
+                aesara_adv_index_clear(&ai);
+            }
+        }
+        """ % dict(
+            x=x,
+            out=out,
+            n_index=len(index),
+            index_objs=", ".join(f"(PyObject*){i}" for i in index),
+            dtype_t="npy_" + node.outputs[0].dtype,
+            omp_parallel=omp_parallel,
+            fail=sub["fail"],
+        )
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
 
 advanced_subtensor = AdvancedSubtensor()
 
 
-class AdvancedIncSubtensor(Op):
-    """Increments a subtensor using advanced indexing."""
+class AdvancedIncSubtensor(OpenMPOp):
+    """Increments a subtensor using advanced indexing.
+
+    The C implementation handles the same indices as the one of
+    `AdvancedSubtensor`.  Duplicated indices are accumulated in order: the
+    threads split the positions of the result that do not come from the
+    index arrays, so that no two threads write to the same element.
+
+    """
 
     __props__ = ("inplace", "set_instead_of_inc", "ignore_duplicates")
 
+    # Number of consecutive result elements, outside of the index
+    # dimensions, updated by a thread at a time.
+    c_block_size = 1024
+
     def __init__(
-        self, inplace=False, set_instead_of_inc=False, ignore_duplicates=False
+        self,
+        inplace=False,
+        set_instead_of_inc=False,
+        ignore_duplicates=False,
+        openmp=None,
     ):
+        super().__init__(openmp=openmp)
         self.set_instead_of_inc = set_instead_of_inc
         self.inplace = inplace
         if inplace:
@@ -2732,6 +3548,236 @@ class AdvancedIncSubtensor(Op):
             gy = _sum_grad_over_bcasted_dims(y, gy)
         return [gx, gy] + [DisconnectedType()() for _ in idxs]
 
+    def c_support_code(self, **kwargs):
+        return _advanced_indexing_c_support_code()
+
+    def c_code(self, node, name, inputs, outputs, sub):
+        dtype = node.outputs[0].dtype
+        if not self.set_instead_of_inc and (
+            dtype in ("float16", "bool") or dtype in complex_dtypes
+        ):
+            raise NotImplementedError()
+
+        x, y, *index = inputs
+        (out,) = outputs
+        if self.inplace:
+            prepare_out = f"""
+            if ({x} != {out}) {{
+                Py_XDECREF({out});
+                Py_INCREF({x});
+                {out} = {x};
+            }}
+            """
+        else:
+            prepare_out = f"""
+            Py_XDECREF({out});
+            {out} = (PyArrayObject*)PyArray_FromAny((PyObject*){x}, NULL, 0, 0,
+                                                    NPY_ARRAY_ENSURECOPY, NULL);
+            if (!{out}) {{
+                {sub["fail"]}
+            }}
+            """
+
+        if self.set_instead_of_inc:
+            update = "="
+            fallback = "PyObject_SetItem((PyObject*)%(out)s, key, (PyObject*)%(y)s)"
+        elif self.ignore_duplicates:
+            # Like NumPy's `x[idx] += y`, all the sums are computed from the
+            # original values before being written back.
+            update = "="
+            fallback = (
+                "aesara_adv_index_iadd((PyObject*)%(out)s, key, (PyObject*)%(y)s)"
+            )
+        else:
+            update = "+="
+            fallback = (
+                "aesara_adv_index_add_at((PyObject*)%(out)s, key, (PyObject*)%(y)s)"
+            )
+        fallback = fallback % dict(out=out, y=y)
+
+        if self.openmp:
+            omp_parallel = (
+                "#pragma omp parallel for schedule(static) if(n_outer * n_pos * n_inner >= %d)"
+                % int(config.openmp_elemwise_minsize)
+            )
+        else:
+            omp_parallel = ""
+
+        if self.ignore_duplicates and not self.set_instead_of_inc:
+            buffer_sums = """
+                // Compute all the sums in a buffer laid out like the
+                // indexed result, then set them as if it were `y`.
+                sums = (%(dtype_t)s*)PyMem_Malloc(
+                    sizeof(%(dtype_t)s) * (n_outer * n_pos * n_inner + 1));
+                if (sums == NULL) {
+                    PyErr_NoMemory();
+                    PyMem_Free(y_outer_off);
+                    PyMem_Free(y_pos_off);
+                    PyMem_Free(y_inner_off);
+                    Py_DECREF(y_arr);
+                    aesara_adv_index_clear(&ai);
+                    %(fail)s
+                }
+                %(omp_parallel)s
+                for (t = 0; t < n_outer * n_pos; t++) {
+                    const npy_intp o = t / n_pos, p = t %% n_pos;
+                    const char* dst = out_data + ai.outer_off[o] + ai.pos_off[p];
+                    const char* src = y_data + y_outer_off[o] + y_pos_off[p];
+                    npy_intp i;
+                    for (i = 0; i < n_inner; i++) {
+                        sums[t * n_inner + i] =
+                            *(const %(dtype_t)s*)(dst + ai.inner_off[i]) +
+                            *(const %(dtype_t)s*)(src + y_inner_off[i]);
+                    }
+                }
+                for (t = 0; t < n_outer; t++) {
+                    y_outer_off[t] = t * n_pos * n_inner * sizeof(%(dtype_t)s);
+                }
+                for (t = 0; t < n_pos; t++) {
+                    y_pos_off[t] = t * n_inner * sizeof(%(dtype_t)s);
+                }
+                for (t = 0; t < n_inner; t++) {
+                    y_inner_off[t] = t * sizeof(%(dtype_t)s);
+                }
+                y_data = (const char*)sums;
+            """ % dict(
+                dtype_t="npy_" + dtype, omp_parallel=omp_parallel, fail=sub["fail"]
+            )
+        else:
+            buffer_sums = ""
+
+        return """
+        %(prepare_out)s
+        {
+            PyObject* index[%(n_index)s + 1] = {%(index_objs)s};
+            aesara_adv_index ai;
+            int status = aesara_adv_index_init(&ai, %(out)s, index, %(n_index)s);
+            if (status < 0) {
+                %(fail)s
+            }
+            if (status == 1) {
+                // Let NumPy handle the indices we do not support.
+                PyObject* key = PyTuple_New(%(n_index)s);
+                int k;
+                if (key == NULL) {
+                    %(fail)s
+                }
+                for (k = 0; k < %(n_index)s; k++) {
+                    Py_INCREF(index[k]);
+                    PyTuple_SET_ITEM(key, k, index[k]);
+                }
+                status = %(fallback)s;
+                Py_DECREF(key);
+                if (status < 0) {
+                    %(fail)s
+                }
+            }
+            else {
+                const npy_intp n_outer = ai.n_outer, n_pos = ai.n_pos, n_inner = ai.n_inner;
+                const npy_intp block = %(block_size)s;
+                const npy_intp n_blocks = (n_inner + block - 1) / block;
+                npy_intp y_strides[NPY_MAXDIMS];
+                npy_intp *y_outer_off = NULL, *y_pos_off = NULL, *y_inner_off = NULL;
+                PyArrayObject* y_arr;
+                %(dtype_t)s* sums = NULL;
+                char* out_data = PyArray_BYTES(%(out)s);
+                const char* y_data;
+                int d, y_nd;
+                npy_intp t;
+
+                Py_INCREF(PyArray_DESCR(%(out)s));
+                y_arr = (PyArrayObject*)PyArray_FromAny(
+                    (PyObject*)%(y)s, PyArray_DESCR(%(out)s), 0, 0,
+                    NPY_ARRAY_FORCECAST | NPY_ARRAY_ALIGNED | NPY_ARRAY_NOTSWAPPED, NULL);
+                if (y_arr == NULL) {
+                    aesara_adv_index_clear(&ai);
+                    %(fail)s
+                }
+
+                // Broadcast `y` against the indexed result.
+                y_nd = PyArray_NDIM(y_arr);
+                status = 0;
+                for (d = 0; d < y_nd - ai.nd; d++) {
+                    if (PyArray_DIMS(y_arr)[d] != 1) status = -1;
+                }
+                for (d = 0; d < ai.nd; d++) {
+                    const int yd = d - (ai.nd - y_nd);
+                    if (yd < 0 || PyArray_DIMS(y_arr)[yd] == 1) {
+                        y_strides[d] = 0;
+                    }
+                    else if (PyArray_DIMS(y_arr)[yd] == ai.dims[d]) {
+                        y_strides[d] = PyArray_STRIDES(y_arr)[yd];
+                    }
+                    else {
+                        status = -1;
+                    }
+                }
+                if (status < 0) {
+                    PyErr_SetString(PyExc_ValueError,
+                                    "shape mismatch: value array could not be "
+                                    "broadcast to indexing result");
+                }
+                else {
+                    status = aesara_adv_index_strided_offsets(
+                        &ai, y_strides, &y_outer_off, &y_pos_off, &y_inner_off);
+                }
+                if (status < 0) {
+                    PyMem_Free(y_outer_off);
+                    PyMem_Free(y_pos_off);
+                    PyMem_Free(y_inner_off);
+                    Py_DECREF(y_arr);
+                    aesara_adv_index_clear(&ai);
+                    %(fail)s
+                }
+                y_data = PyArray_BYTES(y_arr);
+
+                %(buffer_sums)s
+
+                // Each iteration owns a block of result positions and
+                // applies the updates of all the index positions to it in
+                // order, so duplicated indices never race.
+                %(omp_parallel)s
+                for (t = 0; t < n_outer * n_blocks; t++) {
+                    const npy_intp o = t / n_blocks;
+                    const npy_intp begin = (t %% n_blocks) * block;
+                    const npy_intp end = (begin + block < n_inner) ? begin + block : n_inner;
+                    npy_intp p, i;
+                    for (p = 0; p < n_pos; p++) {
+                        char* dst = out_data + ai.outer_off[o] + ai.pos_off[p];
+                        const char* src = y_data + y_outer_off[o] + y_pos_off[p];
+                        for (i = begin; i < end; i++) {
+                            *(%(dtype_t)s*)(dst + ai.inner_off[i]) %(update)s
+                                *(const %(dtype_t)s*)(src + y_inner_off[i]);
+                        }
+                    }
+                }
+
+                PyMem_Free(sums);
+                PyMem_Free(y_outer_off);
+                PyMem_Free(y_pos_off);
+                PyMem_Free(y_inner_off);
+                Py_DECREF(y_arr);
+                aesara_adv_index_clear(&ai);
+            }
+        }
+        """ % dict(
+            prepare_out=prepare_out,
+            y=y,
+            out=out,
+            n_index=len(index),
+            index_objs=", ".join(f"(PyObject*){i}" for i in index),
+            dtype_t="npy_" + dtype,
+            update=update,
+            buffer_sums=buffer_sums,
+            fallback=fallback,
+            block_size=self.c_block_size,
+            omp_parallel=omp_parallel,
+            fail=sub["fail"],
+        )
+
+    def c_code_cache_version(self):
+        return (1, self.openmp, config.openmp_elemwise_minsize)
+
 
 advanced_inc_subtensor = AdvancedIncSubtensor()
 advanced_set_subtensor = AdvancedIncSubtensor(set_instead_of_inc=True)
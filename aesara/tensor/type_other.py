@@ -9,7 +9,7 @@ from aesara import _as_symbolic
 from aesara.gradient import DisconnectedType
 from aesara.graph.basic import Apply, Constant, Variable
 from aesara.graph.op import Op
-from aesara.link.c.type import Generic, Type
+from aesara.link.c.type import Generic
 from aesara.tensor.type import integer_dtypes
 
 
@@ -51,7 +51,12 @@ class MakeSlice(Op):
 make_slice = MakeSlice()
 
 
-class SliceType(Type):
+class SliceType(Generic):
+    """
+    Inherit from Generic so that `COp`s can receive slices as ``PyObject*``.
+
+    """
+
     def clone(self, **kwargs):
         return type(self)()
 
@@ -61,6 +66,9 @@ class SliceType(Type):
         else:
             raise TypeError("Expected a slice!")
 
+    def is_valid_value(self, a):
+        return isinstance(a, slice)
+
     def __str__(self):
         return "slice"
 
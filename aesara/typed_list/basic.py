@@ -102,6 +102,17 @@ class GetItem(COp):
         x_name, index = inp[0], inp[1]
         output_name = out[0]
         fail = sub["fail"]
+        if isinstance(node.inputs[1].type, SliceType):
+            return (
+                """
+        Py_XDECREF(%(output_name)s);
+        %(output_name)s = (typeof %(output_name)s) PyObject_GetItem( (PyObject*) %(x_name)s, %(index)s);
+        if(%(output_name)s == NULL){
+            %(fail)s
+        }
+        """
+                % locals()
+            )
         return (
             """
         %(output_name)s = (typeof %(output_name)s) PyList_GetItem( (PyObject*) %(x_name)s, *((npy_int64 *) PyArray_DATA(%(index)s)));
@@ -114,7 +125,7 @@ class GetItem(COp):
         )
 
     def c_code_cache_version(self):
-        return (1,)
+        return (2,)
 
 
 getitem = GetItem()
@@ -1,5 +1,7 @@
 import contextlib
 import inspect
+import os
+from functools import reduce
 from unittest import mock
 
 import numba
@@ -18,21 +20,26 @@ import aesara.tensor.nnet.basic as nnetb
 import aesara.tensor.random.basic as aer
 from aesara import config, shared
 from aesara.compile.function import function
+from aesara.compile.io import Out
 from aesara.compile.mode import Mode
 from aesara.compile.ops import ViewOp, deep_copy_op
 from aesara.compile.sharedvalue import SharedVariable
+from aesara.gradient import grad
 from aesara.graph.basic import Apply, Constant
 from aesara.graph.fg import FunctionGraph
 from aesara.graph.op import Op, get_test_value
 from aesara.graph.optdb import OptimizationQuery
 from aesara.graph.type import Type
 from aesara.ifelse import ifelse
+from aesara.link.numba.cache import get_cache_dir, get_cache_key
 from aesara.link.numba.dispatch import basic as numba_basic
 from aesara.link.numba.dispatch import numba_typify
 from aesara.link.numba.linker import NumbaLinker
+from aesara.link.utils import compile_function_src
 from aesara.raise_op import assert_op
 from aesara.scalar.basic import Composite
 from aesara.scan.basic import scan
+from aesara.scan.op import Scan
 from aesara.scan.utils import until
 from aesara.tensor import blas
 from aesara.tensor import elemwise as at_elemwise
@@ -1208,6 +1215,187 @@ def test_CAReduce(careduce_fn, axis, v):
     )
 
 
+@pytest.mark.parametrize("parallel", [False, True])
+@pytest.mark.parametrize(
+    "careduce_fn, elemwise_fn, axis",
+    [
+        (Sum, lambda x, y: (x - y) * x, None),
+        (Sum, lambda x, y: (x - y) * x, 0),
+        (Sum, lambda x, y: at.exp(x) * y, (0, 2)),
+        (Max, lambda x, y: x * y, 1),
+        (Min, lambda x, y: x + y, (1, 2)),
+        (Prod, lambda x, y: x / 2 + y, 2),
+        (All, lambda x, y: x > y, 0),
+        (Any, lambda x, y: x > y, None),
+    ],
+)
+def test_FusedCAReduce(careduce_fn, elemwise_fn, axis, parallel):
+    x = set_test_value(at.tensor3(), rng.normal(size=(5, 3, 4)).astype(config.floatX))
+    y = set_test_value(
+        at.tensor(config.floatX, shape=(True, False, True)),
+        rng.normal(size=(1, 3, 1)).astype(config.floatX),
+    )
+    e = elemwise_fn(x, y)
+    g = careduce_fn(axis=axis)(e)
+    g_fg = FunctionGraph(
+        outputs=[at_elemwise.FusedCAReduce(e.owner.op, g.owner.op)(*e.owner.inputs)]
+    )
+
+    with config.change_flags(numba__parallel=parallel):
+        compare_numba_and_py(
+            g_fg,
+            [
+                i.tag.test_value
+                for i in g_fg.inputs
+                if not isinstance(i, (SharedVariable, Constant))
+            ],
+        )
+
+
+def test_FusedCAReduce_errors():
+    x = at.matrix()
+    with pytest.raises(ValueError):
+        at_elemwise.FusedCAReduce(ati.exp_inplace, Sum())
+    with pytest.raises(TypeError):
+        at_elemwise.FusedCAReduce(Elemwise(aes.exp), at.exp)
+    with pytest.raises(TypeError, match="doesn't fit"):
+        # `Sum` sets its dtypes in `make_node`
+        at_elemwise.FusedCAReduce(Elemwise(aes.exp), Sum())(x)
+
+    with config.change_flags(numba__parallel=True):
+        y = at.matrix()
+        fn = function([x, y], (x + y).sum(axis=0), mode="NUMBA")
+        with pytest.raises(ValueError, match="Input dimension mismatch"):
+            fn(np.ones((2, 3), config.floatX), np.ones((2, 2), config.floatX))
+
+
+def test_careduce_fusion():
+    x = at.matrix()
+    y = at.vector()
+    out = at.sqr(x - y).sum(axis=1)
+    fn = function([x, y], [out, at.exp(x).max()], mode="NUMBA")
+    nodes = fn.maker.fgraph.toposort()
+    assert [type(n.op) for n in nodes].count(at_elemwise.FusedCAReduce) == 2
+
+    x_val = rng.normal(size=(4, 3)).astype(config.floatX)
+    y_val = rng.normal(size=3).astype(config.floatX)
+    res, res_max = fn(x_val, y_val)
+    np.testing.assert_allclose(res, ((x_val - y_val) ** 2).sum(axis=1), rtol=1e-5)
+    np.testing.assert_allclose(res_max, np.exp(x_val).max(), rtol=1e-5)
+
+    # The intermediate array is needed by the other output
+    fn = function([x, y], [out, at.sqr(x - y)], mode="NUMBA")
+    nodes = fn.maker.fgraph.toposort()
+    assert not any(isinstance(n.op, at_elemwise.FusedCAReduce) for n in nodes)
+
+
+@pytest.mark.parametrize(
+    "fn, shape",
+    [
+        (lambda x, y: at.exp(x) + y, (6, 3)),
+        (lambda x, y: at.sum(x * y, axis=0), (6, 3)),
+        (lambda x, y: at.max(x, axis=1), (6, 3)),
+        (lambda x, y: at.prod(x, axis=None), (6, 3)),
+        (lambda x, y: ati.add_inplace(at.exp(x), y), (6, 3)),
+        (lambda x, y: at.sum(at.cast(x * 4, "int16"), axis=0), (6, 3)),
+        (lambda x, y: at.sum(x * y, axis=0), (0, 3)),
+    ],
+)
+def test_parallel_loop_nests(fn, shape):
+    x = set_test_value(at.matrix(), rng.normal(size=shape).astype(config.floatX))
+    y = set_test_value(at.row(), rng.normal(size=(1, 3)).astype(config.floatX))
+    g_fg = FunctionGraph(outputs=[fn(x, y)])
+
+    with config.change_flags(numba__parallel=True):
+        compare_numba_and_py(
+            g_fg, [i.tag.test_value for i in g_fg.inputs if not isinstance(i, Constant)]
+        )
+
+
+@pytest.mark.parametrize("ndim", [0, 1])
+def test_Elemwise_many_operands(ndim):
+    # `numba.vectorize` can't create ufuncs with more than 32 operands
+    inputs = [at.tensor(config.floatX, (False,) * ndim) for i in range(40)]
+    scalar_inputs = [aes.get_scalar_type(config.floatX)() for i in range(40)]
+    composite = Composite(scalar_inputs, [reduce(aes.add, scalar_inputs)])
+    fn = function(inputs, Elemwise(composite)(*inputs), mode=numba_mode)
+
+    input_vals = [rng.normal(size=(3,) * ndim).astype(config.floatX) for i in inputs]
+    np.testing.assert_allclose(fn(*input_vals), np.sum(input_vals, axis=0), rtol=1e-5)
+
+
+def test_find_output_buffers():
+    x = at.matrix("x")
+    a = at.exp(x)
+    b = at.log(a)
+    c = at.sin(b)
+    d = c * 2
+    fg = FunctionGraph([x], [d], clone=False)
+    order = fg.toposort()
+
+    buffers = numba_basic.find_output_buffers(fg, order)
+    assert buffers == {c.owner: a, d.owner: b}
+
+    # A view of `a` keeps it alive until `e` is computed
+    v = a.T
+    e = at.log(x)
+    f = at.sin(e) + v
+    fg = FunctionGraph([x], [f], clone=False)
+    order = fg.toposort()
+
+    buffers = numba_basic.find_output_buffers(fg, order)
+    assert buffers == {f.owner: e}
+
+    # Without free arrays, the nodes reuse the previous values of the outputs
+    # that can hold their arrays
+    g = at.exp(x).T
+    fg = FunctionGraph([x], [g], clone=False)
+    order = fg.toposort()
+
+    assert numba_basic.find_output_buffers(fg, order) == {}
+    buffers = numba_basic.find_output_buffers(fg, order, reuse_outputs=True)
+    assert buffers == {g.owner.inputs[0].owner: g}
+
+
+@pytest.mark.parametrize("parallel", [False, True])
+def test_output_buffers(parallel):
+    x = at.matrix("x")
+    y = at.row("y")
+    a = at.exp(x) + y
+    out = at.sin(at.log(a)) * 2
+    out_sum = (a * x).sum(axis=0)
+    mode = Mode(NumbaLinker(allow_gc=False), opts)
+
+    with config.change_flags(numba__parallel=parallel):
+        fn = function(
+            [x, y],
+            [Out(out, borrow=True), Out(out_sum, borrow=True)],
+            mode=mode,
+        )
+
+    def ref(x_val, y_val):
+        a_val = np.exp(x_val) + y_val
+        return np.sin(np.log(a_val)) * 2, (a_val * x_val).sum(axis=0)
+
+    x_val = rng.normal(size=(4, 3)).astype(config.floatX)
+    y_val = rng.normal(size=(1, 3)).astype(config.floatX)
+    res = fn(x_val, y_val)
+    for r, r_ref in zip(res, ref(x_val, y_val)):
+        np.testing.assert_allclose(r, r_ref, rtol=1e-5)
+
+    # The array of the previous call is reused by the loop nests
+    new_res = fn(x_val + 1, y_val)
+    assert np.shares_memory(new_res[1], res[1]) == parallel
+    for r, r_ref in zip(new_res, ref(x_val + 1, y_val)):
+        np.testing.assert_allclose(r, r_ref, rtol=1e-5)
+
+    # New arrays are allocated when the shapes change
+    x_val = rng.normal(size=(2, 5)).astype(config.floatX)
+    y_val = rng.normal(size=(1, 5)).astype(config.floatX)
+    for r, r_ref in zip(fn(x_val, y_val), ref(x_val, y_val)):
+        np.testing.assert_allclose(r, r_ref, rtol=1e-5)
+
+
 @pytest.mark.parametrize(
     "vals, axis",
     [
@@ -1891,6 +2079,16 @@ def test_UnravelIndex(arr, shape, order, exc):
             set_test_value(at.lvector(), np.array([0, 2, 1])),
             UserWarning,
         ),
+        (
+            set_test_value(
+                at.matrix(),
+                np.array([[1.0, 2.0, 3.0], [0.0, 0.5, 1.0]], dtype=config.floatX),
+            ),
+            set_test_value(at.matrix(), rng.random((2, 4)).astype(config.floatX)),
+            "right",
+            None,
+            None,
+        ),
     ],
 )
 def test_Searchsorted(a, v, side, sorter, exc):
@@ -3478,6 +3676,80 @@ def test_scan_while():
     compare_numba_and_py(out_fg, test_input_vals)
 
 
+@pytest.mark.parametrize("truncate_gradient", [-1, 2])
+def test_scan_mit_mot(truncate_gradient):
+    x = at.matrix("x")
+    w = at.matrix("w")
+
+    def step(x_t, h_tm1, h_tm2, w):
+        return at.tanh(at.dot(w, h_tm1) + 0.5 * h_tm2 + x_t)
+
+    h, _ = scan(
+        step,
+        sequences=[x],
+        outputs_info=[dict(initial=at.zeros((2, 3)), taps=[-1, -2])],
+        non_sequences=[w],
+        truncate_gradient=truncate_gradient,
+    )
+    grads = grad(at.sqr(h).sum(), [w, x])
+
+    out_fg = FunctionGraph([x, w], grads)
+    assert any(
+        isinstance(node.op, Scan) and node.op.info.n_mit_mot > 0
+        for node in out_fg.toposort()
+    )
+
+    test_input_vals = [
+        rng.normal(size=(6, 3)).astype(config.floatX),
+        rng.normal(scale=0.3, size=(3, 3)).astype(config.floatX),
+    ]
+    compare_numba_and_py(out_fg, test_input_vals)
+
+
+def test_scan_shared_outputs():
+    x = at.vector("x")
+    s = shared(np.ones(3, dtype=config.floatX), name="s")
+
+    out, updates = scan(lambda x_t: (x_t * s, {s: s * 2}), sequences=[x])
+    fn = function([x], out, updates=updates, mode=numba_mode)
+
+    x_val = rng.normal(size=4).astype(config.floatX)
+    res = fn(x_val)
+    np.testing.assert_allclose(
+        res, np.outer(x_val * 2.0 ** np.arange(4), np.ones(3)), rtol=1e-5
+    )
+    np.testing.assert_allclose(s.get_value(), np.full(3, 16.0))
+
+
+def test_scan_circular_buffers():
+    n_steps = at.iscalar("n_steps")
+
+    fib, _ = scan(
+        lambda a_tm1, a_tm2: a_tm1 + a_tm2,
+        outputs_info=[
+            dict(initial=at.as_tensor_variable(np.r_[1.0, 1.0]), taps=[-1, -2])
+        ],
+        n_steps=n_steps,
+    )
+    fn = function([n_steps], [fib[-1], fib[-3]], mode="NUMBA")
+
+    # Only the last three entries of the output are stored
+    (scan_node,) = [
+        node for node in fn.maker.fgraph.toposort() if isinstance(node.op, Scan)
+    ]
+    buffer_fn = function(
+        fn.maker.fgraph.inputs,
+        scan_node.inputs[1],
+        mode="NUMBA",
+        on_unused_input="ignore",
+        accept_inplace=True,
+    )
+    assert buffer_fn(10).shape == (3,)
+
+    np.testing.assert_allclose(fn(10), [144.0, 55.0])
+    np.testing.assert_allclose(fn(3), [5.0, 2.0])
+
+
 @pytest.mark.parametrize(
     "inputs, cond_fn, true_vals, false_vals",
     [
@@ -3538,13 +3810,19 @@ def test_numba_ifelse(inputs, cond_fn, true_vals, false_vals):
     compare_numba_and_py(out_fg, [get_test_value(i) for i in out_fg.inputs])
 
 
+def get_buffered_elemwise_fn(aesara_numba_fn, name):
+    # The outputs are computed in place, by wrappers of the vectorized functions
+    buffered_fn = aesara_numba_fn.fn.jit_fn.py_func.__globals__[f"{name}_buffered"]
+    return buffered_fn.py_func.__globals__[name]
+
+
 @pytest.mark.xfail(reason="https://github.com/numba/numba/issues/7409")
 def test_config_options_parallel():
     x = at.dvector()
 
     with config.change_flags(numba__vectorize_target="parallel"):
         aesara_numba_fn = function([x], x * 2, mode=numba_mode)
-        numba_mul_fn = aesara_numba_fn.fn.jit_fn.py_func.__globals__["mul"]
+        numba_mul_fn = get_buffered_elemwise_fn(aesara_numba_fn, "mul")
         assert numba_mul_fn.targetoptions["parallel"] is True
 
 
@@ -3553,21 +3831,98 @@ def test_config_options_fastmath():
 
     with config.change_flags(numba__fastmath=True):
         aesara_numba_fn = function([x], x * 2, mode=numba_mode)
-        numba_mul_fn = aesara_numba_fn.fn.jit_fn.py_func.__globals__["mul"]
+        numba_mul_fn = get_buffered_elemwise_fn(aesara_numba_fn, "mul")
         assert numba_mul_fn.targetoptions["fastmath"] is True
 
 
+def test_config_options_parallel_loop_nests():
+    x = at.dvector()
+
+    with config.change_flags(numba__parallel=True):
+        aesara_numba_fn = function([x], x * 2, mode=numba_mode)
+        numba_mul_fn = aesara_numba_fn.fn.jit_fn.py_func.__globals__["loop_nest"]
+        assert numba_mul_fn.targetoptions["parallel"] is True
+
+
+def test_config_options_num_threads(monkeypatch):
+    x = at.dvector()
+
+    with config.change_flags(numba__parallel=True, numba__num_threads=1):
+        aesara_numba_fn = function([x], x * 2, mode=numba_mode)
+    previous = numba.get_num_threads()
+    calls = []
+    orig_set_num_threads = numba.set_num_threads
+
+    def set_num_threads(n):
+        calls.append(n)
+        return orig_set_num_threads(n)
+
+    monkeypatch.setattr(numba, "set_num_threads", set_num_threads)
+    aesara_numba_fn(np.ones(3))
+    # The number of threads is only changed during the call
+    assert calls == [1, previous]
+    assert numba.get_num_threads() == previous
+
+
 def test_config_options_cached():
     x = at.dvector()
 
     with config.change_flags(numba__cache=True):
         aesara_numba_fn = function([x], x * 2, mode=numba_mode)
-        numba_mul_fn = aesara_numba_fn.fn.jit_fn.py_func.__globals__["mul"]
+        numba_mul_fn = get_buffered_elemwise_fn(aesara_numba_fn, "mul")
         assert not isinstance(
             numba_mul_fn._dispatcher.cache, numba.core.caching.NullCache
         )
 
     with config.change_flags(numba__cache=False):
         aesara_numba_fn = function([x], x * 2, mode=numba_mode)
-        numba_mul_fn = aesara_numba_fn.fn.jit_fn.py_func.__globals__["mul"]
+        numba_mul_fn = get_buffered_elemwise_fn(aesara_numba_fn, "mul")
         assert isinstance(numba_mul_fn._dispatcher.cache, numba.core.caching.NullCache)
+
+
+def test_cache_generated_functions():
+    @numba_basic.numba_njit
+    def add_one(x):
+        return x + 1
+
+    @numba_basic.numba_njit
+    def add_two(x):
+        return x + 2
+
+    src = """
+def generated(x):
+    return inner(x)
+"""
+
+    def generate(inner):
+        return compile_function_src(src, "generated", {**globals(), "inner": inner})
+
+    key_1 = get_cache_key(generate(add_one), {})
+    assert key_1 == get_cache_key(generate(add_one), {})
+    assert key_1 != get_cache_key(generate(add_two), {})
+    assert key_1 != get_cache_key(generate(add_one), {"fastmath": True})
+
+    # Closures can't be re-created from the source
+    assert get_cache_key(lambda x: add_one(x), {}) is None
+
+    with config.change_flags(numba__cache=True):
+        fn_1 = numba_basic.numba_njit(generate(add_one))
+        fn_2 = numba_basic.numba_njit(generate(add_one))
+        assert fn_1(1) == 2
+        assert inspect.getfile(fn_1.py_func) == inspect.getfile(fn_2.py_func)
+        assert os.path.dirname(inspect.getfile(fn_1.py_func)) == get_cache_dir()
+        assert not isinstance(fn_1._cache, numba.core.caching.NullCache)
+
+        fn_3 = numba_basic.numba_njit(generate(add_two))
+        assert fn_3(1) == 3
+        assert inspect.getfile(fn_1.py_func) != inspect.getfile(fn_3.py_func)
+
+        x = at.dvector()
+        aesara_numba_fn = function([x], x * 2, mode=numba_mode)
+        numba_mul_fn = get_buffered_elemwise_fn(aesara_numba_fn, "mul")
+        mul_file = inspect.getfile(numba_mul_fn._dispatcher.py_func)
+        assert os.path.dirname(mul_file) == get_cache_dir()
+
+    with config.change_flags(numba__cache=False):
+        fn = numba_basic.numba_njit(generate(add_one))
+        assert not inspect.getfile(fn.py_func).startswith(get_cache_dir())
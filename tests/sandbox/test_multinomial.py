@@ -1,7 +1,9 @@
 import numpy as np
+import pytest
 
 import tests.unittest_tools as utt
 from aesara import function
+from aesara.compile.mode import Mode
 from aesara.configdefaults import config
 from aesara.sandbox.multinomial import MultinomialFromUniform
 from aesara.tensor.type import dmatrix, dvector, fmatrix, fvector, iscalar
@@ -117,3 +119,33 @@ def test_multinomial_dtypes():
     u = fvector()
     m = MultinomialFromUniform("float64")(p, u)
     assert m.dtype == "float64", m.dtype
+
+
+@pytest.mark.skipif(
+    config.cxx == "", reason="MultinomialFromUniform C code needs a C++ compiler"
+)
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("n_elements", [5, 1000])
+def test_multinomial_c_matches_py(n_elements, openmp):
+    rng = np.random.default_rng(utt.fetch_seed())
+    n_rows, n_samples = 4, 300
+    pvals = rng.random((n_rows, n_elements))
+    pvals[:, ::3] = 0
+    pvals /= pvals.sum(1, keepdims=True)
+    unis = rng.random(n_rows * n_samples)
+
+    res = []
+    for linker in ["py", "c"]:
+        p = dmatrix()
+        u = dvector()
+        with config.change_flags(openmp_elemwise_minsize=1):
+            f = function(
+                [p, u],
+                MultinomialFromUniform("auto", openmp=openmp)(p, u, n_samples),
+                mode=Mode(linker=linker, optimizer=None),
+            )
+        res.append(f(pvals, unis))
+
+    assert np.array_equal(res[0], res[1])
+    assert np.all(res[0].sum(1) == n_samples)
+    assert np.all(res[0][:, ::3] == 0)
@@ -2,10 +2,12 @@ import numpy as np
 import pytest
 
 from aesara import function
+from aesara.compile.mode import Mode
 from aesara.configdefaults import config
 from aesara.sandbox import multinomial
 from aesara.sandbox.rng_mrg import MRG_RandomStream as RandomStream
-from aesara.tensor.type import fmatrix, fvector, iscalar
+from aesara.tensor.type import dmatrix, dvector, fmatrix, fvector, iscalar
+from tests import unittest_tools as utt
 
 
 class TestOP:
@@ -143,6 +145,52 @@ class TestOP:
         avg_diff = np.mean(abs(avg_pvals - pvals))
         assert avg_diff < mean_rtol, avg_diff
 
+    def test_fail_select_zero_probability(self):
+        # Outcomes with a zero probability are never selected, so there
+        # may not be enough outcomes left
+        p = dmatrix()
+        u = dvector()
+        n = iscalar()
+        m = multinomial.ChoiceFromUniform(odtype="auto")(p, u, n)
+        f = function([p, u, n], m)
+
+        pvals = np.array([[0.5, 0.0, 0.5]])
+        assert set(f(pvals, np.array([0.9, 0.9]), 2)[0]) == {0, 2}
+        with pytest.raises(ValueError, match="Fewer non-zero entries"):
+            f(pvals, np.array([0.1, 0.2, 0.3]), 3)
+
+    @pytest.mark.skipif(
+        config.cxx == "", reason="ChoiceFromUniform C code needs a C++ compiler"
+    )
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("replace", [False, True])
+    def test_c_matches_py(self, replace, openmp):
+        rng = np.random.default_rng(utt.fetch_seed())
+        n_rows, n_elements, n_selected = 3, 1000, 400
+        pvals = rng.random((n_rows, n_elements))
+        pvals[:, ::7] = 0
+        pvals /= pvals.sum(1, keepdims=True)
+        uni = rng.random(n_rows * n_selected)
+
+        res = []
+        for linker in ["py", "c"]:
+            p = dmatrix()
+            u = dvector()
+            n = iscalar()
+            op = multinomial.ChoiceFromUniform(
+                odtype="auto", replace=replace, openmp=openmp
+            )
+            with config.change_flags(openmp_elemwise_minsize=1):
+                f = function(
+                    [p, u, n], op(p, u, n), mode=Mode(linker=linker, optimizer=None)
+                )
+            res.append(f(pvals, uni, n_selected))
+
+        assert np.array_equal(res[0], res[1])
+        assert np.all(pvals[np.arange(n_rows)[:, None], res[0]] > 0)
+        if not replace:
+            assert all(len(np.unique(row)) == n_selected for row in res[0])
+
 
 class TestFunction:
     def test_select_distinct(self):
@@ -180,6 +180,51 @@ def test_consistency_cpu_parallel():
     assert np.allclose(samples, java_samples)
 
 
+def test_get_substream_rstates_consistency():
+    # The streams are spaced by 2**72 samples
+    rng = MRG_RandomStream(1234)
+    rstates = rng.get_substream_rstates(37, "float32", inc_rstate=False)
+
+    exp_rstates = [rng.rstate]
+    for i in range(1, 37):
+        exp_rstates.append(rng_mrg.ff_2p72(exp_rstates[-1]))
+    assert np.array_equal(rstates, np.asarray(exp_rstates))
+
+
+@pytest.mark.skipif(config.cxx == "", reason="mrg_uniform C code needs a C++ compiler")
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+@pytest.mark.parametrize(
+    "n_streams, size", [(1, (5000,)), (3, (7, 301)), (20, (9,)), (60, (2, 50))]
+)
+def test_consistency_c_py(n_streams, size, dtype, openmp):
+    # The C code must draw the samples of the Python reference, whatever the
+    # way it splits the draw across lanes and threads.
+    rstate = MRG_RandomStream(4321).get_substream_rstates(n_streams, dtype)
+    res = []
+    for linker in ["py", "c"]:
+        op = mrg_uniform(
+            aesara.tensor.TensorType(dtype, (False,) * len(size)), openmp=openmp
+        )
+        rstate_sym = aesara.tensor.imatrix()
+        with config.change_flags(openmp_elemwise_minsize=1):
+            f = function(
+                [rstate_sym],
+                op(rstate_sym, np.asarray(size, dtype="int64")),
+                mode=aesara.compile.mode.Mode(linker=linker, optimizer=None),
+            )
+        new_rstate, sample = f(rstate.copy())
+        new_rstate_2, sample_2 = f(new_rstate)
+        res.append((new_rstate_2, sample, sample_2))
+
+    (py_rstate, py_sample, py_sample_2), (c_rstate, c_sample, c_sample_2) = res
+    assert np.array_equal(c_rstate, py_rstate)
+    # The Python code computes float32 samples in float64 before rounding them
+    rtol = 1e-6 if dtype == "float32" else 0
+    np.testing.assert_allclose(c_sample, py_sample, rtol=rtol)
+    np.testing.assert_allclose(c_sample_2, py_sample_2, rtol=rtol)
+
+
 def check_basics(
     f,
     steps,
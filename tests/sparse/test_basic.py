@@ -10,6 +10,7 @@ import aesara.tensor as at
 from aesara import sparse
 from aesara.compile.function import function
 from aesara.compile.io import In, Out
+from aesara.compile.mode import Mode
 from aesara.configdefaults import config
 from aesara.gradient import GradientError
 from aesara.graph.basic import Apply, Constant, applys_between
@@ -38,11 +39,13 @@ from aesara.sparse import (
     Remove0,
     SamplingDot,
     SparseFromDense,
+    SparseFromSparse,
     SparseTensorType,
     SquareDiagonal,
     StructuredDot,
     StructuredDotGradCSC,
     StructuredDotGradCSR,
+    StructuredSoftmax,
     Transpose,
     TrueDot,
     Usmm,
@@ -51,12 +54,15 @@ from aesara.sparse import (
     add_s_s_data,
     as_sparse_or_tensor_variable,
     as_sparse_variable,
+    bsr_from_sparse,
+    bsr_properties,
     cast,
     clean,
     construct_sparse_from_list,
     csc_from_dense,
     csm_properties,
     csr_from_dense,
+    csr_from_sparse,
     dense_from_sparse,
     diag,
     ensure_sorted_indices,
@@ -74,6 +80,7 @@ from aesara.sparse import (
     structured_dot,
     structured_maximum,
     structured_minimum,
+    structured_softmax,
     transpose,
     true_dot,
 )
@@ -92,6 +99,7 @@ from aesara.tensor.shape import Shape_i
 from aesara.tensor.subtensor import AdvancedIncSubtensor, AdvancedSubtensor1, Subtensor
 from aesara.tensor.type import (
     TensorType,
+    dvector,
     float_dtypes,
     fscalar,
     iscalar,
@@ -406,6 +414,17 @@ class TestTranspose:
         vta = eval_outputs([ta])
         assert vta.shape == (3, 5)
 
+    def test_transpose_bsr(self):
+        a = as_sparse_variable(
+            sp.sparse.bsr_matrix(sp.sparse.eye(4, 6), blocksize=(2, 3))
+        )
+        ta = transpose(a)
+        assert ta.type.format == "bsr", ta.type.format
+
+        vta = eval_outputs([ta])
+        assert vta.shape == (6, 4)
+        assert vta.blocksize == (3, 2)
+
 
 class TestSparseInferShape(utt.InferShapeTester):
     @pytest.mark.skip(reason="infer_shape not implemented for GetItem2d yet")
@@ -479,6 +498,7 @@ class TestSparseInferShape(utt.InferShapeTester):
                 sp.sparse.csr_matrix(random_lil((10, 40), config.floatX, 3)),
             ],
             AddSS,
+            excluding=["local_binary_s_s_csx"],
         )
 
     def test_add_sd(self):
@@ -505,6 +525,7 @@ class TestSparseInferShape(utt.InferShapeTester):
             ]
             * 2,
             MulSS,
+            excluding=["local_binary_s_s_csx"],
         )
 
     def test_mul_sd(self):
@@ -541,6 +562,7 @@ class TestSparseInferShape(utt.InferShapeTester):
                 sp.sparse.csc_matrix(random_lil((5, 3), config.floatX, 3)),
             ],
             Dot,
+            excluding=["local_spgemm_csr"],
         )
 
     def test_dot_broadcast(self):
@@ -572,6 +594,7 @@ class TestSparseInferShape(utt.InferShapeTester):
                 sp.sparse.csc_matrix(random_lil((5, 3), config.floatX, 3)),
             ],
             StructuredDot,
+            excluding=["local_spgemm_csr"],
         )
 
     @pytest.mark.skip(
@@ -1100,6 +1123,32 @@ class TestConversion:
             with pytest.raises(TypeError):
                 self.check_format_ndim(format, 4)
 
+    def test_sparse_from_sparse(self):
+        spmat = sp.sparse.csr_matrix(random_lil((4, 6), "float64", 5))
+        for format in "csc", "csr":
+            x = SparseTensorType(format, dtype="float64")()
+            for out_format, convert in [
+                ("csr", csr_from_sparse),
+                ("csc", SparseFromSparse("csc")),
+                ("bsr", lambda x: bsr_from_sparse(x, (2, 3))),
+            ]:
+                res = aesara.function([x], convert(x))(spmat.asformat(format))
+                assert res.format == out_format
+                assert res.dtype == "float64"
+                assert np.array_equal(res.toarray(), spmat.toarray())
+                if out_format == "bsr":
+                    assert res.blocksize == (2, 3)
+
+        with pytest.raises(ValueError):
+            SparseFromSparse("csr", (2, 2))
+
+        # The bsr conversion adds the zeros of the blocks to the structure
+        verify_grad_sparse(
+            lambda x: csr_from_sparse(bsr_from_sparse(x, (2, 2))),
+            [spmat],
+            structured=True,
+        )
+
 
 class TestCsmProperties:
     def test_csm_properties_grad(self):
@@ -1142,6 +1191,36 @@ class TestCsmProperties:
                 assert np.all(indptr == spmat.indptr)
                 assert np.all(shape == spmat.shape)
 
+    @pytest.mark.skipif(
+        not aesara.config.cxx, reason="G++ not available, so we need to skip this test."
+    )
+    def test_csm_properties_c_code(self):
+        x = SparseTensorType("csr", dtype="float64")()
+        spmat = sp.sparse.csr_matrix(random_lil((5, 4), "float64", 6))
+        res = []
+        for linker in ("py", "c"):
+            f = aesara.function(
+                [x], csm_properties(x), mode=Mode(linker=linker, optimizer=None)
+            )
+            res.append(f(spmat))
+
+        for py_val, c_val in zip(*res):
+            assert c_val.dtype == py_val.dtype
+            assert np.array_equal(c_val, py_val)
+
+    def test_bsr_properties(self):
+        x = SparseTensorType("bsr", dtype="float32")()
+        f = aesara.function([x], bsr_properties(x))
+        spmat = sp.sparse.bsr_matrix(random_lil((4, 6), "float32", 5), blocksize=(2, 3))
+
+        data, indices, indptr, shape = f(spmat)
+
+        assert data.shape[1:] == (2, 3)
+        assert np.all(data == spmat.data)
+        assert np.all(indices == spmat.indices)
+        assert np.all(indptr == spmat.indptr)
+        assert np.all(shape == spmat.shape)
+
 
 class TestCsm:
     def test_csm_grad(self):
@@ -1239,6 +1318,60 @@ class TestCsm:
                 assert np.all(res.indptr == spmat.indptr)
                 assert np.all(res.shape == spmat.shape)
 
+    @pytest.mark.skipif(
+        not aesara.config.cxx, reason="G++ not available, so we need to skip this test."
+    )
+    def test_csm_c_code(self):
+        x = dvector()
+        y = ivector()
+        z = ivector()
+        s = ivector()
+        mode = Mode(linker="c", optimizer=None)
+
+        for format in ("csc", "csr"):
+            f = aesara.function([x, y, z, s], CSM(format)(x, y, z, s), mode=mode)
+            spmat = getattr(sp.sparse, f"{format}_matrix")(
+                random_lil((5, 4), "float64", 6)
+            )
+            shape = np.asarray(spmat.shape, "int32")
+
+            res = f(spmat.data, spmat.indices, spmat.indptr, shape)
+            assert type(res) is type(spmat)
+            assert res.indices.dtype == "int32"
+            assert abs(res - spmat).nnz == 0
+
+            # Entries past the end of the index pointer are dropped
+            ptr = spmat.indptr.copy()
+            ptr[-1] -= 1
+            res = f(spmat.data, spmat.indices, ptr, shape)
+            assert res.nnz == spmat.nnz - 1
+            assert len(res.data) == len(res.indices) == spmat.nnz - 1
+
+            with pytest.raises(ValueError):
+                f(spmat.data, spmat.indices, spmat.indptr[:-1], shape)
+            with pytest.raises(ValueError):
+                f(spmat.data, spmat.indices[:-1], spmat.indptr, shape)
+            with pytest.raises(ValueError):
+                f(spmat.data, spmat.indices, spmat.indptr, shape[:1])
+
+    def test_csm_c_code_int64(self):
+        # Other index types are left to `CSM.perform`
+        x = dvector()
+        y = lvector()
+        z = lvector()
+        s = ivector()
+        f = aesara.function(
+            [x, y, z, s], CSM("csr")(x, y, z, s), mode=Mode(linker="c|py")
+        )
+        spmat = sp.sparse.csr_matrix(random_lil((5, 4), "float64", 6))
+        res = f(
+            spmat.data,
+            spmat.indices.astype("int64"),
+            spmat.indptr.astype("int64"),
+            np.asarray(spmat.shape, "int32"),
+        )
+        assert abs(res - spmat).nnz == 0
+
 
 class TestStructuredDot:
     def test_structureddot_csc_grad(self):
@@ -1273,6 +1406,20 @@ class TestStructuredDot:
 
         verify_grad_sparse(buildgraph_T, [spmat, mat], structured=True)
 
+    def test_structureddot_bsr_grad(self):
+        spmat = sp.sparse.csr_matrix(random_lil((4, 6), "float64", 5))
+        mat = np.asarray(np.random.standard_normal((6, 3)), "float64")
+
+        def buildgraph(spmat, mat):
+            return structured_dot(bsr_from_sparse(spmat, (2, 3)), mat)
+
+        verify_grad_sparse(buildgraph, [spmat, mat], structured=True)
+
+        def buildgraph_T(spmat, mat):
+            return structured_dot(mat.T, bsr_from_sparse(spmat, (2, 3)).T)
+
+        verify_grad_sparse(buildgraph_T, [spmat, mat], structured=True)
+
     def test_upcast(self):
 
         typenames = (
@@ -2207,7 +2354,11 @@ class TestEnsureSortedIndices(utt.InferShapeTester):
             for shape in zip(range(5, 9), range(3, 7)[::-1]):
                 variable, data = sparse_random_inputs(format, shape=shape)
                 self._compile_and_check(
-                    variable, [self.op(*variable)], data, self.op_class
+                    variable,
+                    [self.op(*variable)],
+                    data,
+                    self.op_class,
+                    excluding=["local_ensure_sorted_indices_csx"],
                 )
 
     def test_grad(self):
@@ -2742,6 +2893,7 @@ class _TestHVStack(utt.InferShapeTester):
                 [self.op_class(dtype="float64")(*self.x[format])],
                 self.mat[format],
                 self.op_class,
+                excluding=["local_stack_csx"],
             )
 
     def test_grad(self):
@@ -3292,7 +3444,11 @@ class TestTrueDot(utt.InferShapeTester):
                 variable = [x, y]
                 data = [x_value, y_value]
                 self._compile_and_check(
-                    variable, [self.op(*variable)], data, self.op_class
+                    variable,
+                    [self.op(*variable)],
+                    data,
+                    self.op_class,
+                    excluding=["local_spgemm_csr"],
                 )
 
     def test_grad(self):
@@ -3371,6 +3527,46 @@ class TestSamplingDot(utt.InferShapeTester):
         verify_grad_sparse(_helper, self.a[:2])
 
 
+class TestStructuredSoftmax(utt.InferShapeTester):
+    def setup_method(self):
+        super().setup_method()
+        self.op_class = StructuredSoftmax
+        self.op = structured_softmax
+
+    def test_op(self):
+        for format in sparse.sparse_formats:
+            variable, data = sparse_random_inputs(format, shape=(8, 6), p=0.4)
+            # An explicit zero and an empty row
+            data[0] = sp.sparse.lil_matrix(data[0])
+            data[0][1, :] = 0
+            data[0][2, 3] = 0
+            data[0] = data[0].asformat(format)
+            data[0][2, 3] = 0
+
+            f = aesara.function(variable, self.op(*variable))
+            tested = f(*data)
+            assert tested.format == format
+
+            x = data[0].tocsr()
+            expected = np.zeros(x.shape)
+            for i in range(x.shape[0]):
+                cols = x.indices[x.indptr[i] : x.indptr[i + 1]]
+                e = np.exp(x.data[x.indptr[i] : x.indptr[i + 1]])
+                expected[i, cols] = e / e.sum()
+            utt.assert_allclose(expected, tested.toarray())
+            assert tested.nnz == x.nnz
+
+    def test_infer_shape(self):
+        for format in sparse.sparse_formats:
+            variable, data = sparse_random_inputs(format, shape=(8, 6), p=0.4)
+            self._compile_and_check(variable, [self.op(*variable)], data, self.op_class)
+
+    def test_grad(self):
+        for format in sparse.sparse_formats:
+            variable, data = sparse_random_inputs(format, shape=(8, 6), p=0.4)
+            verify_grad_sparse(self.op, data, structured=True)
+
+
 @makeSharedTester(
     shared_constructor_=sparse.shared,
     dtype_="float64",
@@ -7,11 +7,12 @@ import numpy as np
 
 import aesara
 from aesara import sparse
+from aesara.compile.io import In
 from aesara.compile.mode import Mode, get_default_mode
 from aesara.configdefaults import config
 from aesara.tensor.basic import as_tensor_variable
 from aesara.tensor.math import sum as at_sum
-from aesara.tensor.type import ivector, matrix, vector
+from aesara.tensor.type import TensorType, ivector, matrix, vector
 from tests import unittest_tools as utt
 from tests.sparse.test_basic import random_lil
 
@@ -177,3 +178,493 @@ def test_sd_csc():
     res = aesara.sparse.opt.sd_csc(a_val, a_ind, a_ptr, nrows, b).eval()
 
     utt.assert_allclose(res, target)
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("format", ["csc", "csr"])
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+def test_sd_csx_c_code(format, dtype, openmp):
+    rng = np.random.default_rng(utt.fetch_seed())
+    # Skewed row lengths: a few dense rows among nearly empty ones
+    A = sp.sparse.random(
+        60, 50, density=0.05, format="lil", dtype=dtype, random_state=1
+    )
+    A[[3, 40], :] = rng.random((2, 50))
+    A = A.asformat(format)
+    b_val = rng.random((100, 9)).astype(dtype)
+
+    a_val = as_tensor_variable(A.data)
+    a_ind = as_tensor_variable(A.indices)
+    a_ptr = as_tensor_variable(A.indptr)
+    b = matrix(dtype=dtype)
+    with config.change_flags(openmp_elemwise_minsize=0):
+        if format == "csc":
+            op = aesara.sparse.opt.StructuredDotCSC(openmp=openmp)
+            nrows = as_tensor_variable(np.int32(A.shape[0]))
+            out = op(a_val, a_ind, a_ptr, nrows, b)
+        else:
+            op = aesara.sparse.opt.StructuredDotCSR(openmp=openmp)
+            out = op(a_val, a_ind, a_ptr, b)
+        f = aesara.function([b], out, mode=Mode(linker="c"))
+
+    # Contiguous and strided `b`
+    for b_v in (b_val[:50], b_val[::2]):
+        res = f(b_v)
+        utt.assert_allclose(res, A @ b_v)
+
+
+@pytest.mark.skipif(
+    not aesara.config.cxx, reason="G++ not available, so we need to skip this test."
+)
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+@pytest.mark.parametrize("inplace", [False, True])
+def test_usmm_csc_dense_openmp(dtype, inplace):
+    A = sp.sparse.random(60, 50, density=0.1, format="csc", dtype=dtype, random_state=1)
+    rng = np.random.default_rng(utt.fetch_seed())
+    y_val = rng.random((50, 9)).astype(dtype)
+    z_val = rng.random((60, 9)).astype(dtype)
+    alpha_val = np.asarray([[0.1]], dtype=dtype)
+
+    alpha = TensorType(dtype, (True, True))()
+    y = matrix(dtype=dtype)
+    z = matrix(dtype=dtype)
+    nrows = as_tensor_variable(np.int32(A.shape[0]))
+    res = []
+    # The products are above `openmp_elemwise_minsize`
+    with config.change_flags(openmp_elemwise_minsize=10):
+        for openmp in (False, True):
+            op = aesara.sparse.opt.UsmmCscDense(inplace=inplace, openmp=openmp)
+            out = op(alpha, A.data, A.indices, A.indptr, nrows, y, z)
+            f = aesara.function(
+                [alpha, y, In(z, mutable=inplace)],
+                out,
+                mode=Mode(linker="c"),
+                accept_inplace=True,
+            )
+            res.append(f(alpha_val, y_val, z_val.copy()))
+
+    utt.assert_allclose(res[0], alpha_val[0, 0] * (A @ y_val) + z_val)
+    utt.assert_allclose(res[1], res[0])
+
+
+def _shuffled_csx(format, shape, dtype, density, seed, duplicates=False):
+    """A random sparse matrix whose rows have unsorted indices."""
+    rng = np.random.default_rng(seed)
+    A = sp.sparse.random(*shape, density=density, format=format, random_state=seed)
+    A = A.astype(dtype)
+    data, indices, indptr = A.data, A.indices, A.indptr
+    for m in range(len(indptr) - 1):
+        perm = rng.permutation(indptr[m + 1] - indptr[m]) + indptr[m]
+        data[indptr[m] : indptr[m + 1]] = data[perm]
+        indices[indptr[m] : indptr[m + 1]] = indices[perm]
+    if duplicates:
+        # Repeat the first entry of each row
+        first = indptr[:-1][np.diff(indptr) > 0]
+        counts = np.diff(indptr) + (np.diff(indptr) > 0)
+        data = np.insert(data, first, data[first])
+        indices = np.insert(indices, first, indices[first])
+        indptr = np.r_[0, np.cumsum(counts)].astype("int32")
+    cls = getattr(sp.sparse, format + "_matrix")
+    return cls((data, indices, indptr), shape)
+
+
+def _ops(f):
+    return [type(node.op) for node in f.maker.fgraph.toposort()]
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("format", ["csc", "csr"])
+@pytest.mark.parametrize("op", [sparse.add, sparse.mul])
+def test_local_binary_s_s_csx(op, format, openmp):
+    x = sparse.matrix(format, dtype="float64")
+    y = sparse.matrix(format, dtype="float32")
+    with config.change_flags(openmp=openmp, openmp_elemwise_minsize=0):
+        f = aesara.function([x, y], op(x, y))
+    assert aesara.sparse.opt.BinarySSCSx in _ops(f)
+
+    X = _shuffled_csx(format, (40, 30), "float64", 0.3, 1, duplicates=True)
+    Y = _shuffled_csx(format, (40, 30), "float32", 0.3, 2)
+    # Entries that cancel out are dropped
+    Y[3, 4] = -X[3, 4] if op is sparse.add else 0
+    expected = X + Y if op is sparse.add else X.multiply(Y)
+    res = f(X, Y)
+    assert res.format == format and res.dtype == "float64"
+    assert res.has_sorted_indices and np.all(res.data != 0)
+    utt.assert_allclose(res.toarray(), expected.toarray())
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("format", ["csc", "csr"])
+@pytest.mark.parametrize(
+    "op",
+    [sparse.dot, sparse.structured_dot, sparse.true_dot],
+    ids=["dot", "structured_dot", "true_dot"],
+)
+def test_local_spgemm_csr(op, format, openmp):
+    # TrueDot does not upcast
+    y_dtype = "float32" if op is sparse.true_dot else "float64"
+    x = sparse.matrix(format, dtype="float32")
+    y = sparse.matrix(format, dtype=y_dtype)
+    with config.change_flags(openmp=openmp, openmp_elemwise_minsize=0):
+        f = aesara.function([x, y], op(x, y))
+    assert aesara.sparse.opt.SpGEMMCSR in _ops(f)
+
+    X = _shuffled_csx(format, (40, 30), "float32", 0.2, 1, duplicates=True)
+    Y = _shuffled_csx(format, (30, 20), y_dtype, 0.2, 2)
+    res = f(X, Y)
+    if op is not sparse.dot:
+        assert res.format == format
+        assert np.all(res.data != 0)
+        res = res.toarray()
+    utt.assert_allclose(res, (X @ Y).toarray())
+
+    with pytest.raises(ValueError):
+        f(X, Y.T)
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("format", ["csc", "csr"])
+def test_local_ensure_sorted_indices_csx(format):
+    x = sparse.matrix(format, dtype="float64")
+    with config.change_flags(openmp_elemwise_minsize=0):
+        f = aesara.function([x], sparse.ensure_sorted_indices(x))
+    assert aesara.sparse.opt.EnsureSortedIndicesCSx in _ops(f)
+
+    X = _shuffled_csx(format, (40, 30), "float64", 0.3, 1, duplicates=True)
+    res = f(X)
+    expected = X.sorted_indices()
+    assert np.array_equal(res.indptr, expected.indptr)
+    assert np.array_equal(res.indices, expected.indices)
+    assert np.array_equal(res.data, expected.data)
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("format", ["csc", "csr"])
+def test_local_stack_csx(format):
+    x = sparse.matrix(format, dtype="float32")
+    y = sparse.matrix(format, dtype="int32")
+    stack = sparse.vstack if format == "csr" else sparse.hstack
+    f = aesara.function([x, y], stack([x, y, x], format=format))
+    assert aesara.sparse.opt.StackCSx in _ops(f)
+
+    X = _shuffled_csx(format, (20, 20), "float32", 0.3, 1)
+    Y = sp.sparse.random(20, 20, density=0.3, format=format, random_state=2)
+    Y = (Y * 10).astype("int32")
+    res = f(X, Y)
+    sp_stack = sp.sparse.vstack if format == "csr" else sp.sparse.hstack
+    expected = sp_stack([X, Y, X], format=format, dtype="float64")
+    assert res.format == format and res.dtype == "float64"
+    utt.assert_allclose(res.toarray(), expected.toarray())
+
+    with pytest.raises(ValueError):
+        f(X, Y[:10, :10])
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("format", ["csc", "csr"])
+def test_local_get_item_2d_csx(format):
+    x = sparse.matrix(format, dtype="float64")
+    start, stop = aesara.tensor.lscalar(), aesara.tensor.lscalar()
+    if format == "csr":
+        out = x[start:stop]
+    else:
+        out = x[:, start:stop]
+    f = aesara.function([x, start, stop], out)
+    assert aesara.sparse.opt.SliceCSx in _ops(f)
+
+    X = _shuffled_csx(format, (30, 30), "float64", 0.3, 1)
+    for a, b in [(2, 7), (0, 30), (-5, -1), (8, 3), (-100, 100)]:
+        res = f(X, a, b)
+        expected = X[a:b] if format == "csr" else X[:, a:b]
+        assert res.format == format and res.shape == expected.shape
+        utt.assert_allclose(res.toarray(), expected.toarray())
+
+    # A step or a slice of the minor axis is left to GetItem2d
+    out = x[::2] if format == "csr" else x[:, ::2]
+    assert aesara.sparse.opt.SliceCSx not in _ops(aesara.function([x], out))
+
+
+@pytest.mark.parametrize("format", ["csc", "csr"])
+def test_csx_ops_perform(format):
+    # The Python implementations of the ops used by the rewrites above
+    mode = Mode(linker="py", optimizer="fast_run").including("cxx_only")
+    x = sparse.matrix(format, dtype="float64")
+    y = sparse.matrix(format, dtype="float64")
+    stack = sparse.vstack if format == "csr" else sparse.hstack
+    outs = [
+        sparse.add(x, y),
+        sparse.structured_dot(x, y),
+        sparse.ensure_sorted_indices(x),
+        stack([x, y], format=format),
+        x[3:-2] if format == "csr" else x[:, 3:-2],
+    ]
+    f = aesara.function([x, y], outs, mode=mode)
+    X = _shuffled_csx(format, (20, 20), "float64", 0.3, 1)
+    Y = _shuffled_csx(format, (20, 20), "float64", 0.3, 2)
+    sp_stack = sp.sparse.vstack if format == "csr" else sp.sparse.hstack
+    expected = [
+        X + Y,
+        X @ Y,
+        X.sorted_indices(),
+        sp_stack([X, Y], format=format),
+        X[3:-2] if format == "csr" else X[:, 3:-2],
+    ]
+    for res, exp in zip(f(X, Y), expected):
+        utt.assert_allclose(res.toarray(), exp.toarray())
+
+
+@pytest.mark.skipif(
+    not config.cxx or not config.blas__ldflags, reason="G++ or BLAS not available"
+)
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+def test_sampling_dot_csr_c_code(dtype, openmp):
+    x, y = matrix(dtype=dtype), matrix(dtype=dtype)
+    p = sparse.csr_matrix(dtype=dtype)
+    with config.change_flags(openmp=openmp, openmp_elemwise_minsize=0):
+        f = aesara.function([x, y, p], sparse.sampling_dot(x, y, p))
+    assert aesara.sparse.opt.SamplingDotCSR in _ops(f)
+
+    rng = np.random.default_rng(0)
+    X = rng.standard_normal((30, 17)).astype(dtype)
+    Y = rng.standard_normal((20, 17)).astype(dtype)
+    P = _shuffled_csx("csr", (30, 20), dtype, 0.3, 1, duplicates=True)
+    # Contiguous rows take the inlined kernel, strided ones go through BLAS
+    for X_, Y_ in [(X, Y), (np.asfortranarray(X), Y[:, ::-1].copy()[:, ::-1])]:
+        res = f(X_, Y_, P)
+        expected = P.multiply(X_ @ Y_.T)
+        utt.assert_allclose(res.toarray(), expected.toarray())
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+def test_local_sampling_dot_softmax_dot_csr(dtype, openmp):
+    x, y, v = matrix(dtype=dtype), matrix(dtype=dtype), matrix(dtype=dtype)
+    p = sparse.csr_matrix(dtype=dtype)
+    out = sparse.structured_dot(
+        sparse.structured_softmax(sparse.sampling_dot(x, y, p)), v
+    )
+    with config.change_flags(openmp=openmp, openmp_elemwise_minsize=0):
+        f = aesara.function([x, y, p, v], out)
+        f_ref = aesara.function(
+            [x, y, p, v],
+            out,
+            mode=get_default_mode().excluding("local_sampling_dot_softmax_dot_csr"),
+        )
+    assert aesara.sparse.opt.SamplingDotSoftmaxDotCSR in _ops(f)
+    assert aesara.sparse.opt.SamplingDotSoftmaxDotCSR not in _ops(f_ref)
+
+    rng = np.random.default_rng(0)
+    X = rng.standard_normal((30, 17)).astype(dtype)
+    Y = rng.standard_normal((20, 17)).astype(dtype)
+    V = rng.standard_normal((20, 5)).astype(dtype)
+    P = _shuffled_csx("csr", (30, 20), dtype, 0.3, 1, duplicates=True)
+    # An empty row gets a zero output
+    P = sp.sparse.csr_matrix(P.multiply(np.arange(30)[:, None] != 4))
+
+    S = P.multiply(X @ Y.T).tocsr()
+    S.sum_duplicates()
+    expected = np.zeros((30, 5))
+    for i in range(30):
+        cols = S.indices[S.indptr[i] : S.indptr[i + 1]]
+        e = np.exp(S.data[S.indptr[i] : S.indptr[i + 1]])
+        expected[i] = (e / e.sum()) @ V[cols] if len(cols) else 0
+
+    for X_ in [X, X[:, ::-1].copy()[:, ::-1]]:
+        res = f(X_, Y, P, V)
+        assert res.dtype == dtype
+        utt.assert_allclose(res, expected)
+        utt.assert_allclose(res, f_ref(X_, Y, P, V))
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+def test_local_sampling_dot_softmax_dot_csr_dtypes():
+    # The scores are computed in the dtype of `x` and `y` even when the pattern
+    # and `v` have a lower precision
+    x, y = matrix(dtype="float64"), matrix(dtype="float64")
+    v = matrix(dtype="float32")
+    p = sparse.csr_matrix(dtype="float32")
+    out = sparse.structured_dot(
+        sparse.structured_softmax(sparse.sampling_dot(x, y, p)), v
+    )
+    f = aesara.function([x, y, p, v], out)
+    f_py = aesara.function([x, y, p, v], out, mode=Mode(linker="py"))
+    assert aesara.sparse.opt.SamplingDotSoftmaxDotCSR in _ops(f)
+
+    rng = np.random.default_rng(0)
+    # Large scores that differ by small amounts lose their differences when
+    # they're rounded to float32
+    X = rng.standard_normal((30, 17))
+    Y = rng.standard_normal((20, 17))
+    X[:, 0], Y[:, 0] = 100, 10
+    V = rng.standard_normal((20, 5)).astype("float32")
+    P = _shuffled_csx("csr", (30, 20), "float32", 0.3, 1)
+    P.data[:] = 1
+
+    S = P.multiply(X @ Y.T).tocsr()
+    expected = np.zeros((30, 5))
+    for i in range(30):
+        cols = S.indices[S.indptr[i] : S.indptr[i + 1]]
+        scores = S.data[S.indptr[i] : S.indptr[i + 1]]
+        e = np.exp(scores - scores.max()) if len(cols) else scores
+        expected[i] = (e / e.sum()) @ V[cols] if len(cols) else 0
+
+    for fn in (f, f_py):
+        np.testing.assert_allclose(fn(X, Y, P, V), expected, rtol=1e-6, atol=1e-6)
+
+
+def _blocked_csx(format, shape, blocksize, dtype, density, seed):
+    """A random sparse matrix whose nonzeros fill dense blocks."""
+    R, C = blocksize
+    A = sp.sparse.random(
+        shape[0] // R, shape[1] // C, density=density, random_state=seed
+    )
+    A = sp.sparse.kron(A, np.ones(blocksize), format=format).astype(dtype)
+    A.data[:] = np.random.default_rng(seed).standard_normal(A.nnz)
+    return A
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+@pytest.mark.parametrize("blocksize", [(4, 4), (3, 2)])
+def test_structured_dot_bsr(blocksize, dtype, openmp):
+    x = sparse.bsr_matrix(dtype=dtype)
+    y = matrix(dtype="float64")
+    with config.change_flags(openmp=openmp, openmp_elemwise_minsize=0):
+        f = aesara.function([x, y], sparse.structured_dot(x, y))
+    assert aesara.sparse.opt.StructuredDotBSR in _ops(f)
+    assert sparse.StructuredDot not in _ops(f)
+
+    A = _blocked_csx("csr", (24, 24), blocksize, dtype, 0.3, 0)
+    A = A.tobsr(blocksize=blocksize)
+    for n in [1, 5]:
+        Y = np.random.default_rng(1).standard_normal((24, n))
+        res = f(A, Y)
+        assert res.dtype == "float64"
+        utt.assert_allclose(res, A @ Y)
+    # Strided inputs
+    utt.assert_allclose(f(A, Y[::-1]), A @ Y[::-1])
+    with pytest.raises(ValueError):
+        f(A, Y[:12])
+
+    f_py = aesara.function(
+        [y],
+        aesara.sparse.opt.sd_bsr(A.data, A.indices, A.indptr, y),
+        mode=Mode(linker="py", optimizer=None),
+    )
+    utt.assert_allclose(f_py(Y), A @ Y)
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("format", ["csc", "csr"])
+def test_local_structured_dot_blocked(format):
+    x, y = matrix(), vector()
+    blocked = _blocked_csx(format, (64, 48), (4, 4), config.floatX, 0.2, 0)
+    scattered = sp.sparse.random(64, 48, density=0.1, format=format, random_state=1)
+    scattered = scattered.astype(config.floatX)
+    X = np.random.default_rng(2).standard_normal((48, 5)).astype(config.floatX)
+    Y = X[:, 0]
+
+    for A, op in [
+        (blocked, aesara.sparse.opt.StructuredDotBSR),
+        (scattered, sparse.StructuredDot),
+    ]:
+        f = aesara.function([x], aesara.tensor.dot(sparse.as_sparse_variable(A), x))
+        assert op in _ops(f)
+        utt.assert_allclose(f(X), A @ X)
+
+    # Matrix-vector products go through the SELL format
+    for A in [blocked, scattered]:
+        f = aesara.function([y], sparse.dot(sparse.as_sparse_variable(A), y))
+        assert aesara.sparse.opt.StructuredDotSELL in _ops(f)
+        utt.assert_allclose(f(Y), A @ Y)
+
+    # The constants are left untouched
+    assert blocked.format == format and scattered.format == format
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("linker", ["cvm", "py"])
+def test_local_structured_dot_blocked_non_finite(linker):
+    # The padding of the SELL rows, and the zeros of partially filled
+    # blocks, must not multiply the inf and NaN of the dense operand
+    mode = get_default_mode().clone(linker=linker)
+    x, y = matrix(), vector()
+
+    A = sp.sparse.csr_matrix(np.array([[1, 1], [0, 1]], dtype=config.floatX))
+    f = aesara.function([y], sparse.dot(sparse.as_sparse_variable(A), y), mode=mode)
+    assert aesara.sparse.opt.StructuredDotSELL in _ops(f)
+    Y = np.array([np.inf, 1], dtype=config.floatX)
+    assert np.array_equal(f(Y), [np.inf, 1])
+
+    # Blocks of 2x2 with missing entries
+    A = sp.sparse.kron(
+        sp.sparse.eye(8), np.array([[1, 1], [0, 1]]), format="csr"
+    ).astype(config.floatX)
+    f = aesara.function(
+        [x], aesara.tensor.dot(sparse.as_sparse_variable(A), x), mode=mode
+    )
+    assert aesara.sparse.opt.StructuredDotBSR not in _ops(f)
+    X = np.ones((16, 3), dtype=config.floatX)
+    X[::2, 0] = np.inf
+    X[1::2, 1] = np.nan
+    with np.errstate(invalid="ignore"):
+        expected = A @ X
+    np.testing.assert_array_equal(f(X), expected)
+
+
+@pytest.mark.skipif(not config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("chunk", [4, 8])
+def test_structured_dot_sell(chunk, openmp):
+    # Rows of very different lengths
+    rng = np.random.default_rng(0)
+    lengths = rng.integers(0, 20, 37)
+    rows = np.repeat(np.arange(37), lengths)
+    cols = rng.integers(0, 30, len(rows))
+    A = sp.sparse.csr_matrix((rng.standard_normal(len(rows)), (rows, cols)), (37, 30))
+    A.sum_duplicates()
+    sell = aesara.sparse.opt._csr_to_sell(A, chunk, 16)
+    val, col, slice_ptr, perm, row_len = sell
+    assert len(slice_ptr) == -(-37 // chunk) + 1
+    assert np.array_equal(np.sort(perm), np.arange(37))
+    assert np.array_equal(row_len, np.diff(A.indptr)[perm])
+
+    op = aesara.sparse.opt.StructuredDotSELL(chunk, openmp=openmp)
+    y = matrix()
+    Y = rng.standard_normal((30, 3)).astype(config.floatX)
+    with config.change_flags(openmp_elemwise_minsize=0):
+        f_const = aesara.function([y], op(*sell, y))
+        structure = [ivector() for _ in range(4)]
+        f_var = aesara.function([y, *structure], op(val, *structure, y))
+        f_py = aesara.function(
+            [y], op(*sell, y), mode=Mode(linker="py", optimizer=None)
+        )
+    utt.assert_allclose(f_const(Y), A @ Y)
+    utt.assert_allclose(f_var(Y, col, slice_ptr, perm, row_len), A @ Y)
+    utt.assert_allclose(
+        f_var(np.asfortranarray(Y), col, slice_ptr, perm, row_len), A @ Y
+    )
+    utt.assert_allclose(f_py(Y), A @ Y)
+
+    bad_perm = perm.copy()
+    bad_perm[0] = bad_perm[1]
+    bad_len = row_len.copy()
+    bad_len[0] += (slice_ptr[1] - slice_ptr[0]) // chunk
+    with pytest.raises(ValueError):
+        f_var(Y, col, slice_ptr, bad_perm, row_len)
+    with pytest.raises(ValueError):
+        f_var(Y, col, slice_ptr, perm, bad_len)
+    with pytest.raises(ValueError):
+        f_var(Y, col, slice_ptr, perm, row_len[:-1])
+    with pytest.raises(ValueError):
+        f_var(Y[:20], col, slice_ptr, perm, row_len)
+    with pytest.raises(ValueError):
+        aesara.function([y], op(val, col, slice_ptr, bad_perm, row_len, y))
+    with pytest.raises(ValueError):
+        aesara.function([y], op(val, col, slice_ptr, perm, bad_len, y))
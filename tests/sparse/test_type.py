@@ -1,6 +1,11 @@
+import numpy as np
 import pytest
+import scipy.sparse
 
+import aesara
+from aesara.compile.mode import Mode
 from aesara.sparse import matrix as sp_matrix
+from aesara.sparse.basic import CSM, csm_properties
 from aesara.sparse.type import SparseTensorType
 from aesara.tensor import dmatrix
 
@@ -26,3 +31,26 @@ def test_Sparse_convert_variable():
     # TODO FIXME: We should be able to do this.
     with pytest.raises(NotImplementedError):
         y.type.convert_variable(x)
+
+
+@pytest.mark.skipif(not aesara.config.cxx, reason="G++ not available")
+@pytest.mark.parametrize("format", ["csr", "csc"])
+def test_sparse_c_round_trip(format):
+    # The C code of CSMProperties and CSM takes the matrices apart and builds
+    # new ones
+    x = sp_matrix(format, dtype="float64")
+    y = CSM(format)(*csm_properties(x))
+    f = aesara.function([x], y, mode=Mode(linker="c", optimizer=None))
+
+    ref = getattr(scipy.sparse, f"{format}_matrix")(
+        np.array([[1.0, 0, 2], [0, 0, 3], [4, 0, 0], [0, 5, 0]])
+    )
+    res = f(ref)
+    assert type(res) is type(ref)
+    assert res.format == format
+    assert res.shape == ref.shape
+    assert np.array_equal(res.data, ref.data)
+    assert np.array_equal(res.indices, ref.indices)
+    assert np.array_equal(res.indptr, ref.indptr)
+    assert np.array_equal(res.toarray(), ref.toarray())
+    assert res.has_sorted_indices
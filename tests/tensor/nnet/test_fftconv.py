@@ -0,0 +1,143 @@
+import numpy as np
+import pytest
+
+import aesara
+from aesara.compile.mode import get_default_mode
+from aesara.tensor.nnet import conv2d
+from aesara.tensor.nnet.abstract_conv import AbstractConv2d
+from aesara.tensor.nnet.corr import CorrMM
+from aesara.tensor.nnet.fftconv import FFTConv2d, fft_conv2d, fft_conv_block
+from aesara.tensor.signal import conv as signal_conv
+from aesara.tensor.type import dmatrix, dtensor4, ftensor4
+from tests import unittest_tools as utt
+
+
+mode = get_default_mode().including("fast_run")
+mode_without_fft = mode.excluding("conv_fft")
+
+
+def op_types(f):
+    return [type(node.op) for node in f.maker.fgraph.toposort()]
+
+
+@pytest.mark.parametrize(
+    "imshp, kshp, border_mode, filter_flip",
+    [
+        ((2, 3, 10, 40), (4, 3, 3, 5), "valid", True),
+        ((2, 2, 30, 30), (3, 2, 7, 7), "full", False),
+        ((1, 2, 9, 200), (2, 2, 3, 33), "half", True),
+        ((1, 1, 5, 6), (1, 1, 2, 3), (1, 2), False),
+        ((3, 1, 1, 50), (1, 1, 1, 1), "valid", True),
+        # Long inputs are split into blocks
+        ((2, 1, 1, 3000), (2, 1, 1, 17), "full", True),
+        ((1, 10, 300, 12), (2, 10, 40, 3), "valid", True),
+    ],
+)
+def test_fft_conv2d(imshp, kshp, border_mode, filter_flip):
+    rng = np.random.default_rng(utt.fetch_seed())
+    img = dtensor4("img")
+    kern = dtensor4("kern")
+    f = aesara.function(
+        [img, kern], fft_conv2d(img, kern, border_mode, filter_flip), mode=mode
+    )
+    ref = aesara.function(
+        [img, kern],
+        AbstractConv2d(border_mode=border_mode, filter_flip=filter_flip)(img, kern),
+        mode=mode_without_fft,
+    )
+    img_val = rng.normal(size=imshp)
+    kern_val = rng.normal(size=kshp)
+    res = f(img_val, kern_val)
+    utt.assert_allclose(res, ref(img_val, kern_val))
+
+    out_shape = aesara.function(
+        [img, kern], fft_conv2d(img, kern, border_mode, filter_flip).shape
+    )
+    assert tuple(out_shape(img_val, kern_val)) == res.shape
+
+
+def test_fft_conv_block():
+    # Kernels about as long as the input use a single transform
+    assert fft_conv_block(1000, 61) == (1000, 1080)
+    block, length = fft_conv_block(100000, 1025)
+    assert block == length - 1024
+    assert 2048 <= length < 100000
+
+
+def test_fft_conv2d_grad():
+    rng = np.random.default_rng(utt.fetch_seed())
+    utt.verify_grad(
+        FFTConv2d("full", filter_flip=False),
+        [rng.normal(size=(2, 2, 5, 6)), rng.normal(size=(3, 2, 2, 3))],
+        mode=mode,
+    )
+
+
+def test_fft_conv2d_errors():
+    with pytest.raises(ValueError):
+        FFTConv2d("same")
+    with pytest.raises(ValueError):
+        FFTConv2d((1, -1))
+    with pytest.raises(TypeError):
+        fft_conv2d(ftensor4(), dtensor4())
+
+    img = dtensor4()
+    kern = dtensor4()
+    f = aesara.function([img, kern], fft_conv2d(img, kern), mode=mode)
+    with pytest.raises(ValueError):
+        f(np.ones((1, 2, 5, 5)), np.ones((1, 3, 2, 2)))
+    with pytest.raises(ValueError):
+        f(np.ones((1, 1, 5, 5)), np.ones((1, 1, 6, 2)))
+
+
+def test_conv2d_selects_fft():
+    rng = np.random.default_rng(utt.fetch_seed())
+    img = dtensor4("img")
+    kern = dtensor4("kern")
+    imshp = (2, 2, 1, 4000)
+    kshp = (3, 2, 1, 257)
+    out = conv2d(img, kern, imshp, kshp, border_mode="full")
+    f = aesara.function([img, kern], out, mode=mode)
+    assert op_types(f) == [FFTConv2d]
+
+    ref = aesara.function([img, kern], out, mode=mode_without_fft)
+    assert FFTConv2d not in op_types(ref)
+    img_val = rng.normal(size=imshp)
+    kern_val = rng.normal(size=kshp)
+    utt.assert_allclose(f(img_val, kern_val), ref(img_val, kern_val))
+
+    # The static shapes of the inputs are enough
+    img_s = aesara.tensor.tensor("float64", shape=(None, 2, 1, 4000))
+    kern_s = aesara.tensor.tensor("float64", shape=(3, 2, 1, 257))
+    f = aesara.function([img_s, kern_s], conv2d(img_s, kern_s), mode=mode)
+    assert FFTConv2d in op_types(f)
+
+    # Small or unknown kernels use the direct convolution
+    f = aesara.function(
+        [img, kern], conv2d(img, kern, (2, 2, 30, 30), (3, 2, 3, 3)), mode=mode
+    )
+    assert FFTConv2d not in op_types(f)
+    assert CorrMM in op_types(f)
+    f = aesara.function([img, kern], conv2d(img, kern), mode=mode)
+    assert FFTConv2d not in op_types(f)
+
+    # Strides aren't supported
+    f = aesara.function(
+        [img, kern], conv2d(img, kern, imshp, kshp, subsample=(1, 2)), mode=mode
+    )
+    assert FFTConv2d not in op_types(f)
+
+
+def test_signal_conv2d_selects_fft():
+    rng = np.random.default_rng(utt.fetch_seed())
+    img = dmatrix("img")
+    kern = dmatrix("kern")
+    out = signal_conv.conv2d(img, kern, image_shape=(256, 256), filter_shape=(31, 31))
+    f = aesara.function([img, kern], out, mode=mode)
+    assert FFTConv2d in op_types(f)
+
+    ref = aesara.function([img, kern], out, mode=mode_without_fft)
+    assert FFTConv2d not in op_types(ref)
+    img_val = rng.normal(size=(256, 256))
+    kern_val = rng.normal(size=(31, 31))
+    utt.assert_allclose(f(img_val, kern_val), ref(img_val, kern_val))
@@ -0,0 +1,179 @@
+import numpy as np
+import pytest
+
+import aesara
+import aesara.tensor as at
+from aesara import config, function, shared
+from aesara.compile.mode import Mode
+from aesara.tensor.random import basic as rb
+from aesara.tensor.random.philox import philox4x64, philox_reserve
+from aesara.tensor.random.type import RandomPhiloxType, random_philox_type
+from aesara.tensor.random.utils import RandomStream
+
+
+def philox_rng(seed):
+    return np.random.Generator(np.random.Philox(seed))
+
+
+def shared_philox_rng(seed):
+    return shared(philox_rng(seed), counter_based=True)
+
+
+def test_philox4x64():
+    bit_gen = np.random.Philox(key=np.array([12, 34], dtype=np.uint64))
+    bit_gen.state = {
+        "bit_generator": "Philox",
+        "state": {
+            "counter": np.array([5, 6, 7, 8], dtype=np.uint64),
+            "key": np.array([12, 34], dtype=np.uint64),
+        },
+        "buffer": np.zeros(4, dtype=np.uint64),
+        "buffer_pos": 4,
+        "has_uint32": 0,
+        "uinteger": 0,
+    }
+    # NumPy increments the counter before producing a block
+    exp_res = bit_gen.random_raw(4)
+    res = philox4x64(np.array([[6, 6, 7, 8]], dtype=np.uint64), np.array([12, 34]))[0]
+    assert np.array_equal(res, exp_res)
+
+
+def test_philox_reserve():
+    rng = philox_rng(0)
+    _, c2, c3 = philox_reserve(rng)
+    _, c2_next, c3_next = philox_reserve(rng)
+    assert (c2_next, c3_next) == (c2 + 1, c3)
+
+    # Values drawn by the `Generator` itself never overlap a reserved block
+    rng.random()
+    _, c2_last, _ = philox_reserve(rng)
+    assert c2_last == c2_next + 2
+
+
+def test_RandomPhiloxType():
+    rng = shared_philox_rng(3)
+    assert isinstance(rng.type, RandomPhiloxType)
+    assert rng.type == random_philox_type
+    assert not random_philox_type.is_valid_value(np.random.default_rng(3), True)
+    assert random_philox_type.is_valid_value(philox_rng(3).bit_generator.state, False)
+
+    out = rb.normal(size=(2,), rng=rng)
+    assert isinstance(out.owner.outputs[0].type, RandomPhiloxType)
+    assert out.owner.op.uses_philox(out.owner)
+
+    out = rb.normal(size=(2,), rng=shared(np.random.default_rng(3)))
+    assert not out.owner.op.uses_philox(out.owner)
+
+    with pytest.raises(ValueError, match="Philox"):
+        shared(np.random.default_rng(3), counter_based=True)
+
+
+def test_philox_opt_in():
+    # `Philox` generators keep drawing NumPy's values unless opted in
+    rng = shared(philox_rng(42))
+    assert not isinstance(rng.type, RandomPhiloxType)
+    out = rb.normal(size=(4,), rng=rng)
+    assert not out.owner.op.uses_philox(out.owner)
+    np.testing.assert_array_equal(function([], out)(), philox_rng(42).normal(size=(4,)))
+
+
+philox_cases = [
+    (rb.uniform, (np.array([0.0, 1.0]), 3.0), (4, 2)),
+    (rb.normal, (np.array([[0.0], [10.0]]), np.array([1.0, 2.0, 3.0])), None),
+    (rb.standard_normal, (), (3, 2)),
+    (rb.gamma, (np.array([0.3, 1.0, 5.0]), 2.0), (100, 3)),
+    (rb.beta, (np.array([0.2, 2.0]), np.array([0.5, 3.0])), (100, 2)),
+    (rb.poisson, (np.array([0.0, 3.0, 12.5, 1000.0]),), (100, 4)),
+    (
+        rb.binomial,
+        (np.array([5, 100, 1000, 0]), np.array([0.3, 0.05, 0.9, 0.5])),
+        (100, 4),
+    ),
+    (rb.categorical, (np.array([[0.2, 0.3, 0.5], [1.0, 0.0, 0.0]]),), (100, 2)),
+]
+
+
+@pytest.mark.skipif(config.cxx == "", reason="Philox C kernels need a C++ compiler")
+@pytest.mark.parametrize("openmp", [False, True])
+@pytest.mark.parametrize("rv, params, size", philox_cases)
+def test_philox_c_matches_py(rv, params, size, openmp):
+    res = []
+    for linker, op in [("py", rv), ("c", type(rv)(openmp=openmp))]:
+        rng = shared_philox_rng(42)
+        out = op(*params, size=size, rng=rng)
+        f = function(
+            [],
+            out,
+            updates={rng: out.owner.outputs[0]},
+            mode=Mode(linker=linker, optimizer="fast_run"),
+        )
+        res.append((f(), f()))
+
+    (py_1, py_2), (c_1, c_2) = res
+    assert not np.array_equal(py_1, py_2)
+    if py_1.dtype.kind == "f":
+        np.testing.assert_allclose(c_1, py_1, rtol=1e-12)
+        np.testing.assert_allclose(c_2, py_2, rtol=1e-12)
+    else:
+        np.testing.assert_array_equal(c_1, py_1)
+        np.testing.assert_array_equal(c_2, py_2)
+
+
+@pytest.mark.parametrize(
+    "rv, params, mean, var",
+    [
+        (rb.normal, (1.0, 2.0), 1.0, 4.0),
+        (rb.gamma, (0.5, 2.0), 0.25, 0.125),
+        (rb.gamma, (7.0, 1.0), 7.0, 7.0),
+        (rb.beta, (2.0, 3.0), 0.4, 0.04),
+        (rb.poisson, (4.0,), 4.0, 4.0),
+        (rb.poisson, (50.0,), 50.0, 50.0),
+        (rb.binomial, (20, 0.2), 4.0, 3.2),
+        (rb.binomial, (200, 0.7), 140.0, 42.0),
+    ],
+)
+def test_philox_moments(rv, params, mean, var):
+    n = 100000
+    f = function([], rv(*params, size=(n,), rng=shared_philox_rng(1)))
+    x = f()
+    assert abs(x.mean() - mean) < 5 * np.sqrt(var / n)
+    assert abs(x.var() / var - 1) < 0.05
+
+
+@pytest.mark.parametrize("linker", ["py", "c"])
+def test_philox_invalid_params(linker):
+    if linker == "c" and config.cxx == "":
+        pytest.skip("Philox C kernels need a C++ compiler")
+
+    s = at.dscalar()
+    f = function(
+        [s],
+        rb.normal(0, s, rng=shared_philox_rng(0)),
+        mode=Mode(linker=linker, optimizer="fast_run"),
+    )
+    with pytest.raises(ValueError, match="scale < 0"):
+        f(-1.0)
+
+    x = at.dvector()
+    f = function(
+        [x],
+        rb.normal(x, 1, size=(2, 3), rng=shared_philox_rng(0)),
+        mode=Mode(linker=linker, optimizer="fast_run"),
+    )
+    with pytest.raises(ValueError):
+        f(np.zeros(4))
+
+
+def test_philox_RandomStream():
+    srng = RandomStream(3, counter_based=True)
+    x = srng.normal(size=(3,))
+    assert isinstance(x.owner.inputs[0].type, RandomPhiloxType)
+
+    f = function([], x)
+    assert not np.array_equal(f(), f())
+
+    # Distributions without a Philox kernel draw from the `Generator`
+    y = srng.lognormal(size=(3,))
+    g = aesara.function([], [x, y])
+    x_val, y_val = g()
+    assert np.all(y_val > 0)
@@ -57,7 +57,9 @@ from aesara.tensor.type import (
     integer_dtypes,
     iscalar,
     ivector,
+    lmatrix,
     lscalar,
+    lvector,
     matrix,
     scalar,
     tensor,
@@ -159,9 +161,8 @@ class TestSearchsortedOp(utt.InferShapeTester):
         f = aesara.function(
             [self.x, self.v], searchsorted(self.x, self.v, side="right")
         )
-        assert np.allclose(
-            np.searchsorted(self.a, self.b, side="right"), f(self.a, self.b)
-        )
+        sa = self.a[self.idx_sorted]
+        assert np.allclose(np.searchsorted(sa, self.b, side="right"), f(sa, self.b))
 
     def test_infer_shape(self):
         # Test using default parameters' value
@@ -194,6 +195,59 @@ class TestSearchsortedOp(utt.InferShapeTester):
     def test_grad(self):
         utt.verify_grad(self.op, [self.a[self.idx_sorted], self.b], rng=self.rng)
 
+    @pytest.mark.parametrize("side", ["left", "right"])
+    def test_batched(self, side):
+        x = matrix("x")
+        v = matrix("v")
+        sorter = lmatrix("sorter")
+        a = self.rng.integers(0, 10, (4, 20)).astype(config.floatX)
+        b = self.rng.integers(-1, 11, (4, 6)).astype(config.floatX)
+        idx_sorted = np.argsort(a, axis=-1)
+        expected = np.stack(
+            [np.searchsorted(np.sort(a[i]), b[i], side=side) for i in range(4)]
+        )
+
+        f = aesara.function([x, v], searchsorted(x, v, side=side))
+        assert np.array_equal(f(np.sort(a, axis=-1), b), expected)
+
+        f = aesara.function([x, v, sorter], searchsorted(x, v, side, sorter))
+        assert np.array_equal(f(a, b, idx_sorted), expected)
+
+        with pytest.raises(ValueError):
+            f(a, b[:3], idx_sorted)
+        with pytest.raises(ValueError):
+            searchsorted(x, self.v)
+
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("side", ["left", "right"])
+    @pytest.mark.parametrize("dtype", ["int32", "float64"])
+    def test_c_code(self, dtype, side, openmp):
+        mode = Mode(linker="c", optimizer="fast_run")
+        x = vector("x", dtype=dtype)
+        v = vector("v", dtype=dtype)
+        sorter = lvector("sorter")
+        op = SearchsortedOp(side, openmp=openmp)
+
+        # Long enough to use the Eytzinger layout
+        a = np.sort(self.rng.integers(0, 1000, op.c_eytzinger_minsize + 5))
+        a = a.astype(dtype)
+        b = self.rng.integers(-1, 1001, 4000).astype(dtype)
+        if dtype == "float64":
+            a[-10:] = np.nan
+            b[:10] = np.nan
+
+        for n in (0, 1, 37, a.shape[0]):
+            f = aesara.function([x, v], op(x, v), mode=mode)
+            assert np.array_equal(f(a[:n], b), np.searchsorted(a[:n], b, side=side))
+
+        perm = self.rng.permutation(a.shape[0])
+        f = aesara.function([x, v, sorter], op(x, v, sorter), mode=mode)
+        assert np.array_equal(
+            f(a[perm], b, np.argsort(perm)), np.searchsorted(a, b, side=side)
+        )
+        with pytest.raises(ValueError, match="Sorter index out of range"):
+            f(a[:3], b, np.array([0, 3, 1]))
+
 
 class TestCumOp(utt.InferShapeTester):
     def setup_method(self):
@@ -226,6 +280,31 @@ class TestCumOp(utt.InferShapeTester):
             assert np.allclose(np.cumsum(a, axis=axis), s)
             assert np.allclose(np.cumprod(a, axis=axis), p)
 
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("deterministic", ["default", "more"])
+    @pytest.mark.parametrize("dtype", ["float64", "int32", "uint8"])
+    def test_c_code(self, openmp, deterministic, dtype):
+        x = tensor3("x", dtype=dtype)
+        rng = np.random.default_rng(utt.fetch_seed())
+        with config.change_flags(
+            openmp=openmp, openmp_elemwise_minsize=64, deterministic=deterministic
+        ):
+            for axis in (None, 0, 1, -1):
+                f = aesara.function(
+                    [x],
+                    [cumsum(x, axis=axis), cumprod(x, axis=axis)],
+                    mode=Mode(linker="c"),
+                )
+                # The long rows use the blocked scan when OpenMP is enabled
+                for shp in ((3, 5, 7), (1, 1, 1000), (2, 500, 1), (0, 3, 4)):
+                    a = rng.uniform(0.9, 1.1, size=shp).astype(dtype)
+                    s, p = f(a)
+                    utt.assert_allclose(np.cumsum(a, axis=axis, dtype=dtype), s)
+                    utt.assert_allclose(np.cumprod(a, axis=axis, dtype=dtype), p)
+                    # Non-contiguous inputs use NumPy
+                    s, p = f(np.asfortranarray(a))
+                    utt.assert_allclose(np.cumsum(a, axis=axis, dtype=dtype), s)
+
     def test_infer_shape(self):
         x = tensor3("x")
         a = np.random.random((3, 5, 2)).astype(config.floatX)
@@ -310,6 +389,23 @@ class TestDiffOp(utt.InferShapeTester):
                 g = aesara.function([x], diff(x, n=n, axis=axis))
                 assert np.allclose(np.diff(a, n=n, axis=axis), g(a))
 
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("dtype", ["float64", "int16", "bool"])
+    def test_c_code(self, openmp, dtype):
+        x = tensor3("x", dtype=dtype)
+        rng = np.random.default_rng(utt.fetch_seed())
+        a = rng.integers(0, 5, size=(4, 6, 5)).astype(dtype)
+        with config.change_flags(openmp=openmp, openmp_elemwise_minsize=10):
+            for axis in (0, 1, -1):
+                for n in (1, 2, 3, 6):
+                    f = aesara.function(
+                        [x], diff(x, n=n, axis=axis), mode=Mode(linker="c")
+                    )
+                    for a_val in (a, np.asfortranarray(a)):
+                        out = f(a_val)
+                        assert out.dtype == a.dtype
+                        assert np.array_equal(np.diff(a_val, n=n, axis=axis), out)
+
     @pytest.mark.parametrize(
         "x_type",
         (
@@ -551,6 +647,38 @@ class TestRepeat(utt.InferShapeTester):
                             ]
                         )
 
+    @pytest.mark.parametrize("openmp", [False, True])
+    def test_c_code(self, openmp):
+        x = matrix("x", dtype="float64")
+        r_scalar = lscalar("r")
+        r_vector = ivector("r")
+        rng = np.random.default_rng(utt.fetch_seed())
+        a = rng.random((5, 4)).T
+        for axis in self._possible_axis(a.ndim):
+            with config.change_flags(openmp=openmp, openmp_elemwise_minsize=10):
+                f_scalar = aesara.function(
+                    [x, r_scalar],
+                    Repeat(axis=axis)(x, r_scalar),
+                    mode=Mode(linker="c"),
+                )
+                f_vector = aesara.function(
+                    [x, r_vector],
+                    Repeat(axis=axis)(x, r_vector),
+                    mode=Mode(linker="c"),
+                )
+            for r in (0, 1, 3):
+                assert np.array_equal(f_scalar(a, r), np.repeat(a, r, axis=axis))
+            size = a.size if axis is None else a.shape[axis]
+            r = rng.integers(0, 4, size=size).astype("int32")
+            assert np.array_equal(f_vector(a, r), np.repeat(a, r, axis=axis))
+
+            with pytest.raises(ValueError):
+                f_scalar(a, -1)
+            with pytest.raises(ValueError):
+                f_vector(a, -r - 1)
+            with pytest.raises(ValueError):
+                f_vector(a, np.ones(size + 1, dtype="int32"))
+
     @pytest.mark.slow
     def test_infer_shape(self):
         for ndim in [1, 3]:
@@ -667,6 +795,18 @@ class TestFillDiagonal(utt.InferShapeTester):
         assert out[2, 2, 2] == val
         assert (out == val).sum() == min(a.shape)
 
+    def test_c_code(self):
+        x = tensor3()
+        y = scalar()
+        f = function([x, y], fill_diagonal(x, y), mode=Mode(linker="c"))
+        a = np.asfortranarray(np.random.random((3, 3, 3)).astype(config.floatX))
+        out = f(a, 7)
+        expected = a.copy()
+        np.fill_diagonal(expected, 7)
+        assert np.array_equal(out, expected)
+        with pytest.raises(ValueError, match="equal length"):
+            f(np.zeros((3, 3, 2), dtype=config.floatX), 1)
+
     @pytest.mark.slow
     def test_gradient(self):
         utt.verify_grad(
@@ -880,6 +1020,27 @@ class TestUnique(utt.InferShapeTester):
                 Unique,
             )
 
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("dtype", ["float64", "int8", "bool"])
+    def test_c_code(self, openmp, dtype):
+        x = matrix(dtype=dtype)
+        rng = np.random.default_rng(utt.fetch_seed())
+        inp = rng.integers(-10, 10, size=(30, 20)).astype(dtype)
+        if dtype == "float64":
+            # NaNs are all equal, and so are 0 and -0
+            inp[::7, 1] = np.nan
+            inp[::5, 2] = -0.0
+        inp = inp.T
+        for params in self.op_params:
+            with config.change_flags(openmp=openmp, openmp_elemwise_minsize=10):
+                f = aesara.function([x], at.unique(x, *params), mode=Mode(linker="c"))
+            outs = f(inp)
+            outs_expected = np.unique(inp, *params)
+            if not isinstance(outs, list):
+                outs, outs_expected = [outs], [outs_expected]
+            for out, out_exp in zip(outs, outs_expected):
+                np.testing.assert_array_equal(out, out_exp)
+
 
 class TestUnravelIndex(utt.InferShapeTester):
     def test_unravel_index(self):
@@ -934,6 +1095,12 @@ class TestUnravelIndex(utt.InferShapeTester):
                 check((3, 4), index_ndim, order)
                 check((3, 4, 5), index_ndim, order)
 
+        # out of bounds indices
+        i = lvector()
+        f = function([i], unravel_index(i, (3, 4)))
+        with pytest.raises(ValueError, match="out of bounds"):
+            f([3, 12])
+
         # must specify ndim if length of dims is not fixed
         with pytest.raises(ValueError):
             unravel_index(ivector(), ivector())
@@ -1004,6 +1171,14 @@ class TestRavelMultiIndex(utt.InferShapeTester):
                     check((3, 4), index_ndim, mode, order)
                     check((3, 4, 5), index_ndim, mode, order)
 
+        # invalid indices in "raise" mode, and broadcasted indices
+        i = lmatrix()
+        j = lvector()
+        f = function([i, j], ravel_multi_index((i, j), (3, 4)))
+        np.testing.assert_equal(f([[0], [2]], [1, 2]), [[1, 2], [9, 10]])
+        with pytest.raises(ValueError, match="invalid entry"):
+            f([[0], [3]], [1, 2])
+
         # must provide integers
         with pytest.raises(TypeError):
             ravel_multi_index((fvector(), ivector()), (3, 4))
@@ -3,7 +3,7 @@ import pytest
 
 import aesara
 from aesara.tensor import fft
-from aesara.tensor.type import matrix
+from aesara.tensor.type import TensorType, matrix
 from tests import unittest_tools as utt
 
 
@@ -204,3 +204,64 @@ class TestFFT:
             aesara.config.floatX
         )
         utt.verify_grad(f_irfft, [inputs_val], eps=eps)
+
+    @pytest.mark.skipif(
+        not aesara.config.cxx, reason="G++ not available, so we need to skip this test."
+    )
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("dtype", ["float32", "float64"])
+    @pytest.mark.parametrize(
+        "shape, s",
+        [
+            ((3, 16), (16,)),
+            ((3, 1), (1,)),
+            ((3, 15), (15,)),
+            # Bluestein's algorithm for large prime factors
+            ((2, 97), (97,)),
+            ((2, 10), (16,)),
+            ((2, 20), (7,)),
+            ((2, 6, 12), (6, 12)),
+            ((2, 5, 7), (8, 3)),
+            ((2, 3, 9), (5, 4, 8)),
+        ],
+    )
+    def test_c_code(self, shape, s, dtype, openmp):
+        rng = np.random.default_rng(utt.fetch_seed())
+        mode = aesara.compile.mode.Mode(linker="c")
+        axes = tuple(range(len(shape) - len(s), len(shape)))
+        tol = 1e-4 if dtype == "float32" else 1e-10
+
+        x = TensorType(dtype, shape=(False,) * len(shape))()
+        f = aesara.function([x], fft.RFFTOp(openmp=openmp)(x, s), mode=mode)
+        x_val = rng.normal(size=shape).astype(dtype)
+        res = f(x_val)
+        # The plans are reused by the next calls
+        np.testing.assert_array_equal(f(x_val), res)
+        expected = np.fft.rfftn(x_val, s, axes=axes)
+        assert res.dtype == dtype
+        np.testing.assert_allclose(res[..., 0], expected.real, rtol=tol, atol=tol * 10)
+        np.testing.assert_allclose(res[..., 1], expected.imag, rtol=tol, atol=tol * 10)
+
+        z = TensorType(dtype, shape=(False,) * (len(shape) + 1))()
+        g = aesara.function([z], fft.IRFFTOp(openmp=openmp)(z, s), mode=mode)
+        res = g(res)
+        expected = np.fft.irfftn(expected, s, axes=axes) * np.prod(s)
+        assert res.dtype == dtype
+        np.testing.assert_allclose(res, expected, rtol=tol, atol=tol * 10)
+
+    @pytest.mark.skipif(
+        not aesara.config.cxx, reason="G++ not available, so we need to skip this test."
+    )
+    def test_c_code_errors(self):
+        mode = aesara.compile.mode.Mode(linker="c")
+        x = matrix("x")
+        s = aesara.tensor.lvector("s")
+        f = aesara.function([x, s], fft.rfft_op(x, s), mode=mode)
+        x_val = np.ones((2, 4), dtype=aesara.config.floatX)
+        with pytest.raises(ValueError, match="Invalid number of FFT data points"):
+            f(x_val, [0])
+        with pytest.raises(ValueError):
+            f(x_val, [2, 2, 2])
+        # The shapes can change between calls
+        assert f(x_val, [4]).shape == (2, 3, 2)
+        assert f(x_val, [2, 6]).shape == (2, 4, 2)
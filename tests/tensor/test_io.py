@@ -7,7 +7,8 @@ import aesara
 from aesara import function
 from aesara.graph.basic import Variable
 from aesara.link.c.type import Generic
-from aesara.tensor.io import load
+from aesara.tensor.io import ChunkReader, load
+from aesara.tensor.type import matrix
 
 
 class TestLoadTensor:
@@ -55,3 +56,83 @@ class TestLoadTensor:
 
     def teardown_method(self):
         os.remove(os.path.join(aesara.config.compiledir, "_test.npy"))
+
+
+class TestChunkReader:
+    def setup_method(self):
+        self.data = np.arange(60, dtype="float32").reshape(20, 3)
+        self.npy = os.path.join(aesara.config.compiledir, "_test_chunks.npy")
+        self.raw = os.path.join(aesara.config.compiledir, "_test_chunks.bin")
+        np.save(self.npy, self.data)
+        with open(self.raw, "wb") as f:
+            f.write(b"head")
+            self.data.tofile(f)
+
+    def teardown_method(self):
+        os.remove(self.npy)
+        os.remove(self.raw)
+
+    @pytest.mark.parametrize("mmap_mode", [None, "r"])
+    def test_chunks(self, mmap_mode):
+        x = matrix("x", dtype="float32")
+        fn = function([x], x.sum(axis=0))
+        readers = [
+            ChunkReader(self.npy, 6, mmap_mode=mmap_mode),
+            ChunkReader(self.raw, 6, "float32", (-1, 3), offset=4, mmap_mode=mmap_mode),
+        ]
+        for reader in readers:
+            assert reader.shape == (20, 3)
+            assert len(reader) == 4
+            chunks = list(reader)
+            assert [len(c) for c in chunks] == [6, 6, 6, 2]
+            np.testing.assert_array_equal(np.concatenate(chunks), self.data)
+            assert chunks[0].flags.writeable == (mmap_mode is None)
+            np.testing.assert_array_equal(
+                sum(fn(c) for c in reader), self.data.sum(axis=0)
+            )
+
+        with ChunkReader(self.npy, 4, mmap_mode=mmap_mode, start=3, stop=-5) as r:
+            np.testing.assert_array_equal(np.concatenate(list(r)), self.data[3:15])
+        assert list(ChunkReader(self.npy, 4, start=30)) == []
+
+    def test_raw_shapes(self):
+        reader = ChunkReader(self.raw, 7, "float32", offset=4)
+        assert reader.shape == (60,)
+        np.testing.assert_array_equal(
+            np.concatenate(list(reader)), self.data.reshape(-1)
+        )
+        reader = ChunkReader(self.raw, 7, "float32", (10, 3), offset=4)
+        np.testing.assert_array_equal(np.concatenate(list(reader)), self.data[:10])
+
+    def test_early_stop(self):
+        reader = ChunkReader(self.npy, 1, prefetch=1)
+        for i, chunk in enumerate(reader):
+            if i == 2:
+                break
+        reader.close()
+        assert reader._thread is None
+        # The reader can be iterated again
+        assert len(list(reader)) == 20
+
+    def test_errors(self):
+        with pytest.raises(ValueError):
+            ChunkReader(self.npy, 4, mmap_mode="c")
+        with pytest.raises(ValueError):
+            ChunkReader(self.npy, 0)
+        with pytest.raises(ValueError):
+            ChunkReader(self.raw, 4)
+        with pytest.raises(ValueError):
+            ChunkReader(self.raw, 4, "float32", (-1, 7))
+        with pytest.raises(ValueError):
+            ChunkReader(self.raw, 4, "float32", (30, 3))
+        np.save(self.npy, np.asfortranarray(self.data))
+        with pytest.raises(ValueError):
+            ChunkReader(self.npy, 4)
+
+        # Truncated files are reported when the chunks are read
+        with open(self.npy, "r+b") as f:
+            np.save(f, self.data)
+            f.truncate(f.tell() - 12)
+        reader = ChunkReader(self.npy, 8)
+        with pytest.raises(EOFError):
+            list(reader)
@@ -0,0 +1,180 @@
+import numpy as np
+import pytest
+
+import aesara
+from aesara import function, shared
+from aesara.compile.mode import get_default_mode
+from aesara.configdefaults import config
+from aesara.tensor.math import dot
+from aesara.tensor.nlinalg import Det, MatrixInverse, det, matrix_inverse
+from aesara.tensor.slinalg import (
+    CachedFactorization,
+    Cholesky,
+    CholeskySolve,
+    LUFactor,
+    LUSolve,
+    Solve,
+    cholesky,
+    solve,
+)
+from aesara.tensor.type import dmatrix, dvector
+from tests import unittest_tools as utt
+
+
+mode = get_default_mode().including("fast_run")
+if config.mode == "FAST_COMPILE":
+    mode = aesara.Mode(linker="cvm", optimizer="fast_run")
+
+
+def op_types(f):
+    types = []
+    for node in f.maker.fgraph.toposort():
+        op = node.op
+        if isinstance(op, CachedFactorization):
+            types.append(CachedFactorization)
+            op = op.op
+        types.append(type(op))
+    return types
+
+
+def test_inv_as_solve():
+    rng = np.random.default_rng(utt.fetch_seed())
+    A = dmatrix("A")
+    b = dmatrix("b")
+    f = function(
+        [A, b], [dot(matrix_inverse(A), b), dot(b, matrix_inverse(A))], mode=mode
+    )
+    assert MatrixInverse not in op_types(f)
+    assert op_types(f).count(Solve) == 2
+
+    A_val = rng.normal(size=(4, 4))
+    b_val = rng.normal(size=(4, 4))
+    left, right = f(A_val, b_val)
+    np.testing.assert_allclose(left, np.linalg.solve(A_val, b_val))
+    np.testing.assert_allclose(right, b_val @ np.linalg.inv(A_val))
+
+
+def test_share_lu_factor():
+    rng = np.random.default_rng(utt.fetch_seed())
+    A = dmatrix("A")
+    b = dmatrix("b")
+    c = dvector("c")
+    outs = [solve(A, b), solve(A, c), matrix_inverse(A), det(A)]
+
+    # A single solve factors its matrix itself
+    f = function([A, b], outs[0], mode=mode)
+    assert op_types(f) == [Solve]
+
+    f = function([A, b, c], outs, mode=mode)
+    types = op_types(f)
+    assert types.count(LUFactor) == 1
+    assert types.count(LUSolve) == 3
+    assert not {Solve, MatrixInverse, Det} & set(types)
+
+    for A_val in (rng.normal(size=(4, 4)), np.diag([1.0, 1.0, -2.0, 3.0])[::-1]):
+        b_val = rng.normal(size=(4, 2))
+        c_val = rng.normal(size=4)
+        res = f(A_val, b_val, c_val)
+        exp = [
+            np.linalg.solve(A_val, b_val),
+            np.linalg.solve(A_val, c_val),
+            np.linalg.inv(A_val),
+            np.linalg.det(A_val),
+        ]
+        for r, e in zip(res, exp):
+            np.testing.assert_allclose(r, e, rtol=1e-10, atol=1e-12)
+
+    # Determinants of singular matrices are zero, and solves with them fail
+    g = function([A], det(A), mode=mode)
+    assert g(np.ones((3, 3))) == 0
+    with pytest.raises(np.linalg.LinAlgError):
+        f(np.ones((4, 4)), b_val, c_val)
+
+
+def test_share_cholesky():
+    rng = np.random.default_rng(utt.fetch_seed())
+    A = dmatrix("A")
+    b = dmatrix("b")
+    c = dvector("c")
+
+    f = function([A, b], solve(A, b, assume_a="pos"), mode=mode)
+    assert op_types(f) == [Solve]
+
+    f = function(
+        [A, b, c],
+        [
+            cholesky(A),
+            solve(A, b, assume_a="pos", lower=True),
+            solve(A, c, assume_a="pos", lower=True),
+        ],
+        mode=mode,
+    )
+    types = op_types(f)
+    assert types.count(Cholesky) == 1
+    assert types.count(CholeskySolve) == 2
+    assert Solve not in types
+
+    r = rng.normal(size=(4, 4))
+    A_val = r @ r.T + 4 * np.eye(4)
+    b_val = rng.normal(size=(4, 2))
+    c_val = rng.normal(size=4)
+    L, x_b, x_c = f(A_val, b_val, c_val)
+    np.testing.assert_allclose(L, np.linalg.cholesky(A_val))
+    np.testing.assert_allclose(x_b, np.linalg.solve(A_val, b_val))
+    np.testing.assert_allclose(x_c, np.linalg.solve(A_val, c_val))
+
+    # Factors of the other triangle are not shared
+    f = function(
+        [A, b], [cholesky(A), solve(A, b, assume_a="pos", lower=False)], mode=mode
+    )
+    assert op_types(f) == [Cholesky, Solve] or op_types(f) == [Solve, Cholesky]
+
+
+def test_cache_shared_factorization():
+    rng = np.random.default_rng(utt.fetch_seed())
+    r = rng.normal(size=(4, 4))
+    K_val = r @ r.T + 4 * np.eye(4)
+    K = shared(K_val)
+    A = shared(rng.normal(size=(4, 4)))
+    b = dvector("b")
+    f = function([b], [solve(K + 1, b, assume_a="pos"), solve(A, b), det(A)], mode=mode)
+    types = op_types(f)
+    assert types.count(CachedFactorization) == 2
+    assert types.count(Cholesky) == 1
+    assert types.count(LUFactor) == 1
+
+    def check():
+        x_K, x_A, det_A = f(b_val)
+        np.testing.assert_allclose(x_K, np.linalg.solve(K.get_value() + 1, b_val))
+        np.testing.assert_allclose(x_A, np.linalg.solve(A.get_value(), b_val))
+        np.testing.assert_allclose(det_A, np.linalg.det(A.get_value()))
+
+    b_val = rng.normal(size=4)
+    check()
+    b_val = rng.normal(size=4)
+    check()
+    K.set_value(K_val + np.eye(4))
+    check()
+    A.get_value(borrow=True)[0, 0] += 1
+    check()
+
+    # Updated shared variables are refactored at the next call
+    g = function([], [], updates={A: A * 2}, mode=mode)
+    g()
+    check()
+
+    # Factorizations that depend on the inputs are not cached
+    B = dmatrix("B")
+    f = function([B, b], solve(B + A, b), mode=mode)
+    assert CachedFactorization not in op_types(f)
+
+
+def test_no_shared_factorizations_without_c():
+    A = dmatrix("A")
+    b = dmatrix("b")
+    f = function(
+        [A, b],
+        [solve(A, b), det(A)],
+        mode=mode.excluding("cxx_only"),
+    )
+    assert LUFactor not in op_types(f)
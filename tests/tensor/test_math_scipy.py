@@ -11,9 +11,11 @@ import scipy.stats
 
 from aesara import function
 from aesara import tensor as at
-from aesara.compile.mode import get_default_mode
+from aesara.compile.mode import Mode, get_default_mode
 from aesara.configdefaults import config
+from aesara.scalar.math import gammainc_der, gammaincc_der
 from aesara.tensor import inplace
+from aesara.tensor.elemwise import Elemwise
 from tests import unittest_tools as utt
 from tests.tensor.utils import (
     _good_broadcast_unary_chi2sf,
@@ -237,6 +239,78 @@ TestTriGammaInplaceBroadcast = makeBroadcastTester(
     inplace=True,
 )
 
+
+@pytest.mark.skipif(config.cxx == "", reason="Test requires a C compiler")
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+@pytest.mark.parametrize(
+    "op, expected",
+    [(at.gammaln, scipy.special.gammaln), (at.psi, scipy.special.psi)],
+)
+def test_gammaln_psi_c_contiguous(op, expected, dtype):
+    x_val = np.concatenate(
+        [
+            np.linspace(-10, 30, 4001),
+            np.geomspace(1e-300, 1e300, 601),
+            [1 - 1e-9, 1 + 1e-9, 2 - 1e-9, 2 + 1e-9, 1.4616321449683622],
+            [-0.0, 0.0, -1e-300, np.inf, np.nan, 3e305],
+        ]
+    ).astype(dtype)
+    x = at.vector(dtype=dtype)
+    # `x[::2]` is not contiguous and goes through the generic loop
+    f = function([x], [op(x), op(x[::2])], mode=get_default_mode().excluding("fusion"))
+    res, res_strided = f(x_val)
+
+    with np.errstate(all="ignore"):
+        exp_res = expected(x_val.astype("float64")).astype(dtype)
+    if op is at.gammaln:
+        # lgamma of the C library returns finite values for subnormals
+        keep = ~((np.abs(x_val) < np.finfo(dtype).tiny) & (x_val != 0))
+    else:
+        keep = np.ones_like(x_val, dtype=bool)
+    rtol = 1e-6 if dtype == "float32" else 1e-13
+    np.testing.assert_allclose(res[keep], exp_res[keep], rtol=rtol, atol=rtol)
+    np.testing.assert_allclose(res_strided, res[::2], rtol=rtol, atol=rtol)
+
+
+@pytest.mark.skipif(config.cxx == "", reason="Test requires a C compiler")
+@pytest.mark.parametrize(
+    "op, expected, x_val",
+    [
+        (
+            at.erfinv,
+            scipy.special.erfinv,
+            [-2, -1, -0.9999999999, -0.5, -1e-300, 0, 1e-10, 0.3, 0.5, 0.99, 1, np.nan],
+        ),
+        (
+            at.erfcinv,
+            scipy.special.erfcinv,
+            [-1, 0, 1e-300, 1e-20, 0.01, 0.5, 0.9999, 1, 1.5, 1.99, 2, 3, np.nan],
+        ),
+    ],
+)
+def test_erfinv_c_code(op, expected, x_val):
+    x_val = np.asarray(x_val, dtype="float64")
+    x = at.vector(dtype="float64")
+    res = function([x], op(x))(x_val)
+    np.testing.assert_allclose(res, expected(x_val), rtol=1e-14)
+
+
+@pytest.mark.skipif(config.cxx == "", reason="Test requires a C compiler")
+@pytest.mark.parametrize("scalar_op", [gammainc_der, gammaincc_der])
+def test_gammainc_der_c_matches_py(scalar_op):
+    # The series used by both implementations cancels for large `k` and `x`
+    k_val, x_val = np.meshgrid(
+        [0.01, 0.5, 1.0, 2.5, 7.0, 12.0],
+        [1e-3, 0.2, 1.0, 5.0, 9.0, 20.0, 35.0],
+    )
+    k_val, x_val = k_val.ravel(), x_val.ravel()
+    k, x = at.dvectors("k", "x")
+    out = Elemwise(scalar_op)(k, x)
+    res_c = function([k, x], out, mode=Mode(linker="c"))(k_val, x_val)
+    res_py = function([k, x], out, mode=Mode(linker="py"))(k_val, x_val)
+    np.testing.assert_allclose(res_c, res_py, rtol=1e-7, atol=1e-12)
+
+
 TestChi2SFBroadcast = makeBroadcastTester(
     op=at.chi2sf,
     expected=expected_chi2sf,
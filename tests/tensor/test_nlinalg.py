@@ -34,6 +34,7 @@ from aesara.tensor.type import (
     lscalar,
     matrix,
     scalar,
+    tensor,
     tensor3,
     tensor4,
     vector,
@@ -280,6 +281,57 @@ def test_det_shape():
     assert tuple(det_shape.data) == ()
 
 
+@pytest.mark.skipif(not config.cxx, reason="Needs a C++ compiler")
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+@pytest.mark.parametrize("shape", [(5, 5), (3, 4, 4), (2, 3, 4, 4), (0, 4, 4)])
+def test_batched_inverse_det(dtype, shape):
+    rng = np.random.default_rng(utt.fetch_seed())
+    x_val = rng.standard_normal(shape).astype(dtype)
+    x = tensor(dtype=dtype, shape=(False,) * len(shape))
+    rtol = 1e-3 if dtype == "float32" else 1e-10
+    for out in (matrix_inverse(x), det(x)):
+        py, c = [
+            function([x], out, mode=aesara.Mode(linker=linker, optimizer=None))(x_val)
+            for linker in ("py", "c")
+        ]
+        assert c.shape == py.shape and c.dtype == py.dtype
+        np.testing.assert_allclose(c, py, rtol=rtol, atol=rtol)
+
+
+@pytest.mark.skipif(not config.cxx, reason="Needs a C++ compiler")
+def test_batched_singular():
+    mode = aesara.Mode(linker="c", optimizer=None)
+    x = tensor3()
+    x_val = np.stack([np.eye(3), np.ones((3, 3))]).astype(config.floatX)
+    assert np.array_equal(function([x], det(x), mode=mode)(x_val), [1, 0])
+    with pytest.raises(np.linalg.LinAlgError):
+        function([x], matrix_inverse(x), mode=mode)(x_val)
+
+
+def test_batched_inverse_det_grad():
+    rng = np.random.default_rng(utt.fetch_seed())
+    r = rng.standard_normal((3, 4, 4)) + 4 * np.eye(4)
+    utt.verify_grad(matrix_inverse, [r], rng=np.random)
+    utt.verify_grad(det, [r], rng=np.random)
+
+
+def test_batched_decompositions():
+    rng = np.random.default_rng(utt.fetch_seed())
+    x_val = rng.standard_normal((2, 3, 4, 4)).astype(config.floatX)
+    x_val = x_val + np.swapaxes(x_val, -1, -2)
+    x = tensor4()
+    for outs, ref in [
+        (eig(x), np.linalg.eig(x_val)),
+        (eigh(x), np.linalg.eigh(x_val)),
+        (svd(x), np.linalg.svd(x_val)),
+    ]:
+        f = function([x], [*outs, *(o.shape for o in outs)])
+        res = f(x_val)
+        for val, shp, ref_val in zip(res, res[len(outs) :], ref):
+            assert tuple(shp) == ref_val.shape
+            np.testing.assert_allclose(abs(val), abs(ref_val), rtol=1e-3)
+
+
 def test_trace():
     rng = np.random.default_rng(utt.fetch_seed())
     x = matrix()
@@ -518,7 +518,8 @@ def makeSharedTester(
                 assert (
                     sum(
                         [
-                            node.op.__class__.__name__ in ["Gemm", "StructuredDot"]
+                            node.op.__class__.__name__
+                            in ["Gemm", "StructuredDot", "SpGEMMCSR"]
                             for node in topo
                         ]
                     )
@@ -550,7 +551,8 @@ def makeSharedTester(
                 assert (
                     sum(
                         [
-                            node.op.__class__.__name__ in ["Gemm", "StructuredDot"]
+                            node.op.__class__.__name__
+                            in ["Gemm", "StructuredDot", "SpGEMMCSR"]
                             for node in topo
                         ]
                     )
@@ -580,7 +582,8 @@ def makeSharedTester(
                 assert (
                     sum(
                         [
-                            node.op.__class__.__name__ in ["Gemm", "StructuredDot"]
+                            node.op.__class__.__name__
+                            in ["Gemm", "StructuredDot", "SpGEMMCSR"]
                             for node in topo
                         ]
                     )
@@ -0,0 +1,157 @@
+import time
+
+import numpy as np
+import pytest
+
+import aesara
+from aesara.compile.mode import Mode
+from aesara.graph.sched import sort_schedule_fn
+from aesara.link.vm import VMLinker
+from aesara.tensor.io import (
+    SharedMemoryGroup,
+    ShmCollective,
+    ShmRequest,
+    ShmWait,
+    all_gather,
+    all_reduce,
+    all_reduce_gradients,
+    launch,
+    reduce_scatter,
+    shm_cmps,
+    shm_start_wait_cmp,
+)
+from aesara.tensor.math import exp
+from aesara.tensor.type import dvector, matrix
+
+
+shm_mode = Mode(linker=VMLinker(schedule=sort_schedule_fn(*shm_cmps)))
+
+
+def collectives(group):
+    rank, size = group.rank, group.size
+    x = np.arange(10.0) + rank
+    results = {
+        "sum": group.all_reduce(x),
+        "mean": group.all_reduce(x, "mean"),
+        "max": group.all_reduce(x, "max"),
+        # Arrays larger than the slots are processed in pieces
+        "large": group.all_reduce(np.full((1000, 7), rank, dtype="float32")),
+        "broadcast": group.broadcast(np.full(5000, rank), root=size - 1),
+        "gather": group.all_gather(np.full((3, 2), rank)),
+        "scatter": group.reduce_scatter(
+            np.arange(size * 12.0).reshape(size * 4, 3) * (rank + 1)
+        ),
+        "empty": group.all_reduce(np.zeros((0, 3))),
+    }
+
+    v = dvector("v")
+    f = aesara.function(
+        [v],
+        [all_reduce(v * 2, group, tag=1), all_gather(v, group.name, tag=2)],
+        mode=shm_mode,
+    )
+    results["graph"] = f(np.arange(3.0) * (rank + 1))
+    # The buffers of the previous call are reused
+    results["graph_again"] = f(np.ones(3))
+    with pytest.raises(ValueError):
+        group.all_reduce(np.arange(3), "mean")
+    return results
+
+
+@pytest.mark.parametrize("size", [2, 3])
+def test_collectives(size):
+    results = launch(collectives, size, capacity=4096, timeout=60)
+    ranks = np.arange(size)
+    for rank, res in enumerate(results):
+        np.testing.assert_allclose(res["sum"], size * np.arange(10.0) + ranks.sum())
+        np.testing.assert_allclose(res["mean"], np.arange(10.0) + ranks.mean())
+        np.testing.assert_allclose(res["max"], np.arange(10.0) + size - 1)
+        assert res["large"].dtype == "float32"
+        np.testing.assert_allclose(res["large"], ranks.sum())
+        np.testing.assert_allclose(res["broadcast"], size - 1)
+        np.testing.assert_allclose(res["gather"], np.repeat(ranks, 3)[:, None] + [0, 0])
+        expected = np.arange(size * 12.0).reshape(size * 4, 3) * (ranks + 1).sum()
+        np.testing.assert_allclose(res["scatter"], expected[rank * 4 : rank * 4 + 4])
+        assert res["empty"].shape == (0, 3)
+
+        reduced, gathered = res["graph"]
+        np.testing.assert_allclose(reduced, 2 * np.arange(3.0) * (ranks + 1).sum())
+        np.testing.assert_allclose(
+            gathered, np.outer(ranks + 1, np.arange(3.0)).ravel()
+        )
+        np.testing.assert_allclose(res["graph_again"][0], 2 * size)
+
+
+def test_single_process_group():
+    with SharedMemoryGroup("aesara_test_shm_group", 0, 1, timeout=10) as group:
+        x = np.arange(6.0).reshape(3, 2)
+        np.testing.assert_array_equal(group.all_reduce(x), x)
+        np.testing.assert_array_equal(group.reduce_scatter(x), x)
+        with pytest.raises(ValueError):
+            group.start("all_reduce", x, np.empty(5), "sum")
+    with pytest.raises(ValueError):
+        SharedMemoryGroup("aesara_test_shm_group", 2, 2)
+
+
+def test_input_modified_before_wait():
+    # The in-place addition runs between the start of the reduction and its
+    # wait, while the background thread is still busy
+    v = dvector("v")
+    y = exp(v)
+    with SharedMemoryGroup("aesara_test_shm_inplace", 0, 1, timeout=10) as group:
+        f = aesara.function([v], [all_reduce(y, group), y + 1], mode=shm_mode)
+        assert any(node.op.destroy_map for node in f.maker.fgraph.apply_nodes)
+        group._requests.put(ShmRequest(time.sleep, (0.2,)))
+        reduced, z = f(np.zeros(3))
+    np.testing.assert_array_equal(reduced, np.ones(3))
+    np.testing.assert_array_equal(z, np.full(3, 2.0))
+
+
+def fail_on_rank_1(group):
+    if group.rank == 1:
+        raise ZeroDivisionError()
+    return group.rank
+
+
+def test_failures_are_reported():
+    with pytest.raises(RuntimeError, match="rank 1: ZeroDivisionError"):
+        launch(fail_on_rank_1, 2, timeout=10)
+
+
+def test_make_node():
+    x = matrix("x")
+    y = all_gather(x, "group", tag=3)
+    assert isinstance(y.owner.op, ShmWait)
+    start = y.owner.inputs[0].owner
+    assert start.op == ShmCollective("group", "all_gather", tag=3)
+    assert y.broadcastable == (False, False)
+    assert reduce_scatter(x, "group").owner.inputs[1].ndim == 2
+    with pytest.raises(ValueError):
+        ShmCollective("group", "gather")
+    with pytest.raises(TypeError):
+        all_gather(x.sum(), "group")
+
+
+def test_schedule_overlaps_gradients():
+    x = dvector("x")
+    w1 = dvector("w1")
+    w2 = dvector("w2")
+    cost = ((x * w1).sum() * w2).sum()
+    g1, g2 = aesara.grad(cost, [w1, w2])
+    r1, r2 = all_reduce_gradients([g1, g2], "group")
+    assert r1.owner.inputs[0].owner.op.tag == 0
+    assert r2.owner.inputs[0].owner.op.tag == 1
+
+    f = aesara.function([x, w1, w2], [r1, r2], mode=shm_mode)
+    nodes = f.maker.linker.make_all()[-1]
+    types = [type(node.op) for node in nodes]
+    # The reduction of the gradient of `w2` starts before the gradient of
+    # `w1` is computed, and both are waited on at the end
+    assert types[-2:] == [ShmWait, ShmWait]
+    first_start = types.index(ShmCollective)
+    assert ShmCollective in types[first_start + 1 : -2]
+    assert first_start < len(types) - 4
+
+    start = r1.owner.inputs[0].owner
+    assert shm_start_wait_cmp(start, x.sum().owner) < 0
+    assert shm_start_wait_cmp(r1.owner, x.sum().owner) > 0
@@ -11,9 +11,12 @@ from aesara import function, grad
 from aesara import tensor as at
 from aesara.configdefaults import config
 from aesara.tensor.slinalg import (
+    CachedFactorization,
     Cholesky,
     CholeskyGrad,
     CholeskySolve,
+    LUFactor,
+    LUSolve,
     Solve,
     SolveBase,
     SolveTriangular,
@@ -22,6 +25,8 @@ from aesara.tensor.slinalg import (
     eigvalsh,
     expm,
     kron,
+    lu_factor,
+    lu_solve,
     solve,
     solve_triangular,
 )
@@ -181,8 +186,8 @@ class TestSolveBase(utt.InferShapeTester):
             (vector, matrix, "`A` must be a matrix.*"),
             (
                 functools.partial(tensor, dtype="floatX", shape=(False,) * 3),
-                matrix,
-                "`A` must be a matrix.*",
+                vector,
+                "`b` must be a matrix or a vector.*",
             ),
             (
                 matrix,
@@ -470,6 +475,198 @@ def test_cho_solve():
     )
 
 
+def _spd_batch(rng, shape):
+    r = rng.normal(size=shape)
+    return r @ np.swapaxes(r, -1, -2) + shape[-1] * np.eye(shape[-1])
+
+
+@pytest.mark.skipif(not config.cxx, reason="Needs a C++ compiler")
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+@pytest.mark.parametrize("batch", [(), (3,), (2, 3), (0,)])
+@pytest.mark.parametrize("lower", [True, False])
+def test_batched_c_code(dtype, batch, lower):
+    rng = np.random.default_rng(utt.fetch_seed())
+    shape = (*batch, 4, 4)
+    A_val = _spd_batch(rng, shape).astype(dtype)
+    L_val = np.linalg.cholesky(A_val)
+    if not lower:
+        L_val = np.swapaxes(L_val, -1, -2)
+    A = tensor(dtype=dtype, shape=(False,) * len(shape))
+    rtol = 1e-4 if dtype == "float32" else 1e-10
+
+    def check(outputs, inputs, values):
+        py, c = [
+            function(inputs, outputs, mode=aesara.Mode(linker=linker, optimizer=None))(
+                *values
+            )
+            for linker in ("py", "c")
+        ]
+        assert c.shape == py.shape and c.dtype == py.dtype
+        np.testing.assert_allclose(c, py, rtol=rtol, atol=rtol)
+
+    check(Cholesky(lower=lower)(A), [A], [A_val])
+    for b_shape in (shape[:-1], (*shape[:-1], 3)):
+        b_val = rng.normal(size=b_shape).astype(dtype)
+        b = tensor(dtype=dtype, shape=(False,) * len(b_shape))
+        for op, val in [
+            (Solve(lower=lower), A_val),
+            (Solve(assume_a="pos", lower=lower), A_val),
+            (CholeskySolve(lower=lower), L_val),
+            (SolveTriangular(lower=lower), L_val),
+            (SolveTriangular(lower=lower, trans=1), L_val),
+            (SolveTriangular(lower=lower, unit_diagonal=True), L_val),
+        ]:
+            check(op(A, b), [A, b], [val, b_val])
+
+
+@pytest.mark.skipif(not config.cxx, reason="Needs a C++ compiler")
+def test_batched_c_code_errors():
+    mode = aesara.Mode(linker="c", optimizer=None)
+    A = tensor(dtype="float64", shape=(False,) * 3)
+    b = tensor(dtype="float64", shape=(False,) * 2)
+    A_val = np.stack([np.eye(2), [[1.0, 2.0], [2.0, 1.0]]])
+
+    with pytest.raises(scipy.linalg.LinAlgError, match="not positive definite"):
+        function([A], cholesky(A), mode=mode)(A_val)
+
+    # Only the matrix that fails is replaced by NaNs
+    res = function([A], Cholesky(on_error="nan")(A), mode=mode)(A_val)
+    assert np.array_equal(res[0], np.eye(2))
+    assert np.all(np.isnan(res[1]))
+
+    f = function([A, b], solve(A, b), mode=mode)
+    with pytest.raises(scipy.linalg.LinAlgError, match="singular"):
+        f(np.stack([np.eye(2), np.ones((2, 2))]), np.ones((2, 2)))
+    with pytest.raises(ValueError, match="infs or NaNs"):
+        f(np.stack([np.eye(2), np.full((2, 2), np.nan)]), np.ones((2, 2)))
+    with pytest.raises(ValueError, match="batch dimensions"):
+        f(A_val, np.ones((3, 2)))
+
+    f = function([A, b], solve_triangular(A, b, lower=True), mode=mode)
+    with pytest.raises(scipy.linalg.LinAlgError, match="singular"):
+        f(np.zeros((2, 2, 2)), np.ones((2, 2)))
+
+
+@pytest.mark.parametrize("lower", [True, False])
+def test_batched_cholesky_grad(lower):
+    rng = np.random.default_rng(utt.fetch_seed())
+
+    def op(r):
+        return Cholesky(lower=lower)(
+            at.sum(
+                at.shape_padright(r) * at.shape_padaxis(at.swapaxes(r, -1, -2), -3),
+                axis=-2,
+            )
+            + 4 * np.eye(4)
+        )
+
+    utt.verify_grad(op, [rng.normal(size=(3, 4, 4))], rng=rng)
+
+
+@pytest.mark.parametrize("b_shape", [(3, 4), (3, 4, 2)])
+def test_batched_solve_grad(b_shape):
+    rng = np.random.default_rng(utt.fetch_seed())
+    A_val = rng.normal(size=(3, 4, 4)) * 0.5 + np.eye(4)
+    b_val = rng.normal(size=b_shape)
+    utt.verify_grad(Solve(), [A_val, b_val], rng=rng)
+    utt.verify_grad(SolveTriangular(lower=True), [A_val, b_val], rng=rng)
+
+
+@pytest.mark.parametrize("linker", ["py", "c"])
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+@pytest.mark.parametrize("batch", [(), (3,), (2, 3)])
+def test_lu_factor_solve(linker, dtype, batch):
+    if linker == "c" and not config.cxx:
+        pytest.skip("Needs a C++ compiler")
+    rng = np.random.default_rng(utt.fetch_seed())
+    shape = (*batch, 4, 4)
+    A_val = rng.normal(size=shape).astype(dtype)
+    A = tensor(dtype=dtype, shape=(False,) * len(shape))
+    mode = aesara.Mode(linker=linker, optimizer=None)
+    rtol = 1e-4 if dtype == "float32" else 1e-10
+
+    lu, piv = function([A], lu_factor(A), mode=mode)(A_val)
+    assert lu.dtype == dtype and piv.dtype == "int32"
+    for idx in np.ndindex(*batch):
+        exp_lu, exp_piv = scipy.linalg.lu_factor(A_val[idx])
+        np.testing.assert_allclose(lu[idx], exp_lu, rtol=rtol, atol=rtol)
+        np.testing.assert_array_equal(piv[idx], exp_piv)
+
+    for b_shape in (shape[:-1], (*shape[:-1], 3)):
+        b_val = rng.normal(size=b_shape).astype(dtype)
+        b = tensor(dtype=dtype, shape=(False,) * len(b_shape))
+        x = function([A, b], lu_solve(lu_factor(A), b), mode=mode)(A_val, b_val)
+        assert x.dtype == dtype
+        if len(b_shape) < len(shape):
+            exp = np.linalg.solve(A_val, b_val[..., None])[..., 0]
+        else:
+            exp = np.linalg.solve(A_val, b_val)
+        np.testing.assert_allclose(x, exp, rtol=rtol * 10, atol=rtol * 10)
+
+
+@pytest.mark.parametrize("linker", ["py", "c"])
+def test_lu_solve_errors(linker):
+    if linker == "c" and not config.cxx:
+        pytest.skip("Needs a C++ compiler")
+    mode = aesara.Mode(linker=linker, optimizer=None)
+    A = dmatrix()
+    b = vector(dtype="float64")
+    f = function([A, b], lu_solve(lu_factor(A), b), mode=mode)
+    with pytest.raises(np.linalg.LinAlgError, match="singular"):
+        f(np.ones((2, 2)), np.ones(2))
+    with pytest.raises(ValueError, match="infs or NaNs"):
+        f(np.eye(2), np.array([1.0, np.nan]))
+
+    piv = vector(dtype="int32")
+    f = function([A, piv, b], LUSolve()(A, piv, b), mode=mode)
+    with pytest.raises(ValueError, match="row interchanges"):
+        f(np.eye(2), np.array([0, 2], dtype="int32"), np.ones(2))
+
+    with pytest.raises(TypeError, match="int32"):
+        LUSolve()(A, vector(dtype="int64"), b)
+
+
+def test_lu_infer_shape():
+    A = tensor(dtype="float64", shape=(False,) * 3)
+    b = tensor(dtype="float64", shape=(False,) * 2)
+    rng = np.random.default_rng(utt.fetch_seed())
+    A_val = rng.normal(size=(2, 3, 3))
+    b_val = rng.normal(size=(2, 3))
+    tester = utt.InferShapeTester()
+    tester.setup_method()
+    tester._compile_and_check([A], LUFactor()(A), [A_val], LUFactor)
+    lu, piv = lu_factor(A)
+    tester._compile_and_check([A, b], [lu_solve((lu, piv), b)], [A_val, b_val], LUSolve)
+
+
+@pytest.mark.parametrize("linker", ["py", "cvm"])
+def test_cached_factorization(linker):
+    rng = np.random.default_rng(utt.fetch_seed())
+    A = dmatrix()
+    op = CachedFactorization(Cholesky())
+    assert op == CachedFactorization(Cholesky())
+    assert op != CachedFactorization(Cholesky(lower=False))
+
+    f = function([A], op(A), mode=aesara.Mode(linker=linker, optimizer=None))
+    (node,) = f.maker.fgraph.apply_nodes
+    assert node.op == op
+
+    A_val = _spd_batch(rng, (4, 4))
+    L = f(A_val)
+    np.testing.assert_allclose(L, np.linalg.cholesky(A_val))
+    # A cache hit returns a copy that can be changed freely
+    L[:] = 0
+    np.testing.assert_allclose(f(A_val), np.linalg.cholesky(A_val))
+
+    # Changes to the input, in place or not, are seen
+    A_val += np.eye(4)
+    np.testing.assert_allclose(f(A_val), np.linalg.cholesky(A_val))
+    A_val = _spd_batch(rng, (4, 4))
+    np.testing.assert_allclose(f(A_val), np.linalg.cholesky(A_val))
+    with pytest.raises(scipy.linalg.LinAlgError):
+        f(-A_val)
+
+
 def test_expm():
     rng = np.random.default_rng(utt.fetch_seed())
     A = rng.standard_normal((5, 5)).astype(config.floatX)
@@ -97,6 +97,31 @@ class TestSort:
         gt = np.sort(self.m_val, None)
         utt.assert_allclose(gv, gt)
 
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("dtype", ["float64", "float32", "int16", "uint8"])
+    def test_c_code(self, openmp, dtype):
+        x = tensor(dtype=dtype, shape=(False, False, False))
+        axis = lscalar()
+        with aesara.config.change_flags(openmp=openmp, openmp_elemwise_minsize=10):
+            f = aesara.function(
+                [x, axis], [sort(x, axis), argsort(x, axis)], mode=Mode(linker="c")
+            )
+        x_val = (self.rng.normal(size=(4, 7, 33)) * 10).astype(dtype)
+        if dtype.startswith("float"):
+            x_val[1, 2, :5] = np.nan
+        # Non-contiguous input
+        x_val = x_val.transpose(1, 2, 0)
+        for axis_val in (0, 1, -1):
+            gv, gi = f(x_val, axis_val)
+            np.testing.assert_array_equal(gv, np.sort(x_val, axis_val))
+            # Ties are broken by position
+            np.testing.assert_array_equal(
+                gi, np.argsort(x_val, axis_val, kind="stable")
+            )
+
+        with pytest.raises(ValueError, match="out of bounds"):
+            f(x_val, 3)
+
     def test_grad_vector(self):
         data = self.rng.random((10)).astype(aesara.config.floatX)
         utt.verify_grad(sort, [data])
@@ -512,6 +537,30 @@ class TestTopK:
                 lambda x: topk(x, k, axis=axis, sorted=sorted), [xval], eps=1e-2
             )
 
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("k", [1, -1, 3, -7, 40, -64])
+    def test_sorted(self, openmp, k):
+        x = matrix(name="x", dtype="float64")
+        with aesara.config.change_flags(openmp=openmp, openmp_elemwise_minsize=10):
+            yv, yi = topk_and_argtopk(x, k, axis=-1, sorted=True)
+            fc = aesara.function([x], [yv, yi], mode=Mode(linker="c"))
+        fp = aesara.function([x], [yv, yi], mode=Mode(linker="py"))
+        rng = np.random.default_rng(utt.fetch_seed())
+        # Values with ties
+        x_val = rng.integers(-20, 20, size=(6, 64)).astype("float64")
+        if k > 0:
+            goali = np.argsort(-x_val, axis=-1, kind="stable")[:, :k]
+        else:
+            goali = np.argsort(x_val, axis=-1, kind="stable")[:, :-k]
+        for yvval, yival in (fc(x_val), fp(x_val)):
+            np.testing.assert_array_equal(yival, goali)
+            np.testing.assert_array_equal(
+                yvval, np.take_along_axis(x_val, goali, axis=-1)
+            )
+
+        with pytest.raises(ValueError, match="larger than the size"):
+            fc(x_val[:, :1] if abs(k) > 1 else x_val[:, :0])
+
 
 class TestTopKInferShape(utt.InferShapeTester):
     @pytest.mark.parametrize(
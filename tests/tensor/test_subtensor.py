@@ -11,6 +11,7 @@ import aesara.scalar as scal
 import aesara.tensor.basic as at
 from aesara.compile import DeepCopyOp, shared
 from aesara.compile.io import In
+from aesara.compile.mode import Mode
 from aesara.configdefaults import config
 from aesara.graph.op import get_test_value
 from aesara.graph.opt_utils import is_same_graph
@@ -854,6 +855,32 @@ class TestSubtensor(utt.OptimizationTestMixin):
         val = self.eval_output_and_check(t, op_type=AdvancedSubtensor1, length=2)
         utt.assert_allclose(data[idx[::2]], val)
 
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("idx_dtype", ["int32", "uint8", "int64"])
+    @pytest.mark.parametrize("x_shape", [(5, 3), (5,), (5, 2, 3), (0, 3)])
+    def test_gather_rows(self, openmp, idx_dtype, x_shape):
+        x = tensor(self.dtype, shape=(False,) * len(x_shape))
+        idx = vector(dtype=idx_dtype)
+        with config.change_flags(openmp_elemwise_minsize=0):
+            f = aesara.function(
+                [x, idx],
+                AdvancedSubtensor1(openmp=openmp)(x, idx),
+                mode=Mode(linker="c"),
+            )
+
+        xval = random(*x_shape).astype(self.dtype)
+        if x_shape[0] == 0:
+            idxval = np.zeros(0, dtype=idx_dtype)
+        else:
+            low = 0 if idx_dtype.startswith("u") else -x_shape[0]
+            idxval = integers_ranged(low, x_shape[0] - 1, (12,)).astype(idx_dtype)
+        utt.assert_allclose(f(xval, idxval), xval[idxval])
+        # Non C-contiguous inputs use the generic code path
+        utt.assert_allclose(f(xval[::-1], idxval), xval[::-1][idxval])
+
+        with pytest.raises(IndexError):
+            f(xval, np.r_[idxval, x_shape[0]].astype(idx_dtype))
+
     def test_err_invalid_list(self):
         n = self.shared(np.asarray(5, dtype=self.dtype))
         with pytest.raises(IndexError):
@@ -1677,6 +1704,39 @@ class TestIncSubtensor1:
         utt.assert_allclose(a2val[2], mval[2] * 3)
         utt.assert_allclose(a2val[3], mval[3] * 2)
 
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize("deterministic", ["default", "more"])
+    @pytest.mark.parametrize("set_instead_of_inc", [False, True])
+    @pytest.mark.parametrize(
+        "x_shape, y_shape",
+        [((7, 5), (20, 5)), ((7,), (20,)), ((7,), ()), ((7, 2, 3), (2, 3))],
+    )
+    def test_scatter_rows(
+        self, openmp, deterministic, set_instead_of_inc, x_shape, y_shape
+    ):
+        x = tensor("float64", shape=(False,) * len(x_shape))
+        y = tensor("float64", shape=(False,) * len(y_shape))
+        op = AdvancedIncSubtensor1(set_instead_of_inc=set_instead_of_inc, openmp=openmp)
+        with config.change_flags(
+            deterministic=deterministic, openmp_elemwise_minsize=0
+        ):
+            f = aesara.function(
+                [x, y, self.adv1q], op(x, y, self.adv1q), mode=Mode(linker="c")
+            )
+
+        xval = self.rng.random(x_shape)
+        yval = self.rng.random(y_shape)
+        idxval = self.rng.integers(-7, 7, size=20)
+        expected = xval.copy()
+        if set_instead_of_inc:
+            expected[idxval] = yval
+        else:
+            np.add.at(expected, idxval, yval)
+        utt.assert_allclose(f(xval, yval, idxval), expected)
+
+        with pytest.raises(IndexError):
+            f(xval, yval, np.r_[idxval[:-1], 7])
+
     def test_inc_bcastableidx(self):
         idx = at.constant([0])
         c_inc = col()
@@ -1761,6 +1821,83 @@ class TestAdvancedSubtensor:
             rep[idx] += y_val
             check(idx, y_val, x_val, rep)
 
+    @pytest.mark.parametrize("openmp", [False, True])
+    @pytest.mark.parametrize(
+        "idx",
+        [
+            (np.array([0, 2, 3, 2]),),
+            (np.array([0, 2, 3, 2]), slice(None), np.array([1, -1, 3, 3])),
+            (slice(None, None, -1), np.array([[0, 1], [3, 3]])),
+            (slice(1, None, 2), np.array([0, 2]), np.array([1, 1])),
+            (np.array([True, False, True, True]), slice(1, 4)),
+            (slice(None), np.array([[True, False] * 2] * 5)),
+            (None, np.array([0, 2])),
+        ],
+    )
+    def test_c_code(self, openmp, idx):
+        x_val = random(4, 5, 4)
+        x = dtensor3()
+        sym_idx = [
+            NoneConst
+            if i is None
+            else SliceConstant(slicetype, i)
+            if isinstance(i, slice)
+            else at.as_tensor_variable(i)
+            for i in idx
+        ]
+        mode = Mode(linker="c", optimizer=None)
+        with config.change_flags(openmp_elemwise_minsize=0):
+            f = aesara.function(
+                [x], AdvancedSubtensor(openmp=openmp)(x, *sym_idx), mode=mode
+            )
+            y_val = random(*x_val[idx].shape)
+            y = tensor("float64", shape=(False,) * y_val.ndim)
+            f_inc = aesara.function(
+                [x, y],
+                AdvancedIncSubtensor(openmp=openmp)(x, y, *sym_idx),
+                mode=mode,
+            )
+            f_set = aesara.function(
+                [x, y],
+                AdvancedIncSubtensor(set_instead_of_inc=True, openmp=openmp)(
+                    x, y, *sym_idx
+                ),
+                mode=mode,
+            )
+
+        assert np.array_equal(f(x_val), x_val[idx])
+        assert np.array_equal(f(x_val[:, ::-1]), x_val[:, ::-1][idx])
+
+        exp_inc = x_val.copy()
+        np.add.at(exp_inc, idx, y_val)
+        utt.assert_allclose(f_inc(x_val, y_val), exp_inc)
+
+        exp_set = x_val.copy()
+        exp_set[idx] = y_val
+        utt.assert_allclose(f_set(x_val, y_val), exp_set)
+
+        # Broadcasted updates
+        exp_inc = x_val.copy()
+        np.add.at(exp_inc, idx, y_val[:1])
+        utt.assert_allclose(f_inc(x_val, y_val[:1]), exp_inc)
+
+    def test_c_code_errors(self):
+        x = dtensor3()
+        mode = Mode(linker="c", optimizer=None)
+        f = aesara.function(
+            [x, self.ix1], AdvancedSubtensor()(x, self.ix1, self.ix1), mode=mode
+        )
+        x_val = random(4, 5, 4)
+        with pytest.raises(IndexError):
+            f(x_val, [0, 4])
+        with pytest.raises(IndexError):
+            f(x_val, [0, -6])
+
+        mask = tensor("bool", shape=(False, False))
+        f = aesara.function([x, mask], AdvancedSubtensor()(x, mask), mode=mode)
+        with pytest.raises(IndexError):
+            f(x_val, np.ones((4, 4), dtype=bool))
+
     def eval_output_and_check(self, t, op):
         f = inplace_func([], t, mode=self.mode)
         topo = f.maker.fgraph.toposort()